@@ -0,0 +1,215 @@
+#include "BenchHarness.h"
+#include "Animation.h"
+#include <vector>
+#include <cmath>
+#include <cstring>
+
+using namespace DirectX;
+
+namespace Bench {
+	namespace {
+		const uint32_t s_TrackCount = 4096;
+		const uint32_t s_KeyCount = 32;
+		const float s_KeyInterval = 1.0f / 30.0f;
+
+		void BuildClip(AnimationClip& clip, AnimationClip::Interpolation interpolation) {
+			std::vector<float> times(s_KeyCount);
+			std::vector<XMFLOAT3> positions(s_KeyCount), scales(s_KeyCount);
+			std::vector<XMFLOAT4> rotations(s_KeyCount);
+			for (uint32_t t = 0; t < s_TrackCount; ++t) {
+				uint32_t track = clip.AddTrack();
+				float ft = static_cast<float>(t);
+				for (uint32_t k = 0; k < s_KeyCount; ++k) {
+					float fk = static_cast<float>(k);
+					times[k] = fk * s_KeyInterval;
+					positions[k] = XMFLOAT3(ft + 0.1f * fk, 0.05f * fk * fk, -0.2f * fk);
+					scales[k] = XMFLOAT3(1.0f + 0.01f * fk, 1.0f, 1.0f - 0.01f * fk);
+					XMStoreFloat4(&rotations[k], XMQuaternionRotationRollPitchYaw(0.05f * fk, 0.01f * ft + 0.1f * fk, 0.0f));
+				}
+				clip.SetPositionKeys(track, times.data(), positions.data(), s_KeyCount, interpolation);
+				clip.SetRotationKeys(track, times.data(), rotations.data(), s_KeyCount, interpolation);
+				clip.SetScaleKeys(track, times.data(), scales.data(), s_KeyCount, interpolation);
+			}
+		}
+
+		float Random(uint32_t& seed, float minValue, float maxValue) {
+			seed = seed * 1664525u + 1013904223u;
+			return minValue + (maxValue - minValue) * (static_cast<float>(seed >> 8) / 16777216.0f);
+		}
+
+		struct CheckTrack {
+			std::vector<float> times;
+			std::vector<XMFLOAT3> positions, scales;
+			std::vector<XMFLOAT4> rotations;
+		};
+
+		// 关键帧间隔不均匀、各轨道关键帧数不同的小剪辑，相邻旋转相差较大
+		std::vector<CheckTrack> BuildCheckClip(AnimationClip& clip, AnimationClip::Interpolation interpolation) {
+			std::vector<CheckTrack> tracks(8);
+			uint32_t seed = 777;
+			for (uint32_t t = 0; t < 8; ++t) {
+				uint32_t track = clip.AddTrack();
+				uint32_t keyCount = 2 + t * 3;
+				std::vector<float>& times = tracks[t].times;
+				std::vector<XMFLOAT3>& positions = tracks[t].positions;
+				std::vector<XMFLOAT3>& scales = tracks[t].scales;
+				std::vector<XMFLOAT4>& rotations = tracks[t].rotations;
+				times.resize(keyCount);
+				positions.resize(keyCount);
+				scales.resize(keyCount);
+				rotations.resize(keyCount);
+				float time = Random(seed, 0.0f, 0.2f);
+				for (uint32_t k = 0; k < keyCount; ++k) {
+					times[k] = time;
+					time += Random(seed, 0.01f, 0.3f);
+					positions[k] = XMFLOAT3(Random(seed, -5.0f, 5.0f), Random(seed, -5.0f, 5.0f), Random(seed, -5.0f, 5.0f));
+					scales[k] = XMFLOAT3(Random(seed, 0.5f, 2.0f), Random(seed, 0.5f, 2.0f), Random(seed, 0.5f, 2.0f));
+					XMStoreFloat4(&rotations[k], XMQuaternionRotationRollPitchYaw(
+						Random(seed, -XM_PI, XM_PI), Random(seed, -XM_PI, XM_PI), Random(seed, -XM_PI, XM_PI)));
+				}
+				clip.SetPositionKeys(track, times.data(), positions.data(), keyCount, interpolation);
+				clip.SetRotationKeys(track, times.data(), rotations.data(), keyCount, interpolation);
+				clip.SetScaleKeys(track, times.data(), scales.data(), keyCount, interpolation);
+			}
+			return tracks;
+		}
+
+		bool PoseEqual(const AnimationPose& a, const AnimationPose& b) {
+			for (size_t i = 0; i < a.positions.size(); ++i) {
+				if (memcmp(&a.positions[i], &b.positions[i], sizeof(XMFLOAT3)) != 0 ||
+					memcmp(&a.scales[i], &b.scales[i], sizeof(XMFLOAT3)) != 0 ||
+					memcmp(&a.rotations[i], &b.rotations[i], sizeof(XMFLOAT4)) != 0)
+					return false;
+			}
+			return true;
+		}
+
+		bool RotationsUnit(const AnimationPose& pose) {
+			for (const XMFLOAT4& q : pose.rotations) {
+				if (fabsf(XMVectorGetX(XMVector4Length(XMLoadFloat4(&q))) - 1.0f) > 1e-5f)
+					return false;
+			}
+			return true;
+		}
+
+		// 游标缓存的采样器应与每次新建的采样器(游标从0开始重新定位)给出完全相同的结果
+		void CheckSampler(Harness& harness, const std::string& suffix, AnimationClip::Interpolation interpolation) {
+			AnimationClip clip;
+			const std::vector<CheckTrack> tracks = BuildCheckClip(clip, interpolation);
+			const float duration = clip.GetDuration();
+			const std::string prefix = "Animation/Sampler" + suffix;
+
+			AnimationPose cachedPose, freshPose;
+			bool unit = true;
+			auto matches = [&](AnimationSampler& sampler, float time, bool looped) {
+				AnimationSampler fresh(clip);
+				if (looped) {
+					sampler.SampleLooped(clip, time, cachedPose);
+					fresh.SampleLooped(clip, time, freshPose);
+				}
+				else {
+					sampler.Sample(clip, time, cachedPose);
+					fresh.Sample(clip, time, freshPose);
+				}
+				unit = unit && RotationsUnit(cachedPose);
+				return PoseEqual(cachedPose, freshPose);
+			};
+
+			// 顺序推进，偶尔跨过多个关键帧触发回退到二分查找
+			{
+				AnimationSampler sampler(clip);
+				bool equal = true;
+				uint32_t seed = 1;
+				for (float time = -0.1f; time < duration + 0.1f; time += Random(seed, 0.0f, 1.0f) < 0.9f ? 0.004f : 0.5f)
+					equal = matches(sampler, time, false) && equal;
+				harness.Check(prefix + ":sequential_matches_fresh", equal);
+			}
+			// 倒放
+			{
+				AnimationSampler sampler(clip);
+				bool equal = true;
+				for (float time = duration + 0.1f; time > -0.1f; time -= 0.007f)
+					equal = matches(sampler, time, false) && equal;
+				harness.Check(prefix + ":backward_matches_fresh", equal);
+			}
+			// 循环播放多圈，每圈结束时游标需从末尾回到开头
+			{
+				AnimationSampler sampler(clip);
+				bool equal = true;
+				for (float time = 0.0f; time < 3.5f * duration; time += 0.011f)
+					equal = matches(sampler, time, true) && equal;
+				harness.Check(prefix + ":looped_matches_fresh", equal);
+			}
+			harness.Check(prefix + ":unit_rotations", unit);
+
+			// 在关键帧时间处采样应精确得到关键帧的值(旋转允许整体取反)
+			{
+				bool exact = true;
+				AnimationPose pose;
+				for (size_t t = 0; t < tracks.size(); ++t) {
+					const CheckTrack& track = tracks[t];
+					for (size_t k = 0; k < track.times.size(); ++k) {
+						AnimationSampler sampler(clip);
+						sampler.Sample(clip, track.times[k], pose);
+						XMVECTOR q = XMLoadFloat4(&pose.rotations[t]), key = XMLoadFloat4(&track.rotations[k]);
+						if (XMVectorGetX(XMQuaternionDot(q, key)) < 0.0f)
+							q = XMVectorNegate(q);
+						exact = exact && XMVector3NearEqual(XMLoadFloat3(&pose.positions[t]), XMLoadFloat3(&track.positions[k]), XMVectorReplicate(1e-5f)) &&
+							XMVector3NearEqual(XMLoadFloat3(&pose.scales[t]), XMLoadFloat3(&track.scales[k]), XMVectorReplicate(1e-5f)) &&
+							XMVector4NearEqual(q, key, XMVectorReplicate(1e-6f));
+					}
+				}
+				harness.Check(prefix + ":hits_keys", exact);
+			}
+		}
+
+		void RunClip(Harness& harness, const std::string& suffix, AnimationClip::Interpolation interpolation) {
+			AnimationClip clip;
+			BuildClip(clip, interpolation);
+			AnimationSampler sampler(clip);
+			AnimationPose pose;
+			const std::string count = std::to_string(s_TrackCount);
+
+			// 按帧推进，游标每次最多前进一个关键帧
+			float time = 0.0f;
+			harness.Run("Animation/SampleSequential" + suffix + "/" + count, s_TrackCount, [&]() {
+				time += 1.0f / 60.0f;
+				sampler.SampleLooped(clip, time, pose);
+				DoNotOptimize(pose.positions.data());
+			});
+
+			// 随机跳转时间，退化为二分查找
+			uint32_t seed = 12345;
+			harness.Run("Animation/SampleRandomSeek" + suffix + "/" + count, s_TrackCount, [&]() {
+				seed = seed * 1664525u + 1013904223u;
+				float t = static_cast<float>(seed >> 8) / 16777216.0f * clip.GetDuration();
+				sampler.Sample(clip, t, pose);
+				DoNotOptimize(pose.positions.data());
+			});
+		}
+	}
+
+	void RunAnimationBenchmarks(Harness& harness) {
+		// 替换关键帧后时长应随之缩短
+		{
+			AnimationClip clip;
+			uint32_t a = clip.AddTrack(), b = clip.AddTrack();
+			const float longTimes[] = { 0.0f, 2.0f }, shortTimes[] = { 0.0f, 0.5f };
+			const XMFLOAT3 values[] = { XMFLOAT3(), XMFLOAT3(1.0f, 1.0f, 1.0f) };
+			clip.SetPositionKeys(a, longTimes, values, 2, AnimationClip::Interpolation::Linear);
+			clip.SetScaleKeys(b, shortTimes, values, 2, AnimationClip::Interpolation::Linear);
+			bool grown = clip.GetDuration() == 2.0f;
+			clip.SetPositionKeys(a, shortTimes, values, 2, AnimationClip::Interpolation::Linear);
+			bool shrunk = clip.GetDuration() == 0.5f;
+			clip.SetScaleKeys(b, shortTimes, values, 0, AnimationClip::Interpolation::Linear);
+			clip.SetPositionKeys(a, shortTimes, values, 0, AnimationClip::Interpolation::Linear);
+			harness.Check("Animation/Duration", grown && shrunk && clip.GetDuration() == 0.0f);
+		}
+
+		CheckSampler(harness, "Linear", AnimationClip::Interpolation::Linear);
+		CheckSampler(harness, "Cubic", AnimationClip::Interpolation::Cubic);
+
+		RunClip(harness, "Linear", AnimationClip::Interpolation::Linear);
+		RunClip(harness, "Cubic", AnimationClip::Interpolation::Cubic);
+	}
+}
@@ -0,0 +1,183 @@
+#include "BenchHarness.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <iomanip>
+
+namespace Bench {
+#if defined(_MSC_VER) && !defined(__clang__)
+	void UseCharPointer(const volatile char*) {}
+#endif
+
+	namespace {
+		using Clock = std::chrono::steady_clock;
+
+		double RunIterations(const std::function<void()>& func, uint64_t iterations) {
+			auto start = Clock::now();
+			for (uint64_t i = 0; i < iterations; ++i)
+				func();
+			ClobberMemory();
+			return std::chrono::duration<double, std::nano>(Clock::now() - start).count();
+		}
+
+		double Percentile(const std::vector<double>& sorted, double p) {
+			double pos = p * (sorted.size() - 1);
+			size_t lo = static_cast<size_t>(pos);
+			size_t hi = std::min(lo + 1, sorted.size() - 1);
+			return sorted[lo] + (sorted[hi] - sorted[lo]) * (pos - lo);
+		}
+
+		void WriteJsonString(std::ostream& os, const std::string& str) {
+			os << '"';
+			for (char c : str) {
+				switch (c) {
+				case '"': os << "\\\""; break;
+				case '\\': os << "\\\\"; break;
+				case '\n': os << "\\n"; break;
+				default: os << c; break;
+				}
+			}
+			os << '"';
+		}
+	}
+
+	Harness::Harness(const Options& options)
+		: m_Options(options) {
+		m_Options.samples = std::max(m_Options.samples, 1u);
+	}
+
+	bool Harness::Matches(const std::string& name) const {
+		return m_Options.filter.empty() || name.find(m_Options.filter) != std::string::npos;
+	}
+
+	void Harness::Run(const std::string& name, uint64_t itemsPerIteration, const std::function<void()>& func) {
+		if (!Matches(name))
+			return;
+
+		// 标定迭代次数，使单次采样不短于minSampleMs
+		const double minSampleNs = m_Options.minSampleMs * 1e6;
+		uint64_t iterations = 1;
+		for (;;) {
+			double elapsed = RunIterations(func, iterations);
+			if (elapsed >= minSampleNs || iterations >= (1ull << 40))
+				break;
+			double scale = elapsed > 0.0 ? minSampleNs / elapsed * 1.2 : 10.0;
+			iterations = static_cast<uint64_t>(std::ceil(iterations * std::min(std::max(scale, 1.5), 10.0)));
+		}
+
+		for (uint32_t i = 0; i < m_Options.warmupSamples; ++i)
+			RunIterations(func, iterations);
+
+		std::vector<double> perIter(m_Options.samples);
+		for (uint32_t i = 0; i < m_Options.samples; ++i)
+			perIter[i] = RunIterations(func, iterations) / iterations;
+
+		Result result = {};
+		result.name = name;
+		result.iterations = iterations;
+		result.itemsPerIteration = itemsPerIteration;
+		result.samples = m_Options.samples;
+
+		double sum = 0.0;
+		for (double t : perIter)
+			sum += t;
+		result.meanNs = sum / perIter.size();
+		double var = 0.0;
+		for (double t : perIter)
+			var += (t - result.meanNs) * (t - result.meanNs);
+		result.stddevNs = perIter.size() > 1 ? std::sqrt(var / (perIter.size() - 1)) : 0.0;
+
+		std::sort(perIter.begin(), perIter.end());
+		result.minNs = perIter.front();
+		result.medianNs = Percentile(perIter, 0.5);
+		result.p90Ns = Percentile(perIter, 0.9);
+
+		std::vector<double> deviations(perIter.size());
+		for (size_t i = 0; i < perIter.size(); ++i)
+			deviations[i] = std::fabs(perIter[i] - result.medianNs);
+		std::sort(deviations.begin(), deviations.end());
+		result.madNs = Percentile(deviations, 0.5);
+
+		m_Results.push_back(std::move(result));
+		fprintf(stderr, "%-64s %14.1f ns  (mad %.1f%%)\n", name.c_str(), m_Results.back().medianNs,
+			m_Results.back().medianNs > 0.0 ? m_Results.back().madNs / m_Results.back().medianNs * 100.0 : 0.0);
+	}
+
+	void Harness::AddCounter(const std::string& key, double value) {
+		if (!m_Results.empty())
+			m_Results.back().counters.emplace_back(key, value);
+	}
+
+	bool Harness::Check(const std::string& name, bool passed) {
+		m_Checks.push_back({ name, passed });
+		if (!passed)
+			fprintf(stderr, "CHECK FAILED: %s\n", name.c_str());
+		return passed;
+	}
+
+	const std::vector<Result>& Harness::GetResults() const {
+		return m_Results;
+	}
+
+	size_t Harness::GetFailedCheckCount() const {
+		return std::count_if(m_Checks.begin(), m_Checks.end(), [](const CheckResult& check) { return !check.passed; });
+	}
+
+	void Harness::WriteJson(std::ostream& os) const {
+		os << std::setprecision(6) << std::fixed;
+		os << "{\n  \"context\": {\n";
+		os << "    \"samples\": " << m_Options.samples << ",\n";
+		os << "    \"min_sample_ms\": " << m_Options.minSampleMs << ",\n";
+#if defined(__clang__)
+		os << "    \"compiler\": \"clang " << __clang_major__ << "." << __clang_minor__ << "\",\n";
+#elif defined(__GNUC__)
+		os << "    \"compiler\": \"gcc " << __GNUC__ << "." << __GNUC_MINOR__ << "\",\n";
+#elif defined(_MSC_VER)
+		os << "    \"compiler\": \"msvc " << _MSC_VER << "\",\n";
+#else
+		os << "    \"compiler\": \"unknown\",\n";
+#endif
+#ifdef DIRECTX_MATH_VERSION
+		os << "    \"directxmath_version\": " << DIRECTX_MATH_VERSION << ",\n";
+#endif
+#ifdef NDEBUG
+		os << "    \"build\": \"release\"\n";
+#else
+		os << "    \"build\": \"debug\"\n";
+#endif
+		os << "  },\n  \"benchmarks\": [";
+		for (size_t i = 0; i < m_Results.size(); ++i) {
+			const Result& r = m_Results[i];
+			os << (i ? ",\n" : "\n") << "    {\"name\": ";
+			WriteJsonString(os, r.name);
+			os << ", \"iterations\": " << r.iterations
+				<< ", \"items_per_iteration\": " << r.itemsPerIteration
+				<< ", \"samples\": " << r.samples
+				<< ", \"min_ns\": " << r.minNs
+				<< ", \"median_ns\": " << r.medianNs
+				<< ", \"mean_ns\": " << r.meanNs
+				<< ", \"p90_ns\": " << r.p90Ns
+				<< ", \"stddev_ns\": " << r.stddevNs
+				<< ", \"mad_ns\": " << r.madNs
+				<< ", \"ns_per_item\": " << (r.itemsPerIteration ? r.medianNs / r.itemsPerIteration : r.medianNs);
+			if (!r.counters.empty()) {
+				os << ", \"counters\": {";
+				for (size_t j = 0; j < r.counters.size(); ++j) {
+					os << (j ? ", " : "");
+					WriteJsonString(os, r.counters[j].first);
+					os << ": " << r.counters[j].second;
+				}
+				os << "}";
+			}
+			os << "}";
+		}
+		os << "\n  ],\n  \"checks\": [";
+		for (size_t i = 0; i < m_Checks.size(); ++i) {
+			os << (i ? ",\n" : "\n") << "    {\"name\": ";
+			WriteJsonString(os, m_Checks[i].name);
+			os << ", \"passed\": " << (m_Checks[i].passed ? "true" : "false") << "}";
+		}
+		os << "\n  ]\n}\n";
+	}
+}
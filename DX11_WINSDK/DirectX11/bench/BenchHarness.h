@@ -0,0 +1,93 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <functional>
+#include <ostream>
+
+namespace Bench {
+	// 防止编译器将被测代码优化掉
+#if defined(_MSC_VER) && !defined(__clang__)
+	void UseCharPointer(const volatile char* p);
+	template<class T>
+	inline void DoNotOptimize(const T& value) {
+		UseCharPointer(reinterpret_cast<const volatile char*>(&value));
+		_ReadWriteBarrier();
+	}
+	inline void ClobberMemory() { _ReadWriteBarrier(); }
+#else
+	template<class T>
+	inline void DoNotOptimize(const T& value) {
+		asm volatile("" : : "r,m"(value) : "memory");
+	}
+	inline void ClobberMemory() { asm volatile("" : : : "memory"); }
+#endif
+
+	struct Options {
+		std::string filter;				// 只运行名称包含该子串的用例
+		uint32_t samples = 25;			// 每个用例的采样数
+		uint32_t warmupSamples = 3;		// 预热采样数，不计入统计
+		double minSampleMs = 2.0;		// 单次采样的最短时间，用于确定迭代次数
+		std::string outputPath;			// 为空时JSON输出到stdout
+	};
+
+	// 统计量均为单次迭代耗时(纳秒)
+	struct Result {
+		std::string name;
+		uint64_t iterations;			// 每个采样的迭代次数
+		uint64_t itemsPerIteration;		// 每次迭代处理的元素数目(顶点、物体等)
+		uint32_t samples;
+		double minNs;
+		double medianNs;
+		double meanNs;
+		double p90Ns;
+		double stddevNs;
+		double madNs;					// 中位数绝对偏差，受离群值影响小
+		std::vector<std::pair<std::string, double>> counters;	// 用例附加的计数器
+	};
+
+	struct CheckResult {
+		std::string name;
+		bool passed;
+	};
+
+	class Harness {
+	public:
+		explicit Harness(const Options& options);
+
+		// func执行一次迭代，用例名称按"分组/名称/参数"组织
+		void Run(const std::string& name, uint64_t itemsPerIteration, const std::function<void()>& func);
+		// 为最近一次运行的用例附加计数器(如剔除率)
+		void AddCounter(const std::string& key, double value);
+		// 记录一项正确性检查，失败时输出到stderr，任何检查失败时程序以非零值退出
+		bool Check(const std::string& name, bool passed);
+
+		bool Matches(const std::string& name) const;
+		const std::vector<Result>& GetResults() const;
+		size_t GetFailedCheckCount() const;
+
+		void WriteJson(std::ostream& os) const;
+
+	private:
+		Options m_Options;
+		std::vector<Result> m_Results;
+		std::vector<CheckResult> m_Checks;
+	};
+
+	// 各模块的用例注册函数
+	void RunGeometryBenchmarks(Harness& harness);
+	void RunTransformBenchmarks(Harness& harness);
+	void RunCameraBenchmarks(Harness& harness);
+	void RunHierarchyBenchmarks(Harness& harness);
+	void RunMathBenchmarks(Harness& harness);
+	void RunAnimationBenchmarks(Harness& harness);
+	void RunSkinningBenchmarks(Harness& harness);
+	void RunCullingBenchmarks(Harness& harness);
+	void RunOcclusionBenchmarks(Harness& harness);
+	void RunShadowBenchmarks(Harness& harness);
+	void RunSpatialBenchmarks(Harness& harness);
+	void RunBroadphaseBenchmarks(Harness& harness);
+	void RunInstancingBenchmarks(Harness& harness);
+	void RunRenderQueueBenchmarks(Harness& harness);
+}
@@ -0,0 +1,66 @@
+#include "BenchHarness.h"
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+
+// 用法: DirectX11Bench [--filter 子串] [--samples N] [--min-sample-ms T] [--out 文件.json]
+int main(int argc, char* argv[]) {
+	Bench::Options options;
+	for (int i = 1; i < argc; ++i) {
+		const char* arg = argv[i];
+		const char* value = i + 1 < argc ? argv[i + 1] : nullptr;
+		if (strcmp(arg, "--filter") == 0 && value) {
+			options.filter = value; ++i;
+		}
+		else if (strcmp(arg, "--samples") == 0 && value) {
+			options.samples = static_cast<uint32_t>(strtoul(value, nullptr, 10)); ++i;
+		}
+		else if (strcmp(arg, "--min-sample-ms") == 0 && value) {
+			options.minSampleMs = strtod(value, nullptr); ++i;
+		}
+		else if (strcmp(arg, "--out") == 0 && value) {
+			options.outputPath = value; ++i;
+		}
+		else {
+			fprintf(stderr, "usage: %s [--filter name] [--samples n] [--min-sample-ms t] [--out file.json]\n", argv[0]);
+			return strcmp(arg, "--help") == 0 ? 0 : 1;
+		}
+	}
+
+	Bench::Harness harness(options);
+	Bench::RunGeometryBenchmarks(harness);
+	Bench::RunTransformBenchmarks(harness);
+	Bench::RunCameraBenchmarks(harness);
+	Bench::RunHierarchyBenchmarks(harness);
+	Bench::RunMathBenchmarks(harness);
+	Bench::RunAnimationBenchmarks(harness);
+	Bench::RunSkinningBenchmarks(harness);
+	Bench::RunCullingBenchmarks(harness);
+	Bench::RunOcclusionBenchmarks(harness);
+	Bench::RunShadowBenchmarks(harness);
+	Bench::RunSpatialBenchmarks(harness);
+	Bench::RunBroadphaseBenchmarks(harness);
+	Bench::RunInstancingBenchmarks(harness);
+	Bench::RunRenderQueueBenchmarks(harness);
+
+	if (options.outputPath.empty()) {
+		harness.WriteJson(std::cout);
+	}
+	else {
+		std::ofstream fout(options.outputPath);
+		if (!fout) {
+			fprintf(stderr, "failed to open %s\n", options.outputPath.c_str());
+			return 1;
+		}
+		harness.WriteJson(fout);
+	}
+
+	size_t failedChecks = harness.GetFailedCheckCount();
+	if (failedChecks > 0) {
+		fprintf(stderr, "%zu check(s) failed\n", failedChecks);
+		return 1;
+	}
+	return 0;
+}
@@ -0,0 +1,171 @@
+#include "BenchHarness.h"
+#include "SweepAndPrune.h"
+#include <algorithm>
+#include <cmath>
+#include <iterator>
+#include <vector>
+
+using namespace DirectX;
+
+namespace Bench {
+	namespace {
+		const uint32_t s_ObjectCount = 10000;
+		const float s_WorldHalfSize = 150.0f;
+		const uint32_t s_CheckFrames = 4;
+
+		// 物体绕y轴旋转的长方体，每帧沿各自速度移动一小段并旋转
+		struct MovingScene {
+			std::vector<XMFLOAT3> positions;
+			std::vector<XMFLOAT3> velocities;
+			std::vector<XMFLOAT3> extents;
+			std::vector<float> yaws;
+			std::vector<BoundingBox> boxes;
+			std::vector<BoundingOrientedBox> orientedBoxes;
+		};
+
+		float NextRandom(uint32_t& seed) {
+			seed = seed * 1664525u + 1013904223u;
+			return static_cast<float>(seed >> 8) / 16777216.0f;
+		}
+
+		void UpdateBounds(MovingScene& scene, uint32_t i) {
+			float c = fabsf(cosf(scene.yaws[i])), s = fabsf(sinf(scene.yaws[i]));
+			const XMFLOAT3& e = scene.extents[i];
+			scene.boxes[i] = BoundingBox(scene.positions[i], XMFLOAT3(c * e.x + s * e.z, e.y, s * e.x + c * e.z));
+			XMFLOAT4 orientation;
+			XMStoreFloat4(&orientation, XMQuaternionRotationRollPitchYaw(0.0f, scene.yaws[i], 0.0f));
+			scene.orientedBoxes[i] = BoundingOrientedBox(scene.positions[i], e, orientation);
+		}
+
+		void BuildScene(MovingScene& scene) {
+			uint32_t seed = 2024;
+			scene.positions.resize(s_ObjectCount);
+			scene.velocities.resize(s_ObjectCount);
+			scene.extents.resize(s_ObjectCount);
+			scene.yaws.resize(s_ObjectCount);
+			scene.boxes.resize(s_ObjectCount);
+			scene.orientedBoxes.resize(s_ObjectCount);
+			for (uint32_t i = 0; i < s_ObjectCount; ++i) {
+				scene.positions[i] = XMFLOAT3(2.0f * s_WorldHalfSize * NextRandom(seed) - s_WorldHalfSize, 20.0f * NextRandom(seed),
+					2.0f * s_WorldHalfSize * NextRandom(seed) - s_WorldHalfSize);
+				scene.velocities[i] = XMFLOAT3(0.4f * NextRandom(seed) - 0.2f, 0.0f, 0.4f * NextRandom(seed) - 0.2f);
+				scene.extents[i] = XMFLOAT3(0.5f + 2.0f * NextRandom(seed), 0.5f + NextRandom(seed), 0.2f + 0.5f * NextRandom(seed));
+				scene.yaws[i] = XM_2PI * NextRandom(seed);
+				UpdateBounds(scene, i);
+			}
+		}
+
+		void StepScene(MovingScene& scene) {
+			for (uint32_t i = 0; i < s_ObjectCount; ++i) {
+				XMFLOAT3& pos = scene.positions[i];
+				XMFLOAT3& velocity = scene.velocities[i];
+				if (fabsf(pos.x + velocity.x) > s_WorldHalfSize)
+					velocity.x = -velocity.x;
+				if (fabsf(pos.z + velocity.z) > s_WorldHalfSize)
+					velocity.z = -velocity.z;
+				pos.x += velocity.x;
+				pos.z += velocity.z;
+				scene.yaws[i] += 0.02f;
+				UpdateBounds(scene, i);
+			}
+		}
+
+		bool Overlaps(const BoundingBox& a, const BoundingBox& b) {
+			return a.Center.x - a.Extents.x <= b.Center.x + b.Extents.x && b.Center.x - b.Extents.x <= a.Center.x + a.Extents.x &&
+				a.Center.y - a.Extents.y <= b.Center.y + b.Extents.y && b.Center.y - b.Extents.y <= a.Center.y + a.Extents.y &&
+				a.Center.z - a.Extents.z <= b.Center.z + b.Extents.z && b.Center.z - b.Extents.z <= a.Center.z + a.Extents.z;
+		}
+
+		// O(n^2)的参考结果，与SweepAndPrune使用相同的最小/最大点比较
+		void BruteForceOverlaps(const std::vector<BoundingBox>& boxes, std::vector<SweepAndPrune::Pair>& pairs) {
+			pairs.clear();
+			for (uint32_t i = 0; i < boxes.size(); ++i) {
+				for (uint32_t j = i + 1; j < boxes.size(); ++j) {
+					if (Overlaps(boxes[i], boxes[j]))
+						pairs.push_back({ i, j });
+				}
+			}
+		}
+	}
+
+	void RunBroadphaseBenchmarks(Harness& harness) {
+		if (!harness.Matches("Broadphase/"))
+			return;
+
+		MovingScene scene;
+		BuildScene(scene);
+		SweepAndPrune sap;
+		std::vector<uint32_t> handles(s_ObjectCount);
+		const std::string count = std::to_string(s_ObjectCount);
+
+		harness.Run("Broadphase/SAP/Build:" + count, s_ObjectCount, [&]() {
+			sap.Clear();
+			for (uint32_t i = 0; i < s_ObjectCount; ++i)
+				handles[i] = sap.Add(scene.boxes[i], i);
+			sap.Update();
+			DoNotOptimize(sap.GetOverlapCount());
+		});
+		harness.AddCounter("pairs", static_cast<double>(sap.GetOverlapCount()));
+
+		// 逐帧检查重叠对与暴力结果一致，开始/结束事件等于前后两帧重叠对的差集
+		bool identical = true;
+		std::vector<SweepAndPrune::Pair> overlaps, previous, reference, expected;
+		BruteForceOverlaps(scene.boxes, previous);
+		for (uint32_t frame = 0; frame < s_CheckFrames; ++frame) {
+			for (uint32_t k = 0; k < 8; ++k)
+				StepScene(scene);
+			for (uint32_t i = 0; i < s_ObjectCount; ++i)
+				sap.SetBounds(handles[i], scene.boxes[i]);
+			sap.Update();
+			sap.GetOverlaps(overlaps);
+			BruteForceOverlaps(scene.boxes, reference);
+			identical = identical && overlaps == reference;
+			expected.clear();
+			std::set_difference(reference.begin(), reference.end(), previous.begin(), previous.end(), std::back_inserter(expected));
+			identical = identical && sap.GetBeginOverlaps() == expected;
+			expected.clear();
+			std::set_difference(previous.begin(), previous.end(), reference.begin(), reference.end(), std::back_inserter(expected));
+			identical = identical && sap.GetEndOverlaps() == expected;
+			previous.swap(reference);
+		}
+
+		size_t beginCount = 0, endCount = 0;
+		uint64_t swapCount = 0;
+		uint32_t frameCount = 0;
+		harness.Run("Broadphase/SAP/Update:" + count, s_ObjectCount, [&]() {
+			StepScene(scene);
+			for (uint32_t i = 0; i < s_ObjectCount; ++i)
+				sap.SetBounds(handles[i], scene.boxes[i]);
+			sap.Update();
+			beginCount += sap.GetBeginOverlaps().size();
+			endCount += sap.GetEndOverlaps().size();
+			swapCount += sap.GetSwapCount();
+			++frameCount;
+		});
+		harness.AddCounter("pairs", static_cast<double>(sap.GetOverlapCount()));
+		harness.AddCounter("begin_per_frame", static_cast<double>(beginCount) / frameCount);
+		harness.AddCounter("end_per_frame", static_cast<double>(endCount) / frameCount);
+		harness.AddCounter("swaps_per_frame", static_cast<double>(swapCount) / frameCount);
+		harness.Check("Broadphase/SAP/Update:identical", identical);
+
+		harness.Run("Broadphase/BruteForce:" + count, s_ObjectCount, [&]() {
+			BruteForceOverlaps(scene.boxes, reference);
+			DoNotOptimize(reference.size());
+		});
+
+		// 窄阶段预筛选，与逐对直接做有向包围盒测试比较
+		sap.GetOverlaps(overlaps);
+		std::vector<SweepAndPrune::Pair> filtered;
+		expected.clear();
+		for (const SweepAndPrune::Pair& pair : overlaps) {
+			if (scene.orientedBoxes[pair.first].Intersects(scene.orientedBoxes[pair.second]))
+				expected.push_back(pair);
+		}
+		harness.Run("Broadphase/OrientedBoxFilter", overlaps.size(), [&]() {
+			SweepAndPrune::FilterOverlaps(overlaps, scene.orientedBoxes.data(), filtered);
+			DoNotOptimize(filtered.size());
+		});
+		harness.AddCounter("pass_ratio", overlaps.empty() ? 0.0 : static_cast<double>(filtered.size()) / overlaps.size());
+		harness.Check("Broadphase/OrientedBoxFilter:identical", filtered == expected);
+	}
+}
@@ -0,0 +1,127 @@
+#include "BenchHarness.h"
+#include "Camera.h"
+#include <cmath>
+
+using namespace DirectX;
+
+namespace Bench {
+	namespace {
+		// 远离世界原点时，以相机为原点的世界矩阵配合只含旋转的观察矩阵，结果应与双精度计算一致
+		// (同样的场景用绝对世界矩阵时，单精度平移在1e7处的舍入误差可达0.5)
+		bool CheckCameraRelative() {
+			const Double3 cameraPos(1.0e7 + 0.3, 52.7, -3.0e6 + 0.45);
+			const Double3 objectPos(cameraPos.x + 3.3, cameraPos.y - 1.7, cameraPos.z + 12.9);
+			FirstPersonCamera camera;
+			camera.SetFrustum(XM_PI / 3, 16.0f / 9.0f, 0.5f, 1000.0f);
+			camera.LookAt(cameraPos, objectPos, XMFLOAT3(0.0f, 1.0f, 0.0f));
+
+			Transform object;
+			object.SetScale(1.5f, 0.5f, 2.0f);
+			object.SetRotation(0.3f, -1.1f, 0.7f);
+			object.SetPosition(objectPos);
+
+			XMMATRIX World = object.GetLocalToWorldMatrixXM(camera.GetPositionDouble());
+			XMFLOAT4X4 world, view, proj;
+			XMStoreFloat4x4(&world, object.GetLocalToWorldMatrixXM());
+			XMStoreFloat4x4(&view, camera.GetViewRelativeXM());
+			XMStoreFloat4x4(&proj, camera.GetProjXM());
+
+			const XMFLOAT3 vertices[] = { XMFLOAT3(0.5f, -0.25f, 0.75f), XMFLOAT3(-1.0f, 1.0f, -1.0f), XMFLOAT3() };
+			for (const XMFLOAT3& v : vertices) {
+				// 双精度参考：旋转缩放用单精度矩阵的元素，平移直接以双精度相减
+				const double local[3] = { v.x, v.y, v.z };
+				const double offset[3] = { objectPos.x - cameraPos.x, objectPos.y - cameraPos.y, objectPos.z - cameraPos.z };
+				double rel[4] = { 0.0, 0.0, 0.0, 1.0 }, viewPos[4] = {}, clipPos[4] = {};
+				for (int j = 0; j < 3; ++j) {
+					rel[j] = offset[j];
+					for (int i = 0; i < 3; ++i)
+						rel[j] += local[i] * world.m[i][j];
+				}
+				for (int j = 0; j < 4; ++j) {
+					for (int i = 0; i < 4; ++i)
+						viewPos[j] += rel[i] * view.m[i][j];
+				}
+				for (int j = 0; j < 4; ++j) {
+					for (int i = 0; i < 4; ++i)
+						clipPos[j] += viewPos[i] * proj.m[i][j];
+				}
+
+				XMFLOAT4 viewResult, clipResult;
+				XMStoreFloat4(&viewResult, XMVector3Transform(XMLoadFloat3(&v), World * camera.GetViewRelativeXM()));
+				XMStoreFloat4(&clipResult, XMVector3Transform(XMLoadFloat3(&v), World * camera.GetViewProjRelativeXM()));
+				const float viewError[] = { viewResult.x - float(viewPos[0]), viewResult.y - float(viewPos[1]), viewResult.z - float(viewPos[2]) };
+				const float clipError[] = { clipResult.x - float(clipPos[0]), clipResult.y - float(clipPos[1]), clipResult.w - float(clipPos[3]) };
+				for (int i = 0; i < 3; ++i) {
+					if (fabsf(viewError[i]) > 1e-4f || fabsf(clipError[i]) > 1e-4f)
+						return false;
+				}
+			}
+			return true;
+		}
+	}
+
+	void RunCameraBenchmarks(Harness& harness) {
+		harness.Check("Camera/CameraRelative:far_from_origin", CheckCameraRelative());
+
+		FirstPersonCamera fpCamera;
+		fpCamera.SetFrustum(XM_PI / 3, 16.0f / 9.0f, 0.5f, 1000.0f);
+		fpCamera.LookAt(XMFLOAT3(0.0f, 5.0f, -10.0f), XMFLOAT3(0.0f, 0.0f, 0.0f), XMFLOAT3(0.0f, 1.0f, 0.0f));
+
+		ThirdPersonCamera tpCamera;
+		tpCamera.SetFrustum(XM_PI / 3, 16.0f / 9.0f, 0.5f, 1000.0f);
+		tpCamera.SetTarget(XMFLOAT3(0.0f, 0.5f, 0.0f));
+		tpCamera.SetDistance(8.0f);
+		tpCamera.SetDistanceMinMax(3.0f, 20.0f);
+		tpCamera.SetRotationX(XM_PIDIV4 / 2);
+
+		XMFLOAT4X4 result;
+		harness.Run("Camera/FirstPerson/GetViewXM", 1, [&]() {
+			XMStoreFloat4x4(&result, fpCamera.GetViewXM());
+			DoNotOptimize(result);
+		});
+		harness.Run("Camera/FirstPerson/GetProjXM", 1, [&]() {
+			XMStoreFloat4x4(&result, fpCamera.GetProjXM());
+			DoNotOptimize(result);
+		});
+		harness.Run("Camera/FirstPerson/GetViewProjXM", 1, [&]() {
+			XMStoreFloat4x4(&result, fpCamera.GetViewProjXM());
+			DoNotOptimize(result);
+		});
+		harness.Run("Camera/ThirdPerson/GetViewProjXM", 1, [&]() {
+			XMStoreFloat4x4(&result, tpCamera.GetViewProjXM());
+			DoNotOptimize(result);
+		});
+
+		// 每帧典型的相机更新后取矩阵
+		harness.Run("Camera/FirstPerson/UpdateAndGetViewProjXM", 1, [&]() {
+			fpCamera.RotateY(0.001f);
+			fpCamera.Pitch(0.0005f);
+			fpCamera.Walk(0.01f);
+			XMStoreFloat4x4(&result, fpCamera.GetViewProjXM());
+			DoNotOptimize(result);
+		});
+		harness.Run("Camera/ThirdPerson/UpdateAndGetViewProjXM", 1, [&]() {
+			tpCamera.RotateY(0.001f);
+			tpCamera.Approach(0.0f);
+			XMStoreFloat4x4(&result, tpCamera.GetViewProjXM());
+			DoNotOptimize(result);
+		});
+
+		// 一帧内多个系统(常量缓冲区、剔除、阴影等)反复读取同一相机的矩阵与视锥体
+		harness.Run("Camera/FirstPerson/UpdateAndReadFrame", 1, [&]() {
+			fpCamera.RotateY(0.001f);
+			for (int i = 0; i < 4; ++i) {
+				XMStoreFloat4x4(&result, fpCamera.GetViewXM());
+				DoNotOptimize(result);
+				XMStoreFloat4x4(&result, fpCamera.GetProjXM());
+				DoNotOptimize(result);
+				XMStoreFloat4x4(&result, fpCamera.GetViewProjXM());
+				DoNotOptimize(result);
+				XMStoreFloat4x4(&result, fpCamera.GetInvViewProjXM());
+				DoNotOptimize(result);
+				Culling::FrustumPlanes planes = fpCamera.GetFrustumPlanes();
+				DoNotOptimize(planes);
+			}
+		});
+	}
+}
@@ -0,0 +1,98 @@
+#include "BenchHarness.h"
+#include "Camera.h"
+#include "JobSystem.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <vector>
+
+using namespace DirectX;
+
+namespace Bench {
+	namespace {
+		const uint32_t s_ObjectCount = 1000000;
+
+		// 物体均匀分布在2000x100x2000的区域内，相机位于中心附近
+		void BuildScene(Culling::BoundingSphereSoA& spheres, Culling::BoundingBoxSoA& boxes) {
+			spheres.Reserve(s_ObjectCount);
+			boxes.Reserve(s_ObjectCount);
+			uint32_t seed = 2024;
+			auto next = [&seed]() {
+				seed = seed * 1664525u + 1013904223u;
+				return static_cast<float>(seed >> 8) / 16777216.0f;
+			};
+			for (uint32_t i = 0; i < s_ObjectCount; ++i) {
+				XMFLOAT3 center(2000.0f * next() - 1000.0f, 100.0f * next() - 50.0f, 2000.0f * next() - 1000.0f);
+				float radius = 0.5f + 4.5f * next();
+				spheres.Add(center, radius);
+				boxes.Add(center, XMFLOAT3(radius, 0.5f * radius, radius));
+			}
+		}
+	}
+
+	void RunCullingBenchmarks(Harness& harness) {
+		Culling::BoundingSphereSoA spheres;
+		Culling::BoundingBoxSoA boxes;
+		BuildScene(spheres, boxes);
+
+		FirstPersonCamera camera;
+		camera.SetFrustum(XM_PI / 3, 16.0f / 9.0f, 0.5f, 1000.0f);
+		camera.LookAt(XMFLOAT3(0.0f, 10.0f, 0.0f), XMFLOAT3(100.0f, 0.0f, 300.0f), XMFLOAT3(0.0f, 1.0f, 0.0f));
+		Culling::FrustumPlanes frustum = camera.GetFrustumPlanes();
+
+		// 反向Z的投影矩阵提取出的平面应与标准Z相同，远平面的距离按相对误差比较(标准Z在远处本身就有舍入误差)
+		{
+			camera.SetReverseZ(true);
+			const Culling::FrustumPlanes& reversed = camera.GetFrustumPlanes();
+			bool same = true;
+			for (int p = 0; p < 6; ++p) {
+				const XMFLOAT4& a = reversed.planes[p];
+				const XMFLOAT4& b = frustum.planes[p];
+				same = same && XMVector3NearEqual(XMLoadFloat4(&a), XMLoadFloat4(&b), XMVectorReplicate(1e-4f)) &&
+					fabsf(a.w - b.w) <= 1e-3f * (std::max)(1.0f, fabsf(b.w));
+			}
+			harness.Check("Culling/ReverseZPlanes", same);
+			camera.SetReverseZ(false);
+		}
+
+		const std::string count = std::to_string(s_ObjectCount);
+		std::vector<uint32_t> serialSpheres(s_ObjectCount), serialBoxes(s_ObjectCount);
+		size_t visibleSpheres = 0, visibleBoxes = 0;
+
+		harness.Run("Culling/Spheres/" + count, s_ObjectCount, [&]() {
+			visibleSpheres = Culling::CullSpheres(frustum, spheres, serialSpheres.data());
+			DoNotOptimize(visibleSpheres);
+		});
+		harness.AddCounter("visible_ratio", static_cast<double>(visibleSpheres) / s_ObjectCount);
+		harness.Run("Culling/Boxes/" + count, s_ObjectCount, [&]() {
+			visibleBoxes = Culling::CullBoxes(frustum, boxes, serialBoxes.data());
+			DoNotOptimize(visibleBoxes);
+		});
+		harness.AddCounter("visible_ratio", static_cast<double>(visibleBoxes) / s_ObjectCount);
+
+		// 多线程剔除，检查结果与单线程相同
+		std::vector<uint32_t> parallelVisible(s_ObjectCount);
+		const uint32_t threadCounts[] = { 1, 2, 4, 8, 16, 32 };
+		for (uint32_t threadCount : threadCounts) {
+			std::string suffix = count + "/threads:" + std::to_string(threadCount);
+			if (!harness.Matches("Culling/ParallelSpheres/" + suffix) && !harness.Matches("Culling/ParallelBoxes/" + suffix))
+				continue;
+			JobSystem jobSystem(threadCount);
+			size_t visible = 0;
+
+			harness.Run("Culling/ParallelSpheres/" + suffix, s_ObjectCount, [&]() {
+				visible = Culling::CullSpheres(jobSystem, frustum, spheres, parallelVisible.data());
+				DoNotOptimize(visible);
+			});
+			harness.Check("Culling/ParallelSpheres/" + suffix + ":identical", visible == visibleSpheres &&
+				memcmp(parallelVisible.data(), serialSpheres.data(), visible * sizeof(uint32_t)) == 0);
+
+			harness.Run("Culling/ParallelBoxes/" + suffix, s_ObjectCount, [&]() {
+				visible = Culling::CullBoxes(jobSystem, frustum, boxes, parallelVisible.data());
+				DoNotOptimize(visible);
+			});
+			harness.Check("Culling/ParallelBoxes/" + suffix + ":identical", visible == visibleBoxes &&
+				memcmp(parallelVisible.data(), serialBoxes.data(), visible * sizeof(uint32_t)) == 0);
+		}
+	}
+}
@@ -0,0 +1,211 @@
+#include "BenchHarness.h"
+#include "Geometry.h"
+#include <cmath>
+#include <cfloat>
+#include <vector>
+
+using namespace DirectX;
+
+namespace Bench {
+	namespace {
+		std::string Name(const char* func, UINT tess) {
+			return std::string("Geometry/") + func + "/" + std::to_string(tess);
+		}
+
+		template<class MeshDataType>
+		uint64_t VertexCount(const MeshDataType& meshData) {
+			return meshData.vertexVec.size();
+		}
+
+		float Random(uint32_t& seed, float minValue, float maxValue) {
+			seed = seed * 1664525u + 1013904223u;
+			return minValue + (maxValue - minValue) * (static_cast<float>(seed >> 8) / 16777216.0f);
+		}
+
+		// 批量查询与逐点查询的结果应一致，count不是4的倍数时覆盖标量处理的尾部
+		bool CheckTerrainBatch(const TerrainField& field, size_t count) {
+			// 点的范围略大于地形，覆盖钳制到边界的情况
+			uint32_t seed = 99u + static_cast<uint32_t>(count);
+			float halfWidth = 0.6f * field.GetWidth(), halfDepth = 0.6f * field.GetDepth();
+			std::vector<XMFLOAT2> positions(count);
+			for (XMFLOAT2& p : positions)
+				p = XMFLOAT2(Random(seed, -halfWidth, halfWidth), Random(seed, -halfDepth, halfDepth));
+
+			std::vector<float> heights(count), heightsOnly(count);
+			std::vector<XMFLOAT3> normals(count);
+			field.GetHeightsAndNormals(positions.data(), heights.data(), normals.data(), count);
+			field.GetHeights(positions.data(), heightsOnly.data(), count);
+			for (size_t i = 0; i < count; ++i) {
+				float h = field.GetHeight(positions[i].x, positions[i].y);
+				XMVECTOR n = field.GetNormalXM(positions[i].x, positions[i].y);
+				float tolerance = 1e-4f * (std::max)(1.0f, fabsf(h));
+				if (fabsf(heights[i] - h) > tolerance || fabsf(heightsOnly[i] - h) > tolerance ||
+					!XMVector3NearEqual(XMLoadFloat3(&normals[i]), n, XMVectorReplicate(1e-4f)))
+					return false;
+			}
+			return true;
+		}
+
+		// 沿线段细分步进求首个穿入双线性曲面的参数，再二分细化；未穿入但离曲面不足epsilon的线段视为无法判定
+		enum class MarchResult { Hit, Miss, Ambiguous };
+		MarchResult MarchSegment(const TerrainField& field, const XMFLOAT3& p0, const XMFLOAT3& p1, float& t) {
+			const int steps = 20000;
+			const float epsilon = 1e-3f;
+			auto clearance = [&](float s) {
+				float x = p0.x + (p1.x - p0.x) * s, y = p0.y + (p1.y - p0.y) * s, z = p0.z + (p1.z - p0.z) * s;
+				return field.Contains(x, z) ? y - field.GetHeight(x, z) : FLT_MAX;
+			};
+			float minClearance = FLT_MAX;
+			for (int k = 0; k <= steps; ++k) {
+				float s = static_cast<float>(k) / steps;
+				float c = clearance(s);
+				minClearance = (std::min)(minClearance, c);
+				if (c > 0.0f)
+					continue;
+				float lo = k > 0 ? static_cast<float>(k - 1) / steps : 0.0f, hi = s;
+				for (int i = 0; i < 32 && k > 0; ++i) {
+					float mid = 0.5f * (lo + hi);
+					(clearance(mid) > 0.0f ? lo : hi) = mid;
+				}
+				t = hi;
+				return MarchResult::Hit;
+			}
+			return minClearance < epsilon ? MarchResult::Ambiguous : MarchResult::Miss;
+		}
+
+		bool CheckTerrainIntersect(const TerrainField& field, const std::vector<XMFLOAT3>& p0, const std::vector<XMFLOAT3>& p1,
+			size_t& hitCount) {
+			std::vector<float> batchT(p0.size());
+			size_t batchHits = field.IntersectSegments(p0.data(), p1.data(), batchT.data(), p0.size());
+			hitCount = 0;
+			for (size_t i = 0; i < p0.size(); ++i) {
+				float t = FLT_MAX, refT = FLT_MAX;
+				bool hit = field.IntersectSegment(p0[i], p1[i], t);
+				hitCount += hit ? 1 : 0;
+				if (batchT[i] != t)
+					return false;
+				MarchResult result = MarchSegment(field, p0[i], p1[i], refT);
+				if (result == MarchResult::Ambiguous)
+					continue;
+				if (hit != (result == MarchResult::Hit) || (hit && fabsf(t - refT) > 1e-3f))
+					return false;
+			}
+			return batchHits == hitCount;
+		}
+
+		void CheckTerrainField(Harness& harness, const std::function<float(float, float)>& heightFunc) {
+			TerrainField field(160.0f, 120.0f, 48, 40, heightFunc);
+			const size_t batchCounts[] = { 1, 3, 4, 7, 1001, 1024 };
+			for (size_t count : batchCounts)
+				harness.Check("Geometry/TerrainField:batch_matches_scalar/" + std::to_string(count), CheckTerrainBatch(field, count));
+
+			const float halfWidth = 0.5f * field.GetWidth(), halfDepth = 0.5f * field.GetDepth();
+			std::vector<XMFLOAT3> p0, p1;
+			// 随机线段，端点高度覆盖地形的高度范围，部分起点在地形之外
+			uint32_t seed = 4242;
+			for (int i = 0; i < 300; ++i) {
+				p0.push_back(XMFLOAT3(Random(seed, -90.0f, 90.0f), Random(seed, -10.0f, 60.0f), Random(seed, -70.0f, 70.0f)));
+				p1.push_back(XMFLOAT3(Random(seed, -90.0f, 90.0f), Random(seed, -60.0f, 10.0f), Random(seed, -70.0f, 70.0f)));
+			}
+			// 竖直线段，包括落在网格线与地形边缘上的
+			for (int i = 0; i <= 8; ++i) {
+				float x = -halfWidth + field.GetWidth() * i / 8, z = -halfDepth + field.GetDepth() * (8 - i) / 8;
+				p0.push_back(XMFLOAT3(x, 60.0f, z));
+				p1.push_back(XMFLOAT3(x, -60.0f, z));
+			}
+			// 沿地形四条边的线段
+			const float edgeX[] = { -halfWidth, halfWidth }, edgeZ[] = { -halfDepth, halfDepth };
+			for (float x : edgeX) {
+				p0.push_back(XMFLOAT3(x, 50.0f, -halfDepth));
+				p1.push_back(XMFLOAT3(x, -50.0f, halfDepth));
+			}
+			for (float z : edgeZ) {
+				p0.push_back(XMFLOAT3(-halfWidth, 50.0f, z));
+				p1.push_back(XMFLOAT3(halfWidth, -50.0f, z));
+			}
+			size_t hitCount = 0;
+			bool matches = CheckTerrainIntersect(field, p0, p1, hitCount);
+			// 命中与未命中两种情况都须覆盖到
+			harness.Check("Geometry/TerrainField:intersect_matches_march", matches && hitCount > 0 && hitCount < p0.size());
+		}
+	}
+
+	void RunGeometryBenchmarks(Harness& harness) {
+		const UINT tessellations[] = { 8, 32, 128 };
+
+		for (UINT n : tessellations) {
+			uint64_t items = VertexCount(Geometry::CreateSphere(1.0f, n, n));
+			harness.Run(Name("CreateSphere", n), items, [n]() {
+				DoNotOptimize(Geometry::CreateSphere(1.0f, n, n));
+			});
+			harness.Run(Name("CreateSphere<PosNormalTangentTex>", n), items, [n]() {
+				DoNotOptimize(Geometry::CreateSphere<VertexPosNormalTangentTex>(1.0f, n, n));
+			});
+		}
+
+		harness.Run("Geometry/CreateBox", VertexCount(Geometry::CreateBox()), []() {
+			DoNotOptimize(Geometry::CreateBox());
+		});
+
+		for (UINT n : tessellations) {
+			uint64_t items = VertexCount(Geometry::CreateCylinder(1.0f, 2.0f, n, n));
+			harness.Run(Name("CreateCylinder", n), items, [n]() {
+				DoNotOptimize(Geometry::CreateCylinder(1.0f, 2.0f, n, n));
+			});
+			items = VertexCount(Geometry::CreateCylinderNoCap(1.0f, 2.0f, n, n));
+			harness.Run(Name("CreateCylinderNoCap", n), items, [n]() {
+				DoNotOptimize(Geometry::CreateCylinderNoCap(1.0f, 2.0f, n, n));
+			});
+		}
+
+		for (UINT n : tessellations) {
+			uint64_t items = VertexCount(Geometry::CreateCone(1.0f, 2.0f, n));
+			harness.Run(Name("CreateCone", n), items, [n]() {
+				DoNotOptimize(Geometry::CreateCone(1.0f, 2.0f, n));
+			});
+			items = VertexCount(Geometry::CreateConeNoCap(1.0f, 2.0f, n));
+			harness.Run(Name("CreateConeNoCap", n), items, [n]() {
+				DoNotOptimize(Geometry::CreateConeNoCap(1.0f, 2.0f, n));
+			});
+		}
+
+		harness.Run("Geometry/Create2DShow", VertexCount(Geometry::Create2DShow()), []() {
+			DoNotOptimize(Geometry::Create2DShow());
+		});
+		harness.Run("Geometry/CreatePlane", VertexCount(Geometry::CreatePlane()), []() {
+			DoNotOptimize(Geometry::CreatePlane());
+		});
+
+		auto heightFunc = [](float x, float z) { return 0.3f * (z * sinf(0.1f * x) + x * cosf(0.1f * z)); };
+		CheckTerrainField(harness, heightFunc);
+
+		// 宽度或深度为0的地形退化为一条线，法向量不应出现NaN
+		{
+			TerrainField line(0.0f, 16.0f, 4, 4, heightFunc);
+			auto meshData = Geometry::CreateTerrain(line);
+			bool finite = true;
+			for (const auto& vertex : meshData.vertexVec)
+				finite = finite && std::isfinite(vertex.normal.x) && std::isfinite(vertex.normal.y) && std::isfinite(vertex.normal.z);
+			harness.Check("Geometry/TerrainField:zero_width_normals", finite);
+		}
+		auto normalFunc = [](float x, float z) {
+			return XMFLOAT3(-0.03f * z * cosf(0.1f * x) - 0.3f * cosf(0.1f * z), 1.0f,
+				-0.3f * sinf(0.1f * x) + 0.03f * x * sinf(0.1f * z));
+		};
+		const UINT terrainSlices[] = { 16, 64, 256 };
+		for (UINT n : terrainSlices) {
+			uint64_t items = (n + 1) * (n + 1);
+			harness.Run(Name("CreateTerrain", n), items, [=]() {
+				DoNotOptimize(Geometry::CreateTerrain(160.0f, 160.0f, n, n, 1.0f, 1.0f, heightFunc, normalFunc));
+			});
+			harness.Run(Name("TerrainField::Init", n), items, [=]() {
+				TerrainField field(160.0f, 160.0f, n, n, heightFunc);
+				DoNotOptimize(field);
+			});
+			TerrainField field(160.0f, 160.0f, n, n, heightFunc);
+			harness.Run(Name("CreateTerrain<TerrainField>", n), items, [&field]() {
+				DoNotOptimize(Geometry::CreateTerrain(field));
+			});
+		}
+	}
+}
@@ -0,0 +1,90 @@
+#include "BenchHarness.h"
+#include "TransformHierarchy.h"
+#include "JobSystem.h"
+#include <cstring>
+#include <vector>
+
+using namespace DirectX;
+
+namespace Bench {
+	namespace {
+		// 每个根节点下有10个子节点，每个子节点下有9个叶节点，共101个节点
+		void BuildScene(TransformHierarchy& hierarchy, uint32_t rootCount, std::vector<TransformHierarchy::NodeHandle>& roots,
+			std::vector<TransformHierarchy::NodeHandle>& allNodes) {
+			const XMFLOAT3 unitScale(1.0f, 1.0f, 1.0f);
+			hierarchy.Reserve(rootCount * 101);
+			for (uint32_t r = 0; r < rootCount; ++r) {
+				float fr = static_cast<float>(r);
+				XMFLOAT4 rotation;
+				XMStoreFloat4(&rotation, XMQuaternionRotationRollPitchYaw(0.0f, 0.01f * fr, 0.0f));
+				auto root = hierarchy.AddNode(TransformHierarchy::InvalidHandle, unitScale, rotation, XMFLOAT3(fr, 0.0f, -fr));
+				roots.push_back(root);
+				allNodes.push_back(root);
+				for (uint32_t c = 0; c < 10; ++c) {
+					XMStoreFloat4(&rotation, XMQuaternionRotationRollPitchYaw(0.1f * c, 0.0f, 0.05f * c));
+					auto child = hierarchy.AddNode(root, XMFLOAT3(0.9f, 0.9f, 0.9f), rotation, XMFLOAT3(1.0f, 0.5f * c, 0.0f));
+					allNodes.push_back(child);
+					for (uint32_t l = 0; l < 9; ++l) {
+						XMStoreFloat4(&rotation, XMQuaternionRotationRollPitchYaw(0.0f, 0.2f * l, 0.0f));
+						allNodes.push_back(hierarchy.AddNode(child, unitScale, rotation, XMFLOAT3(0.0f, 0.0f, 0.3f * l)));
+					}
+				}
+			}
+			hierarchy.UpdateWorldMatrices();
+		}
+	}
+
+	void RunHierarchyBenchmarks(Harness& harness) {
+		const uint32_t rootCount = 1000;
+		TransformHierarchy hierarchy;
+		std::vector<TransformHierarchy::NodeHandle> roots, allNodes;
+		BuildScene(hierarchy, rootCount, roots, allNodes);
+		const uint64_t nodeCount = hierarchy.GetNodeCount();
+		const std::string count = std::to_string(nodeCount);
+
+		// 所有根节点都移动，整个层级需要重新计算
+		harness.Run("Hierarchy/UpdateAllDirty/" + count, nodeCount, [&]() {
+			for (auto root : roots)
+				hierarchy.SetLocalPosition(root, hierarchy.GetLocalPosition(root));
+			hierarchy.UpdateWorldMatrices();
+			DoNotOptimize(hierarchy.GetWorldMatrices());
+		});
+
+		// 约1%的节点移动
+		harness.Run("Hierarchy/UpdateSparseDirty/" + count, nodeCount, [&]() {
+			for (size_t i = 0; i < allNodes.size(); i += 97)
+				hierarchy.SetLocalPosition(allNodes[i], hierarchy.GetLocalPosition(allNodes[i]));
+			hierarchy.UpdateWorldMatrices();
+			DoNotOptimize(hierarchy.GetWorldMatrices());
+		});
+
+		// 多线程更新，线程数从1到32；同时检查结果与单线程逐位相同
+		TransformHierarchy serial = hierarchy;
+		for (auto root : roots)
+			serial.SetLocalPosition(root, serial.GetLocalPosition(root));
+		serial.UpdateWorldMatrices();
+		const uint32_t threadCounts[] = { 1, 2, 4, 8, 16, 32 };
+		for (uint32_t threadCount : threadCounts) {
+			std::string name = "Hierarchy/ParallelUpdateAllDirty/" + count + "/threads:" + std::to_string(threadCount);
+			if (!harness.Matches(name))
+				continue;
+			JobSystem jobSystem(threadCount);
+			TransformHierarchy parallel = hierarchy;
+			harness.Run(name, nodeCount, [&]() {
+				for (auto root : roots)
+					parallel.SetLocalPosition(root, parallel.GetLocalPosition(root));
+				parallel.UpdateWorldMatrices(jobSystem);
+				DoNotOptimize(parallel.GetWorldMatrices());
+			});
+			bool identical = memcmp(serial.GetWorldMatrices(), parallel.GetWorldMatrices(),
+				sizeof(XMFLOAT4X4A) * nodeCount) == 0;
+			harness.Check(name + ":bit_identical", identical);
+		}
+
+		// 没有节点移动，只有跳过子树的开销
+		harness.Run("Hierarchy/UpdateClean/" + count, nodeCount, [&]() {
+			hierarchy.UpdateWorldMatrices();
+			DoNotOptimize(hierarchy.GetWorldMatrices());
+		});
+	}
+}
@@ -0,0 +1,168 @@
+#include "BenchHarness.h"
+#include "InstanceBatcher.h"
+#include "MathHelper.h"
+#include <cstring>
+#include <map>
+#include <tuple>
+#include <vector>
+
+using namespace DirectX;
+
+namespace Bench {
+	namespace {
+		const uint32_t s_ObjectCount = 100000;
+		const uint32_t s_MeshCount = 24;
+		const uint32_t s_TextureCount = 4;
+		const uint32_t s_MaterialCount = 3;
+
+		// 网格与纹理在合批时只作为键，用数组元素的地址代替
+		char s_MeshKeys[s_MeshCount];
+		char s_TextureKeys[s_TextureCount];
+
+		struct Prop {
+			uint32_t mesh, texture, material;
+			XMFLOAT4X4 world;
+		};
+
+		float NextRandom(uint32_t& seed) {
+			seed = seed * 1664525u + 1013904223u;
+			return static_cast<float>(seed >> 8) / 16777216.0f;
+		}
+
+		const MeshResource* MeshKey(uint32_t i) { return reinterpret_cast<const MeshResource*>(&s_MeshKeys[i]); }
+		ID3D11ShaderResourceView* TextureKey(uint32_t i) { return reinterpret_cast<ID3D11ShaderResourceView*>(&s_TextureKeys[i]); }
+
+		Material MakeMaterial(uint32_t i) {
+			float c = 0.25f * (i + 1);
+			return Material(XMFLOAT4(c, c, c, 1.0f), XMFLOAT4(c, 0.5f, 0.5f, 1.0f), XMFLOAT4(0.2f, 0.2f, 0.2f, 8.0f), XMFLOAT4());
+		}
+
+		// 重复摆放的道具：少量网格/纹理/材质组合，位置、朝向与等比缩放各不相同
+		void BuildProps(std::vector<Prop>& props, uint32_t count, uint32_t seed) {
+			props.resize(count);
+			for (Prop& prop : props) {
+				prop.mesh = static_cast<uint32_t>(NextRandom(seed) * s_MeshCount) % s_MeshCount;
+				prop.texture = static_cast<uint32_t>(NextRandom(seed) * s_TextureCount) % s_TextureCount;
+				prop.material = static_cast<uint32_t>(NextRandom(seed) * s_MaterialCount) % s_MaterialCount;
+				XMMATRIX W = XMMatrixScaling(0.5f + NextRandom(seed), 0.5f + NextRandom(seed), 0.5f + NextRandom(seed)) *
+					XMMatrixRotationY(XM_2PI * NextRandom(seed)) *
+					XMMatrixTranslation(400.0f * NextRandom(seed) - 200.0f, 0.0f, 400.0f * NextRandom(seed) - 200.0f);
+				XMStoreFloat4x4(&prop.world, W);
+			}
+		}
+
+		bool SameMatrix(const XMFLOAT4X4& a, XMMATRIX b) {
+			XMFLOAT4X4 m;
+			XMStoreFloat4x4(&m, b);
+			return memcmp(&a, &m, sizeof(m)) == 0;
+		}
+
+		// 按键分组的参考结果：每个批次须对应一个组，批次按各组首次提交的顺序排列，批次内的实例按提交顺序连续存放
+		bool CheckBatches(const InstanceBatcher& batcher, const std::vector<Prop>& props, const Material* materials) {
+			std::map<std::tuple<uint32_t, uint32_t, uint32_t>, std::vector<uint32_t>> groups;
+			for (uint32_t i = 0; i < props.size(); ++i)
+				groups[std::make_tuple(props[i].mesh, props[i].texture, props[i].material)].push_back(i);
+
+			const std::vector<InstanceBatcher::Batch>& batches = batcher.GetBatches();
+			const std::vector<InstancedData>& instanceData = batcher.GetInstanceData();
+			if (batches.size() != groups.size() || instanceData.size() != props.size())
+				return false;
+
+			uint32_t next = 0;
+			int64_t lastFirstItem = -1;
+			for (const InstanceBatcher::Batch& batch : batches) {
+				if (batch.startInstance != next)
+					return false;
+				next += batch.instanceCount;
+				uint32_t mesh = static_cast<uint32_t>(reinterpret_cast<const char*>(batch.mesh) - s_MeshKeys);
+				uint32_t texture = static_cast<uint32_t>(reinterpret_cast<const char*>(batch.texture) - s_TextureKeys);
+				uint32_t material = 0;
+				while (material < s_MaterialCount && memcmp(&materials[material], &batch.material, sizeof(Material)) != 0)
+					++material;
+				auto it = groups.find(std::make_tuple(mesh, texture, material));
+				if (it == groups.end() || it->second.size() != batch.instanceCount || it->second[0] <= lastFirstItem)
+					return false;
+				lastFirstItem = it->second[0];
+				for (uint32_t k = 0; k < batch.instanceCount; ++k) {
+					const Prop& prop = props[it->second[k]];
+					XMMATRIX W = XMLoadFloat4x4(&prop.world);
+					const InstancedData& data = instanceData[batch.startInstance + k];
+					if (!SameMatrix(data.world, XMMatrixTranspose(W)) ||
+						!SameMatrix(data.worldInvTranspose, XMMatrixTranspose(InverseTranspose(W))))
+						return false;
+				}
+				groups.erase(it);
+			}
+			return groups.empty();
+		}
+
+		void Submit(InstanceBatcher& batcher, const std::vector<Prop>& props, const Material* materials) {
+			batcher.Clear();
+			for (const Prop& prop : props)
+				batcher.Add(MeshKey(prop.mesh), TextureKey(prop.texture), materials[prop.material], XMLoadFloat4x4(&prop.world));
+			batcher.Build();
+		}
+
+		// 合批与实例数组打包的正确性，不受--filter影响
+		void CheckInstancing(Harness& harness, const Material* materials) {
+			InstanceBatcher batcher;
+			std::vector<Prop> props;
+			Submit(batcher, props, materials);
+			harness.Check("Instancing/Check/Empty", batcher.GetBatches().empty() && batcher.GetInstanceData().empty());
+
+			BuildProps(props, 1, 7);
+			Submit(batcher, props, materials);
+			harness.Check("Instancing/Check/Single", batcher.GetBatches().size() == 1 && CheckBatches(batcher, props, materials));
+
+			BuildProps(props, 2000, 11);
+			Submit(batcher, props, materials);
+			harness.Check("Instancing/Check/Random:2000", CheckBatches(batcher, props, materials));
+
+			// 复用同一个batcher，上一帧的分组与材质不能残留
+			props.resize(300);
+			for (Prop& prop : props)
+				prop.material = 2 - prop.material;
+			Submit(batcher, props, materials);
+			harness.Check("Instancing/Check/Reuse", CheckBatches(batcher, props, materials));
+
+			// 值相同的材质即使来自不同对象也归入同一组
+			Material copies[s_MaterialCount];
+			for (uint32_t i = 0; i < s_MaterialCount; ++i)
+				copies[i] = materials[i];
+			batcher.Clear();
+			for (uint32_t i = 0; i < props.size(); ++i) {
+				const Prop& prop = props[i];
+				const Material& material = (i & 1) ? copies[prop.material] : materials[prop.material];
+				batcher.Add(MeshKey(prop.mesh), TextureKey(prop.texture), material, XMLoadFloat4x4(&prop.world));
+			}
+			batcher.Build();
+			harness.Check("Instancing/Check/MaterialByValue", CheckBatches(batcher, props, materials));
+		}
+	}
+
+	void RunInstancingBenchmarks(Harness& harness) {
+		Material materials[s_MaterialCount];
+		for (uint32_t i = 0; i < s_MaterialCount; ++i)
+			materials[i] = MakeMaterial(i);
+		CheckInstancing(harness, materials);
+
+		if (!harness.Matches("Instancing/"))
+			return;
+
+		std::vector<Prop> props;
+		BuildProps(props, s_ObjectCount, 4242);
+
+		InstanceBatcher batcher;
+		batcher.Reserve(s_ObjectCount);
+		const std::string count = std::to_string(s_ObjectCount);
+
+		// 每帧的全部CPU工作：提交、分组、填充实例数组
+		harness.Run("Instancing/Batch:" + count, s_ObjectCount, [&]() {
+			Submit(batcher, props, materials);
+			DoNotOptimize(batcher.GetInstanceData().data());
+		});
+		harness.AddCounter("draw_calls", static_cast<double>(batcher.GetBatches().size()));
+		harness.AddCounter("objects", static_cast<double>(s_ObjectCount));
+		harness.Check("Instancing/Batch:" + count + ":identical", CheckBatches(batcher, props, materials));
+	}
+}
@@ -0,0 +1,128 @@
+#include "BenchHarness.h"
+#include "MathHelper.h"
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+using namespace DirectX;
+
+namespace Bench {
+	namespace {
+		const size_t s_MatrixCount = 1024;
+
+		// kind: 0为刚体变换，1为等比缩放，2为非等比缩放
+		std::vector<XMFLOAT4X4> CreateMatrices(int kind) {
+			std::vector<XMFLOAT4X4> matrices(s_MatrixCount);
+			for (size_t i = 0; i < s_MatrixCount; ++i) {
+				float f = static_cast<float>(i);
+				XMMATRIX S = XMMatrixIdentity();
+				if (kind == 1)
+					S = XMMatrixScaling(1.0f + 0.01f * f, 1.0f + 0.01f * f, 1.0f + 0.01f * f);
+				else if (kind == 2)
+					S = XMMatrixScaling(1.0f + 0.01f * f, 0.5f, 2.0f);
+				XMStoreFloat4x4(&matrices[i], S * XMMatrixRotationRollPitchYaw(0.01f * f, 0.02f * f, 0.03f * f) *
+					XMMatrixTranslation(f, -f, 0.5f * f));
+			}
+			return matrices;
+		}
+
+		// 逐元素比较，误差按元素大小相对计算(平移分量可达上千)
+		bool NearEqual(const XMFLOAT4X4& a, const XMFLOAT4X4& b, float epsilon = 1e-4f) {
+			for (int i = 0; i < 4; ++i) {
+				for (int j = 0; j < 4; ++j) {
+					if (fabsf(a.m[i][j] - b.m[i][j]) > epsilon * (std::max)(1.0f, fabsf(b.m[i][j])))
+						return false;
+				}
+			}
+			return true;
+		}
+
+		// 检查func的结果与reference在所有输入上一致
+		template<class Func, class RefFunc>
+		bool MatchesReference(const std::vector<XMFLOAT4X4>& input, Func&& func, RefFunc&& reference) {
+			for (const XMFLOAT4X4& m : input) {
+				XMFLOAT4X4 result, expected;
+				XMStoreFloat4x4(&result, func(XMLoadFloat4x4(&m)));
+				XMStoreFloat4x4(&expected, reference(XMLoadFloat4x4(&m)));
+				if (!NearEqual(result, expected))
+					return false;
+			}
+			return true;
+		}
+
+		// 批量求逆的结果应与逐个通用求逆一致，count不是4的倍数时覆盖标量处理的尾部
+		bool CheckBatch(const std::vector<XMFLOAT4X4>& input, size_t count) {
+			std::vector<XMFLOAT4X4> output(count);
+			AffineInverseBatch(input.data(), output.data(), count);
+			for (size_t i = 0; i < count; ++i) {
+				XMFLOAT4X4 expected;
+				XMStoreFloat4x4(&expected, XMMatrixInverse(nullptr, XMLoadFloat4x4(&input[i])));
+				if (!NearEqual(output[i], expected))
+					return false;
+			}
+			return true;
+		}
+
+		template<class Func>
+		void RunInverse(Harness& harness, const std::string& name, const std::vector<XMFLOAT4X4>& input,
+			std::vector<XMFLOAT4X4>& output, Func&& func) {
+			harness.Run(name, s_MatrixCount, [&]() {
+				for (size_t i = 0; i < s_MatrixCount; ++i)
+					XMStoreFloat4x4(&output[i], func(XMLoadFloat4x4(&input[i])));
+				DoNotOptimize(output.data());
+			});
+		}
+	}
+
+	void RunMathBenchmarks(Harness& harness) {
+		const std::string count = std::to_string(s_MatrixCount);
+		std::vector<XMFLOAT4X4> rigid = CreateMatrices(0);
+		std::vector<XMFLOAT4X4> uniform = CreateMatrices(1);
+		std::vector<XMFLOAT4X4> affine = CreateMatrices(2);
+		std::vector<XMFLOAT4X4> output(s_MatrixCount);
+
+		auto general = [](FXMMATRIX M) { return XMMatrixInverse(nullptr, M); };
+		auto inverseTransposeOld = [](FXMMATRIX M) {
+			XMMATRIX A = M;
+			A.r[3] = g_XMIdentityR3;
+			return XMMatrixTranspose(XMMatrixInverse(nullptr, A));
+		};
+
+		// 各专用求逆与通用求逆的结果比较
+		harness.Check("Math/RigidInverse:matches_general",
+			MatchesReference(rigid, [](FXMMATRIX M) { return RigidInverse(M); }, general));
+		harness.Check("Math/UniformScaleInverse:matches_general",
+			MatchesReference(uniform, [](FXMMATRIX M) { return UniformScaleInverse(M); }, general));
+		harness.Check("Math/AffineInverse:matches_general",
+			MatchesReference(affine, [](FXMMATRIX M) { return AffineInverse(M); }, general));
+		const std::pair<const char*, const std::vector<XMFLOAT4X4>*> kinds[] = {
+			{ "Rigid", &rigid }, { "UniformScale", &uniform }, { "Affine", &affine }
+		};
+		for (const auto& kind : kinds) {
+			harness.Check(std::string("Math/FastInverse<") + kind.first + ">:matches_general",
+				MatchesReference(*kind.second, [](FXMMATRIX M) { return FastInverse(M); }, general));
+			harness.Check(std::string("Math/InverseTranspose<") + kind.first + ">:matches_general",
+				MatchesReference(*kind.second, [](FXMMATRIX M) { return InverseTranspose(M); }, inverseTransposeOld));
+		}
+		const size_t batchCounts[] = { 1, 3, 4, 5, 7, s_MatrixCount - 1, s_MatrixCount };
+		for (size_t batchCount : batchCounts)
+			harness.Check("Math/AffineInverseBatch/" + std::to_string(batchCount) + ":matches_general", CheckBatch(affine, batchCount));
+
+		RunInverse(harness, "Math/XMMatrixInverse/" + count, affine, output, general);
+		RunInverse(harness, "Math/RigidInverse/" + count, rigid, output, [](FXMMATRIX M) { return RigidInverse(M); });
+		RunInverse(harness, "Math/UniformScaleInverse/" + count, uniform, output, [](FXMMATRIX M) { return UniformScaleInverse(M); });
+		RunInverse(harness, "Math/AffineInverse/" + count, affine, output, [](FXMMATRIX M) { return AffineInverse(M); });
+		// 带结构判断的分派
+		RunInverse(harness, "Math/FastInverse<Rigid>/" + count, rigid, output, [](FXMMATRIX M) { return FastInverse(M); });
+		RunInverse(harness, "Math/FastInverse<Affine>/" + count, affine, output, [](FXMMATRIX M) { return FastInverse(M); });
+
+		harness.Run("Math/AffineInverseBatch/" + count, s_MatrixCount, [&]() {
+			AffineInverseBatch(affine.data(), output.data(), s_MatrixCount);
+			DoNotOptimize(output.data());
+		});
+
+		RunInverse(harness, "Math/InverseTranspose<General>/" + count, rigid, output, inverseTransposeOld);
+		RunInverse(harness, "Math/InverseTranspose<Rigid>/" + count, rigid, output, [](FXMMATRIX M) { return InverseTranspose(M); });
+		RunInverse(harness, "Math/InverseTranspose<Affine>/" + count, affine, output, [](FXMMATRIX M) { return InverseTranspose(M); });
+	}
+}
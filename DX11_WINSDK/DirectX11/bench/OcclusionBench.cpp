@@ -0,0 +1,269 @@
+#include "BenchHarness.h"
+#include "Camera.h"
+#include "Geometry.h"
+#include "JobSystem.h"
+#include "Occlusion.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <numeric>
+#include <vector>
+
+using namespace DirectX;
+
+namespace Bench {
+	namespace {
+		const uint32_t s_BlockCount = 24;			// 每个方向上的街区数
+		const float s_BlockSpacing = 20.0f;			// 街区中心间距，建筑占14x14，其余为街道
+		const float s_BuildingHalfSize = 7.0f;
+		const uint32_t s_ObjectCount = 200000;
+		const uint32_t s_FrameCount = 32;
+
+		struct CityScene {
+			OccluderMesh buildingMesh;
+			std::vector<XMFLOAT4X4> buildingWorlds;
+			Culling::BoundingBoxSoA objects;
+		};
+
+		float CityExtent() {
+			return 0.5f * s_BlockCount * s_BlockSpacing;
+		}
+
+		// 网格状城市：每个街区一栋高度随机的建筑作为遮挡体，小物体随机散布在街道上及建筑之间
+		void BuildCity(CityScene& scene) {
+			uint32_t seed = 2024;
+			auto next = [&seed]() {
+				seed = seed * 1664525u + 1013904223u;
+				return static_cast<float>(seed >> 8) / 16777216.0f;
+			};
+			scene.buildingMesh = OccluderMesh::FromMeshData(Geometry::CreateBox<VertexPosNormalTex>(1.0f, 1.0f, 1.0f));
+			float origin = -CityExtent() + 0.5f * s_BlockSpacing;
+			for (uint32_t i = 0; i < s_BlockCount; ++i) {
+				for (uint32_t j = 0; j < s_BlockCount; ++j) {
+					float height = 10.0f + 50.0f * next();
+					XMMATRIX World = XMMatrixScaling(2.0f * s_BuildingHalfSize, height, 2.0f * s_BuildingHalfSize) *
+						XMMatrixTranslation(origin + i * s_BlockSpacing, 0.5f * height, origin + j * s_BlockSpacing);
+					scene.buildingWorlds.emplace_back();
+					XMStoreFloat4x4(&scene.buildingWorlds.back(), World);
+				}
+			}
+
+			scene.objects.Reserve(s_ObjectCount);
+			while (scene.objects.Size() < s_ObjectCount) {
+				float x = 2.0f * CityExtent() * next() - CityExtent();
+				float z = 2.0f * CityExtent() * next() - CityExtent();
+				// 跳过落在建筑内部的位置
+				float localX = std::fmod(x + CityExtent(), s_BlockSpacing) - 0.5f * s_BlockSpacing;
+				float localZ = std::fmod(z + CityExtent(), s_BlockSpacing) - 0.5f * s_BlockSpacing;
+				if (std::fabs(localX) < s_BuildingHalfSize + 1.0f && std::fabs(localZ) < s_BuildingHalfSize + 1.0f)
+					continue;
+				float size = 0.25f + 0.75f * next();
+				scene.objects.Add(XMFLOAT3(x, size + 2.0f * next(), z), XMFLOAT3(size, size, size));
+			}
+		}
+
+		// 第frame帧的相机：沿一条街道以人眼高度前进，并左右转头
+		void SetupCamera(FirstPersonCamera& camera, uint32_t frame) {
+			float t = static_cast<float>(frame) / s_FrameCount;
+			float street = -CityExtent() + 2.0f * s_BlockSpacing;
+			XMFLOAT3 pos(street, 1.8f, -CityExtent() + 20.0f + t * 1.5f * CityExtent());
+			float yaw = 0.6f * std::sin(t * XM_2PI);
+			camera.LookTo(pos, XMFLOAT3(std::sin(yaw), 0.0f, std::cos(yaw)), XMFLOAT3(0.0f, 1.0f, 0.0f));
+		}
+
+		void AddBuildings(OcclusionCuller& culler, const CityScene& scene) {
+			for (const XMFLOAT4X4& world : scene.buildingWorlds)
+				culler.AddOccluder(scene.buildingMesh, XMLoadFloat4x4(&world));
+		}
+
+		// 线段from->to是否穿过某栋建筑(建筑网格为单位立方体，包围盒即为世界矩阵的缩放与平移)
+		bool SegmentBlocked(const CityScene& scene, const XMFLOAT3& from, const XMFLOAT3& to) {
+			const float p[3] = { from.x, from.y, from.z };
+			const float d[3] = { to.x - from.x, to.y - from.y, to.z - from.z };
+			for (const XMFLOAT4X4& world : scene.buildingWorlds) {
+				const float center[3] = { world._41, world._42, world._43 };
+				const float extents[3] = { 0.5f * world._11, 0.5f * world._22, 0.5f * world._33 };
+				float t0 = 0.0f, t1 = 1.0f;
+				for (int axis = 0; axis < 3 && t0 <= t1; ++axis) {
+					float lo = center[axis] - extents[axis], hi = center[axis] + extents[axis];
+					if (std::fabs(d[axis]) < 1e-12f) {
+						if (p[axis] < lo || p[axis] > hi)
+							t1 = -1.0f;
+						continue;
+					}
+					float tNear = (lo - p[axis]) / d[axis], tFar = (hi - p[axis]) / d[axis];
+					if (tNear > tFar)
+						std::swap(tNear, tFar);
+					t0 = std::max(t0, tNear);
+					t1 = std::min(t1, tFar);
+				}
+				if (t0 <= t1)
+					return true;
+			}
+			return false;
+		}
+
+		// 暴力判断包围盒是否可见：角点、面中心和中心中任一点在视锥体内且与相机之间没有建筑遮挡。
+		// 遮挡剔除只在像素中心采样，因此要求该点在屏幕上偏移约一个像素后仍然可见，排除恰好擦过建筑边缘的情况
+		bool VisibleByRayCast(const CityScene& scene, const FirstPersonCamera& camera, uint32_t screenHeight,
+			const XMFLOAT3& center, const XMFLOAT3& extents) {
+			XMMATRIX ViewProj = camera.GetViewProjXM();
+			XMVECTOR eye = camera.GetPositionXM();
+			XMFLOAT3 eyePos = camera.GetPosition();
+			XMVECTOR right = camera.GetRightAxisXM(), up = camera.GetUpAxisXM();
+			const float pixelAngle = 2.0f * std::tan(0.5f * camera.GetFovY()) / screenHeight;
+			const float offsets[5][2] = { { 0.0f, 0.0f }, { 1.5f, 0.0f }, { -1.5f, 0.0f }, { 0.0f, 1.5f }, { 0.0f, -1.5f } };
+
+			for (int sample = 0; sample < 27; ++sample) {
+				// 每个轴取-1、0、1，得到角点、棱中点、面中心与中心
+				float sx = static_cast<float>(sample % 3 - 1), sy = static_cast<float>(sample / 3 % 3 - 1), sz = static_cast<float>(sample / 9 - 1);
+				XMVECTOR point = XMVectorSet(center.x + sx * extents.x, center.y + sy * extents.y, center.z + sz * extents.z, 1.0f);
+				XMFLOAT4 clip;
+				XMStoreFloat4(&clip, XMVector3Transform(point, ViewProj));
+				if (clip.w <= 0.0f || clip.z < 0.0f || clip.z > clip.w || std::fabs(clip.x) > clip.w || std::fabs(clip.y) > clip.w)
+					continue;
+
+				float pixelSize = pixelAngle * XMVectorGetX(XMVector3Length(XMVectorSubtract(point, eye)));
+				bool visible = true;
+				for (int k = 0; k < 5 && visible; ++k) {
+					XMFLOAT3 target;
+					XMStoreFloat3(&target, XMVectorAdd(point, XMVectorAdd(XMVectorScale(right, offsets[k][0] * pixelSize),
+						XMVectorScale(up, offsets[k][1] * pixelSize))));
+					visible = !SegmentBlocked(scene, eyePos, target);
+				}
+				if (visible)
+					return true;
+			}
+			return false;
+		}
+	}
+
+	void RunOcclusionBenchmarks(Harness& harness) {
+		if (!harness.Matches("Occlusion/"))
+			return;
+
+		CityScene scene;
+		BuildCity(scene);
+
+		FirstPersonCamera camera;
+		camera.SetFrustum(XM_PI / 3, 16.0f / 9.0f, 0.5f, 1000.0f);
+		SetupCamera(camera, 0);
+
+		std::vector<uint32_t> frustumVisible(s_ObjectCount);
+		std::vector<uint32_t> occlusionVisible(s_ObjectCount);
+		size_t frustumCount = Culling::CullBoxes(camera.GetFrustumPlanes(), scene.objects, frustumVisible.data());
+
+		// 单线程参考结果
+		OcclusionCuller serialCuller;
+		serialCuller.BeginFrame(camera.GetViewProjXM());
+		AddBuildings(serialCuller, scene);
+		serialCuller.Rasterize();
+		std::vector<uint32_t> serialVisible(s_ObjectCount);
+		size_t serialCount = serialCuller.CullBoxes(scene.objects, frustumVisible.data(), frustumCount, serialVisible.data());
+
+		// 保守性：射线检测确认可见的物体不能被剔除；抽取视锥体内的部分物体，在多个相机位置上检查
+		{
+			OcclusionCuller checkCuller;
+			std::vector<uint32_t> inFrustum(s_ObjectCount);
+			size_t tested = 0, culled = 0;
+			bool conservative = true;
+			for (uint32_t frame = 0; frame < s_FrameCount; frame += 8) {
+				SetupCamera(camera, frame);
+				size_t count = Culling::CullBoxes(camera.GetFrustumPlanes(), scene.objects, inFrustum.data());
+				checkCuller.BeginFrame(camera.GetViewProjXM());
+				AddBuildings(checkCuller, scene);
+				checkCuller.Rasterize();
+				for (size_t i = 0; i < count; i += 23) {
+					uint32_t index = inFrustum[i];
+					XMFLOAT3 center(scene.objects.centerX[index], scene.objects.centerY[index], scene.objects.centerZ[index]);
+					XMFLOAT3 extents(scene.objects.extentsX[index], scene.objects.extentsY[index], scene.objects.extentsZ[index]);
+					bool visible = checkCuller.IsVisible(center, extents);
+					culled += visible ? 0 : 1;
+					if (!VisibleByRayCast(scene, camera, checkCuller.GetHeight(), center, extents))
+						continue;
+					++tested;
+					conservative = conservative && visible;
+				}
+			}
+			SetupCamera(camera, 0);
+			// 确认样本中既有可见物体也有被剔除的物体，检查才有意义
+			harness.Check("Occlusion/CullBoxes:conservative", conservative && tested > 0 && culled > 0);
+		}
+
+		OcclusionCuller culler;
+		harness.Run("Occlusion/Rasterize/threads:0", scene.buildingWorlds.size(), [&]() {
+			culler.BeginFrame(camera.GetViewProjXM());
+			AddBuildings(culler, scene);
+			culler.Rasterize();
+			DoNotOptimize(culler.GetHiZ(0)[0]);
+		});
+		harness.AddCounter("triangles", culler.GetTriangleCount());
+
+		size_t visible = 0;
+		harness.Run("Occlusion/CullBoxes/threads:0", frustumCount, [&]() {
+			visible = serialCuller.CullBoxes(scene.objects, frustumVisible.data(), frustumCount, occlusionVisible.data());
+			DoNotOptimize(visible);
+		});
+		harness.AddCounter("occlusion_rate", frustumCount ? 1.0 - static_cast<double>(visible) / frustumCount : 0.0);
+
+		for (uint32_t threadCount : { 1u, 2u, 4u, 8u, 16u, 32u }) {
+			std::string suffix = "threads:" + std::to_string(threadCount);
+			if (!harness.Matches("Occlusion/ParallelRasterize/" + suffix) && !harness.Matches("Occlusion/ParallelCullBoxes/" + suffix))
+				continue;
+			JobSystem jobSystem(threadCount);
+
+			harness.Run("Occlusion/ParallelRasterize/" + suffix, scene.buildingWorlds.size(), [&]() {
+				culler.BeginFrame(camera.GetViewProjXM());
+				AddBuildings(culler, scene);
+				culler.Rasterize(jobSystem);
+				DoNotOptimize(culler.GetHiZ(0)[0]);
+			});
+			bool identical = true;
+			for (uint32_t level = 0; level < culler.GetHiZLevelCount(); ++level)
+				identical = identical && memcmp(culler.GetHiZ(level), serialCuller.GetHiZ(level),
+					sizeof(float) * culler.GetHiZWidth(level) * culler.GetHiZHeight(level)) == 0;
+			harness.Check("Occlusion/ParallelRasterize/" + suffix + ":bit_identical", identical);
+
+			harness.Run("Occlusion/ParallelCullBoxes/" + suffix, frustumCount, [&]() {
+				visible = serialCuller.CullBoxes(jobSystem, scene.objects, frustumVisible.data(), frustumCount, occlusionVisible.data());
+				DoNotOptimize(visible);
+			});
+			harness.Check("Occlusion/ParallelCullBoxes/" + suffix + ":identical", visible == serialCount &&
+				memcmp(occlusionVisible.data(), serialVisible.data(), visible * sizeof(uint32_t)) == 0);
+		}
+
+		// 完整的每帧流程：视锥体剔除 -> 光栅化遮挡体 -> HiZ测试，记录每帧的遮挡率(被遮挡数 / 视锥体内数)
+		if (harness.Matches("Occlusion/CityWalk/")) {
+			JobSystem jobSystem;
+			auto runFrame = [&](uint32_t frame) {
+				SetupCamera(camera, frame);
+				size_t inFrustum = Culling::CullBoxes(jobSystem, camera.GetFrustumPlanes(), scene.objects, frustumVisible.data());
+				culler.BeginFrame(camera.GetViewProjXM());
+				AddBuildings(culler, scene);
+				culler.Rasterize(jobSystem);
+				size_t notOccluded = culler.CullBoxes(jobSystem, scene.objects, frustumVisible.data(), inFrustum, occlusionVisible.data());
+				return inFrustum ? 1.0 - static_cast<double>(notOccluded) / inFrustum : 0.0;
+			};
+
+			std::vector<double> rates(s_FrameCount);
+			for (uint32_t i = 0; i < s_FrameCount; ++i)
+				rates[i] = runFrame(i);
+
+			uint32_t frame = 0;
+			harness.Run("Occlusion/CityWalk/frames:" + std::to_string(s_FrameCount), s_ObjectCount, [&]() {
+				double rate = runFrame(frame);
+				DoNotOptimize(rate);
+				frame = (frame + 1) % s_FrameCount;
+			});
+			harness.AddCounter("occlusion_rate_mean", std::accumulate(rates.begin(), rates.end(), 0.0) / s_FrameCount);
+			harness.AddCounter("occlusion_rate_min", *std::min_element(rates.begin(), rates.end()));
+			harness.AddCounter("occlusion_rate_max", *std::max_element(rates.begin(), rates.end()));
+			for (uint32_t i = 0; i < s_FrameCount; ++i) {
+				char key[32];
+				snprintf(key, sizeof(key), "occlusion_rate_frame%02u", i);
+				harness.AddCounter(key, rates[i]);
+			}
+		}
+	}
+}
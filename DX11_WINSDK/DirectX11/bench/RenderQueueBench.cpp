@@ -0,0 +1,120 @@
+#include "BenchHarness.h"
+#include "RenderQueue.h"
+#include <algorithm>
+#include <vector>
+
+namespace Bench {
+	namespace {
+		const uint32_t s_PacketCount = 100000;
+
+		struct DrawItem {
+			uint32_t pass;
+			bool transparent;
+			uint32_t shader, material, texture;
+			float depth;
+		};
+
+		float NextRandom(uint32_t& seed) {
+			seed = seed * 1664525u + 1013904223u;
+			return static_cast<float>(seed >> 8) / 16777216.0f;
+		}
+
+		// 按场景中的插入顺序排列的绘制项：2个通道，约1/5透明，每种材质使用固定的纹理
+		void BuildItems(std::vector<DrawItem>& items) {
+			uint32_t seed = 777;
+			items.resize(s_PacketCount);
+			for (DrawItem& item : items) {
+				item.pass = NextRandom(seed) < 0.9f ? 0 : 1;
+				item.transparent = NextRandom(seed) < 0.2f;
+				item.shader = static_cast<uint32_t>(NextRandom(seed) * 8);
+				item.material = static_cast<uint32_t>(NextRandom(seed) * 64);
+				item.texture = item.material * 7 % 128;
+				item.depth = 1.0f + 500.0f * NextRandom(seed);
+			}
+		}
+
+		void SubmitItems(RenderQueue& queue, const std::vector<DrawItem>& items) {
+			queue.Clear();
+			for (uint32_t i = 0; i < items.size(); ++i) {
+				const DrawItem& item = items[i];
+				queue.Submit(item.pass, item.transparent, item.shader, item.material, item.texture, item.depth, i);
+			}
+		}
+
+		// 相邻两次绘制之间着色器、材质、纹理与混合状态的切换次数
+		uint64_t CountStateChanges(const std::vector<DrawItem>& items, const std::vector<uint32_t>& order) {
+			uint64_t changes = 0;
+			for (size_t i = 1; i < order.size(); ++i) {
+				const DrawItem& prev = items[order[i - 1]];
+				const DrawItem& curr = items[order[i]];
+				changes += (prev.shader != curr.shader) + (prev.material != curr.material) +
+					(prev.texture != curr.texture) + (prev.transparent != curr.transparent);
+			}
+			return changes;
+		}
+	}
+
+	void RunRenderQueueBenchmarks(Harness& harness) {
+		if (!harness.Matches("RenderQueue/"))
+			return;
+
+		std::vector<DrawItem> items;
+		BuildItems(items);
+		RenderQueue queue;
+		queue.Reserve(s_PacketCount);
+		const std::string count = std::to_string(s_PacketCount);
+
+		harness.Run("RenderQueue/SubmitSort:" + count, s_PacketCount, [&]() {
+			SubmitItems(queue, items);
+			queue.Sort();
+			DoNotOptimize(queue.GetPackets().data());
+		});
+
+		// 与按键稳定排序的结果逐项比较
+		SubmitItems(queue, items);
+		std::vector<RenderQueue::Packet> reference(queue.GetPackets());
+		std::stable_sort(reference.begin(), reference.end(), [](const RenderQueue::Packet& a, const RenderQueue::Packet& b) {
+			return a.key < b.key;
+		});
+		queue.Sort();
+		const std::vector<RenderQueue::Packet>& packets = queue.GetPackets();
+		bool identical = packets.size() == reference.size();
+		for (size_t i = 0; identical && i < packets.size(); ++i)
+			identical = packets[i].key == reference[i].key && packets[i].payload == reference[i].payload;
+
+		// 通道内先不透明后透明，透明物体由远到近
+		bool ordered = true;
+		for (size_t i = 1; i < packets.size(); ++i) {
+			const DrawItem& prev = items[packets[i - 1].payload];
+			const DrawItem& curr = items[packets[i].payload];
+			if (prev.pass != curr.pass) {
+				ordered = ordered && prev.pass < curr.pass;
+				continue;
+			}
+			ordered = ordered && (!prev.transparent || curr.transparent);
+			if (prev.transparent && curr.transparent)
+				ordered = ordered && RenderQueue::QuantizeDepth(prev.depth) >= RenderQueue::QuantizeDepth(curr.depth);
+		}
+
+		std::vector<uint32_t> insertionOrder(s_PacketCount), sortedOrder(s_PacketCount);
+		for (uint32_t i = 0; i < s_PacketCount; ++i) {
+			insertionOrder[i] = i;
+			sortedOrder[i] = packets[i].payload;
+		}
+		harness.AddCounter("state_changes_unsorted", static_cast<double>(CountStateChanges(items, insertionOrder)));
+		harness.AddCounter("state_changes_sorted", static_cast<double>(CountStateChanges(items, sortedOrder)));
+		harness.Check("RenderQueue/SubmitSort:" + count + ":ordered", ordered);
+		harness.Check("RenderQueue/SubmitSort:" + count + ":identical", identical);
+
+		std::vector<RenderQueue::Packet> unsorted;
+		SubmitItems(queue, items);
+		unsorted = queue.GetPackets();
+		harness.Run("RenderQueue/StdSort:" + count, s_PacketCount, [&]() {
+			reference = unsorted;
+			std::sort(reference.begin(), reference.end(), [](const RenderQueue::Packet& a, const RenderQueue::Packet& b) {
+				return a.key < b.key;
+			});
+			DoNotOptimize(reference.data());
+		});
+	}
+}
@@ -0,0 +1,137 @@
+#include "BenchHarness.h"
+#include "Camera.h"
+#include "CascadedShadow.h"
+#include "JobSystem.h"
+#include "LightHelper.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <vector>
+
+using namespace DirectX;
+
+namespace Bench {
+	namespace {
+		const uint32_t s_ObjectCount = 1000000;
+
+		// 各级联的视锥体切面角点是否都在光源正交体内，返回在外的角点数
+		uint32_t CountUncoveredCorners(const Camera& camera, const CascadedShadow& shadow) {
+			float tanY = tanf(0.5f * camera.GetFovY());
+			float tanX = tanY * camera.GetAspectRatio();
+			XMMATRIX InvView = camera.GetInvViewXM();
+			uint32_t uncovered = 0;
+			for (uint32_t i = 0; i < shadow.GetCascadeCount(); ++i) {
+				const CascadedShadow::Cascade& cascade = shadow.GetCascade(i);
+				XMMATRIX LightViewProj = XMLoadFloat4x4(&cascade.lightViewProj);
+				for (int k = 0; k < 8; ++k) {
+					float z = (k & 4) ? cascade.farZ : cascade.nearZ;
+					XMVECTOR corner = XMVectorSet((k & 1 ? 1.0f : -1.0f) * tanX * z, (k & 2 ? 1.0f : -1.0f) * tanY * z, z, 1.0f);
+					XMFLOAT4 clip;
+					XMStoreFloat4(&clip, XMVector3Transform(XMVector3Transform(corner, InvView), LightViewProj));
+					if (fabsf(clip.x) > 1.0001f || fabsf(clip.y) > 1.0001f || clip.z < 0.0f || clip.z > 1.0f)
+						++uncovered;
+				}
+			}
+			return uncovered;
+		}
+	}
+
+	void RunShadowBenchmarks(Harness& harness) {
+		if (!harness.Matches("Shadow/"))
+			return;
+
+		FirstPersonCamera camera;
+		camera.SetFrustum(XM_PI / 3, 16.0f / 9.0f, 0.5f, 1000.0f);
+		camera.LookTo(XMFLOAT3(0.0f, 10.0f, 0.0f), XMFLOAT3(0.3f, -0.1f, 1.0f), XMFLOAT3(0.0f, 1.0f, 0.0f));
+		DirectionalLight light;
+		light.direction = XMFLOAT3(-0.577f, -0.577f, 0.577f);
+
+		CascadedShadow shadow;
+		shadow.SetShadowDistance(300.0f);
+		harness.Run("Shadow/Update/cascades:4", 4, [&]() {
+			camera.RotateY(0.001f);
+			shadow.Update(camera, light);
+			DoNotOptimize(shadow.GetCascade(0).lightViewProj);
+		});
+		uint32_t uncoveredCorners = CountUncoveredCorners(camera, shadow);
+		harness.AddCounter("uncovered_corners", uncoveredCorners);
+		harness.Check("Shadow/Update:covered", uncoveredCorners == 0);
+
+		// 相机平移时固定点在阴影贴图上的亚纹素位置应保持不变
+		{
+			float radius[CascadedShadow::MaxCascades];
+			double fraction[CascadedShadow::MaxCascades][2];
+			double drift = 0.0;
+			XMVECTOR point = XMVectorSet(12.345f, 0.5f, 30.21f, 1.0f);
+			float size = static_cast<float>(shadow.GetShadowMapSize());
+			for (int step = 0; step < 32; ++step) {
+				camera.Strafe(0.0137f);
+				camera.Walk(0.0071f);
+				shadow.Update(camera, light);
+				for (uint32_t i = 0; i < shadow.GetCascadeCount(); ++i) {
+					const CascadedShadow::Cascade& cascade = shadow.GetCascade(i);
+					XMFLOAT4 uv;
+					XMStoreFloat4(&uv, XMVector3Transform(point, XMLoadFloat4x4(&cascade.shadowTransform)));
+					double u = uv.x * size, v = uv.y * size;
+					double fu = u - floor(u), fv = v - floor(v);
+					if (step == 0) {
+						radius[i] = cascade.radius;
+						fraction[i][0] = fu, fraction[i][1] = fv;
+					}
+					else if (cascade.radius == radius[i]) {
+						drift = std::max(drift, std::max(fabs(fu - fraction[i][0]), fabs(fv - fraction[i][1])));
+					}
+				}
+			}
+			harness.AddCounter("subtexel_drift", drift);
+			harness.Check("Shadow/Update:stable", drift < 1e-3);
+		}
+
+		// 物体均匀分布在2000x100x2000的区域内
+		Culling::BoundingBoxSoA boxes;
+		boxes.Reserve(s_ObjectCount);
+		uint32_t seed = 2024;
+		auto next = [&seed]() {
+			seed = seed * 1664525u + 1013904223u;
+			return static_cast<float>(seed >> 8) / 16777216.0f;
+		};
+		for (uint32_t i = 0; i < s_ObjectCount; ++i) {
+			float size = 0.5f + 4.5f * next();
+			boxes.Add(XMFLOAT3(2000.0f * next() - 1000.0f, 100.0f * next() - 50.0f, 2000.0f * next() - 1000.0f),
+				XMFLOAT3(size, size, size));
+		}
+		shadow.Update(camera, light);
+
+		auto cullSerial = [&](std::vector<uint32_t>* lists) {
+			for (uint32_t i = 0; i < shadow.GetCascadeCount(); ++i) {
+				lists[i].resize(s_ObjectCount);
+				lists[i].resize(shadow.CullCasters(i, boxes, lists[i].data()));
+			}
+		};
+		std::vector<uint32_t> serialLists[CascadedShadow::MaxCascades];
+		cullSerial(serialLists);
+
+		std::vector<uint32_t> lists[CascadedShadow::MaxCascades];
+		harness.Run("Shadow/CullCasters/threads:0", s_ObjectCount * shadow.GetCascadeCount(), [&]() {
+			cullSerial(lists);
+			DoNotOptimize(lists[0].size());
+		});
+		for (uint32_t i = 0; i < shadow.GetCascadeCount(); ++i)
+			harness.AddCounter("casters_cascade" + std::to_string(i), static_cast<double>(serialLists[i].size()));
+
+		for (uint32_t threadCount : { 1u, 2u, 4u, 8u, 16u, 32u }) {
+			std::string name = "Shadow/CullCasters/threads:" + std::to_string(threadCount);
+			if (!harness.Matches(name))
+				continue;
+			JobSystem jobSystem(threadCount);
+			harness.Run(name, s_ObjectCount * shadow.GetCascadeCount(), [&]() {
+				shadow.CullCasters(jobSystem, boxes, lists);
+				DoNotOptimize(lists[0].size());
+			});
+			bool identical = true;
+			for (uint32_t i = 0; i < shadow.GetCascadeCount(); ++i)
+				identical = identical && lists[i] == serialLists[i];
+			harness.Check(name + ":identical", identical);
+		}
+	}
+}
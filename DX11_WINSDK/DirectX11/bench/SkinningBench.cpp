@@ -0,0 +1,121 @@
+#include "BenchHarness.h"
+#include "Animation.h"
+#include "Geometry.h"
+#include "JobSystem.h"
+#include "Skinning.h"
+#include <cstring>
+#include <vector>
+
+using namespace DirectX;
+
+namespace Bench {
+	namespace {
+		const uint32_t s_CharacterCount = 100;
+		const uint32_t s_VertexCount = 10000;
+		const uint32_t s_BoneCount = 64;
+
+		// 沿y轴排列的骨骼链，每根骨骼长0.1
+		void BuildSkeleton(Skeleton& skeleton) {
+			for (uint32_t i = 0; i < s_BoneCount; ++i) {
+				XMFLOAT4X4 inverseBindPose;
+				XMStoreFloat4x4(&inverseBindPose, XMMatrixTranslation(0.0f, -0.1f * i, 0.0f));
+				skeleton.AddBone(i == 0 ? Skeleton::NoParent : (int32_t)i - 1, inverseBindPose);
+			}
+		}
+
+		// 围绕骨骼链的圆柱面，每个顶点受相邻的4根骨骼影响
+		std::vector<VertexPosNormalTangentTexSkin> BuildVertices() {
+			std::vector<VertexPosNormalTangentTexSkin> vertices(s_VertexCount);
+			for (uint32_t i = 0; i < s_VertexCount; ++i) {
+				float t = static_cast<float>(i) / s_VertexCount;
+				float theta = XM_2PI * 37.0f * t;
+				float y = 0.1f * (s_BoneCount - 1) * t;
+				uint8_t bone = static_cast<uint8_t>(y / 0.1f);
+				auto clampBone = [](int b) { return static_cast<uint8_t>(b < (int)s_BoneCount ? b : s_BoneCount - 1); };
+				vertices[i] = VertexPosNormalTangentTexSkin(XMFLOAT3(0.2f * cosf(theta), y, 0.2f * sinf(theta)),
+					XMFLOAT3(cosf(theta), 0.0f, sinf(theta)), XMFLOAT4(-sinf(theta), 0.0f, cosf(theta), 1.0f), XMFLOAT2(theta / XM_2PI, t),
+					bone, clampBone(bone + 1), clampBone(bone + 2), clampBone(bone + 3), XMFLOAT4(0.4f, 0.3f, 0.2f, 0.1f));
+			}
+			return vertices;
+		}
+
+		void BuildPoses(const Skeleton& skeleton, std::vector<XMFLOAT4X4A>& skinningMatrices) {
+			AnimationPose pose;
+			pose.Resize(s_BoneCount);
+			skinningMatrices.resize(s_CharacterCount * s_BoneCount);
+			for (uint32_t c = 0; c < s_CharacterCount; ++c) {
+				for (uint32_t b = 0; b < s_BoneCount; ++b) {
+					pose.scales[b] = XMFLOAT3(1.0f, 1.0f, 1.0f);
+					XMStoreFloat4(&pose.rotations[b], XMQuaternionRotationRollPitchYaw(0.01f * c, 0.0f, 0.02f));
+					pose.positions[b] = XMFLOAT3(b == 0 ? static_cast<float>(c) : 0.0f, b == 0 ? 0.0f : 0.1f, 0.0f);
+				}
+				skeleton.ComputeSkinningMatrices(pose, &skinningMatrices[c * s_BoneCount]);
+			}
+		}
+	}
+
+	void RunSkinningBenchmarks(Harness& harness) {
+		// 几何体生成的蒙皮顶点应完全绑定到0号骨骼，蒙皮后只随该骨骼平移
+		{
+			auto meshData = Geometry::CreateSphere<VertexPosNormalTangentTexSkin>(1.0f, 8, 8);
+			std::vector<VertexPosNormalTangentTex> skinned(meshData.vertexVec.size());
+			XMFLOAT4X4A bone0;
+			XMStoreFloat4x4A(&bone0, XMMatrixTranslation(1.0f, 2.0f, 3.0f));
+			Skinning::SkinVertices(meshData.vertexVec.data(), skinned.data(), skinned.size(), &bone0);
+			bool bound = true;
+			for (size_t i = 0; i < skinned.size(); ++i) {
+				XMVECTOR expected = XMVectorAdd(XMLoadFloat3(&meshData.vertexVec[i].pos), XMVectorSet(1.0f, 2.0f, 3.0f, 0.0f));
+				bound = bound && XMVector3NearEqual(XMLoadFloat3(&skinned[i].pos), expected, XMVectorReplicate(1e-5f));
+			}
+			harness.Check("Skinning/GeometryDefaultWeights", bound);
+		}
+
+		Skeleton skeleton;
+		BuildSkeleton(skeleton);
+		std::vector<VertexPosNormalTangentTexSkin> vertices = BuildVertices();
+		std::vector<XMFLOAT4X4A> skinningMatrices;
+		BuildPoses(skeleton, skinningMatrices);
+
+		const uint64_t totalVertices = (uint64_t)s_CharacterCount * s_VertexCount;
+		const std::string count = std::to_string(s_CharacterCount) + "x" + std::to_string(s_VertexCount);
+		std::vector<VertexPosNormalTangentTex> serialOutput(totalVertices);
+
+		// 所有角色共用同一网格，各自有独立的姿势和输出缓冲区
+		harness.Run("Skinning/SkinVertices/" + count, totalVertices, [&]() {
+			for (uint32_t c = 0; c < s_CharacterCount; ++c)
+				Skinning::SkinVertices(vertices.data(), &serialOutput[c * s_VertexCount], s_VertexCount,
+					&skinningMatrices[c * s_BoneCount]);
+			DoNotOptimize(serialOutput.data());
+		});
+
+		harness.Run("Skinning/ComputeSkinningMatrices/" + std::to_string(s_BoneCount), s_BoneCount, [&]() {
+			std::vector<XMFLOAT4X4> locals(s_BoneCount);
+			for (uint32_t b = 0; b < s_BoneCount; ++b)
+				XMStoreFloat4x4(&locals[b], XMMatrixTranslation(0.0f, 0.1f, 0.0f));
+			skeleton.ComputeSkinningMatrices(locals.data(), skinningMatrices.data());
+			DoNotOptimize(skinningMatrices.data());
+		});
+		BuildPoses(skeleton, skinningMatrices);
+
+		// 多线程：按角色分配任务，同时检查结果与单线程逐位相同
+		std::vector<VertexPosNormalTangentTex> parallelOutput(totalVertices);
+		const uint32_t threadCounts[] = { 1, 2, 4, 8, 16, 32 };
+		for (uint32_t threadCount : threadCounts) {
+			std::string name = "Skinning/ParallelSkinVertices/" + count + "/threads:" + std::to_string(threadCount);
+			if (!harness.Matches(name))
+				continue;
+			JobSystem jobSystem(threadCount);
+			harness.Run(name, totalVertices, [&]() {
+				jobSystem.ParallelFor(s_CharacterCount, 1, [&](uint32_t begin, uint32_t end) {
+					for (uint32_t c = begin; c < end; ++c)
+						Skinning::SkinVertices(vertices.data(), &parallelOutput[c * s_VertexCount], s_VertexCount,
+							&skinningMatrices[c * s_BoneCount]);
+				});
+				DoNotOptimize(parallelOutput.data());
+			});
+			bool identical = memcmp(serialOutput.data(), parallelOutput.data(),
+				sizeof(VertexPosNormalTangentTex) * totalVertices) == 0;
+			harness.Check(name + ":bit_identical", identical);
+		}
+	}
+}
@@ -0,0 +1,290 @@
+#include "BenchHarness.h"
+#include "Camera.h"
+#include "LooseOctree.h"
+#include "Transform.h"
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+using namespace DirectX;
+
+namespace Bench {
+	namespace {
+		const uint32_t s_ObjectCount = 100000;
+		const uint32_t s_MovingPeriod = 10;			// 每帧移动1/10的物体
+		const uint32_t s_QueryCount = 64;
+		const float s_WorldHalfSize = 1000.0f;
+
+		struct DynamicScene {
+			std::vector<Transform> transforms;
+			std::vector<XMFLOAT3> localExtents;
+			std::vector<XMFLOAT3> velocities;
+			std::vector<uint32_t> indexedVersions;	// 上次写入八叉树时的Transform版本号
+			std::vector<uint32_t> handles;
+		};
+
+		float NextRandom(uint32_t& seed) {
+			seed = seed * 1664525u + 1013904223u;
+			return static_cast<float>(seed >> 8) / 16777216.0f;
+		}
+
+		// 模型空间包围盒(中心在原点)变换到世界空间后的轴对齐包围盒
+		void WorldBounds(const Transform& transform, const XMFLOAT3& localExtents, XMFLOAT3& center, XMFLOAT3& extents) {
+			XMMATRIX World = transform.GetLocalToWorldMatrixXM();
+			XMVECTOR e = XMVectorScale(XMVectorAbs(World.r[0]), localExtents.x);
+			e = XMVectorMultiplyAdd(XMVectorAbs(World.r[1]), XMVectorReplicate(localExtents.y), e);
+			e = XMVectorMultiplyAdd(XMVectorAbs(World.r[2]), XMVectorReplicate(localExtents.z), e);
+			XMStoreFloat3(&center, World.r[3]);
+			XMStoreFloat3(&extents, e);
+		}
+
+		// 物体分布在2000x200x2000的区域内，少数为大物体，每个物体有各自的速度
+		void BuildScene(DynamicScene& scene) {
+			uint32_t seed = 2024;
+			scene.transforms.resize(s_ObjectCount);
+			scene.localExtents.resize(s_ObjectCount);
+			scene.velocities.resize(s_ObjectCount);
+			for (uint32_t i = 0; i < s_ObjectCount; ++i) {
+				float size = i % 100 == 0 ? 10.0f + 40.0f * NextRandom(seed) : 0.5f + 4.5f * NextRandom(seed);
+				scene.localExtents[i] = XMFLOAT3(size, 0.5f * size, size);
+				scene.transforms[i].SetPosition(2.0f * s_WorldHalfSize * NextRandom(seed) - s_WorldHalfSize,
+					200.0f * NextRandom(seed) - 100.0f, 2.0f * s_WorldHalfSize * NextRandom(seed) - s_WorldHalfSize);
+				scene.transforms[i].SetRotation(0.0f, XM_2PI * NextRandom(seed), 0.0f);
+				scene.velocities[i] = XMFLOAT3(8.0f * NextRandom(seed) - 4.0f, 0.0f, 8.0f * NextRandom(seed) - 4.0f);
+			}
+		}
+
+		void InsertAll(DynamicScene& scene, LooseOctree& octree) {
+			octree.Reset(XMFLOAT3(0.0f, 0.0f, 0.0f), s_WorldHalfSize);
+			scene.handles.resize(s_ObjectCount);
+			scene.indexedVersions.resize(s_ObjectCount);
+			XMFLOAT3 center, extents;
+			for (uint32_t i = 0; i < s_ObjectCount; ++i) {
+				WorldBounds(scene.transforms[i], scene.localExtents[i], center, extents);
+				scene.handles[i] = octree.Insert(center, extents, i);
+				scene.indexedVersions[i] = scene.transforms[i].GetVersion();
+			}
+		}
+
+		// 第frame帧移动下标模s_MovingPeriod余frame的物体，超出区域时反向
+		void MoveObjects(DynamicScene& scene, uint32_t frame) {
+			for (uint32_t i = frame % s_MovingPeriod; i < s_ObjectCount; i += s_MovingPeriod) {
+				Transform& transform = scene.transforms[i];
+				XMFLOAT3& velocity = scene.velocities[i];
+				XMFLOAT3 pos = transform.GetPosition();
+				if (fabsf(pos.x + velocity.x) > s_WorldHalfSize)
+					velocity.x = -velocity.x;
+				if (fabsf(pos.z + velocity.z) > s_WorldHalfSize)
+					velocity.z = -velocity.z;
+				transform.SetPosition(pos.x + velocity.x, pos.y, pos.z + velocity.z);
+			}
+		}
+
+		// 只把版本号改变的物体写入八叉树，返回更新数目
+		uint32_t SyncOctree(DynamicScene& scene, LooseOctree& octree) {
+			uint32_t updated = 0;
+			XMFLOAT3 center, extents;
+			for (uint32_t i = 0; i < s_ObjectCount; ++i) {
+				uint32_t version = scene.transforms[i].GetVersion();
+				if (version == scene.indexedVersions[i])
+					continue;
+				WorldBounds(scene.transforms[i], scene.localExtents[i], center, extents);
+				octree.Update(scene.handles[i], center, extents);
+				scene.indexedVersions[i] = version;
+				++updated;
+			}
+			return updated;
+		}
+
+		void GatherBoxes(const DynamicScene& scene, Culling::BoundingBoxSoA& boxes) {
+			boxes.Resize(s_ObjectCount);
+			XMFLOAT3 center, extents;
+			for (uint32_t i = 0; i < s_ObjectCount; ++i) {
+				WorldBounds(scene.transforms[i], scene.localExtents[i], center, extents);
+				boxes.Set(i, center, extents);
+			}
+		}
+
+		float DistanceSqToBox(const XMFLOAT3& p, const Culling::BoundingBoxSoA& boxes, uint32_t i) {
+			float dx = std::max(fabsf(p.x - boxes.centerX[i]) - boxes.extentsX[i], 0.0f);
+			float dy = std::max(fabsf(p.y - boxes.centerY[i]) - boxes.extentsY[i], 0.0f);
+			float dz = std::max(fabsf(p.z - boxes.centerZ[i]) - boxes.extentsZ[i], 0.0f);
+			return dx * dx + dy * dy + dz * dz;
+		}
+
+		// 逐个测试所有物体的最近射线命中，用于验证八叉树的结果
+		float BruteForceRaycast(const Culling::BoundingBoxSoA& boxes, const XMFLOAT3& origin, const XMFLOAT3& direction, float maxDistance) {
+			float length = sqrtf(direction.x * direction.x + direction.y * direction.y + direction.z * direction.z);
+			float inv[3] = { length / direction.x, length / direction.y, length / direction.z };
+			const float o[3] = { origin.x, origin.y, origin.z };
+			float best = -1.0f;
+			for (uint32_t i = 0; i < boxes.Size(); ++i) {
+				const float c[3] = { boxes.centerX[i], boxes.centerY[i], boxes.centerZ[i] };
+				const float e[3] = { boxes.extentsX[i], boxes.extentsY[i], boxes.extentsZ[i] };
+				float tMin = 0.0f, tMax = best >= 0.0f ? best : maxDistance;
+				for (int k = 0; k < 3; ++k) {
+					float t0 = (c[k] - e[k] - o[k]) * inv[k];
+					float t1 = (c[k] + e[k] - o[k]) * inv[k];
+					if (t0 > t1)
+						std::swap(t0, t1);
+					tMin = std::max(tMin, t0);
+					tMax = std::min(tMax, t1);
+				}
+				if (tMin <= tMax)
+					best = tMin;
+			}
+			return best;
+		}
+	}
+
+	void RunSpatialBenchmarks(Harness& harness) {
+		if (!harness.Matches("Spatial/"))
+			return;
+
+		DynamicScene scene;
+		BuildScene(scene);
+		LooseOctree octree;
+		const std::string count = std::to_string(s_ObjectCount);
+
+		harness.Run("Spatial/Octree/Insert:" + count, s_ObjectCount, [&]() {
+			InsertAll(scene, octree);
+			DoNotOptimize(octree.GetNodeCount());
+		});
+		harness.AddCounter("nodes", octree.GetNodeCount());
+
+		harness.Run("Spatial/Octree/Rebuild:" + count, s_ObjectCount, [&]() {
+			octree.Rebuild();
+			DoNotOptimize(octree.GetNodeCount());
+		});
+
+		// 每帧移动10%的物体，按Transform版本号增量更新
+		uint32_t frame = 0;
+		uint32_t updated = 0;
+		InsertAll(scene, octree);
+		harness.Run("Spatial/Octree/FrameUpdate/moving:" + std::to_string(s_ObjectCount / s_MovingPeriod), s_ObjectCount, [&]() {
+			MoveObjects(scene, frame++);
+			updated = SyncOctree(scene, octree);
+			DoNotOptimize(updated);
+		});
+		harness.AddCounter("updated_per_frame", updated);
+		harness.AddCounter("reinsert_ratio", frame ? static_cast<double>(octree.GetReinsertCount()) /
+			(static_cast<double>(frame) * (s_ObjectCount / s_MovingPeriod)) : 0.0);
+		harness.AddCounter("nodes", octree.GetNodeCount());
+
+		// 对照：移动后整棵树重建
+		harness.Run("Spatial/Octree/RebuildPerFrame/moving:" + std::to_string(s_ObjectCount / s_MovingPeriod), s_ObjectCount, [&]() {
+			MoveObjects(scene, frame++);
+			SyncOctree(scene, octree);
+			octree.Rebuild();
+			DoNotOptimize(octree.GetNodeCount());
+		});
+
+		// 以下查询使用增量更新若干帧后的树，并与逐个测试的结果比较
+		InsertAll(scene, octree);
+		for (uint32_t i = 0; i < 64; ++i) {
+			MoveObjects(scene, frame++);
+			SyncOctree(scene, octree);
+		}
+		Culling::BoundingBoxSoA boxes;
+		GatherBoxes(scene, boxes);
+
+		FirstPersonCamera camera;
+		camera.SetFrustum(XM_PI / 3, 16.0f / 9.0f, 0.5f, 300.0f);
+		camera.LookAt(XMFLOAT3(0.0f, 10.0f, 0.0f), XMFLOAT3(100.0f, 0.0f, 300.0f), XMFLOAT3(0.0f, 1.0f, 0.0f));
+		const Culling::FrustumPlanes& frustum = camera.GetFrustumPlanes();
+
+		std::vector<uint32_t> results, reference(s_ObjectCount);
+		reference.resize(Culling::CullBoxes(frustum, boxes, reference.data()));
+		harness.Run("Spatial/BruteForce/Frustum:" + count, s_ObjectCount, [&]() {
+			results.resize(s_ObjectCount);
+			results.resize(Culling::CullBoxes(frustum, boxes, results.data()));
+			DoNotOptimize(results.size());
+		});
+		harness.Run("Spatial/Octree/Frustum:" + count, s_ObjectCount, [&]() {
+			octree.QueryFrustum(frustum, results);
+			DoNotOptimize(results.size());
+		});
+		std::sort(results.begin(), results.end());
+		harness.AddCounter("visible", static_cast<double>(results.size()));
+		harness.Check("Spatial/Octree/Frustum:" + count + ":identical", results == reference);
+
+		// 查询点与射线
+		uint32_t seed = 7;
+		std::vector<XMFLOAT3> points(s_QueryCount), directions(s_QueryCount);
+		for (uint32_t i = 0; i < s_QueryCount; ++i) {
+			points[i] = XMFLOAT3(1800.0f * NextRandom(seed) - 900.0f, 20.0f * NextRandom(seed) - 10.0f, 1800.0f * NextRandom(seed) - 900.0f);
+			float yaw = XM_2PI * NextRandom(seed);
+			directions[i] = XMFLOAT3(std::sin(yaw), 0.2f * NextRandom(seed) - 0.1f, std::cos(yaw));
+		}
+
+		const float radius = 50.0f;
+		bool identical = true;
+		size_t hits = 0;
+		for (uint32_t q = 0; q < s_QueryCount; ++q) {
+			octree.QuerySphere(points[q], radius, results);
+			std::sort(results.begin(), results.end());
+			reference.clear();
+			for (uint32_t i = 0; i < s_ObjectCount; ++i) {
+				if (DistanceSqToBox(points[q], boxes, i) <= radius * radius)
+					reference.push_back(i);
+			}
+			identical = identical && results == reference;
+			hits += results.size();
+		}
+		harness.Run("Spatial/Octree/Sphere/radius:50", s_QueryCount, [&]() {
+			for (uint32_t q = 0; q < s_QueryCount; ++q) {
+				octree.QuerySphere(points[q], radius, results);
+				DoNotOptimize(results.size());
+			}
+		});
+		harness.AddCounter("results_per_query", static_cast<double>(hits) / s_QueryCount);
+		harness.Check("Spatial/Octree/Sphere:identical", identical);
+
+		const float maxDistance = 500.0f;
+		identical = true;
+		hits = 0;
+		for (uint32_t q = 0; q < s_QueryCount; ++q) {
+			uint32_t userData = 0;
+			float distance = -1.0f;
+			bool hit = octree.Raycast(points[q], directions[q], maxDistance, userData, distance);
+			float expected = BruteForceRaycast(boxes, points[q], directions[q], maxDistance);
+			identical = identical && hit == (expected >= 0.0f) && (!hit || distance == expected);
+			hits += hit;
+		}
+		harness.Run("Spatial/BruteForce/Raycast", s_QueryCount, [&]() {
+			for (uint32_t q = 0; q < s_QueryCount; ++q)
+				DoNotOptimize(BruteForceRaycast(boxes, points[q], directions[q], maxDistance));
+		});
+		harness.Run("Spatial/Octree/Raycast", s_QueryCount, [&]() {
+			for (uint32_t q = 0; q < s_QueryCount; ++q) {
+				uint32_t userData;
+				float distance;
+				DoNotOptimize(octree.Raycast(points[q], directions[q], maxDistance, userData, distance));
+			}
+		});
+		harness.AddCounter("hit_ratio", static_cast<double>(hits) / s_QueryCount);
+		harness.Check("Spatial/Octree/Raycast:identical", identical);
+
+		// 距离相等时下标可能不同，按距离比较
+		const uint32_t k = 16;
+		identical = true;
+		std::vector<float> distances(s_ObjectCount);
+		for (uint32_t q = 0; q < s_QueryCount; ++q) {
+			octree.QueryNearest(points[q], k, results);
+			for (uint32_t i = 0; i < s_ObjectCount; ++i)
+				distances[i] = DistanceSqToBox(points[q], boxes, i);
+			std::vector<float> expected(distances);
+			std::partial_sort(expected.begin(), expected.begin() + k, expected.end());
+			identical = identical && results.size() == k;
+			for (uint32_t i = 0; i < k && identical; ++i)
+				identical = distances[results[i]] == expected[i];
+		}
+		harness.Run("Spatial/Octree/KNearest/k:16", s_QueryCount, [&]() {
+			for (uint32_t q = 0; q < s_QueryCount; ++q) {
+				octree.QueryNearest(points[q], k, results);
+				DoNotOptimize(results.size());
+			}
+		});
+		harness.Check("Spatial/Octree/KNearest:identical", identical);
+	}
+}
@@ -0,0 +1,133 @@
+#include "BenchHarness.h"
+#include "Transform.h"
+#include "MathHelper.h"
+#include <vector>
+
+using namespace DirectX;
+
+namespace Bench {
+	namespace {
+		const size_t s_ObjectCount = 1024;
+
+		// 与BasicEffect中CBChangesEveryDrawing的世界矩阵部分布局相同
+		struct CBWorld {
+			XMMATRIX world;
+			XMMATRIX worldInvTranspose;
+		};
+
+		std::vector<Transform> CreateTransforms(size_t count) {
+			std::vector<Transform> transforms(count);
+			for (size_t i = 0; i < count; ++i) {
+				float f = static_cast<float>(i);
+				transforms[i].SetScale(1.0f + 0.001f * f, 1.0f, 1.0f + 0.002f * f);
+				transforms[i].SetRotation(0.01f * f, 0.02f * f, 0.005f * f);
+				transforms[i].SetPosition(f, 0.5f * f, -f);
+			}
+			return transforms;
+		}
+	}
+
+	void RunTransformBenchmarks(Harness& harness) {
+		// 分多次绕x轴旋转越过90°，结果应与一次旋转相同，不能在90°处反弹
+		{
+			Transform stepped, direct;
+			for (int i = 0; i < 200; ++i)
+				stepped.Rotate(XMFLOAT3(0.01f, 0.0f, 0.0f));
+			direct.SetRotation(2.0f, 0.0f, 0.0f);
+			harness.Check("Transform/Rotate:pitch_past_90",
+				XMVector3NearEqual(stepped.GetForwardAxisXM(), direct.GetForwardAxisXM(), XMVectorReplicate(1e-4f)) &&
+				XMVector3NearEqual(stepped.GetUpAxisXM(), direct.GetUpAxisXM(), XMVectorReplicate(1e-4f)));
+		}
+
+		std::vector<Transform> transforms = CreateTransforms(s_ObjectCount);
+		std::vector<XMFLOAT4X4> matrices(s_ObjectCount);
+		std::vector<XMFLOAT3> axes(s_ObjectCount * 3);
+		std::vector<CBWorld> cbuffers(s_ObjectCount);
+		const std::string count = std::to_string(s_ObjectCount);
+
+		harness.Run("Transform/GetLocalToWorldMatrixXM/" + count, s_ObjectCount, [&]() {
+			for (size_t i = 0; i < s_ObjectCount; ++i)
+				XMStoreFloat4x4(&matrices[i], transforms[i].GetLocalToWorldMatrixXM());
+			DoNotOptimize(matrices.data());
+		});
+
+		harness.Run("Transform/GetWorldToLocalMatrixXM/" + count, s_ObjectCount, [&]() {
+			for (size_t i = 0; i < s_ObjectCount; ++i)
+				XMStoreFloat4x4(&matrices[i], transforms[i].GetWorldToLocalMatrixXM());
+			DoNotOptimize(matrices.data());
+		});
+
+		harness.Run("Transform/GetAxes/" + count, s_ObjectCount, [&]() {
+			for (size_t i = 0; i < s_ObjectCount; ++i) {
+				axes[i * 3] = transforms[i].GetRightAxis();
+				axes[i * 3 + 1] = transforms[i].GetUpAxis();
+				axes[i * 3 + 2] = transforms[i].GetForwardAxis();
+			}
+			DoNotOptimize(axes.data());
+		});
+
+		// 一帧内对每个物体的典型读取：世界矩阵、逆矩阵和三个基向量
+		// Static为静止物体(命中缓存)，Moving在读取前修改位置，Uncached每次读取都由四元数重新计算，每个物体只构造一次旋转矩阵
+		struct FrameReads {
+			XMFLOAT4X4 world;
+			XMFLOAT4X4 invWorld;
+			XMFLOAT3 axes[3];
+		};
+		std::vector<FrameReads> reads(s_ObjectCount);
+		auto readAll = [&](const Transform& transform, FrameReads& out) {
+			XMStoreFloat4x4(&out.world, transform.GetLocalToWorldMatrixXM());
+			XMStoreFloat4x4(&out.invWorld, transform.GetWorldToLocalMatrixXM());
+			out.axes[0] = transform.GetRightAxis();
+			out.axes[1] = transform.GetUpAxis();
+			out.axes[2] = transform.GetForwardAxis();
+		};
+
+		harness.Run("Transform/Static/FrameReads/" + count, s_ObjectCount, [&]() {
+			for (size_t i = 0; i < s_ObjectCount; ++i)
+				readAll(transforms[i], reads[i]);
+			DoNotOptimize(reads.data());
+		});
+
+		harness.Run("Transform/Moving/FrameReads/" + count, s_ObjectCount, [&]() {
+			for (size_t i = 0; i < s_ObjectCount; ++i) {
+				transforms[i].SetPosition(transforms[i].GetPosition());
+				readAll(transforms[i], reads[i]);
+			}
+			DoNotOptimize(reads.data());
+		});
+
+		harness.Run("Transform/Uncached/FrameReads/" + count, s_ObjectCount, [&]() {
+			for (size_t i = 0; i < s_ObjectCount; ++i) {
+				const Transform& transform = transforms[i];
+				FrameReads& out = reads[i];
+				XMMATRIX R = XMMatrixRotationQuaternion(transform.GetRotationQuatXM());
+				XMMATRIX W = XMMatrixScalingFromVector(transform.GetScaleXM()) * R *
+					XMMatrixTranslationFromVector(transform.GetPositionXM());
+				XMStoreFloat4x4(&out.world, W);
+				XMStoreFloat4x4(&out.invWorld, XMMatrixInverse(nullptr, W));
+				for (int j = 0; j < 3; ++j)
+					XMStoreFloat3(&out.axes[j], R.r[j]);
+			}
+			DoNotOptimize(reads.data());
+		});
+
+		// 每帧绕轴旋转物体并取世界矩阵
+		harness.Run("Transform/RotateAxisAndGetWorld/" + count, s_ObjectCount, [&]() {
+			for (size_t i = 0; i < s_ObjectCount; ++i) {
+				transforms[i].RotateAxis(XMFLOAT3(0.0f, 1.0f, 0.0f), 0.001f);
+				XMStoreFloat4x4(&matrices[i], transforms[i].GetLocalToWorldMatrixXM());
+			}
+			DoNotOptimize(matrices.data());
+		});
+
+		// BasicEffect::SetWorldMatrix的矩阵准备：世界矩阵及其逆转置的转置
+		harness.Run("Effect/SetWorldMatrixPrep/" + count, s_ObjectCount, [&]() {
+			for (size_t i = 0; i < s_ObjectCount; ++i) {
+				XMMATRIX W = transforms[i].GetLocalToWorldMatrixXM();
+				cbuffers[i].world = XMMatrixTranspose(W);
+				cbuffers[i].worldInvTranspose = XMMatrixTranspose(InverseTranspose(W));
+			}
+			DoNotOptimize(cbuffers.data());
+		});
+	}
+}
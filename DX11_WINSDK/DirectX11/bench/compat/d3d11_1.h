@@ -0,0 +1,82 @@
+#pragma once
+
+// 非Windows平台下基准测试使用的最小D3D11类型定义
+// 只提供Vertex、Geometry、Camera等CPU端代码用到的部分，数值与Windows SDK保持一致
+#ifdef _WIN32
+#error "bench/compat should only be used on non-Windows platforms"
+#endif
+
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+#include <cerrno>
+
+typedef uint8_t BYTE;
+typedef uint16_t WORD;
+typedef uint32_t UINT;
+typedef uint32_t DWORD;
+typedef int32_t INT;
+typedef int32_t BOOL;
+typedef float FLOAT;
+typedef const char* LPCSTR;
+
+enum DXGI_FORMAT {
+	DXGI_FORMAT_UNKNOWN = 0,
+	DXGI_FORMAT_R32G32B32A32_FLOAT = 2,
+	DXGI_FORMAT_R32G32B32_FLOAT = 6,
+	DXGI_FORMAT_R16G16B16A16_FLOAT = 10,
+	DXGI_FORMAT_R32G32_FLOAT = 16,
+	DXGI_FORMAT_R8G8B8A8_UNORM = 28,
+	DXGI_FORMAT_R8G8B8A8_UINT = 30,
+	DXGI_FORMAT_R16G16_FLOAT = 34,
+	DXGI_FORMAT_D32_FLOAT = 40,
+	DXGI_FORMAT_R32_FLOAT = 41,
+	DXGI_FORMAT_R32_UINT = 42,
+	DXGI_FORMAT_D24_UNORM_S8_UINT = 45,
+	DXGI_FORMAT_R16_UINT = 57
+};
+
+enum D3D11_INPUT_CLASSIFICATION {
+	D3D11_INPUT_PER_VERTEX_DATA = 0,
+	D3D11_INPUT_PER_INSTANCE_DATA = 1
+};
+
+#define D3D11_APPEND_ALIGNED_ELEMENT (0xffffffff)
+
+struct D3D11_INPUT_ELEMENT_DESC {
+	LPCSTR SemanticName;
+	UINT SemanticIndex;
+	DXGI_FORMAT Format;
+	UINT InputSlot;
+	UINT AlignedByteOffset;
+	D3D11_INPUT_CLASSIFICATION InputSlotClass;
+	UINT InstanceDataStepRate;
+};
+
+struct D3D11_VIEWPORT {
+	FLOAT TopLeftX;
+	FLOAT TopLeftY;
+	FLOAT Width;
+	FLOAT Height;
+	FLOAT MinDepth;
+	FLOAT MaxDepth;
+};
+
+// 只作为分组键使用的资源接口，CPU端代码不会调用其方法
+struct ID3D11ShaderResourceView;
+
+#ifndef ARRAYSIZE
+template<class T, size_t N>
+char(&BenchArraySizeHelper(T(&)[N]))[N];
+#define ARRAYSIZE(A) (sizeof(BenchArraySizeHelper(A)))
+#endif
+
+inline int memcpy_s(void* dest, size_t destSize, const void* src, size_t count)
+{
+	if (count == 0)
+		return 0;
+	if (dest == nullptr || src == nullptr || destSize < count)
+		return EINVAL;
+	memcpy(dest, src, count);
+	return 0;
+}
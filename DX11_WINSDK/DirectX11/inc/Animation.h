@@ -0,0 +1,102 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include <DirectXMath.h>
+#include "TransformHierarchy.h"
+
+// 关键帧动画
+// 一个剪辑包含若干条轨道，每条轨道对应一个Transform，有缩放、旋转(四元数)、平移三个通道。
+// 所有轨道同一通道的关键帧连续存放在同一组数组中(时间、值、切线分开存放)，
+// 采样结果也按通道分别存放在AnimationPose的数组中
+class AnimationClip {
+public:
+	enum class Channel { Scale, Rotation, Position, Count };
+	enum class Interpolation { Linear, Cubic };
+
+	AnimationClip() = default;
+	~AnimationClip() = default;
+
+	AnimationClip(const AnimationClip&) = default;
+	AnimationClip& operator=(const AnimationClip&) = default;
+
+	AnimationClip(AnimationClip&&) = default;
+	AnimationClip& operator=(AnimationClip&&) = default;
+
+	// 添加一条轨道，没有关键帧的通道输出这里给定的默认值
+	uint32_t AddTrack(const DirectX::XMFLOAT3& scale = { 1.0f, 1.0f, 1.0f },
+		const DirectX::XMFLOAT4& rotationQuat = { 0.0f, 0.0f, 0.0f, 1.0f },
+		const DirectX::XMFLOAT3& position = {});
+	uint32_t GetTrackCount() const;
+
+	// 设置某一通道的关键帧，times需要严格递增，会覆盖该通道原有的关键帧
+	void SetScaleKeys(uint32_t track, const float* times, const DirectX::XMFLOAT3* values, uint32_t count,
+		Interpolation interpolation = Interpolation::Linear);
+	void SetRotationKeys(uint32_t track, const float* times, const DirectX::XMFLOAT4* values, uint32_t count,
+		Interpolation interpolation = Interpolation::Linear);
+	void SetPositionKeys(uint32_t track, const float* times, const DirectX::XMFLOAT3* values, uint32_t count,
+		Interpolation interpolation = Interpolation::Linear);
+
+	uint32_t GetKeyCount(uint32_t track, Channel channel) const;
+	// 所有关键帧中最晚的时间
+	float GetDuration() const;
+
+private:
+	friend class AnimationSampler;
+
+	struct ChannelData {
+		std::vector<float> times;
+		std::vector<DirectX::XMFLOAT4A> values;
+		std::vector<DirectX::XMFLOAT4A> tangents;	// 三次插值用的Hermite切线(对时间的导数)
+		std::vector<uint32_t> keyOffsets;			// 每条轨道的首个关键帧下标
+		std::vector<uint32_t> keyCounts;
+		std::vector<Interpolation> interpolations;
+		std::vector<DirectX::XMFLOAT4A> defaults;
+	};
+
+	void SetKeys(Channel channel, uint32_t track, const float* times, const DirectX::XMFLOAT4A* values, uint32_t count,
+		Interpolation interpolation);
+	void ComputeTangents(ChannelData& data, uint32_t track);
+	void UpdateDuration();
+
+private:
+	ChannelData m_Channels[(size_t)Channel::Count];
+	float m_Duration = 0.0f;
+};
+
+// 采样输出，按通道分别存放，下标与轨道一致
+struct AnimationPose {
+	std::vector<DirectX::XMFLOAT3> scales;
+	std::vector<DirectX::XMFLOAT4> rotations;
+	std::vector<DirectX::XMFLOAT3> positions;
+
+	void Resize(uint32_t trackCount);
+
+	void ApplyTo(uint32_t track, Transform& transform) const;
+	// nodes[i]为第i条轨道驱动的节点
+	void ApplyTo(TransformHierarchy& hierarchy, const TransformHierarchy::NodeHandle* nodes) const;
+};
+
+// 动画采样器
+// 为每条轨道的每个通道记录上一次所在的关键帧区间，时间单调推进时只需向后比较一两个关键帧，
+// 只有时间回退或跳跃较远时才使用二分查找重新定位
+class AnimationSampler {
+public:
+	AnimationSampler() = default;
+	explicit AnimationSampler(const AnimationClip& clip);
+
+	void Reset(const AnimationClip& clip);
+
+	// time会被钳制到[0, duration]
+	void Sample(const AnimationClip& clip, float time, AnimationPose& pose);
+	// 循环播放，time按duration取模
+	void SampleLooped(const AnimationClip& clip, float time, AnimationPose& pose);
+
+private:
+	uint32_t FindKey(const float* times, uint32_t count, float time, uint32_t cursor) const;
+	template<bool IsRotation, class T>
+	void SampleChannel(const AnimationClip::ChannelData& data, uint32_t* cursors, float time, T* out) const;
+
+private:
+	std::vector<uint32_t> m_Cursors[(size_t)AnimationClip::Channel::Count];
+};
@@ -2,6 +2,8 @@
 
 #include <d3d11_1.h>
 #include <DirectXMath.h>
+#include <DirectXCollision.h>
+#include "Culling.h"
 #include "Transform.h"
 
 class Camera {
@@ -11,6 +13,7 @@ public:
 
 	DirectX::XMVECTOR GetPositionXM() const;
 	DirectX::XMFLOAT3 GetPosition() const;
+	Double3 GetPositionDouble() const;
 
 	float GetRotationX() const;
 	float GetRotationY() const;
@@ -22,17 +25,50 @@ public:
 	DirectX::XMVECTOR GetLookAxisXM() const;
 	DirectX::XMFLOAT3 GetLookAxis() const;
 
+	// 以下矩阵与视锥体均被缓存，只在相机变换或视锥体参数改变后的首次读取时重新计算
 	DirectX::XMMATRIX GetViewXM() const;
 	DirectX::XMMATRIX GetProjXM() const;
 	DirectX::XMMATRIX GetViewProjXM() const;
 
+	DirectX::XMMATRIX GetInvViewXM() const;
+	DirectX::XMMATRIX GetInvProjXM() const;
+	DirectX::XMMATRIX GetInvViewProjXM() const;
+
+	// 以相机位置为原点的观察矩阵(只含旋转)，需配合Transform::GetLocalToWorldMatrixXM(origin)使用
+	DirectX::XMMATRIX GetViewRelativeXM() const;
+	DirectX::XMMATRIX GetViewProjRelativeXM() const;
+
+	// 世界空间下的视锥体
+	DirectX::BoundingFrustum GetBoundingFrustum() const;
+	const Culling::FrustumPlanes& GetFrustumPlanes() const;
+
+	// 观察或投影矩阵每改变一次递增，常量缓冲区可据此跳过未变化时的更新
+	uint32_t GetVersion() const;
+
 	D3D11_VIEWPORT GetViewPort() const;
 
 	void SetFrustum(float fovY, float aspect, float nearZ, float farZ);
+	float GetFovY() const;
+	float GetAspectRatio() const;
+	float GetNearZ() const;
+	float GetFarZ() const;
+
+	// 反向Z：近平面深度为1、远平面为0，需配合RenderStates::GetDepthStencilState与GetDepthClearValue使用
+	void SetReverseZ(bool enable);
+	bool IsReverseZ() const;
+	// 无限远平面：投影矩阵忽略farZ，GPU不再按远平面裁剪；视锥体剔除仍以farZ为可视距离
+	void SetInfiniteFarPlane(bool enable);
+	bool IsInfiniteFarPlane() const;
 
 	void SetViewPort(const D3D11_VIEWPORT& viewPort);
 	void SetViewPort(float topLeftX, float topLeftY, float width, float height, float minDepth = 0.0f, float maxDepth = 1.0f);
 
+protected:
+	static float GetPitchFromForwardAxis(const DirectX::XMFLOAT3& forward);
+
+	// 检查变换版本与投影参数，必要时重新计算缓存
+	void UpdateMatrices() const;
+
 protected:
 
 	Transform m_Transform = {};
@@ -41,8 +77,24 @@ protected:
 	float m_FarZ = 0.0f;
 	float m_Aspect = 0.0f;
 	float m_FovY = 0.0f;
+	bool m_ReverseZ = false;
+	bool m_InfiniteFarPlane = false;
 
 	D3D11_VIEWPORT m_ViewPort = {};
+
+private:
+	mutable DirectX::XMFLOAT4X4 m_View = {};
+	mutable DirectX::XMFLOAT4X4 m_Proj = {};
+	mutable DirectX::XMFLOAT4X4 m_ViewProj = {};
+	mutable DirectX::XMFLOAT4X4 m_InvView = {};
+	mutable DirectX::XMFLOAT4X4 m_InvProj = {};
+	mutable DirectX::XMFLOAT4X4 m_InvViewProj = {};
+	mutable DirectX::XMFLOAT4X4 m_CullProj = {};		// 用于剔除的标准投影，远平面为farZ
+	mutable Culling::FrustumPlanes m_FrustumPlanes = {};
+	mutable DirectX::BoundingFrustum m_BoundingFrustum;
+	mutable uint32_t m_CachedTransformVersion = UINT32_MAX;
+	mutable bool m_IsProjDirty = true;
+	mutable uint32_t m_Version = 0;
 };
 
 class FirstPersonCamera : public Camera {
@@ -52,9 +104,12 @@ public:
 
 	void SetPosition(float x, float y, float z);
 	void SetPosition(const DirectX::XMFLOAT3& pos);
+	void SetPosition(const Double3& pos);
 
 	void LookAt(const DirectX::XMFLOAT3& pos, const DirectX::XMFLOAT3& target, const DirectX::XMFLOAT3& up);
+	void LookAt(const Double3& pos, const Double3& target, const DirectX::XMFLOAT3& up);
 	void LookTo(const DirectX::XMFLOAT3& pos, const DirectX::XMFLOAT3& to, const DirectX::XMFLOAT3& up);
+	void LookTo(const Double3& pos, const DirectX::XMFLOAT3& to, const DirectX::XMFLOAT3& up);
 
 	void Strafe(float d);
 
@@ -73,6 +128,7 @@ public:
 	~ThirdPersonCamera() override;
 
 	DirectX::XMFLOAT3 GetTargetPosition() const;
+	Double3 GetTargetPositionDouble() const;
 	float GetDistance() const;
 	void RotateX(float rad);
 	void RotateY(float rad);
@@ -80,11 +136,12 @@ public:
 	void SetRotationX(float rad);
 	void SetRotationY(float rad);
 	void SetTarget(const DirectX::XMFLOAT3& target);
+	void SetTarget(const Double3& target);
 	void SetDistance(float dist);
 	void SetDistanceMinMax(float minDist, float maxDist);
 
 private:
-	DirectX::XMFLOAT3 m_Target = {};
+	Double3 m_Target = {};
 	float m_Distance = 0.0f;
 	float m_MinDist = 0.0f, m_MaxDist = 0.0f;
 };
\ No newline at end of file
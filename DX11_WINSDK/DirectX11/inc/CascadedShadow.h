@@ -0,0 +1,67 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include <DirectXMath.h>
+#include "Culling.h"
+
+class Camera;
+class JobSystem;
+struct DirectionalLight;
+
+// 方向光的级联阴影
+// 按实用划分(对数与均匀划分的加权)将相机视锥体沿深度切成若干段，每段用包围球确定正交投影的范围，
+// 包围球半径只与划分深度有关，相机旋转时投影大小不变；球心在光源空间按阴影贴图纹素大小对齐，
+// 相机平移时阴影边缘不会闪烁
+class CascadedShadow {
+public:
+	// 划分深度可放入一个float4传给着色器
+	static const uint32_t MaxCascades = 4;
+
+	struct Cascade {
+		float nearZ, farZ;							// 该段在相机观察空间的深度范围
+		DirectX::XMFLOAT3 center;					// 世界空间包围球(球心已按纹素对齐)
+		float radius;
+		DirectX::XMFLOAT4X4 lightView;
+		DirectX::XMFLOAT4X4 lightProj;
+		DirectX::XMFLOAT4X4 lightViewProj;
+		DirectX::XMFLOAT4X4 shadowTransform;		// 世界空间 -> 阴影贴图纹理空间[0, 1]
+		Culling::FrustumPlanes planes;				// 光源正交体，用于筛选投射者
+	};
+
+	CascadedShadow() = default;
+	~CascadedShadow() = default;
+
+	// lambda为0时均匀划分，为1时对数划分
+	void SetCascadeCount(uint32_t count);
+	void SetSplitLambda(float lambda);
+	void SetShadowMapSize(uint32_t size);
+	// 阴影的最远距离，为0时使用相机的farZ
+	void SetShadowDistance(float distance);
+	// 包围球朝光源方向额外延伸的距离，位于球外但挡在光源与球之间的物体仍能投射阴影
+	void SetCasterExtrusion(float distance);
+
+	uint32_t GetCascadeCount() const;
+	float GetSplitLambda() const;
+	uint32_t GetShadowMapSize() const;
+
+	void Update(const Camera& camera, const DirectionalLight& light);
+	void XM_CALLCONV Update(const Camera& camera, DirectX::FXMVECTOR lightDirection);
+
+	const Cascade& GetCascade(uint32_t index) const;
+	// 各段的farZ，供着色器选择级联，多余的分量重复最后一段
+	DirectX::XMFLOAT4 GetCascadeSplits() const;
+
+	// 输出与第cascade段光源正交体相交的包围盒下标，按升序排列，返回数目
+	size_t CullCasters(uint32_t cascade, const Culling::BoundingBoxSoA& boxes, uint32_t* casterIndices) const;
+	// 为所有级联生成投射者列表，casterLists至少有GetCascadeCount()个元素，每个级联的剔除在线程池中并行
+	void CullCasters(JobSystem& jobSystem, const Culling::BoundingBoxSoA& boxes, std::vector<uint32_t>* casterLists) const;
+
+private:
+	uint32_t m_CascadeCount = 4;
+	float m_SplitLambda = 0.75f;
+	uint32_t m_ShadowMapSize = 2048;
+	float m_ShadowDistance = 0.0f;
+	float m_CasterExtrusion = 100.0f;
+	Cascade m_Cascades[MaxCascades] = {};
+};
@@ -0,0 +1,95 @@
+#pragma once
+
+#include <wrl/client.h>
+#include <d3d11_1.h>
+#include <cstdint>
+#include <vector>
+#include "DeviceContextStateCache.h"
+
+// 逐物体常量缓冲区环
+// 一个大的动态常量缓冲区按256字节为单位分配给各次绘制，通过ID3D11DeviceContext1::VSSetConstantBuffers1
+// 的偏移绑定。绘制分为两个阶段：Begin与End之间写入一帧所有物体的常量(只Map一次)，End之后绑定并绘制。
+// 环在帧之间循环使用，剩余空间足够时以WRITE_NO_OVERWRITE映射，否则回到起点以WRITE_DISCARD映射
+// 一帧写满剩余空间后，之后的分配暂存在内存中，End时上传到单独的溢出缓冲区；下一帧按本帧用量扩大环
+// 设备不支持常量缓冲区偏移时(非11.1运行时)，数据保存在内存中，绑定时逐次Map一个普通常量缓冲区
+class ConstantBufferRing {
+public:
+	template <class T>
+	using ComPtr = Microsoft::WRL::ComPtr<T>;
+
+	// VSSetConstantBuffers1的偏移与大小须为16个常量(256字节)的倍数
+	static const UINT AlignmentBytes = 256;
+
+	struct Allocation {
+		UINT offset;			// 相对于本帧起点的字节偏移
+		UINT byteSize;			// 已对齐到AlignmentBytes
+	};
+
+	ConstantBufferRing() = default;
+	~ConstantBufferRing() = default;
+
+	ConstantBufferRing(const ConstantBufferRing&) = delete;
+	ConstantBufferRing& operator=(const ConstantBufferRing&) = delete;
+
+	// deviceContext1为nullptr时使用回退路径
+	bool InitResource(ID3D11Device* device, ID3D11DeviceContext1* deviceContext1, UINT byteWidth = 4 * 1024 * 1024);
+	bool IsOffsettingSupported() const;
+
+	void Begin(ID3D11DeviceContext* deviceContext);
+	Allocation Allocate(const void* data, UINT byteSize);
+	template<class T>
+	Allocation Allocate(const T& data) { return Allocate(&data, sizeof(T)); }
+	// 本帧超出剩余空间时在这里上传溢出的部分
+	void End(ID3D11DeviceContext* deviceContext);
+
+	// 经由stateCache绑定，连续绑定同一分配时不重复调用
+	void BindVS(DeviceContextStateCache& stateCache, ID3D11DeviceContext* deviceContext, UINT slot, const Allocation& allocation);
+	void BindGS(DeviceContextStateCache& stateCache, ID3D11DeviceContext* deviceContext, UINT slot, const Allocation& allocation);
+	void BindPS(DeviceContextStateCache& stateCache, ID3D11DeviceContext* deviceContext, UINT slot, const Allocation& allocation);
+
+	// 本帧至今的Map次数与写入字节数
+	UINT GetMapCount() const;
+	UINT GetFrameBytes() const;
+
+private:
+	enum Stage { StageVS, StageGS, StagePS, StageCount };
+
+	struct FallbackBuffer {
+		ComPtr<ID3D11Buffer> buffer;
+		UINT byteWidth = 0;
+		uint64_t frame = 0;
+		UINT offset = UINT32_MAX;		// 本帧已上传的分配，连续绑定同一分配时不重复Map
+	};
+
+	HRESULT CreateDynamicBuffer(UINT byteWidth, ID3D11Buffer** ppBuffer);
+	HRESULT CreateRingBuffer(UINT byteWidth);
+	// 返回分配所在的缓冲区及其中的首个常量下标
+	ID3D11Buffer* GetOffsetBinding(const Allocation& allocation, UINT& firstConstant) const;
+	ID3D11Buffer* UploadFallback(ID3D11DeviceContext* deviceContext, Stage stage, UINT slot, const Allocation& allocation);
+
+private:
+	ComPtr<ID3D11Device> m_pDevice;
+	ComPtr<ID3D11DeviceContext1> m_pDeviceContext1;
+	ComPtr<ID3D11Buffer> m_pBuffer;
+	UINT m_ByteWidth = 0;
+	bool m_Offsetting = false;
+	bool m_NoOverwrite = false;			// 是否支持以WRITE_NO_OVERWRITE映射动态常量缓冲区
+
+	uint8_t* m_pMapped = nullptr;
+	UINT m_RingHead = 0;				// 上一帧结束的位置
+	UINT m_FrameStart = 0;
+	UINT m_FrameBytes = 0;
+	UINT m_LastFrameBytes = 0;
+	UINT m_MapCount = 0;
+	uint64_t m_FrameIndex = 0;
+
+	// 超出剩余空间后本帧从m_SpillStart起的数据暂存在m_Spill中，已写入映射内存的部分不再读回
+	// 回退路径下m_SpillStart为0，整帧的数据都在m_Spill中
+	bool m_Spilled = false;
+	UINT m_SpillStart = 0;
+	std::vector<uint8_t> m_Spill;
+	ComPtr<ID3D11Buffer> m_pOverflowBuffer;
+	UINT m_OverflowByteWidth = 0;
+
+	std::vector<FallbackBuffer> m_FallbackBuffers[StageCount];
+};
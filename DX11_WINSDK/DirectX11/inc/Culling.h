@@ -0,0 +1,56 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include <DirectXMath.h>
+
+class JobSystem;
+
+// 视锥体剔除
+// 包围体按分量分开存放(SoA)，剔除内核每次从各分量数组中读取4个包围体并同时与6个平面测试，
+// 输出可见包围体的下标列表
+namespace Culling {
+	// 平面(a, b, c, d)满足ax + by + cz + d >= 0的一侧为视锥体内部，法向量已归一化
+	// 顺序为左、右、下、上、近、远
+	struct FrustumPlanes {
+		DirectX::XMFLOAT4 planes[6];
+	};
+
+	// 从观察投影矩阵(行向量约定，裁剪空间深度范围[0, w])提取视锥体平面，
+	// 传入投影矩阵得到观察空间平面，传入观察投影矩阵得到世界空间平面
+	// 反向Z时近平面为z = w、远平面为z = 0；无限远平面退化为恒在内部的(0, 0, 0, 1)
+	FrustumPlanes XM_CALLCONV ExtractFrustumPlanes(DirectX::FXMMATRIX viewProj, bool reverseZ = false);
+
+	struct BoundingSphereSoA {
+		std::vector<float> centerX, centerY, centerZ;
+		std::vector<float> radius;
+
+		void Reserve(size_t count);
+		void Resize(size_t count);
+		size_t Size() const;
+		void Set(size_t index, const DirectX::XMFLOAT3& center, float r);
+		void Add(const DirectX::XMFLOAT3& center, float r);
+	};
+
+	struct BoundingBoxSoA {
+		std::vector<float> centerX, centerY, centerZ;
+		std::vector<float> extentsX, extentsY, extentsZ;
+
+		void Reserve(size_t count);
+		void Resize(size_t count);
+		size_t Size() const;
+		void Set(size_t index, const DirectX::XMFLOAT3& center, const DirectX::XMFLOAT3& extents);
+		void Add(const DirectX::XMFLOAT3& center, const DirectX::XMFLOAT3& extents);
+	};
+
+	// 与视锥体相交或在其内部的包围体视为可见，visibleIndices至少能容纳count个下标
+	// 返回可见数目，下标按升序输出
+	size_t CullSpheres(const FrustumPlanes& frustum, const BoundingSphereSoA& spheres, uint32_t* visibleIndices);
+	size_t CullBoxes(const FrustumPlanes& frustum, const BoundingBoxSoA& boxes, uint32_t* visibleIndices);
+
+	// 多线程版本，每批grainSize个包围体，结果与单线程版本相同
+	size_t CullSpheres(JobSystem& jobSystem, const FrustumPlanes& frustum, const BoundingSphereSoA& spheres,
+		uint32_t* visibleIndices, uint32_t grainSize = 16384);
+	size_t CullBoxes(JobSystem& jobSystem, const FrustumPlanes& frustum, const BoundingBoxSoA& boxes,
+		uint32_t* visibleIndices, uint32_t grainSize = 16384);
+}
@@ -0,0 +1,91 @@
+#pragma once
+
+#include <d3d11_1.h>
+
+// 设备上下文状态缓存
+// 记录经由它设置的管线状态，参数与当前绑定相同的调用直接丢弃，不再进入运行时与驱动
+// 只知道经由它设置的状态：其他代码直接修改了这些状态(如ClearState)之后须调用Invalidate，
+// 换用另一个上下文时自动清空记录
+class DeviceContextStateCache {
+public:
+	// 记录的着色器资源槽数，更高的槽不过滤
+	static const UINT ShaderResourceSlotCount = 16;
+
+	// 自上一次ResetStats以来实际发出与被过滤的调用次数
+	struct Stats {
+		UINT issuedCalls;
+		UINT filteredCalls;
+	};
+
+	DeviceContextStateCache();
+	~DeviceContextStateCache() = default;
+
+	DeviceContextStateCache(const DeviceContextStateCache&) = delete;
+	DeviceContextStateCache& operator=(const DeviceContextStateCache&) = delete;
+
+	// 忘记所有已记录的状态，之后的每个调用都会发出一次
+	void Invalidate();
+
+	void IASetPrimitiveTopology(ID3D11DeviceContext* deviceContext, D3D11_PRIMITIVE_TOPOLOGY topology);
+	void IASetInputLayout(ID3D11DeviceContext* deviceContext, ID3D11InputLayout* inputLayout);
+
+	void VSSetShader(ID3D11DeviceContext* deviceContext, ID3D11VertexShader* shader);
+	void GSSetShader(ID3D11DeviceContext* deviceContext, ID3D11GeometryShader* shader);
+	void PSSetShader(ID3D11DeviceContext* deviceContext, ID3D11PixelShader* shader);
+	void RSSetState(ID3D11DeviceContext* deviceContext, ID3D11RasterizerState* rasterizerState);
+
+	// 每次绑定一个槽
+	void VSSetConstantBuffer(ID3D11DeviceContext* deviceContext, UINT slot, ID3D11Buffer* buffer);
+	void GSSetConstantBuffer(ID3D11DeviceContext* deviceContext, UINT slot, ID3D11Buffer* buffer);
+	void PSSetConstantBuffer(ID3D11DeviceContext* deviceContext, UINT slot, ID3D11Buffer* buffer);
+	// 带常量偏移的绑定，缓冲区相同而偏移不同时照常发出
+	void VSSetConstantBuffer1(ID3D11DeviceContext1* deviceContext1, UINT slot, ID3D11Buffer* buffer, UINT firstConstant, UINT numConstants);
+	void GSSetConstantBuffer1(ID3D11DeviceContext1* deviceContext1, UINT slot, ID3D11Buffer* buffer, UINT firstConstant, UINT numConstants);
+	void PSSetConstantBuffer1(ID3D11DeviceContext1* deviceContext1, UINT slot, ID3D11Buffer* buffer, UINT firstConstant, UINT numConstants);
+
+	void PSSetShaderResource(ID3D11DeviceContext* deviceContext, UINT slot, ID3D11ShaderResourceView* shaderResource);
+
+	const Stats& GetStats() const;
+	void ResetStats();
+
+private:
+	enum Stage { StageVS, StageGS, StagePS, StageCount };
+
+	template<class T>
+	struct CachedValue {
+		T value;
+		bool valid;
+	};
+
+	// 整个缓冲区绑定时firstConstant与numConstants均为0
+	struct ConstantBufferBinding {
+		ID3D11Buffer* buffer;
+		UINT firstConstant;
+		UINT numConstants;
+
+		bool operator==(const ConstantBufferBinding& other) const {
+			return buffer == other.buffer && firstConstant == other.firstConstant && numConstants == other.numConstants;
+		}
+	};
+
+	struct State {
+		CachedValue<D3D11_PRIMITIVE_TOPOLOGY> topology;
+		CachedValue<ID3D11InputLayout*> inputLayout;
+		CachedValue<ID3D11VertexShader*> vertexShader;
+		CachedValue<ID3D11GeometryShader*> geometryShader;
+		CachedValue<ID3D11PixelShader*> pixelShader;
+		CachedValue<ID3D11RasterizerState*> rasterizerState;
+		CachedValue<ConstantBufferBinding> constantBuffers[StageCount][D3D11_COMMONSHADER_CONSTANT_BUFFER_API_SLOT_COUNT];
+		CachedValue<ID3D11ShaderResourceView*> psShaderResources[ShaderResourceSlotCount];
+	};
+
+	// 返回true表示调用可以丢弃，否则记录新值
+	template<class T>
+	bool Filter(ID3D11DeviceContext* deviceContext, CachedValue<T>& cached, const T& value);
+	bool FilterConstantBuffer(ID3D11DeviceContext* deviceContext, Stage stage, UINT slot, const ConstantBufferBinding& binding);
+
+private:
+	ID3D11DeviceContext* m_pDeviceContext;
+	State m_State;
+	Stats m_Stats;
+};
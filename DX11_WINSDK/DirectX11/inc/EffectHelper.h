@@ -1,5 +1,8 @@
 #pragma once
 
+#include <cassert>
+#include <cstring>
+
 template<class DerivedType>
 struct AlignedType {
 
@@ -25,6 +28,22 @@ struct CBufferBase {
 	template<class T>
 	using ComPtr = Microsoft::WRL::ComPtr<T>;
 
+	// 所有常量缓冲区的上传统计，每帧开始时清零
+	struct UploadStats {
+		UINT64 uploadBytes;
+		UINT uploadCount;
+		UINT skipCount;			// 标记为脏但内容与上次上传相同而跳过的次数
+	};
+
+	static UploadStats& GetUploadStats() {
+		static UploadStats stats = {};
+		return stats;
+	}
+
+	static void ResetUploadStats() {
+		GetUploadStats() = UploadStats();
+	}
+
 	CBufferBase() : isDirty() {}
 	~CBufferBase() = default;
 
@@ -41,11 +60,38 @@ struct CBufferBase {
 	virtual void BindPS(ID3D11DeviceContext* deviceContext) = 0;
 };
 
+// data与上一次上传的内容(shadow)分开保存，Write只在字段的值改变时写入并记录脏的字节范围，
+// UpdateBuffer只比较脏范围内的字节，与上次上传相同时不Map
+// WRITE_DISCARD要求写满整个缓冲区，因此真正上传时仍复制整个T
 template<UINT startSlot, class T>
 struct CBufferObject : CBufferBase {
 	T data;
 
-	CBufferObject() : CBufferBase(), data(){}
+	CBufferObject() : CBufferBase(), data(), shadow(), dirtyBegin(), dirtyEnd(), hasUploaded() {}
+
+	// field须为data的成员(或成员数组的元素)，返回值是否改变
+	template<class U>
+	bool Write(U& field, const U& value) {
+		if (memcmp(&field, &value, sizeof(U)) == 0)
+			return false;
+		size_t offset = reinterpret_cast<const BYTE*>(&field) - reinterpret_cast<const BYTE*>(&data);
+		assert(offset + sizeof(U) <= sizeof(T));
+		memcpy(&field, &value, sizeof(U));
+		MarkDirty(offset, sizeof(U));
+		return true;
+	}
+
+	void MarkDirty(size_t offset, size_t size) {
+		if (dirtyEnd <= dirtyBegin) {
+			dirtyBegin = offset;
+			dirtyEnd = offset + size;
+		}
+		else {
+			dirtyBegin = offset < dirtyBegin ? offset : dirtyBegin;
+			dirtyEnd = offset + size > dirtyEnd ? offset + size : dirtyEnd;
+		}
+		isDirty = true;
+	}
 
 	HRESULT CreateBuffer(ID3D11Device* device) override
 	{
@@ -63,10 +109,31 @@ struct CBufferObject : CBufferBase {
 	void UpdateBuffer(ID3D11DeviceContext* deviceContext) override {
 		if (isDirty) {
 			isDirty = false;
+			// 直接设置isDirty而没有记录范围时比较整个缓冲区
+			size_t begin = dirtyBegin, end = dirtyEnd;
+			if (end <= begin) {
+				begin = 0;
+				end = sizeof(T);
+			}
+			dirtyBegin = dirtyEnd = 0;
+
+			const BYTE* pData = reinterpret_cast<const BYTE*>(&data);
+			BYTE* pShadow = reinterpret_cast<BYTE*>(&shadow);
+			if (hasUploaded && memcmp(pShadow + begin, pData + begin, end - begin) == 0) {
+				++GetUploadStats().skipCount;
+				return;
+			}
+
 			D3D11_MAPPED_SUBRESOURCE mappedData;
 			deviceContext->Map(cBuffer.Get(), 0, D3D11_MAP_WRITE_DISCARD, 0, &mappedData);
 			memcpy_s(mappedData.pData, sizeof(T), &data, sizeof(T));
 			deviceContext->Unmap(cBuffer.Get(), 0);
+			memcpy(pShadow, pData, sizeof(T));
+			hasUploaded = true;
+
+			UploadStats& stats = GetUploadStats();
+			stats.uploadBytes += sizeof(T);
+			++stats.uploadCount;
 		}
 	}
 
@@ -93,4 +160,9 @@ struct CBufferObject : CBufferBase {
 	void BindPS(ID3D11DeviceContext* deviceContext) override {
 		deviceContext->PSSetConstantBuffers(startSlot, 1, cBuffer.GetAddressOf());
 	}
+
+private:
+	T shadow;					// 上一次上传到GPU的内容
+	size_t dirtyBegin, dirtyEnd;
+	bool hasUploaded;
 };
\ No newline at end of file
@@ -1,8 +1,11 @@
 #pragma once
 #include <memory>
+#include "ConstantBufferRing.h"
 #include "LightHelper.h"
 #include "RenderStates.h"
 
+class Camera;
+
 class IEffect {
 public:
 	template <class T>
@@ -50,8 +53,14 @@ public:
 	void SetRenderSplitedTriangle(ID3D11DeviceContext* deviceContext);
 	void SetRenderCylinderNoCap(ID3D11DeviceContext* deviceContext);
 	void SetRenderNormal(ID3D11DeviceContext* deviceContext);
+	// 顶点槽0为VertexPosNormalColor，槽1为InstancedData，世界矩阵取自实例数据
+	void SetRenderInstanced(ID3D11DeviceContext* deviceContext);
 
 	void XM_CALLCONV SetWorldMatrix(DirectX::FXMMATRIX W);
+	// 把世界矩阵与材质写入常量缓冲区环(在ring的Begin与End之间调用)，返回的分配在End之后交给SetObjectConstants
+	ConstantBufferRing::Allocation XM_CALLCONV WriteObjectConstants(ConstantBufferRing& ring, DirectX::FXMMATRIX W, const Material& material);
+	// 之后的Apply从ring中绑定物体常量而不再上传CBChangesEveryDrawing，ring为nullptr时恢复SetWorldMatrix与SetMaterial的数据
+	void SetObjectConstants(ConstantBufferRing* ring, const ConstantBufferRing::Allocation& allocation);
 	void XM_CALLCONV SetViewMatrix(DirectX::FXMMATRIX V);
 	void XM_CALLCONV SetProjMatrix(DirectX::FXMMATRIX P);
 	void XM_CALLCONV SetReflectionMatrix(DirectX::FXMMATRIX R);
@@ -67,12 +76,18 @@ public:
 	void SetMaterial(const Material& material);
 	void SetTexture(ID3D11ShaderResourceView* texture);
 	void SetEyePos(const DirectX::XMFLOAT3& eyePos);
+	// 以相机位置为原点绘制：观察矩阵取Camera::GetViewRelativeXM，g_EyePosW为原点
+	// 世界矩阵须由Transform::GetLocalToWorldMatrixXM(camera.GetPositionDouble())构建，点光源与聚光灯的位置也须相对于相机
+	void SetCameraRelative(const Camera& camera);
 
 	void SetReflectionState(bool isOn);
 	void SetShadowState(bool isOn);
 
 	void SetCylinderHeight(float height);
 
+	// SetRender*与Apply对上下文的调用都经由它过滤；其他代码直接修改了这些状态后须调用其Invalidate
+	DeviceContextStateCache& GetStateCache();
+
 	void Apply(ID3D11DeviceContext* deviceContext) override;
 
 private:
@@ -15,6 +15,8 @@ public:
 
 	bool Init();
 	void OnResize();
+	void ProcessInput(float dt);
+	void SaveSceneState();
 	void UpdateScene(float dt);
 	void DrawScene();
 
@@ -34,6 +36,13 @@ private:
 	int m_VertexCount;
 	Mode m_ShowMode;
 
+	// 固定步长更新的旋转角度，绘制时在上一步与当前步之间插值
+	float m_Phi, m_Theta;
+	float m_PrevPhi, m_PrevTheta;
+
+	// 反向Z + 无限远平面投影
+	bool m_ReverseZ;
+
 	BasicEffect m_BasicEffect;
 
 };
\ No newline at end of file
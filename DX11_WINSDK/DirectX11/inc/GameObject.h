@@ -1,8 +1,11 @@
 #pragma once
+#include <DirectXCollision.h>
 #include "Effects.h"
-#include "Geometry.h"
+#include "MeshRegistry.h"
 #include "Transform.h"
 
+class LooseOctree;
+
 class GameObject {
 public:
 	template <class T>
@@ -10,58 +13,64 @@ public:
 
 	GameObject();
 
+	// 加入空间索引后持有八叉树中的句柄，复制后两个物体会共用同一句柄，因此禁止复制
+	GameObject(const GameObject&) = delete;
+	GameObject& operator=(const GameObject&) = delete;
+
 	Transform& GetTransform();
 	const Transform& GetTransform() const;
 
-	template<class VertexType, class IndexType>
-	void SetBuffer(ID3D11Device* device, const Geometry::MeshData<VertexType, IndexType>& meshData);
+	// 在每次固定步长更新之前(D3DApp::SaveSceneState中)保存当前状态，绘制时在上一状态与当前状态之间插值
+	void SavePreviousTransform();
+	const Transform& GetPreviousTransform() const;
+	Transform GetInterpolatedTransform(float alpha) const;
+
+	// 引用MeshRegistry中的网格，多个物体共享同一份顶点/索引缓冲区
+	void SetMesh(const MeshHandle& mesh);
+	const MeshHandle& GetMesh() const;
 	void SetTexture(ID3D11ShaderResourceView* texture);
+	ID3D11ShaderResourceView* GetTexture() const;
 	void SetMaterial(const Material& material);
+	const Material& GetMaterial() const;
+
+	// 模型空间包围盒，SetMesh时取网格的包围盒
+	void SetLocalBoundingBox(const DirectX::BoundingBox& box);
+	const DirectX::BoundingBox& GetLocalBoundingBox() const;
+	// 世界空间的轴对齐包围盒
+	DirectX::BoundingBox GetBoundingBox() const;
+	// 世界空间的有向包围盒，用于窄阶段的预筛选
+	DirectX::BoundingOrientedBox GetOrientedBoundingBox() const;
+
+	// 加入空间索引后每帧调用UpdateSpatialIndex，只有Transform的版本号或包围盒改变时才更新
+	void AddToSpatialIndex(LooseOctree& octree, uint32_t userData);
+	void RemoveFromSpatialIndex(LooseOctree& octree);
+	void UpdateSpatialIndex(LooseOctree& octree);
+
+	// 绘制时世界矩阵以origin(相机的GetPositionDouble)为原点，平移先以双精度相减，远离世界原点时也不丢失精度
+	// 须与BasicEffect::SetCameraRelative设置的观察矩阵配合使用
+	void Draw(ID3D11DeviceContext* deviceContext, BasicEffect& effect, const Double3& origin);
+	void Draw(ID3D11DeviceContext* deviceContext, BasicEffect& effect, const Double3& origin, float alpha);
 
-	void Draw(ID3D11DeviceContext* deviceContext, BasicEffect& effect);
+	// 两阶段绘制：在ring的Begin与End之间为每个物体调用WriteConstants，End之后再调用Draw，
+	// 一帧所有物体的常量只需Map一次
+	void WriteConstants(BasicEffect& effect, ConstantBufferRing& ring, const Double3& origin);
+	void Draw(ID3D11DeviceContext* deviceContext, BasicEffect& effect, ConstantBufferRing& ring);
 
-	void SetDebugObjectName(const std::string& name);
+private:
+	// 绑定网格的顶点/索引缓冲区，没有网格时返回nullptr
+	const MeshResource* BindMesh(ID3D11DeviceContext* deviceContext) const;
+	void XM_CALLCONV DrawWithWorld(ID3D11DeviceContext* deviceContext, BasicEffect& effect, DirectX::FXMMATRIX world);
 
 private:
 	Transform m_Transfrom;
+	Transform m_PrevTransform;
 	Material m_Material;
 	ComPtr<ID3D11ShaderResourceView> m_pTexture;
-	ComPtr<ID3D11Buffer> m_pVertexBuffer;
-	ComPtr<ID3D11Buffer> m_pIndexBuffer;
-	UINT m_VertexStride;
-	UINT m_IndexCount;
+	MeshHandle m_Mesh;
+	DirectX::BoundingBox m_LocalBoundingBox;
+	ConstantBufferRing::Allocation m_ConstantAllocation;
+	uint32_t m_SpatialHandle;
+	uint32_t m_SpatialVersion;
+	bool m_SpatialDirty;
 
 };
-
-template<class VertexType, class IndexType>
-inline void GameObject::SetBuffer(ID3D11Device* device, const Geometry::MeshData<VertexType, IndexType>& meshData) {
-	m_pVertexBuffer.Reset();
-	m_pIndexBuffer.Reset();
-
-	if (device == nullptr)
-		return;
-
-	m_VertexStride = sizeof(VertexType);
-	D3D11_BUFFER_DESC vbd;
-	ZeroMemory(&vbd, sizeof(vbd));
-	vbd.Usage = D3D11_USAGE_IMMUTABLE;
-	vbd.ByteWidth = m_VertexStride * (UINT)meshData.vertexVec.size();
-	vbd.BindFlags = D3D11_BIND_VERTEX_BUFFER;
-	vbd.CPUAccessFlags = 0;
-	
-	D3D11_SUBRESOURCE_DATA InitData;
-	ZeroMemory(&InitData, sizeof(InitData));
-	InitData.pSysMem = meshData.vertexVec.data();
-	device->CreateBuffer(&vbd, &InitData, m_pVertexBuffer.GetAddressOf());
-
-	m_IndexCount = (UINT)meshData.indexVec.size();
-	D3D11_BUFFER_DESC ibd;
-	ZeroMemory(&ibd, sizeof(ibd));
-	ibd.Usage = D3D11_USAGE_IMMUTABLE;
-	ibd.ByteWidth = m_IndexCount * sizeof(IndexType);
-	ibd.BindFlags = D3D11_BIND_INDEX_BUFFER;
-	ibd.CPUAccessFlags = 0;
-
-	InitData.pSysMem = meshData.indexVec.data();
-	device->CreateBuffer(&ibd, &InitData, m_pIndexBuffer.GetAddressOf());
-}
\ No newline at end of file
@@ -5,6 +5,7 @@
 #include <map>
 #include <functional>
 #include "Vertex.h"
+#include "TerrainField.h"
 
 namespace Geometry {
 	// 网格数据
@@ -58,15 +59,19 @@ namespace Geometry {
 	// 创建地形
 	template<class VertexType = VertexPosNormalTex, class IndexType = DWORD>
 	MeshData<VertexType, IndexType> CreateTerrain(const DirectX::XMFLOAT2& terrainSize, const DirectX::XMUINT2& slices = { 10, 10 }, const DirectX::XMFLOAT2& maxTexCoord = { 1.0f, 1.0f },
-		const std::function<float(float, float)>& heightFunc = [](float x, float z) {return 0.0f},
-		const std::function<DirectX::XMFLOAT3(float, float)>& normalFunc = [](float x, float z) {return DirectX::XMFLOAT3(0.0f, 1.0f, 0.0f)},
-		const std::function<DirectX::XMFLOAT4(float, float)>& colorFunc = [](float x, float z) {return DirectX::XMFLOAT4(1.0f, 1.0f, 1.0f, 1.0f)});
+		const std::function<float(float, float)>& heightFunc = [](float x, float z) {return 0.0f;},
+		const std::function<DirectX::XMFLOAT3(float, float)>& normalFunc = [](float x, float z) {return DirectX::XMFLOAT3(0.0f, 1.0f, 0.0f);},
+		const std::function<DirectX::XMFLOAT4(float, float)>& colorFunc = [](float x, float z) {return DirectX::XMFLOAT4(1.0f, 1.0f, 1.0f, 1.0f);});
 	template<class VertexType = VertexPosNormalTex, class IndexType = DWORD>
 	MeshData<VertexType, IndexType> CreateTerrain(float width = 10.0f, float depth = 10.0f, 
 	UINT slicesX = 10, UINT slicesZ = 10, float texU = 1.0f, float texV = 1.0f, 
 	const std::function<float(float, float)>& heightFunc = [](float x, float z) {return 0.0f;},
-		const std::function<DirectX::XMFLOAT3(float, float)>& normalFunc = [](float x, float z) {return DirectX::XMFLOAT3(0.0f, 1.0f, 0.0f)},
-		const std::function<DirectX::XMFLOAT4(float, float)>& colorFunc = [](float x, float z) {return DirectX::XMFLOAT4(1.0f, 1.0f, 1.0f, 1.0f)});
+		const std::function<DirectX::XMFLOAT3(float, float)>& normalFunc = [](float x, float z) {return DirectX::XMFLOAT3(0.0f, 1.0f, 0.0f);},
+		const std::function<DirectX::XMFLOAT4(float, float)>& colorFunc = [](float x, float z) {return DirectX::XMFLOAT4(1.0f, 1.0f, 1.0f, 1.0f);});
+	// 使用已采样的高度场创建地形，顶点与TerrainField中的网格一一对应
+	template<class VertexType = VertexPosNormalTex, class IndexType = DWORD>
+	MeshData<VertexType, IndexType> CreateTerrain(const TerrainField& terrainField, float texU = 1.0f, float texV = 1.0f,
+		const std::function<DirectX::XMFLOAT4(float, float)>& colorFunc = [](float x, float z) {return DirectX::XMFLOAT4(1.0f, 1.0f, 1.0f, 1.0f);});
 }
 
 namespace Geometry {
@@ -77,6 +82,9 @@ namespace Geometry {
 			DirectX::XMFLOAT4 tangent;
 			DirectX::XMFLOAT4 color;
 			DirectX::XMFLOAT2 tex;
+			// 几何体不含骨骼，蒙皮顶点默认完全受0号骨骼影响
+			uint8_t boneIndices[4] = { 0, 0, 0, 0 };
+			DirectX::XMFLOAT4 weights = DirectX::XMFLOAT4(1.0f, 0.0f, 0.0f, 0.0f);
 		};
 
 		template<class VertexType>
@@ -87,12 +95,17 @@ namespace Geometry {
 				{"NORMAL", std::pair<size_t, size_t>(12, 24)},
 				{"TANGENT", std::pair<size_t, size_t>(24, 40)},
 				{"COLOR", std::pair<size_t, size_t>(40, 56)},
-				{"TEXCOORD", std::pair<size_t, size_t>(56, 64)}
+				{"TEXCOORD", std::pair<size_t, size_t>(56, 64)},
+				{"BLENDINDICES", std::pair<size_t, size_t>(64, 68)},
+				{"BLENDWEIGHT", std::pair<size_t, size_t>(68, 84)}
 			};
 
 			for (size_t i = 0; i < ARRAYSIZE(VertexType::inputLayout); i++) {
 				semanticName = VertexType::inputLayout[i].SemanticName;
-				const auto& range = semanticSizeMap.at(semanticName);
+				auto it = semanticSizeMap.find(semanticName);
+				if (it == semanticSizeMap.end())
+					continue;
+				const auto& range = it->second;
 				memcpy_s(reinterpret_cast<char*>(&vertexDst) + VertexType::inputLayout[i].AlignedByteOffset, 
 				range.second - range.first, 
 				reinterpret_cast<const char*>(&vertexSrc) + range.first, 
@@ -653,4 +666,65 @@ namespace Geometry {
 
 		return meshData;
 	}
-}
\ No newline at end of file
+
+	template<class VertexType, class IndexType>
+	MeshData<VertexType, IndexType> CreateTerrain(const TerrainField& terrainField, float texU, float texV,
+		const std::function<DirectX::XMFLOAT4(float, float)>& colorFunc)
+	{
+		using namespace DirectX;
+
+		MeshData<VertexType, IndexType> meshData;
+		UINT slicesX = terrainField.GetSlicesX();
+		UINT slicesZ = terrainField.GetSlicesZ();
+		UINT vertexCount = (slicesX + 1) * (slicesZ + 1);
+		UINT indexCount = 6 * slicesX * slicesZ;
+		meshData.vertexVec.resize(vertexCount);
+		meshData.indexVec.resize(indexCount);
+
+		Internal::VertexData vertexData;
+		UINT vIndex = 0;
+		UINT iIndex = 0;
+
+		float sliceWidth = terrainField.GetWidth() / slicesX;
+		float sliceDepth = terrainField.GetDepth() / slicesZ;
+		float leftBottomX = -terrainField.GetWidth() / 2;
+		float leftBottomZ = -terrainField.GetDepth() / 2;
+		float posX, posZ;
+		float sliceTexWidth = texU / slicesX;
+		float sliceTexDepth = texV / slicesZ;
+
+		XMFLOAT3 normal;
+		XMFLOAT4 tangent;
+		// 高度与法向量直接取自高度场，不再重复调用高度函数
+		for (UINT z = 0; z <= slicesZ; ++z)
+		{
+			posZ = leftBottomZ + z * sliceDepth;
+			for (UINT x = 0; x <= slicesX; ++x)
+			{
+				posX = leftBottomX + x * sliceWidth;
+				normal = terrainField.GetVertexNormal(x, z);
+				XMStoreFloat4(&tangent, XMVector3Normalize(XMVectorSet(normal.y, -normal.x, 0.0f, 0.0f)) + g_XMIdentityR3);
+
+				vertexData = { XMFLOAT3(posX, terrainField.GetVertexHeight(x, z), posZ),
+					normal, tangent, colorFunc(posX, posZ), XMFLOAT2(x * sliceTexWidth, texV - z * sliceTexDepth) };
+				Internal::InsertVertexElement(meshData.vertexVec[vIndex++], vertexData);
+			}
+		}
+		// 放入索引
+		for (UINT i = 0; i < slicesZ; ++i)
+		{
+			for (UINT j = 0; j < slicesX; ++j)
+			{
+				meshData.indexVec[iIndex++] = i * (slicesX + 1) + j;
+				meshData.indexVec[iIndex++] = (i + 1) * (slicesX + 1) + j;
+				meshData.indexVec[iIndex++] = (i + 1) * (slicesX + 1) + j + 1;
+
+				meshData.indexVec[iIndex++] = (i + 1) * (slicesX + 1) + j + 1;
+				meshData.indexVec[iIndex++] = i * (slicesX + 1) + j + 1;
+				meshData.indexVec[iIndex++] = i * (slicesX + 1) + j;
+			}
+		}
+
+		return meshData;
+	}
+}
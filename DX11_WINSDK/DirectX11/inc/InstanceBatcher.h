@@ -0,0 +1,73 @@
+#pragma once
+
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+#include <DirectXMath.h>
+#include "LightHelper.h"
+#include "Vertex.h"
+
+struct MeshResource;
+
+// 实例合批
+// 收集一帧内的绘制项，按(网格, 纹理, 材质)分组，同组实例的矩阵在实例数组中连续存放，
+// 每组对应一次DrawIndexedInstanced；网格与纹理只作为分组的键，这里不会访问设备资源
+class InstanceBatcher {
+public:
+	struct Batch {
+		const MeshResource* mesh;
+		ID3D11ShaderResourceView* texture;
+		Material material;
+		uint32_t startInstance;			// 在实例数组中的起始位置
+		uint32_t instanceCount;
+	};
+
+	InstanceBatcher() = default;
+	~InstanceBatcher() = default;
+
+	void Clear();
+	void Reserve(size_t count);
+	void XM_CALLCONV Add(const MeshResource* mesh, ID3D11ShaderResourceView* texture, const Material& material,
+		DirectX::FXMMATRIX world);
+
+	// 按组计数排序并填充实例数组，批次按各组首次提交的顺序排列，同一组内保持提交顺序
+	void Build();
+
+	size_t GetItemCount() const;
+	const std::vector<Batch>& GetBatches() const;
+	const std::vector<InstancedData>& GetInstanceData() const;
+
+private:
+	struct Item {
+		DirectX::XMFLOAT4X4 world;
+		uint32_t group;
+	};
+
+	struct GroupKey {
+		const MeshResource* mesh;
+		ID3D11ShaderResourceView* texture;
+		uint32_t materialIndex;
+
+		bool operator==(const GroupKey& other) const {
+			return mesh == other.mesh && texture == other.texture && materialIndex == other.materialIndex;
+		}
+	};
+
+	struct GroupKeyHash {
+		size_t operator()(const GroupKey& key) const;
+	};
+
+	uint32_t FindMaterial(const Material& material);
+	uint32_t FindGroup(const GroupKey& key);
+
+private:
+	std::vector<Item> m_Items;
+	std::vector<Material> m_Materials;			// 本帧出现过的不同材质
+	std::vector<GroupKey> m_Groups;
+	std::unordered_map<GroupKey, uint32_t, GroupKeyHash> m_GroupMap;
+	uint32_t m_LastMaterial = 0;				// 相邻提交的物体通常材质与分组相同，先与上一次的结果比较
+	uint32_t m_LastGroup = 0;
+	std::vector<uint32_t> m_GroupOffsets;
+	std::vector<Batch> m_Batches;
+	std::vector<InstancedData> m_InstanceData;
+};
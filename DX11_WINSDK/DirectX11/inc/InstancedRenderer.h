@@ -0,0 +1,50 @@
+#pragma once
+
+#include <wrl/client.h>
+#include <d3d11_1.h>
+#include "Effects.h"
+#include "InstanceBatcher.h"
+#include "MeshRegistry.h"
+#include "Transform.h"
+
+class GameObject;
+
+// 硬件实例化绘制
+// Begin与End之间提交的物体按(网格, 纹理, 材质)合批，每帧只Map一次实例缓冲区，
+// 每组一次DrawIndexedInstanced。网格须为VertexPosNormalColor格式，且在Begin与End之间不要创建新网格
+class InstancedRenderer {
+public:
+	template <class T>
+	using ComPtr = Microsoft::WRL::ComPtr<T>;
+
+	InstancedRenderer() = default;
+	~InstancedRenderer() = default;
+
+	InstancedRenderer(const InstancedRenderer&) = delete;
+	InstancedRenderer& operator=(const InstancedRenderer&) = delete;
+
+	// 实例缓冲区不够时按两倍扩容
+	bool InitResource(ID3D11Device* device, UINT initialCapacity = 1024);
+
+	void Begin();
+	// 世界矩阵以origin(相机的GetPositionDouble)为原点，须与BasicEffect::SetCameraRelative配合使用
+	void Submit(const GameObject& object, const Double3& origin);
+	void XM_CALLCONV Submit(const MeshHandle& mesh, ID3D11ShaderResourceView* texture, const Material& material,
+		DirectX::FXMMATRIX world);
+	void End(ID3D11DeviceContext* deviceContext, BasicEffect& effect);
+
+	// 上一次End发出的绘制调用数与实例数
+	UINT GetDrawCallCount() const;
+	UINT GetInstanceCount() const;
+
+private:
+	void ReserveInstanceBuffer(UINT count);
+
+private:
+	ComPtr<ID3D11Device> m_pDevice;
+	ComPtr<ID3D11Buffer> m_pInstanceBuffer;
+	UINT m_Capacity = 0;
+	InstanceBatcher m_Batcher;
+	UINT m_DrawCallCount = 0;
+	UINT m_InstanceCount = 0;
+};
@@ -0,0 +1,59 @@
+#pragma once
+
+#include <cstdint>
+#include <atomic>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <vector>
+
+// 工作窃取线程池
+// 每个线程持有自己的任务队列，从队尾取任务，空闲时从其它队列的队首窃取；
+// 调用ParallelFor的线程也会参与执行直到所有任务完成
+class JobSystem {
+public:
+	using RangeFunc = std::function<void(uint32_t begin, uint32_t end)>;
+
+	// threadCount包括调用线程，为0时使用硬件线程数
+	explicit JobSystem(uint32_t threadCount = 0);
+	~JobSystem();
+
+	JobSystem(const JobSystem&) = delete;
+	JobSystem& operator=(const JobSystem&) = delete;
+
+	uint32_t GetThreadCount() const;
+
+	// 将[0, count)按grainSize分批并行执行func，返回时全部完成
+	// 可以在任务内部嵌套调用
+	void ParallelFor(uint32_t count, uint32_t grainSize, const RangeFunc& func);
+
+private:
+	struct Job {
+		const RangeFunc* func;
+		uint32_t begin;
+		uint32_t end;
+		std::atomic<uint32_t>* pending;
+	};
+
+	struct WorkQueue {
+		std::mutex mutex;
+		std::deque<Job> jobs;
+	};
+
+	void WorkerLoop(uint32_t workerIndex);
+	bool TryGetJob(uint32_t workerIndex, Job& job);
+	void Execute(const Job& job);
+	uint32_t GetCurrentWorkerIndex() const;
+
+private:
+	std::vector<std::unique_ptr<WorkQueue>> m_Queues;	// [0]供外部线程使用，其余对应各工作线程
+	std::vector<std::thread> m_Threads;
+
+	std::mutex m_WakeMutex;
+	std::condition_variable m_WakeCondition;
+	std::atomic<uint32_t> m_QueuedJobs{ 0 };
+	bool m_Quit = false;
+};
@@ -0,0 +1,95 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include <DirectXMath.h>
+#include "Culling.h"
+
+// 松散八叉树
+// 每个节点的松散范围是其紧致范围的2倍，物体按中心所在的八分区向下放入能容纳其包围盒的最深一层，
+// 因此物体只属于一个节点，移动时通常只需更新包围盒；只有中心离开节点的紧致范围或尺寸不再适合该层时才重新插入。
+// 节点的物体数超过NodeCapacity后才分裂，稀疏区域不会产生很深的节点链。
+// 中心在根节点范围外的物体留在根节点中，Rebuild会按所有物体重新确定根节点范围
+class LooseOctree {
+public:
+	static const uint32_t InvalidHandle = UINT32_MAX;
+	static const uint32_t MaxDepthLimit = 16;
+	static const uint32_t NodeCapacity = 16;
+
+	LooseOctree(const DirectX::XMFLOAT3& center = DirectX::XMFLOAT3(0.0f, 0.0f, 0.0f), float halfSize = 1024.0f,
+		uint32_t maxDepth = 8);
+	~LooseOctree() = default;
+
+	// 清空所有物体并重新设置根节点范围
+	void Reset(const DirectX::XMFLOAT3& center, float halfSize, uint32_t maxDepth = 8);
+	void Clear();
+
+	// 返回的句柄在Remove之前保持有效，userData原样出现在查询结果中(如GameObject的下标)
+	uint32_t Insert(const DirectX::XMFLOAT3& center, const DirectX::XMFLOAT3& extents, uint32_t userData);
+	// 物体的Transform变化后(版本号改变)用新的世界包围盒更新
+	void Update(uint32_t handle, const DirectX::XMFLOAT3& center, const DirectX::XMFLOAT3& extents);
+	void Remove(uint32_t handle);
+
+	// 按当前所有物体的包围盒重新确定根节点范围并批量重建，句柄保持不变
+	void Rebuild();
+
+	size_t Size() const;
+	uint32_t GetNodeCount() const;
+	uint32_t GetMaxDepth() const;
+	uint32_t GetUserData(uint32_t handle) const;
+	void GetBounds(uint32_t handle, DirectX::XMFLOAT3& center, DirectX::XMFLOAT3& extents) const;
+	// 自上次Rebuild或Reset以来Update中需要重新插入的次数
+	uint32_t GetReinsertCount() const;
+
+	// 以下查询清空results后写入命中物体的userData，前三种的顺序不确定
+	// 与视锥体相交或在其内部，测试与Culling::CullBoxes相同
+	void QueryFrustum(const Culling::FrustumPlanes& frustum, std::vector<uint32_t>& results) const;
+	void QuerySphere(const DirectX::XMFLOAT3& center, float radius, std::vector<uint32_t>& results) const;
+	// 射线在[0, maxDistance]内穿过的所有包围盒，direction无需归一化
+	void QueryRay(const DirectX::XMFLOAT3& origin, const DirectX::XMFLOAT3& direction, float maxDistance,
+		std::vector<uint32_t>& results) const;
+	// 最近的相交包围盒，起点在包围盒内时距离为0
+	bool Raycast(const DirectX::XMFLOAT3& origin, const DirectX::XMFLOAT3& direction, float maxDistance,
+		uint32_t& userData, float& distance) const;
+	// 到点的距离(点在包围盒内时为0)最近的k个物体，按距离升序排列
+	void QueryNearest(const DirectX::XMFLOAT3& point, uint32_t k, std::vector<uint32_t>& results) const;
+
+private:
+	struct Node {
+		DirectX::XMFLOAT3 center;
+		float halfSize;						// 紧致范围的半边长，松散范围为其2倍
+		uint32_t parent;
+		uint32_t depth;
+		uint32_t subtreeCount;				// 该节点及其子孙中的物体数，为0的子树在查询时跳过
+		bool split;							// 分裂后能放入子节点的物体都放到子节点中
+		uint32_t children[8];
+		std::vector<uint32_t> objects;		// 物体句柄
+	};
+
+	struct Object {
+		DirectX::XMFLOAT3 center;
+		DirectX::XMFLOAT3 extents;
+		uint32_t userData;
+		uint32_t node;						// 空闲句柄为InvalidHandle
+		uint32_t slot;						// 在节点objects中的位置
+	};
+
+	uint32_t CreateNode(uint32_t parent, uint32_t octant);
+	uint32_t FindNode(const DirectX::XMFLOAT3& center, const DirectX::XMFLOAT3& extents);
+	bool FitsNode(const Node& node, const DirectX::XMFLOAT3& center, const DirectX::XMFLOAT3& extents) const;
+	void Link(uint32_t handle, uint32_t node);
+	void Split(uint32_t node);
+	void Unlink(uint32_t handle);
+	void CollectSubtree(uint32_t node, std::vector<uint32_t>& results) const;
+	// nodeTest返回节点松散范围与查询体的关系，完全在内部的子树不再逐个测试物体
+	template<class NodeTest, class ObjectTest>
+	void Query(NodeTest&& nodeTest, ObjectTest&& objectTest, std::vector<uint32_t>& results) const;
+
+private:
+	std::vector<Node> m_Nodes;				// m_Nodes[0]为根节点
+	std::vector<Object> m_Objects;
+	std::vector<uint32_t> m_FreeHandles;
+	uint32_t m_MaxDepth = 8;
+	uint32_t m_ReinsertCount = 0;
+	size_t m_Size = 0;
+};
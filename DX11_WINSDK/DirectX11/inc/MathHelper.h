@@ -0,0 +1,198 @@
+#pragma once
+
+#include <cstddef>
+#include <DirectXMath.h>
+
+//
+// 矩阵求逆相关函数
+// 世界矩阵、观察矩阵大多是仿射矩阵，按其结构选用专门的求逆方法比通用的4x4求逆快得多
+// 以下函数均采用行向量约定，即M = S * R * T，第4列为(0, 0, 0, 1)
+//
+
+// 矩阵的结构类型
+enum class MatrixKind {
+	Rigid,			// 旋转 + 平移
+	UniformScale,	// 等比缩放 + 旋转 + 平移
+	Affine,			// 一般仿射矩阵(非等比缩放、切变)
+	General			// 含投影，只能使用通用求逆
+};
+
+// -----------------------------
+// RigidInverse函数
+// -----------------------------
+// 刚体变换的逆：旋转部分转置，平移取反后旋转
+inline DirectX::XMMATRIX XM_CALLCONV RigidInverse(DirectX::FXMMATRIX M) {
+	using namespace DirectX;
+
+	XMMATRIX R = M;
+	R.r[3] = g_XMIdentityR3;
+	R = XMMatrixTranspose(R);
+
+	XMVECTOR t = XMVector3TransformNormal(M.r[3], R);
+	R.r[3] = XMVectorSetW(XMVectorNegate(t), 1.0f);
+	return R;
+}
+
+// -----------------------------
+// UniformScaleInverse函数
+// -----------------------------
+// 等比缩放变换的逆：上3x3部分为s * R，其逆为R^T / s = (sR)^T / s^2
+inline DirectX::XMMATRIX XM_CALLCONV UniformScaleInverse(DirectX::FXMMATRIX M) {
+	using namespace DirectX;
+
+	XMVECTOR invScaleSq = XMVectorReciprocal(XMVector3LengthSq(M.r[0]));
+	XMMATRIX A = M;
+	A.r[3] = g_XMIdentityR3;
+	A = XMMatrixTranspose(A);
+	A.r[0] = XMVectorMultiply(A.r[0], invScaleSq);
+	A.r[1] = XMVectorMultiply(A.r[1], invScaleSq);
+	A.r[2] = XMVectorMultiply(A.r[2], invScaleSq);
+
+	XMVECTOR t = XMVector3TransformNormal(M.r[3], A);
+	A.r[3] = XMVectorSetW(XMVectorNegate(t), 1.0f);
+	return A;
+}
+
+// -----------------------------
+// AffineInverse函数
+// -----------------------------
+// 一般仿射变换的逆：上3x3部分用伴随矩阵求逆(3次叉积)，平移部分再单独变换
+inline DirectX::XMMATRIX XM_CALLCONV AffineInverse(DirectX::FXMMATRIX M) {
+	using namespace DirectX;
+
+	// 伴随矩阵的各列为两行的叉积
+	XMVECTOR c0 = XMVector3Cross(M.r[1], M.r[2]);
+	XMVECTOR c1 = XMVector3Cross(M.r[2], M.r[0]);
+	XMVECTOR c2 = XMVector3Cross(M.r[0], M.r[1]);
+	XMVECTOR invDet = XMVectorReciprocal(XMVector3Dot(M.r[0], c0));
+
+	XMMATRIX A(c0, c1, c2, g_XMIdentityR3);
+	A = XMMatrixTranspose(A);
+	A.r[0] = XMVectorSetW(XMVectorMultiply(A.r[0], invDet), 0.0f);
+	A.r[1] = XMVectorSetW(XMVectorMultiply(A.r[1], invDet), 0.0f);
+	A.r[2] = XMVectorSetW(XMVectorMultiply(A.r[2], invDet), 0.0f);
+
+	XMVECTOR t = XMVector3TransformNormal(M.r[3], A);
+	A.r[3] = XMVectorSetW(XMVectorNegate(t), 1.0f);
+	return A;
+}
+
+// -----------------------------
+// ClassifyMatrix函数
+// -----------------------------
+// 根据各行长度与正交性判断矩阵结构，epsilon为允许的相对误差
+inline MatrixKind XM_CALLCONV ClassifyMatrix(DirectX::FXMMATRIX M, float epsilon = 1e-5f) {
+	using namespace DirectX;
+
+	XMVECTOR lastColumn = XMVectorSet(XMVectorGetW(M.r[0]), XMVectorGetW(M.r[1]), XMVectorGetW(M.r[2]), XMVectorGetW(M.r[3]));
+	if (!XMVector4NearEqual(lastColumn, g_XMIdentityR3, XMVectorReplicate(epsilon)))
+		return MatrixKind::General;
+
+	XMVECTOR lenSq = XMVectorSet(
+		XMVectorGetX(XMVector3LengthSq(M.r[0])),
+		XMVectorGetX(XMVector3LengthSq(M.r[1])),
+		XMVectorGetX(XMVector3LengthSq(M.r[2])), 0.0f);
+	XMVECTOR dots = XMVectorSet(
+		XMVectorGetX(XMVector3Dot(M.r[0], M.r[1])),
+		XMVectorGetX(XMVector3Dot(M.r[1], M.r[2])),
+		XMVectorGetX(XMVector3Dot(M.r[2], M.r[0])), 0.0f);
+
+	// 以第一行的长度平方作为尺度，判断是否正交且等长
+	XMVECTOR scaleSq = XMVectorSplatX(lenSq);
+	XMVECTOR tolerance = XMVectorScale(scaleSq, epsilon);
+	if (!XMVector3NearEqual(dots, XMVectorZero(), tolerance) ||
+		!XMVector3NearEqual(lenSq, scaleSq, tolerance))
+		return MatrixKind::Affine;
+
+	if (XMVector3NearEqual(lenSq, XMVectorSplatOne(), XMVectorReplicate(epsilon)))
+		return MatrixKind::Rigid;
+	return MatrixKind::UniformScale;
+}
+
+// -----------------------------
+// FastInverse函数
+// -----------------------------
+// 按矩阵结构选择求逆方法
+inline DirectX::XMMATRIX XM_CALLCONV FastInverse(DirectX::FXMMATRIX M, MatrixKind kind) {
+	switch (kind)
+	{
+	case MatrixKind::Rigid: return RigidInverse(M);
+	case MatrixKind::UniformScale: return UniformScaleInverse(M);
+	case MatrixKind::Affine: return AffineInverse(M);
+	default: return DirectX::XMMatrixInverse(nullptr, M);
+	}
+}
+
+inline DirectX::XMMATRIX XM_CALLCONV FastInverse(DirectX::FXMMATRIX M) {
+	return FastInverse(M, ClassifyMatrix(M));
+}
+
+// -----------------------------
+// InverseTranspose函数
+// -----------------------------
+inline DirectX::XMMATRIX XM_CALLCONV InverseTranspose(DirectX::FXMMATRIX M) {
+	using namespace DirectX;
+
+	// 世界矩阵的逆的转置仅针对法向量, 我们也不需要世界矩阵的平移分量
+	// 而且不去掉的话,后续再乘上观察矩阵之类的就会产生错误的变换结果
+	XMMATRIX A = M;
+	A.r[3] = g_XMIdentityR3;
+
+	// 刚体变换的逆转置就是其本身，等比缩放只差一个系数
+	switch (ClassifyMatrix(A))
+	{
+	case MatrixKind::Rigid:
+		return A;
+	case MatrixKind::UniformScale:
+	{
+		XMVECTOR invScaleSq = XMVectorReciprocal(XMVector3LengthSq(A.r[0]));
+		A.r[0] = XMVectorMultiply(A.r[0], invScaleSq);
+		A.r[1] = XMVectorMultiply(A.r[1], invScaleSq);
+		A.r[2] = XMVectorMultiply(A.r[2], invScaleSq);
+		return A;
+	}
+	case MatrixKind::Affine:
+		return XMMatrixTranspose(AffineInverse(A));
+	default:
+		return XMMatrixTranspose(XMMatrixInverse(nullptr, A));
+	}
+}
+
+// -----------------------------
+// AffineInverseBatch函数
+// -----------------------------
+// 批量求仿射矩阵的逆，每次同时处理4个矩阵(每个SIMD分量对应一个矩阵)
+// 输入输出可以是同一数组
+void AffineInverseBatch(const DirectX::XMFLOAT4X4* matrices, DirectX::XMFLOAT4X4* inverses, size_t count);
+
+// -----------------------------
+// PerspectiveFovLH函数
+// -----------------------------
+// 左手系透视投影，可选反向Z(近平面深度为1，远平面为0)与无限远平面(忽略farZ)
+// 反向Z配合浮点深度缓冲区时，浮点数在0附近的高精度正好抵消透视除法导致的远处精度损失
+inline DirectX::XMMATRIX XM_CALLCONV PerspectiveFovLH(float fovY, float aspect, float nearZ, float farZ,
+	bool reverseZ, bool infiniteFar) {
+	using namespace DirectX;
+
+	float sinFov, cosFov;
+	XMScalarSinCos(&sinFov, &cosFov, 0.5f * fovY);
+	float yScale = cosFov / sinFov;
+	float xScale = yScale / aspect;
+
+	// z_clip = a * z_view + b，w_clip = z_view
+	float a, b;
+	if (infiniteFar) {
+		a = reverseZ ? 0.0f : 1.0f;
+		b = reverseZ ? nearZ : -nearZ;
+	}
+	else {
+		float invRange = 1.0f / (farZ - nearZ);
+		a = reverseZ ? -nearZ * invRange : farZ * invRange;
+		b = reverseZ ? nearZ * farZ * invRange : -nearZ * farZ * invRange;
+	}
+	return XMMatrixSet(
+		xScale, 0.0f, 0.0f, 0.0f,
+		0.0f, yScale, 0.0f, 0.0f,
+		0.0f, 0.0f, a, 1.0f,
+		0.0f, 0.0f, b, 0.0f);
+}
@@ -0,0 +1,120 @@
+#pragma once
+
+#include <wrl/client.h>
+#include <d3d11_1.h>
+#include <DirectXCollision.h>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "Geometry.h"
+
+class MeshRegistry;
+
+// GPU上的网格资源，由MeshRegistry创建，所有引用它的MeshHandle释放后一并释放
+struct MeshResource {
+	Microsoft::WRL::ComPtr<ID3D11Buffer> vertexBuffer;
+	Microsoft::WRL::ComPtr<ID3D11Buffer> indexBuffer;
+	UINT vertexStride;
+	UINT vertexCount;
+	UINT indexCount;
+	DXGI_FORMAT indexFormat;
+	DirectX::BoundingBox localBounds;		// 模型空间包围盒
+	std::string name;
+};
+
+// 网格句柄，复制时增加引用计数，析构时减少；MeshRegistry须比所有句柄存活得更久
+class MeshHandle {
+public:
+	static const uint32_t InvalidId = UINT32_MAX;
+
+	MeshHandle() = default;
+	~MeshHandle();
+
+	MeshHandle(const MeshHandle& other);
+	MeshHandle& operator=(const MeshHandle& other);
+
+	MeshHandle(MeshHandle&& other) noexcept;
+	MeshHandle& operator=(MeshHandle&& other) noexcept;
+
+	void Reset();
+
+	const MeshResource* Get() const;
+	const MeshResource* operator->() const { return Get(); }
+	explicit operator bool() const { return m_pRegistry != nullptr; }
+
+	uint32_t GetId() const { return m_Id; }
+	bool operator==(const MeshHandle& other) const { return m_pRegistry == other.m_pRegistry && m_Id == other.m_Id; }
+	bool operator!=(const MeshHandle& other) const { return !(*this == other); }
+
+private:
+	friend class MeshRegistry;
+	// 接管一个已经计入的引用
+	MeshHandle(MeshRegistry* registry, uint32_t id) : m_pRegistry(registry), m_Id(id) {}
+
+	MeshRegistry* m_pRegistry = nullptr;
+	uint32_t m_Id = InvalidId;
+};
+
+// 网格注册表
+// 相同名称的网格只创建一次顶点/索引缓冲区，物体之间共享，显存占用与不同网格的数目成正比
+class MeshRegistry {
+public:
+	MeshRegistry() = default;
+	~MeshRegistry();
+
+	MeshRegistry(const MeshRegistry&) = delete;
+	MeshRegistry& operator=(const MeshRegistry&) = delete;
+
+	// name已注册时直接返回已有网格的句柄而不创建缓冲区，name为空的网格不参与查找
+	template<class VertexType, class IndexType>
+	MeshHandle Create(ID3D11Device* device, const std::string& name, const Geometry::MeshData<VertexType, IndexType>& meshData);
+	// 找不到时返回空句柄
+	MeshHandle Find(const std::string& name);
+
+	uint32_t GetRefCount(const MeshHandle& handle) const;
+	// 当前存活的网格数及其缓冲区占用的字节数
+	size_t GetMeshCount() const;
+	size_t GetBufferBytes() const;
+
+private:
+	friend class MeshHandle;
+
+	struct Entry {
+		MeshResource mesh;
+		uint32_t refCount;
+	};
+
+	MeshHandle CreateMesh(ID3D11Device* device, const std::string& name,
+		const void* vertexData, UINT vertexStride, UINT vertexCount,
+		const void* indexData, DXGI_FORMAT indexFormat, UINT indexCount,
+		const DirectX::BoundingBox& localBounds);
+	void AddRef(uint32_t id);
+	void Release(uint32_t id);
+
+private:
+	std::vector<Entry> m_Entries;
+	std::vector<uint32_t> m_FreeIds;
+	std::unordered_map<std::string, uint32_t> m_NameToId;
+	size_t m_MeshCount = 0;
+	size_t m_BufferBytes = 0;
+};
+
+template<class VertexType, class IndexType>
+inline MeshHandle MeshRegistry::Create(ID3D11Device* device, const std::string& name,
+	const Geometry::MeshData<VertexType, IndexType>& meshData) {
+	if (!name.empty()) {
+		MeshHandle existing = Find(name);
+		if (existing)
+			return existing;
+	}
+	if (device == nullptr || meshData.vertexVec.empty() || meshData.indexVec.empty())
+		return MeshHandle();
+
+	static_assert(sizeof(IndexType) == 2 || sizeof(IndexType) == 4, "IndexType must be 16 or 32 bits");
+	DirectX::BoundingBox localBounds;
+	DirectX::BoundingBox::CreateFromPoints(localBounds, meshData.vertexVec.size(), &meshData.vertexVec[0].pos, sizeof(VertexType));
+	return CreateMesh(device, name,
+		meshData.vertexVec.data(), sizeof(VertexType), (UINT)meshData.vertexVec.size(),
+		meshData.indexVec.data(), sizeof(IndexType) == 2 ? DXGI_FORMAT_R16_UINT : DXGI_FORMAT_R32_UINT, (UINT)meshData.indexVec.size(),
+		localBounds);
+}
@@ -0,0 +1,98 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include <DirectXMath.h>
+#include "Culling.h"
+
+class JobSystem;
+
+// 遮挡体网格
+// 只保留位置，由MeshData按cellSize大小的网格聚类合并顶点并去掉退化三角形得到，
+// cellSize应远小于遮挡体尺寸，否则简化后的网格可能比原网格大而错误地遮挡物体
+struct OccluderMesh {
+	std::vector<DirectX::XMFLOAT3> positions;
+	std::vector<uint32_t> indices;
+
+	template<class MeshDataType>
+	static OccluderMesh FromMeshData(const MeshDataType& meshData, float cellSize = 1e-3f) {
+		std::vector<DirectX::XMFLOAT3> positions(meshData.vertexVec.size());
+		for (size_t i = 0; i < positions.size(); ++i)
+			positions[i] = meshData.vertexVec[i].pos;
+		std::vector<uint32_t> indices(meshData.indexVec.begin(), meshData.indexVec.end());
+		return Simplify(positions, indices, cellSize);
+	}
+
+	static OccluderMesh Simplify(const std::vector<DirectX::XMFLOAT3>& positions, const std::vector<uint32_t>& indices, float cellSize);
+};
+
+// CPU软件遮挡剔除
+// 遮挡体以低分辨率光栅化到深度缓冲区(深度范围[0, 1]，清除为1)，每个像素保留最近深度；
+// 然后逐级取2x2中的最大深度生成层次Z(HiZ)，物体包围盒的最近深度大于所覆盖HiZ纹素的深度时被遮挡。
+// 屏幕按TileSize x TileSize分块，光栅化与块内的HiZ层级按块并行
+class OcclusionCuller {
+public:
+	static const uint32_t TileSize = 32;
+
+	// 宽高向上取整到TileSize的倍数
+	OcclusionCuller(uint32_t width = 320, uint32_t height = 192);
+	~OcclusionCuller() = default;
+
+	OcclusionCuller(const OcclusionCuller&) = delete;
+	OcclusionCuller& operator=(const OcclusionCuller&) = delete;
+
+	void Resize(uint32_t width, uint32_t height);
+	uint32_t GetWidth() const;
+	uint32_t GetHeight() const;
+
+	// 清空上一帧的遮挡体，反向Z的viewProj在内部转换回标准深度，HiZ始终以近处深度小为准
+	void XM_CALLCONV BeginFrame(DirectX::FXMMATRIX viewProj, bool reverseZ = false);
+	// 变换到裁剪空间，按近平面裁剪并剔除背面后暂存三角形
+	void XM_CALLCONV AddOccluder(const OccluderMesh& mesh, DirectX::FXMMATRIX world);
+
+	// 按块分配三角形并光栅化，随后生成HiZ
+	void Rasterize();
+	void Rasterize(JobSystem& jobSystem);
+
+	// 包围盒与近平面相交时视为可见，完全在屏幕外时视为不可见
+	bool IsVisible(const DirectX::XMFLOAT3& center, const DirectX::XMFLOAT3& extents) const;
+
+	// 测试candidates中的包围盒(通常为视锥体剔除的结果)，按原顺序输出未被遮挡的下标，返回数目
+	size_t CullBoxes(const Culling::BoundingBoxSoA& boxes, const uint32_t* candidates, size_t count,
+		uint32_t* visibleIndices) const;
+	size_t CullBoxes(JobSystem& jobSystem, const Culling::BoundingBoxSoA& boxes, const uint32_t* candidates, size_t count,
+		uint32_t* visibleIndices, uint32_t grainSize = 4096) const;
+
+	uint32_t GetTriangleCount() const;
+	uint32_t GetHiZLevelCount() const;
+	uint32_t GetHiZWidth(uint32_t level) const;
+	uint32_t GetHiZHeight(uint32_t level) const;
+	// 第0级即光栅化得到的深度缓冲区，按行存放
+	const float* GetHiZ(uint32_t level) const;
+
+private:
+	// 屏幕空间三角形，边函数Ax + By + C >= 0为内部，深度为屏幕空间的线性函数
+	struct ScreenTriangle {
+		float edgeA[3], edgeB[3], edgeC[3];
+		float depthA, depthB, depthC;
+		int32_t minX, minY, maxX, maxY;
+	};
+
+	void XM_CALLCONV SetupTriangle(DirectX::FXMVECTOR v0, DirectX::FXMVECTOR v1, DirectX::FXMVECTOR v2);
+	void BinTriangles();
+	void RasterizeTile(uint32_t tileIndex);
+	void BuildUpperHiZ();
+	size_t CullRange(const Culling::BoundingBoxSoA& boxes, const uint32_t* candidates, size_t begin, size_t end,
+		uint32_t* out) const;
+
+private:
+	uint32_t m_Width = 0, m_Height = 0;
+	uint32_t m_TilesX = 0, m_TilesY = 0;
+	DirectX::XMFLOAT4X4 m_ViewProj = {};
+
+	std::vector<ScreenTriangle> m_Triangles;
+	std::vector<std::vector<uint32_t>> m_TileBins;		// 每块覆盖到的三角形下标，按添加顺序
+	std::vector<std::vector<float>> m_HiZ;
+	std::vector<DirectX::XMUINT2> m_HiZSizes;
+	std::vector<DirectX::XMFLOAT4> m_ClipVertices;		// AddOccluder的临时空间
+};
@@ -0,0 +1,54 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// 渲染队列
+// 每个绘制包携带一个64位排序键，每帧按键做基数排序后依次绘制，使着色器、材质、纹理的切换次数最少
+// 键从高位到低位：
+//   不透明物体：通道(4) | 透明(1)=0 | 着色器(10) | 材质(12) | 纹理(13) | 深度(24，由近到远)
+//   透明物体：  通道(4) | 透明(1)=1 | 深度(24，由远到近) | 着色器(10) | 材质(12) | 纹理(13)
+// 同一通道内透明物体排在不透明物体之后，彼此按由远到近的顺序混合(BSTransparent)
+class RenderQueue {
+public:
+	static const uint32_t PassBits = 4;
+	static const uint32_t ShaderBits = 10;
+	static const uint32_t MaterialBits = 12;
+	static const uint32_t TextureBits = 13;
+	static const uint32_t DepthBits = 24;
+
+	struct Packet {
+		uint64_t key;
+		uint32_t payload;			// 由调用者解释，如物体下标
+	};
+
+	RenderQueue() = default;
+	~RenderQueue() = default;
+
+	// 各字段超出位宽时截断；depth为观察空间深度，负值按0处理
+	static uint64_t MakeKey(uint32_t pass, bool transparent, uint32_t shader, uint32_t material, uint32_t texture, float depth);
+	static uint32_t GetPass(uint64_t key);
+	static bool IsTransparent(uint64_t key);
+	static uint32_t GetShader(uint64_t key);
+	static uint32_t GetMaterial(uint64_t key);
+	static uint32_t GetTexture(uint64_t key);
+	// 深度的24位量化值，保持大小顺序
+	static uint32_t QuantizeDepth(float depth);
+
+	void Clear();
+	void Reserve(size_t count);
+	void Submit(uint64_t key, uint32_t payload);
+	void Submit(uint32_t pass, bool transparent, uint32_t shader, uint32_t material, uint32_t texture, float depth, uint32_t payload);
+
+	// LSD基数排序，所有包都相同的位段跳过；键相同的包保持提交顺序
+	void Sort();
+
+	size_t Size() const;
+	const std::vector<Packet>& GetPackets() const;
+
+private:
+	std::vector<Packet> m_Packets;
+	std::vector<Packet> m_Scratch;
+	std::vector<uint32_t> m_Histograms;
+};
@@ -12,6 +12,14 @@ public:
 
 	static void InitAll(ID3D11Device* device);
 
+	// 按深度映射方式选择深度清除值与深度测试状态，标准深度下返回的nullptr即默认状态(LESS)
+	static float GetDepthClearValue(bool reverseZ);
+	static ID3D11DepthStencilState* GetDepthStencilState(bool reverseZ, bool depthWrite = true);
+
+	// 带深度测试的模板状态，反向Z下返回深度比较为GREATER_EQUAL的对应版本
+	enum class DepthStencilMode { WriteStencil, DrawWithStencil, NoDoubleBlend, NoDepthWriteWithStencil };
+	static ID3D11DepthStencilState* GetDepthStencilState(bool reverseZ, DepthStencilMode mode);
+
 public:
 	static ComPtr<ID3D11RasterizerState> RSWireframe;
 	static ComPtr<ID3D11RasterizerState> RSNoCull;
@@ -25,6 +33,7 @@ public:
 	static ComPtr<ID3D11BlendState> BSAlphaToCoverage;
 	static ComPtr<ID3D11BlendState> BSAdditive;
 
+	// 以下带深度测试的状态均为标准深度(LESS)，反向Z下需通过GetDepthStencilState获取
 	static ComPtr<ID3D11DepthStencilState> DSSWriteStencil;
 	static ComPtr<ID3D11DepthStencilState> DSSDrawWithStencil;
 	static ComPtr<ID3D11DepthStencilState> DSSNoDoubleBlend;
@@ -32,4 +41,10 @@ public:
 	static ComPtr<ID3D11DepthStencilState> DSSNoDepthWrite;
 	static ComPtr<ID3D11DepthStencilState> DSSNoDepthTestWithStencil;
 	static ComPtr<ID3D11DepthStencilState> DSSNoDepthWriteWithStencil;
+	static ComPtr<ID3D11DepthStencilState> DSSReverseZ;
+	static ComPtr<ID3D11DepthStencilState> DSSReverseZNoDepthWrite;
+	static ComPtr<ID3D11DepthStencilState> DSSReverseZWriteStencil;
+	static ComPtr<ID3D11DepthStencilState> DSSReverseZDrawWithStencil;
+	static ComPtr<ID3D11DepthStencilState> DSSReverseZNoDoubleBlend;
+	static ComPtr<ID3D11DepthStencilState> DSSReverseZNoDepthWriteWithStencil;
 };
\ No newline at end of file
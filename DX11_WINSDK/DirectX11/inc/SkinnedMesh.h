@@ -0,0 +1,56 @@
+#pragma once
+
+#include <wrl/client.h>
+#include <string>
+#include <vector>
+#include "Geometry.h"
+#include "Skinning.h"
+
+class JobSystem;
+
+// CPU蒙皮网格
+// 保存蒙皮前的顶点，每帧蒙皮后写入动态顶点缓冲区，输出顶点格式为VertexPosNormalTangentTex
+class SkinnedMesh {
+public:
+	template <class T>
+	using ComPtr = Microsoft::WRL::ComPtr<T>;
+
+	SkinnedMesh();
+
+	template<class IndexType>
+	void SetBuffer(ID3D11Device* device, const Geometry::MeshData<VertexPosNormalTangentTexSkin, IndexType>& meshData);
+
+	// 以WRITE_DISCARD映射顶点缓冲区并直接在其中蒙皮，jobSystem不为空时多线程执行
+	void Update(ID3D11DeviceContext* deviceContext, const DirectX::XMFLOAT4X4A* skinningMatrices, JobSystem* jobSystem = nullptr);
+
+	// 只绑定缓冲区并绘制，着色器与常量缓冲区由调用方设置
+	void Draw(ID3D11DeviceContext* deviceContext);
+
+	UINT GetVertexCount() const;
+
+	void SetDebugObjectName(const std::string& name);
+
+private:
+	void CreateBuffers(ID3D11Device* device, const void* indexData, UINT indexByteWidth);
+
+private:
+	std::vector<VertexPosNormalTangentTexSkin> m_BindPoseVertices;
+	ComPtr<ID3D11Buffer> m_pVertexBuffer;
+	ComPtr<ID3D11Buffer> m_pIndexBuffer;
+	DXGI_FORMAT m_IndexFormat;
+	UINT m_IndexCount;
+};
+
+template<class IndexType>
+inline void SkinnedMesh::SetBuffer(ID3D11Device* device, const Geometry::MeshData<VertexPosNormalTangentTexSkin, IndexType>& meshData) {
+	m_pVertexBuffer.Reset();
+	m_pIndexBuffer.Reset();
+
+	if (device == nullptr)
+		return;
+
+	m_BindPoseVertices = meshData.vertexVec;
+	m_IndexCount = (UINT)meshData.indexVec.size();
+	m_IndexFormat = sizeof(IndexType) == 2 ? DXGI_FORMAT_R16_UINT : DXGI_FORMAT_R32_UINT;
+	CreateBuffers(device, meshData.indexVec.data(), m_IndexCount * sizeof(IndexType));
+}
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include <DirectXMath.h>
+#include "Vertex.h"
+
+class JobSystem;
+struct AnimationPose;
+
+// 骨架
+// 骨骼按父节点在前的顺序存放，保存每根骨骼的父骨骼下标与绑定姿势的逆矩阵
+class Skeleton {
+public:
+	static const int32_t NoParent = -1;
+	// BLENDINDICES为8位无符号整数
+	static const uint32_t MaxBones = 256;
+
+	Skeleton() = default;
+	~Skeleton() = default;
+
+	Skeleton(const Skeleton&) = default;
+	Skeleton& operator=(const Skeleton&) = default;
+
+	Skeleton(Skeleton&&) = default;
+	Skeleton& operator=(Skeleton&&) = default;
+
+	// parent必须为NoParent或已添加的骨骼，返回新骨骼的下标
+	uint32_t AddBone(int32_t parent, const DirectX::XMFLOAT4X4& inverseBindPose);
+	uint32_t GetBoneCount() const;
+	int32_t GetParent(uint32_t bone) const;
+	const DirectX::XMFLOAT4X4& GetInverseBindPose(uint32_t bone) const;
+
+	// 由各骨骼相对父骨骼的局部矩阵求出蒙皮矩阵(绑定姿势的逆 * 模型空间矩阵)
+	void ComputeSkinningMatrices(const DirectX::XMFLOAT4X4* localMatrices, DirectX::XMFLOAT4X4A* skinningMatrices) const;
+	// 局部姿势来自动画采样结果，轨道下标与骨骼下标一致
+	void ComputeSkinningMatrices(const AnimationPose& localPose, DirectX::XMFLOAT4X4A* skinningMatrices) const;
+
+private:
+	// matrices中已是模型空间矩阵，原地左乘绑定姿势的逆
+	void ApplyInverseBindPoses(DirectX::XMFLOAT4X4A* matrices) const;
+
+private:
+	std::vector<int32_t> m_ParentIndices;
+	std::vector<DirectX::XMFLOAT4X4> m_InverseBindPoses;
+};
+
+namespace Skinning {
+	// CPU蒙皮：先按权重混合4个蒙皮矩阵，再变换位置、法向量和切线
+	// 法向量与切线直接用混合矩阵变换后归一化，因此蒙皮矩阵中不应包含非等比缩放
+	// dst可以是映射后的动态顶点缓冲区，只会顺序写入
+	void SkinVertices(const VertexPosNormalTangentTexSkin* src, VertexPosNormalTangentTex* dst, size_t count,
+		const DirectX::XMFLOAT4X4A* skinningMatrices);
+	// 按grainSize个顶点一批分配到线程池执行
+	void SkinVertices(JobSystem& jobSystem, const VertexPosNormalTangentTexSkin* src, VertexPosNormalTangentTex* dst,
+		size_t count, const DirectX::XMFLOAT4X4A* skinningMatrices, uint32_t grainSize = 4096);
+}
@@ -0,0 +1,94 @@
+#pragma once
+
+#include <cstdint>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+#include <DirectXCollision.h>
+
+// 扫掠裁剪(Sweep and Prune)宽阶段碰撞检测
+// 每个轴上保存所有包围盒的端点并保持有序，物体每帧只移动一点时插入排序接近线性；
+// 排序中最小端点越过另一物体的最大端点时两者可能开始重叠，最大端点越过最小端点时必然分离，
+// 据此增量维护重叠对，并给出本帧开始与结束重叠的事件
+class SweepAndPrune {
+public:
+	static const uint32_t InvalidHandle = UINT32_MAX;
+	// 一次Update中新加入的物体超过该数目时整体排序并重新扫描重叠对
+	static const uint32_t BatchRebuildThreshold = 64;
+
+	// 重叠的两个物体的userData，first < second
+	struct Pair {
+		uint32_t first, second;
+
+		bool operator==(const Pair& other) const { return first == other.first && second == other.second; }
+		bool operator<(const Pair& other) const { return first != other.first ? first < other.first : second < other.second; }
+	};
+
+	SweepAndPrune() = default;
+	~SweepAndPrune() = default;
+
+	// 新物体在下一次Update时加入排序，返回的句柄在Remove之前保持有效
+	uint32_t Add(const DirectX::BoundingBox& box, uint32_t userData);
+	void SetBounds(uint32_t handle, const DirectX::BoundingBox& box);
+	// 与其重叠的对在下一次Update时产生结束事件
+	void Remove(uint32_t handle);
+	void Clear();
+
+	// 更新三个轴上的端点顺序并维护重叠对，随后可以读取本帧的事件
+	void Update();
+
+	size_t Size() const;
+	size_t GetOverlapCount() const;
+	// 当前所有重叠对，按(first, second)升序
+	void GetOverlaps(std::vector<Pair>& pairs) const;
+	// 上一次Update中开始、结束重叠的对，按(first, second)升序
+	const std::vector<Pair>& GetBeginOverlaps() const;
+	const std::vector<Pair>& GetEndOverlaps() const;
+	// 上一次Update中插入排序交换端点的次数
+	uint64_t GetSwapCount() const;
+
+	// 窄阶段预筛选：保留有向包围盒也相交的对，orientedBoxes按userData索引
+	static void FilterOverlaps(const std::vector<Pair>& pairs, const DirectX::BoundingOrientedBox* orientedBoxes,
+		std::vector<Pair>& results);
+
+private:
+	struct Object {
+		DirectX::XMFLOAT3 minPoint;
+		DirectX::XMFLOAT3 maxPoint;
+		uint32_t userData;
+		bool alive;
+	};
+
+	// 端点的值与所属物体，最大端点排在值相同的最小端点之后，使相接的包围盒算作重叠
+	struct Endpoint {
+		float value;
+		uint32_t data;						// 句柄 << 1 | 是否为最大端点
+
+		uint32_t Handle() const { return data >> 1; }
+		bool IsMax() const { return (data & 1) != 0; }
+		bool operator<(const Endpoint& other) const {
+			return value < other.value || (value == other.value && (data & 1) < (other.data & 1));
+		}
+	};
+
+	static uint64_t PairKey(uint32_t a, uint32_t b);
+	bool Overlaps(uint32_t a, uint32_t b) const;
+	void AddPair(uint32_t a, uint32_t b);
+	void RemovePair(uint32_t a, uint32_t b);
+	void SortAxis(uint32_t axis);
+	void RebuildPairs();
+	void EmitEvents();
+
+private:
+	std::vector<Object> m_Objects;
+	std::vector<Endpoint> m_Endpoints[3];
+	std::vector<uint32_t> m_AddedHandles;		// 尚未加入端点数组
+	std::vector<uint32_t> m_RemovedHandles;		// 端点在下一次Update时移除，句柄之后才能重用
+	std::vector<uint32_t> m_FreeHandles;
+	std::unordered_set<uint64_t> m_Pairs;		// 句柄对
+	std::unordered_map<uint64_t, bool> m_ChangedPairs;	// 本帧变化过的句柄对及其在帧开始时是否重叠
+	std::vector<Pair> m_BeginOverlaps;
+	std::vector<Pair> m_EndOverlaps;
+	uint64_t m_SwapCount = 0;
+	size_t m_Size = 0;
+};
@@ -0,0 +1,82 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include <functional>
+#include <DirectXMath.h>
+
+// 地形高度场
+// 以与Geometry::CreateTerrain相同的方式对高度函数采样并保存为紧凑的高度网格，
+// 之后的高度、法向量查询为O(1)，线段求交借助最小/最大高度四叉树为O(log n)
+class TerrainField {
+public:
+	TerrainField() = default;
+	TerrainField(float width, float depth, uint32_t slicesX, uint32_t slicesZ,
+		const std::function<float(float, float)>& heightFunc);
+	~TerrainField() = default;
+
+	TerrainField(const TerrainField&) = default;
+	TerrainField& operator=(const TerrainField&) = default;
+
+	TerrainField(TerrainField&&) = default;
+	TerrainField& operator=(TerrainField&&) = default;
+
+	// 对高度函数重新采样，地形中心位于原点
+	void Init(float width, float depth, uint32_t slicesX, uint32_t slicesZ,
+		const std::function<float(float, float)>& heightFunc);
+
+	float GetWidth() const;
+	float GetDepth() const;
+	uint32_t GetSlicesX() const;
+	uint32_t GetSlicesZ() const;
+
+	bool Contains(float x, float z) const;
+
+	// 网格顶点上的高度与法向量(中心差分)
+	float GetVertexHeight(uint32_t ix, uint32_t iz) const;
+	DirectX::XMFLOAT3 GetVertexNormal(uint32_t ix, uint32_t iz) const;
+
+	// 双线性插值的高度与法向量，超出地形范围的坐标会被钳制到边界
+	float GetHeight(float x, float z) const;
+	DirectX::XMFLOAT3 GetNormal(float x, float z) const;
+	DirectX::XMVECTOR XM_CALLCONV GetNormalXM(float x, float z) const;
+
+	// 批量查询，positions的分量为(x, z)，每次处理4个点
+	void GetHeights(const DirectX::XMFLOAT2* positions, float* heights, size_t count) const;
+	void GetHeightsAndNormals(const DirectX::XMFLOAT2* positions, float* heights, DirectX::XMFLOAT3* normals, size_t count) const;
+
+	// 线段p0->p1与地形求交，命中时t为[0, 1]内首个交点的参数
+	bool IntersectSegment(const DirectX::XMFLOAT3& p0, const DirectX::XMFLOAT3& p1, float& t) const;
+	// 批量线段求交，未命中的线段t为FLT_MAX，返回命中数目
+	size_t IntersectSegments(const DirectX::XMFLOAT3* p0, const DirectX::XMFLOAT3* p1, float* t, size_t count) const;
+
+private:
+	void BuildMinMaxLevels();
+	void GetCellCoord(float x, float z, uint32_t& cellX, uint32_t& cellZ, float& u, float& v) const;
+	// 第i条网格线的坐标，最后一条直接取地形边界，避免累积误差使边界上的点落在外面
+	float GetGridLineX(uint32_t i) const;
+	float GetGridLineZ(uint32_t i) const;
+	bool IntersectCell(uint32_t cellX, uint32_t cellZ, const DirectX::XMFLOAT3& p0, const DirectX::XMFLOAT3& dir,
+		float tMin, float tMax, float& t) const;
+
+private:
+	struct MinMaxLevel {
+		uint32_t width;
+		uint32_t depth;
+		std::vector<DirectX::XMFLOAT2> minMax;		// x为最小高度，y为最大高度
+	};
+
+	float m_Width = 0.0f;
+	float m_Depth = 0.0f;
+	float m_OriginX = 0.0f;
+	float m_OriginZ = 0.0f;
+	float m_CellWidth = 0.0f;
+	float m_CellDepth = 0.0f;
+	float m_InvCellWidth = 0.0f;
+	float m_InvCellDepth = 0.0f;
+	uint32_t m_SlicesX = 0;
+	uint32_t m_SlicesZ = 0;
+
+	std::vector<float> m_Heights;				// (slicesX + 1) * (slicesZ + 1)，按z行存放
+	std::vector<MinMaxLevel> m_MinMaxLevels;	// [0]为单元格级别，最后一级为1x1
+};
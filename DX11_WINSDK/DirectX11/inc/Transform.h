@@ -1,7 +1,30 @@
 #pragma once
 
+#include <cstdint>
 #include <DirectXMath.h>
 
+// 双精度坐标，用于远离原点的大场景
+struct Double3 {
+	double x = 0.0;
+	double y = 0.0;
+	double z = 0.0;
+
+	Double3() = default;
+	constexpr Double3(double _x, double _y, double _z) : x(_x), y(_y), z(_z) {}
+	explicit constexpr Double3(const DirectX::XMFLOAT3& v) : x(v.x), y(v.y), z(v.z) {}
+
+	// 相对于origin的单精度偏移
+	DirectX::XMFLOAT3 RelativeTo(const Double3& origin) const {
+		return DirectX::XMFLOAT3(float(x - origin.x), float(y - origin.y), float(z - origin.z));
+	}
+	DirectX::XMFLOAT3 ToFloat3() const {
+		return DirectX::XMFLOAT3(float(x), float(y), float(z));
+	}
+};
+
+// 世界矩阵、逆矩阵与基向量在const的Get函数中按需计算并写入缓存，
+// 因此缓存失效时多个线程同时读取同一个Transform是数据竞争；
+// 并行阶段之前须在单线程中调用UpdateCache，之后只要不再修改即可并发读取
 class Transform {
 public:
 	Transform() = default;
@@ -17,11 +40,17 @@ public:
 	DirectX::XMFLOAT3 GetScale() const;
 	DirectX::XMVECTOR GetScaleXM() const;
 
+	// 欧拉角(弧度)，由四元数换算得到
 	DirectX::XMFLOAT3 GetRotation() const;
 	DirectX::XMVECTOR GetRotationXM() const;
 
+	DirectX::XMFLOAT4 GetRotationQuat() const;
+	DirectX::XMVECTOR GetRotationQuatXM() const;
+
 	DirectX::XMFLOAT3 GetPosition() const;
 	DirectX::XMVECTOR GetPositionXM() const;
+	// 位置以双精度保存，单精度版本只是其近似值
+	Double3 GetPositionDouble() const;
 
 	DirectX::XMFLOAT3 GetRightAxis() const;
 	DirectX::XMVECTOR GetRightAxisXM() const;
@@ -38,15 +67,23 @@ public:
 	DirectX::XMFLOAT4X4 GetWorldToLocalMatrix() const;
 	DirectX::XMMATRIX GetWorldToLocalMatrixXM() const;
 
+	// 以origin(通常为相机位置)为原点的世界矩阵及其逆矩阵，平移部分先以双精度相减再转为单精度
+	DirectX::XMMATRIX GetLocalToWorldMatrixXM(const Double3& origin) const;
+	DirectX::XMMATRIX GetWorldToLocalMatrixXM(const Double3& origin) const;
+
 	void SetScale(const DirectX::XMFLOAT3& scale);
 	void SetScale(float x, float y, float z);
 
 	void SetRotation(const DirectX::XMFLOAT3& eularAnglesInRadian);
 	void SetRotation(float x, float y, float z);
+	void SetRotationQuat(const DirectX::XMFLOAT4& quaternion);
 
 	void SetPosition(const DirectX::XMFLOAT3& position);
 	void SetPosition(float x, float y, float z);
+	void SetPosition(const Double3& position);
 
+	// 在原有旋转之后叠加一次欧拉角旋转，而非把欧拉角相加；
+	// 欧拉角由四元数分解得到，俯仰角在±90°处不连续，相加会在该处来回反弹
 	void Rotate(const DirectX::XMFLOAT3& eulerAnglesInRadian);
 	void RotateAxis(const DirectX::XMFLOAT3& axis, float radian);
 	void RotateAround(const DirectX::XMFLOAT3& point, const DirectX::XMFLOAT3& axis, float radian);
@@ -56,11 +93,34 @@ public:
 	void LookAt(const DirectX::XMFLOAT3& target, const DirectX::XMFLOAT3& up = { 0.0f, 1.0f, 0.0f });
 	void LookTo(const DirectX::XMFLOAT3& direction, const DirectX::XMFLOAT3& up = { 0.0f, 1.0f, 0.0f });
 
+	// 每次缩放、旋转或平移改变时递增，依赖方可据此判断缓存是否过期
+	uint32_t GetVersion() const;
+	// 立即计算所有失效的缓存，之后的const Get函数不再写入成员
+	void UpdateCache() const;
+
+	// 在两个状态之间插值，缩放和位置线性插值，旋转球面插值
+	static Transform Interpolate(const Transform& from, const Transform& to, float t);
+
 private:
-	DirectX::XMFLOAT3 GetEulerAnglesFromRotationMatrix(const DirectX::XMFLOAT4X4& rotationMatrix);
+	DirectX::XMFLOAT3 GetEulerAnglesFromQuaternion(const DirectX::XMFLOAT4& quaternion) const;
+
+	// 缩放、旋转、平移任意一项改变后标记缓存失效
+	void MarkDirty();
+	// 重新计算世界矩阵和基向量
+	void UpdateWorldMatrix() const;
 
 private:
 	DirectX::XMFLOAT3 m_Scale = { 1.0f, 1.0f, 1.0f };
-	DirectX::XMFLOAT3 m_Rotation = {};
-	DirectX::XMFLOAT3 m_Position = {};
+	DirectX::XMFLOAT4 m_Rotation = { 0.0f, 0.0f, 0.0f, 1.0f };	// 旋转四元数
+	Double3 m_Position = {};
+
+	// 按需计算的缓存，静止物体重复读取时只需一次加载
+	mutable DirectX::XMFLOAT4X4 m_LocalToWorld = {};
+	mutable DirectX::XMFLOAT4X4 m_WorldToLocal = {};
+	mutable DirectX::XMFLOAT3 m_RightAxis = {};
+	mutable DirectX::XMFLOAT3 m_UpAxis = {};
+	mutable DirectX::XMFLOAT3 m_ForwardAxis = {};
+	mutable bool m_IsWorldDirty = true;
+	mutable bool m_IsInverseDirty = true;
+	uint32_t m_Version = 0;
 };
\ No newline at end of file
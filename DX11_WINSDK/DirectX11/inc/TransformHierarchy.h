@@ -0,0 +1,99 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include <DirectXMath.h>
+#include "Transform.h"
+
+class JobSystem;
+
+// 变换层级
+// 节点按深度优先顺序以SoA形式存放，父节点总是位于其子树之前，
+// 子树在数组中是连续的区间[index, subtreeEnd)，因此世界矩阵可以在一次线性遍历中求出
+class TransformHierarchy {
+public:
+	using NodeHandle = uint32_t;
+	static const NodeHandle InvalidHandle = UINT32_MAX;
+
+	TransformHierarchy() = default;
+	~TransformHierarchy() = default;
+
+	TransformHierarchy(const TransformHierarchy&) = default;
+	TransformHierarchy& operator=(const TransformHierarchy&) = default;
+
+	TransformHierarchy(TransformHierarchy&&) = default;
+	TransformHierarchy& operator=(TransformHierarchy&&) = default;
+
+	void Reserve(size_t nodeCount);
+	void Clear();
+
+	// 在父节点子树的末尾插入新节点，parent为InvalidHandle时作为根节点添加到末尾
+	// 按深度优先顺序构建时插入为O(1)，否则需要移动其后的节点
+	NodeHandle AddNode(NodeHandle parent, const Transform& localTransform);
+	NodeHandle AddNode(NodeHandle parent, const DirectX::XMFLOAT3& scale, const DirectX::XMFLOAT4& rotationQuat,
+		const DirectX::XMFLOAT3& position);
+	// 移除节点及其整棵子树
+	void RemoveNode(NodeHandle node);
+
+	bool IsValid(NodeHandle node) const;
+	size_t GetNodeCount() const;
+	NodeHandle GetParent(NodeHandle node) const;
+
+	DirectX::XMFLOAT3 GetLocalScale(NodeHandle node) const;
+	DirectX::XMFLOAT4 GetLocalRotationQuat(NodeHandle node) const;
+	DirectX::XMFLOAT3 GetLocalPosition(NodeHandle node) const;
+
+	void SetLocalScale(NodeHandle node, const DirectX::XMFLOAT3& scale);
+	void SetLocalRotationQuat(NodeHandle node, const DirectX::XMFLOAT4& rotationQuat);
+	void SetLocalPosition(NodeHandle node, const DirectX::XMFLOAT3& position);
+	void SetLocalTransform(NodeHandle node, const Transform& localTransform);
+
+	// 世界矩阵在调用UpdateWorldMatrices后有效
+	DirectX::XMFLOAT4X4 GetWorldMatrix(NodeHandle node) const;
+	DirectX::XMMATRIX XM_CALLCONV GetWorldMatrixXM(NodeHandle node) const;
+
+	// 按深度优先顺序排列的世界矩阵，配合GetNodeIndex使用
+	const DirectX::XMFLOAT4X4A* GetWorldMatrices() const;
+	uint32_t GetNodeIndex(NodeHandle node) const;
+
+	// 只更新局部变换改变过的节点及其子树，未改变的子树整体跳过
+	void UpdateWorldMatrices();
+	// 多线程版本，结果与单线程版本逐位相同
+	// 根部节点先串行计算，之后互不相交的子树区间分批并行更新
+	void UpdateWorldMatrices(JobSystem& jobSystem, uint32_t grainSize = 2048);
+
+private:
+	enum DirtyFlag : uint8_t {
+		DirtySelf = 0x1,			// 局部变换已改变，整棵子树需要重新计算
+		DirtyDescendant = 0x2		// 子树中存在改变的节点
+	};
+
+	void MarkDirty(uint32_t index);
+	void ComputeWorldMatrix(uint32_t index);
+	// 处理[begin, end)内依次相邻的若干棵子树，forceUpdate表示它们的父节点已经改变
+	void UpdateRange(uint32_t begin, uint32_t end, bool forceUpdate);
+
+	struct UpdateTask {
+		uint32_t begin;
+		uint32_t end;
+		bool forceUpdate;
+	};
+	// 将不超过grainSize的子树划分为任务，更大的子树的根节点在此串行计算
+	void CollectUpdateTasks(uint32_t grainSize);
+
+private:
+	std::vector<DirectX::XMFLOAT3> m_LocalScales;
+	std::vector<DirectX::XMFLOAT4A> m_LocalRotations;
+	std::vector<DirectX::XMFLOAT3> m_LocalPositions;
+	std::vector<DirectX::XMFLOAT4X4A> m_WorldMatrices;
+	std::vector<uint32_t> m_ParentIndices;			// 父节点下标，根节点为UINT32_MAX
+	std::vector<uint32_t> m_SubtreeEnds;			// 子树末尾(不含)的下标
+	std::vector<uint8_t> m_DirtyFlags;
+	std::vector<NodeHandle> m_IndexToHandle;
+
+	std::vector<uint32_t> m_HandleToIndex;			// 已移除的句柄为UINT32_MAX
+	std::vector<NodeHandle> m_FreeHandles;
+
+	std::vector<UpdateTask> m_UpdateTasks;
+	std::vector<std::pair<uint32_t, bool>> m_TaskStack;
+};
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <cstdint>
 #include <d3d11_1.h>
 #include <DirectXMath.h>
 
@@ -131,4 +132,40 @@ struct VertexPosNormalTangentTex
 	DirectX::XMFLOAT4 tangent;
 	DirectX::XMFLOAT2 tex;
 	static const D3D11_INPUT_ELEMENT_DESC inputLayout[4];
-};
\ No newline at end of file
+};
+
+// 蒙皮顶点，每个顶点最多受4根骨骼影响，权重之和应为1
+struct VertexPosNormalTangentTexSkin
+{
+	VertexPosNormalTangentTexSkin() = default;
+
+	VertexPosNormalTangentTexSkin(const VertexPosNormalTangentTexSkin&) = default;
+	VertexPosNormalTangentTexSkin& operator=(const VertexPosNormalTangentTexSkin&) = default;
+
+	VertexPosNormalTangentTexSkin(VertexPosNormalTangentTexSkin&&) = default;
+	VertexPosNormalTangentTexSkin& operator=(VertexPosNormalTangentTexSkin&&) = default;
+
+	constexpr VertexPosNormalTangentTexSkin(const DirectX::XMFLOAT3& _pos, const DirectX::XMFLOAT3& _normal,
+		const DirectX::XMFLOAT4& _tangent, const DirectX::XMFLOAT2& _tex,
+		uint8_t _bone0, uint8_t _bone1, uint8_t _bone2, uint8_t _bone3, const DirectX::XMFLOAT4& _weights) :
+		pos(_pos), normal(_normal), tangent(_tangent), tex(_tex),
+		boneIndices{ _bone0, _bone1, _bone2, _bone3 }, weights(_weights) {}
+
+	DirectX::XMFLOAT3 pos;
+	DirectX::XMFLOAT3 normal;
+	DirectX::XMFLOAT4 tangent;
+	DirectX::XMFLOAT2 tex;
+	uint8_t boneIndices[4];
+	DirectX::XMFLOAT4 weights;
+	static const D3D11_INPUT_ELEMENT_DESC inputLayout[6];
+};
+
+// 实例化绘制的逐实例数据，从输入槽1读取
+// 与常量缓冲区中的矩阵一样以转置形式存放，着色器中按列读出
+struct InstancedData
+{
+	DirectX::XMFLOAT4X4 world;
+	DirectX::XMFLOAT4X4 worldInvTranspose;
+	// 槽0为VertexPosNormalColor，槽1为InstancedData
+	static const D3D11_INPUT_ELEMENT_DESC inputLayoutPosNormalColor[11];
+};
@@ -30,8 +30,18 @@ public:
 
 	int			Run();
 
+	// 固定时间步长更新，hz为0时退回到每帧以可变dt更新一次
+	void		SetFixedTimeStep(float hz, int maxStepsPerFrame = 5);
+	float		FixedTimeStep() const;
+	// 上一次固定更新之后经过的时间占一个步长的比例，绘制时用于插值
+	float		InterpolationAlpha() const;
+
 	virtual bool Init();
 	virtual void OnResize();
+	// 每帧调用一次，在所有UpdateScene之前读取输入，短于一个步长的按键也不会漏掉
+	virtual void ProcessInput(float dt);
+	// 每次UpdateScene之前调用，保存上一状态(如GameObject::SavePreviousTransform)供绘制时插值
+	virtual void SaveSceneState();
 	virtual void UpdateScene(float dt) = 0;
 	virtual void DrawScene() = 0;
 	virtual LRESULT MsgProc(HWND hwnd, UINT msg, WPARAM wParam, LPARAM lParam);
@@ -42,6 +52,8 @@ protected:
 	bool InitDirect2D();
 
 	void CalculateFrameStats();
+	// 读取输入，推进累积时间并执行若干次SaveSceneState与UpdateScene
+	void StepScene(float dt);
 
 protected:
 
@@ -55,6 +67,10 @@ protected:
 	UINT		m_4xMsaaQuality;
 
 	GameTimer	m_Timer;
+	float		m_FixedTimeStep;		// 秒，0表示不使用固定步长
+	int			m_MaxStepsPerFrame;		// 单帧最多追赶的更新次数
+	double		m_Accumulator;
+	float		m_InterpolationAlpha;
 
 	template <class T>
 	using ComPtr = Microsoft::WRL::ComPtr<T>;
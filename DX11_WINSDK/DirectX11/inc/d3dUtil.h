@@ -15,6 +15,7 @@
 #include <d3dcompiler.h>
 #include <vector>
 #include <string>
+#include "MathHelper.h"
 #include "DDSTextureLoader.h"
 #include "WICTextureLoader.h"
 
@@ -189,16 +190,4 @@ HRESULT CreateShaderFromFile(
 // 数学相关函数
 //
 
-// -----------------------------
-// InverseTranspose函数
-// -----------------------------
-inline DirectX::XMMATRIX XM_CALLCONV InverseTranspose(DirectX::FXMMATRIX M) {
-	using namespace DirectX;
-
-	// 世界矩阵的逆的转置仅针对法向量, 我们也不需要世界矩阵的平移分量
-	// 而且不去掉的话,后续再乘上观察矩阵之类的就会产生错误的变换结果
-	XMMATRIX A = M;
-	A.r[3] = g_XMIdentityR3;
-
-	return XMMatrixTranspose(XMMatrixInverse(nullptr, A));
-}
\ No newline at end of file
+// InverseTranspose等矩阵求逆函数见MathHelper.h
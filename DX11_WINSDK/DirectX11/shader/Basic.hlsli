@@ -1,30 +1,5 @@
 #include "LightHelper.hlsli"
-
-
-cbuffer CBChangesEveryFrame : register(b0)
-{
-    matrix g_World;
-    matrix g_WorldInvTranspose;
-}
-
-
-cbuffer CBChangesOnResize : register(b1)
-{
-    matrix g_Proj;
-}
-
-cbuffer CBChangesRarely : register(b2)
-{
-
-    DirectionalLight g_DirLight[5];
-    PointLight g_PointLight[5];
-    SpotLight g_SpotLight[5];
-    Material g_Material;
-    matrix g_View;
-    float3 g_EyePosW;
-    float g_CylinderHeight;
-   
-}
+#include "BasicCBuffers.hlsli"
 
 struct VertexPosColor
 {
@@ -45,6 +20,15 @@ struct VertexPosNormalColor
     float4 Color : COLOR;
 };
 
+struct InstancePosNormalColor
+{
+    float3 PosL : POSITION;
+    float3 NormalL : NORMAL;
+    float4 Color : COLOR;
+    matrix World : WORLD;
+    matrix WorldInvTranspose : WORLDINVTRANSPOSE;
+};
+
 struct VertexPosHWNormalColor
 {
     float4 PosH : SV_Position;
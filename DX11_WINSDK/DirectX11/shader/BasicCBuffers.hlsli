@@ -0,0 +1,60 @@
+// BasicEffect的常量缓冲区布局，由Basic.hlsli与BasicEffect.cpp共同包含
+// C++一侧只看到下面的宏，用static_assert检查结构体的大小与偏移；
+// HLSL一侧用同样的宏写register与packoffset，两边的布局不一致时其中一侧编译失败
+// 偏移与大小均以16字节的常量寄存器为单位
+
+#define BASIC_MAX_LIGHTS 5
+
+// 每个物体：世界矩阵与材质，SetMaterial不再牵连视图矩阵与光源
+#define CB_OBJECT_SLOT 0
+#define CB_OBJECT_WORLD 0
+#define CB_OBJECT_WORLD_INV_TRANSPOSE 4
+#define CB_OBJECT_MATERIAL 8
+#define CB_OBJECT_REGISTERS 12
+
+// 每帧：摄像机，g_CylinderHeight占用g_EyePosW所在寄存器的w分量
+#define CB_FRAME_SLOT 1
+#define CB_FRAME_VIEW 0
+#define CB_FRAME_PROJ 4
+#define CB_FRAME_EYE_POS 8
+#define CB_FRAME_REGISTERS 9
+
+// 场景：光源，摄像机移动时不再重新上传
+#define CB_LIGHTING_SLOT 2
+#define CB_LIGHTING_DIR_LIGHT 0
+#define CB_LIGHTING_POINT_LIGHT 20
+#define CB_LIGHTING_SPOT_LIGHT 45
+#define CB_LIGHTING_REGISTERS 75
+
+#ifndef __cplusplus
+
+#define CB_REGISTER_(n) register(b##n)
+#define CB_REGISTER(n) CB_REGISTER_(n)
+#define CB_PACKOFFSET_(n) packoffset(c##n)
+#define CB_PACKOFFSET(n) CB_PACKOFFSET_(n)
+#define CB_PACKOFFSET_W_(n) packoffset(c##n.w)
+#define CB_PACKOFFSET_W(n) CB_PACKOFFSET_W_(n)
+
+cbuffer CBChangesEveryDrawing : CB_REGISTER(CB_OBJECT_SLOT)
+{
+    matrix g_World : CB_PACKOFFSET(CB_OBJECT_WORLD);
+    matrix g_WorldInvTranspose : CB_PACKOFFSET(CB_OBJECT_WORLD_INV_TRANSPOSE);
+    Material g_Material : CB_PACKOFFSET(CB_OBJECT_MATERIAL);
+}
+
+cbuffer CBChangesEveryFrame : CB_REGISTER(CB_FRAME_SLOT)
+{
+    matrix g_View : CB_PACKOFFSET(CB_FRAME_VIEW);
+    matrix g_Proj : CB_PACKOFFSET(CB_FRAME_PROJ);
+    float3 g_EyePosW : CB_PACKOFFSET(CB_FRAME_EYE_POS);
+    float g_CylinderHeight : CB_PACKOFFSET_W(CB_FRAME_EYE_POS);
+}
+
+cbuffer CBChangesRarely : CB_REGISTER(CB_LIGHTING_SLOT)
+{
+    DirectionalLight g_DirLight[BASIC_MAX_LIGHTS] : CB_PACKOFFSET(CB_LIGHTING_DIR_LIGHT);
+    PointLight g_PointLight[BASIC_MAX_LIGHTS] : CB_PACKOFFSET(CB_LIGHTING_POINT_LIGHT);
+    SpotLight g_SpotLight[BASIC_MAX_LIGHTS] : CB_PACKOFFSET(CB_LIGHTING_SPOT_LIGHT);
+}
+
+#endif
@@ -0,0 +1,14 @@
+#include "Basic.hlsli"
+
+VertexPosHWNormalColor VS(InstancePosNormalColor vIn)
+{
+    VertexPosHWNormalColor vOut;
+    matrix viewProj = mul(g_View, g_Proj);
+    float4 posW = mul(float4(vIn.PosL, 1.0f), vIn.World);
+    
+    vOut.PosH = mul(posW, viewProj);
+    vOut.PosW = posW.xyz;
+    vOut.NormalW = mul(vIn.NormalL, (float3x3) vIn.WorldInvTranspose);
+    vOut.Color = vIn.Color;
+    return vOut;
+}
\ No newline at end of file
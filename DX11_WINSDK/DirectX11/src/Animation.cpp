@@ -0,0 +1,268 @@
+#include "Animation.h"
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+
+using namespace DirectX;
+
+namespace {
+	// 游标向后线性查找的最大步数，超过则改用二分查找
+	const uint32_t MaxLinearSteps = 4;
+
+	inline void StoreValue(XMFLOAT3* dest, FXMVECTOR v) { XMStoreFloat3(dest, v); }
+	inline void StoreValue(XMFLOAT4* dest, FXMVECTOR v) { XMStoreFloat4(dest, v); }
+}
+
+uint32_t AnimationClip::AddTrack(const XMFLOAT3& scale, const XMFLOAT4& rotationQuat, const XMFLOAT3& position)
+{
+	const XMFLOAT4A defaults[] = {
+		XMFLOAT4A(scale.x, scale.y, scale.z, 0.0f),
+		XMFLOAT4A(rotationQuat.x, rotationQuat.y, rotationQuat.z, rotationQuat.w),
+		XMFLOAT4A(position.x, position.y, position.z, 0.0f)
+	};
+	for (size_t c = 0; c < (size_t)Channel::Count; ++c) {
+		ChannelData& data = m_Channels[c];
+		data.keyOffsets.push_back((uint32_t)data.times.size());
+		data.keyCounts.push_back(0);
+		data.interpolations.push_back(Interpolation::Linear);
+		data.defaults.push_back(defaults[c]);
+	}
+	return (uint32_t)m_Channels[0].keyCounts.size() - 1;
+}
+
+uint32_t AnimationClip::GetTrackCount() const
+{
+	return (uint32_t)m_Channels[0].keyCounts.size();
+}
+
+void AnimationClip::SetScaleKeys(uint32_t track, const float* times, const XMFLOAT3* values, uint32_t count,
+	Interpolation interpolation)
+{
+	std::vector<XMFLOAT4A> keys(count);
+	for (uint32_t i = 0; i < count; ++i)
+		keys[i] = XMFLOAT4A(values[i].x, values[i].y, values[i].z, 0.0f);
+	SetKeys(Channel::Scale, track, times, keys.data(), count, interpolation);
+}
+
+void AnimationClip::SetRotationKeys(uint32_t track, const float* times, const XMFLOAT4* values, uint32_t count,
+	Interpolation interpolation)
+{
+	// 相邻关键帧保持在同一半球，插值时总是走最短路径
+	std::vector<XMFLOAT4A> keys(count);
+	XMVECTOR prev = XMQuaternionIdentity();
+	for (uint32_t i = 0; i < count; ++i) {
+		XMVECTOR q = XMQuaternionNormalize(XMLoadFloat4(&values[i]));
+		if (i > 0 && XMVectorGetX(XMQuaternionDot(prev, q)) < 0.0f)
+			q = XMVectorNegate(q);
+		XMStoreFloat4A(&keys[i], q);
+		prev = q;
+	}
+	SetKeys(Channel::Rotation, track, times, keys.data(), count, interpolation);
+}
+
+void AnimationClip::SetPositionKeys(uint32_t track, const float* times, const XMFLOAT3* values, uint32_t count,
+	Interpolation interpolation)
+{
+	std::vector<XMFLOAT4A> keys(count);
+	for (uint32_t i = 0; i < count; ++i)
+		keys[i] = XMFLOAT4A(values[i].x, values[i].y, values[i].z, 0.0f);
+	SetKeys(Channel::Position, track, times, keys.data(), count, interpolation);
+}
+
+uint32_t AnimationClip::GetKeyCount(uint32_t track, Channel channel) const
+{
+	return m_Channels[(size_t)channel].keyCounts[track];
+}
+
+float AnimationClip::GetDuration() const
+{
+	return m_Duration;
+}
+
+void AnimationClip::SetKeys(Channel channel, uint32_t track, const float* times, const XMFLOAT4A* values, uint32_t count,
+	Interpolation interpolation)
+{
+	ChannelData& data = m_Channels[(size_t)channel];
+	assert(track < data.keyCounts.size());
+	for (uint32_t i = 1; i < count; ++i)
+		assert(times[i] > times[i - 1]);
+
+	// 替换该轨道原有的关键帧区间，按轨道顺序设置时总是追加在末尾
+	uint32_t offset = data.keyOffsets[track];
+	uint32_t oldCount = data.keyCounts[track];
+	data.times.erase(data.times.begin() + offset, data.times.begin() + offset + oldCount);
+	data.values.erase(data.values.begin() + offset, data.values.begin() + offset + oldCount);
+	data.tangents.erase(data.tangents.begin() + offset, data.tangents.begin() + offset + oldCount);
+	data.times.insert(data.times.begin() + offset, times, times + count);
+	data.values.insert(data.values.begin() + offset, values, values + count);
+	data.tangents.insert(data.tangents.begin() + offset, count, XMFLOAT4A());
+	for (size_t i = track + 1; i < data.keyOffsets.size(); ++i)
+		data.keyOffsets[i] = data.keyOffsets[i] - oldCount + count;
+	data.keyCounts[track] = count;
+	data.interpolations[track] = interpolation;
+
+	if (interpolation == Interpolation::Cubic)
+		ComputeTangents(data, track);
+	UpdateDuration();
+}
+
+void AnimationClip::UpdateDuration()
+{
+	// 替换关键帧可能缩短原本最长的轨道，需从所有轨道重新求最晚时间
+	m_Duration = 0.0f;
+	for (const ChannelData& data : m_Channels) {
+		for (size_t i = 0; i < data.keyCounts.size(); ++i) {
+			if (data.keyCounts[i] > 0)
+				m_Duration = std::max(m_Duration, data.times[data.keyOffsets[i] + data.keyCounts[i] - 1]);
+		}
+	}
+}
+
+void AnimationClip::ComputeTangents(ChannelData& data, uint32_t track)
+{
+	// Catmull-Rom切线，对非均匀的关键帧间隔按时间差归一化，端点使用单侧差分
+	uint32_t offset = data.keyOffsets[track];
+	uint32_t count = data.keyCounts[track];
+	const float* times = data.times.data() + offset;
+	const XMFLOAT4A* values = data.values.data() + offset;
+	XMFLOAT4A* tangents = data.tangents.data() + offset;
+	for (uint32_t i = 0; i < count; ++i) {
+		uint32_t prev = i > 0 ? i - 1 : i;
+		uint32_t next = i + 1 < count ? i + 1 : i;
+		if (prev == next) {
+			tangents[i] = XMFLOAT4A();
+			continue;
+		}
+		XMVECTOR diff = XMVectorSubtract(XMLoadFloat4A(&values[next]), XMLoadFloat4A(&values[prev]));
+		XMStoreFloat4A(&tangents[i], XMVectorScale(diff, 1.0f / (times[next] - times[prev])));
+	}
+}
+
+void AnimationPose::Resize(uint32_t trackCount)
+{
+	scales.resize(trackCount);
+	rotations.resize(trackCount);
+	positions.resize(trackCount);
+}
+
+void AnimationPose::ApplyTo(uint32_t track, Transform& transform) const
+{
+	transform.SetScale(scales[track]);
+	transform.SetRotationQuat(rotations[track]);
+	transform.SetPosition(positions[track]);
+}
+
+void AnimationPose::ApplyTo(TransformHierarchy& hierarchy, const TransformHierarchy::NodeHandle* nodes) const
+{
+	for (size_t i = 0; i < scales.size(); ++i) {
+		hierarchy.SetLocalScale(nodes[i], scales[i]);
+		hierarchy.SetLocalRotationQuat(nodes[i], rotations[i]);
+		hierarchy.SetLocalPosition(nodes[i], positions[i]);
+	}
+}
+
+AnimationSampler::AnimationSampler(const AnimationClip& clip)
+{
+	Reset(clip);
+}
+
+void AnimationSampler::Reset(const AnimationClip& clip)
+{
+	for (auto& cursors : m_Cursors)
+		cursors.assign(clip.GetTrackCount(), 0);
+}
+
+void AnimationSampler::Sample(const AnimationClip& clip, float time, AnimationPose& pose)
+{
+	uint32_t trackCount = clip.GetTrackCount();
+	if (m_Cursors[0].size() != trackCount)
+		Reset(clip);
+	pose.Resize(trackCount);
+
+	time = std::min(std::max(time, 0.0f), clip.GetDuration());
+	SampleChannel<false>(clip.m_Channels[(size_t)AnimationClip::Channel::Scale],
+		m_Cursors[(size_t)AnimationClip::Channel::Scale].data(), time, pose.scales.data());
+	SampleChannel<true>(clip.m_Channels[(size_t)AnimationClip::Channel::Rotation],
+		m_Cursors[(size_t)AnimationClip::Channel::Rotation].data(), time, pose.rotations.data());
+	SampleChannel<false>(clip.m_Channels[(size_t)AnimationClip::Channel::Position],
+		m_Cursors[(size_t)AnimationClip::Channel::Position].data(), time, pose.positions.data());
+}
+
+void AnimationSampler::SampleLooped(const AnimationClip& clip, float time, AnimationPose& pose)
+{
+	float duration = clip.GetDuration();
+	if (duration > 0.0f) {
+		time = fmodf(time, duration);
+		if (time < 0.0f)
+			time += duration;
+	}
+	Sample(clip, time, pose);
+}
+
+uint32_t AnimationSampler::FindKey(const float* times, uint32_t count, float time, uint32_t cursor) const
+{
+	// 返回满足times[k] <= time < times[k + 1]的k，调用方保证times[0] <= time < times[count - 1]
+	if (cursor + 1 < count && times[cursor] <= time) {
+		for (uint32_t step = 0; step < MaxLinearSteps; ++step, ++cursor) {
+			if (time < times[cursor + 1])
+				return cursor;
+		}
+	}
+	return (uint32_t)(std::upper_bound(times, times + count, time) - times) - 1;
+}
+
+template<bool IsRotation, class T>
+void AnimationSampler::SampleChannel(const AnimationClip::ChannelData& data, uint32_t* cursors, float time, T* out) const
+{
+	const uint32_t trackCount = (uint32_t)data.keyCounts.size();
+	const float* allTimes = data.times.data();
+	const XMFLOAT4A* allValues = data.values.data();
+	const XMFLOAT4A* allTangents = data.tangents.data();
+
+	for (uint32_t i = 0; i < trackCount; ++i) {
+		uint32_t count = data.keyCounts[i];
+		if (count == 0) {
+			StoreValue(&out[i], XMLoadFloat4A(&data.defaults[i]));
+			continue;
+		}
+
+		uint32_t offset = data.keyOffsets[i];
+		const float* times = allTimes + offset;
+		if (count == 1 || time <= times[0]) {
+			StoreValue(&out[i], XMLoadFloat4A(&allValues[offset]));
+			continue;
+		}
+		if (time >= times[count - 1]) {
+			StoreValue(&out[i], XMLoadFloat4A(&allValues[offset + count - 1]));
+			continue;
+		}
+
+		uint32_t k = FindKey(times, count, time, cursors[i]);
+		cursors[i] = k;
+		float dt = times[k + 1] - times[k];
+		float s = (time - times[k]) / dt;
+		XMVECTOR p0 = XMLoadFloat4A(&allValues[offset + k]);
+		XMVECTOR p1 = XMLoadFloat4A(&allValues[offset + k + 1]);
+
+		XMVECTOR res;
+		if (data.interpolations[i] == AnimationClip::Interpolation::Linear) {
+			res = XMVectorLerp(p0, p1, s);
+		}
+		else {
+			// 三次Hermite插值，切线按区间长度缩放
+			float s2 = s * s, s3 = s2 * s;
+			float h00 = 2.0f * s3 - 3.0f * s2 + 1.0f;
+			float h10 = (s3 - 2.0f * s2 + s) * dt;
+			float h01 = -2.0f * s3 + 3.0f * s2;
+			float h11 = (s3 - s2) * dt;
+			res = XMVectorScale(p0, h00);
+			res = XMVectorMultiplyAdd(XMLoadFloat4A(&allTangents[offset + k]), XMVectorReplicate(h10), res);
+			res = XMVectorMultiplyAdd(p1, XMVectorReplicate(h01), res);
+			res = XMVectorMultiplyAdd(XMLoadFloat4A(&allTangents[offset + k + 1]), XMVectorReplicate(h11), res);
+		}
+		// 关键帧已处于同一半球，分量插值后归一化(nlerp)即可
+		if (IsRotation)
+			res = XMQuaternionNormalize(res);
+		StoreValue(&out[i], res);
+	}
+}
@@ -1,8 +1,11 @@
 #include "Effects.h"
+#include "Camera.h"
 #include "d3dUtil.h"
 #include "EffectHelper.h"
 #include "DXTrace.h"
 #include "Vertex.h"
+#include "BasicCBuffers.hlsli"
+#include <cstddef>
 
 using namespace DirectX;
 
@@ -10,15 +13,20 @@ class BasicEffect::Impl : public AlignedType<BasicEffect::Impl>
 {
 public:
 
-	struct CBChangesEveryFrame
+	// 布局见BasicCBuffers.hlsli
+	struct CBChangesEveryDrawing
 	{
 		DirectX::XMMATRIX world;
 		DirectX::XMMATRIX worldInvTranspose;
+		Material material;
 	};
 
-	struct CBChangesOnResize
+	struct CBChangesEveryFrame
 	{
+		DirectX::XMMATRIX view;
 		DirectX::XMMATRIX proj;
+		DirectX::XMFLOAT3 eyePos;
+		float cylinderHeight;
 	};
 
 	struct CBChangesRarely
@@ -26,24 +34,46 @@ public:
 		DirectionalLight dirLight[BasicEffect::maxLights];
 		PointLight pointLight[BasicEffect::maxLights];
 		SpotLight spotLight[BasicEffect::maxLights];
-		Material material;
-		DirectX::XMMATRIX view;
-		DirectX::XMFLOAT3 eyePos;
-		float cylinderHeight;
 	};
 
+	// 与BasicCBuffers.hlsli中的packoffset一致
+	static const size_t registerSize = 16;
+
+	static_assert(BasicEffect::maxLights == BASIC_MAX_LIGHTS, "light count differs from BasicCBuffers.hlsli");
+
+	static_assert(offsetof(CBChangesEveryDrawing, world) == CB_OBJECT_WORLD * registerSize, "CBChangesEveryDrawing layout");
+	static_assert(offsetof(CBChangesEveryDrawing, worldInvTranspose) == CB_OBJECT_WORLD_INV_TRANSPOSE * registerSize, "CBChangesEveryDrawing layout");
+	static_assert(offsetof(CBChangesEveryDrawing, material) == CB_OBJECT_MATERIAL * registerSize, "CBChangesEveryDrawing layout");
+	static_assert(sizeof(CBChangesEveryDrawing) == CB_OBJECT_REGISTERS * registerSize, "CBChangesEveryDrawing size");
+
+	static_assert(offsetof(CBChangesEveryFrame, view) == CB_FRAME_VIEW * registerSize, "CBChangesEveryFrame layout");
+	static_assert(offsetof(CBChangesEveryFrame, proj) == CB_FRAME_PROJ * registerSize, "CBChangesEveryFrame layout");
+	static_assert(offsetof(CBChangesEveryFrame, eyePos) == CB_FRAME_EYE_POS * registerSize, "CBChangesEveryFrame layout");
+	static_assert(offsetof(CBChangesEveryFrame, cylinderHeight) == CB_FRAME_EYE_POS * registerSize + 12, "CBChangesEveryFrame layout");
+	static_assert(sizeof(CBChangesEveryFrame) == CB_FRAME_REGISTERS * registerSize, "CBChangesEveryFrame size");
+
+	static_assert(offsetof(CBChangesRarely, dirLight) == CB_LIGHTING_DIR_LIGHT * registerSize, "CBChangesRarely layout");
+	static_assert(offsetof(CBChangesRarely, pointLight) == CB_LIGHTING_POINT_LIGHT * registerSize, "CBChangesRarely layout");
+	static_assert(offsetof(CBChangesRarely, spotLight) == CB_LIGHTING_SPOT_LIGHT * registerSize, "CBChangesRarely layout");
+	static_assert(sizeof(CBChangesRarely) == CB_LIGHTING_REGISTERS * registerSize, "CBChangesRarely size");
+
 public:
-	Impl() : m_IsDirty(){}
+	Impl() : m_IsDirty(), m_pObjectRing(), m_ObjectAllocation() {}
 	~Impl() = default;
 
 public:
 
-	CBufferObject<0, CBChangesEveryFrame> m_CBFrame;
-	CBufferObject<1, CBChangesOnResize> m_CBOnResize;
-	CBufferObject<2, CBChangesRarely> m_CBRarely;
+	CBufferObject<CB_OBJECT_SLOT, CBChangesEveryDrawing> m_CBDrawing;
+	CBufferObject<CB_FRAME_SLOT, CBChangesEveryFrame> m_CBFrame;
+	CBufferObject<CB_LIGHTING_SLOT, CBChangesRarely> m_CBRarely;
 	BOOL m_IsDirty;
 	std::vector<CBufferBase*> m_pCBuffers;
 
+	ConstantBufferRing* m_pObjectRing;
+	ConstantBufferRing::Allocation m_ObjectAllocation;
+
+	DeviceContextStateCache m_StateCache;
+
 	
 	ComPtr<ID3D11VertexShader> m_pTriangleVS;
 	ComPtr<ID3D11PixelShader> m_pTrianglePS;
@@ -57,8 +87,11 @@ public:
 	ComPtr<ID3D11PixelShader> m_pNormalPS;
 	ComPtr<ID3D11GeometryShader> m_pNormalGS;
 
+	ComPtr<ID3D11VertexShader> m_pInstanceVS;
+
 	ComPtr<ID3D11InputLayout> m_pVertexPosColorLayout;
 	ComPtr<ID3D11InputLayout> m_pVertexPosNormalColorLayout;
+	ComPtr<ID3D11InputLayout> m_pInstancePosNormalColorLayout;
 
 
 	ComPtr<ID3D11ShaderResourceView> m_pTexture;
@@ -130,9 +163,13 @@ bool BasicEffect::InitAll(ID3D11Device* device) {
 	HR(CreateShaderFromFile(L"HLSL\\Normal_GS.cso", L"HLSL\\Normal_GS.hlsl", "GS", "gs_5_0", blob.ReleaseAndGetAddressOf()));
 	HR(device->CreateGeometryShader(blob->GetBufferPointer(), blob->GetBufferSize(), nullptr, pImpl->m_pNormalGS.GetAddressOf()));
 
+	HR(CreateShaderFromFile(L"HLSL\\Instance_VS.cso", L"HLSL\\Instance_VS.hlsl", "VS", "vs_5_0", blob.ReleaseAndGetAddressOf()));
+	HR(device->CreateVertexShader(blob->GetBufferPointer(), blob->GetBufferSize(), nullptr, pImpl->m_pInstanceVS.GetAddressOf()));
+	HR(device->CreateInputLayout(InstancedData::inputLayoutPosNormalColor, ARRAYSIZE(InstancedData::inputLayoutPosNormalColor), blob->GetBufferPointer(), blob->GetBufferSize(), pImpl->m_pInstancePosNormalColorLayout.GetAddressOf()));
+
 	pImpl->m_pCBuffers.assign({
+		&pImpl->m_CBDrawing,
 		&pImpl->m_CBFrame,
-		&pImpl->m_CBOnResize,
 		&pImpl->m_CBRarely
 		});
 
@@ -143,8 +180,9 @@ bool BasicEffect::InitAll(ID3D11Device* device) {
 
 	D3D11SetDebugObjectName(pImpl->m_pVertexPosColorLayout.Get(), "VertexPosColorLayout");
 	D3D11SetDebugObjectName(pImpl->m_pVertexPosNormalColorLayout.Get(), "VertexPosNormalColorLayout");
-	D3D11SetDebugObjectName(pImpl->m_pCBuffers[0]->cBuffer.Get(), "CBFrame");
-	D3D11SetDebugObjectName(pImpl->m_pCBuffers[1]->cBuffer.Get(), "CBOnResize");
+	D3D11SetDebugObjectName(pImpl->m_pInstancePosNormalColorLayout.Get(), "InstancePosNormalColorLayout");
+	D3D11SetDebugObjectName(pImpl->m_pCBuffers[0]->cBuffer.Get(), "CBDrawing");
+	D3D11SetDebugObjectName(pImpl->m_pCBuffers[1]->cBuffer.Get(), "CBFrame");
 	D3D11SetDebugObjectName(pImpl->m_pCBuffers[2]->cBuffer.Get(), "CBRarely");
 	D3D11SetDebugObjectName(pImpl->m_pTriangleVS.Get(), "Triangle_VS");
 	D3D11SetDebugObjectName(pImpl->m_pTriangleGS.Get(), "Triangle_GS");
@@ -155,85 +193,114 @@ bool BasicEffect::InitAll(ID3D11Device* device) {
 	D3D11SetDebugObjectName(pImpl->m_pNormalVS.Get(), "Normal_VS");
 	D3D11SetDebugObjectName(pImpl->m_pNormalGS.Get(), "Normal_GS");
 	D3D11SetDebugObjectName(pImpl->m_pNormalPS.Get(), "Normal_PS");
+	D3D11SetDebugObjectName(pImpl->m_pInstanceVS.Get(), "Instance_VS");
 
 	return true;
 }
 
 void BasicEffect::SetRenderSplitedTriangle(ID3D11DeviceContext* deviceContext) {
-	deviceContext->IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
-	deviceContext->IASetInputLayout(pImpl->m_pVertexPosColorLayout.Get());
-	deviceContext->VSSetShader(pImpl->m_pTriangleVS.Get(), nullptr, 0);
-	deviceContext->PSSetShader(pImpl->m_pTrianglePS.Get(), nullptr, 0);
-	deviceContext->GSSetShader(pImpl->m_pTriangleGS.Get(), nullptr, 0);
-	deviceContext->RSSetState(nullptr);
+	auto& stateCache = pImpl->m_StateCache;
+	stateCache.IASetPrimitiveTopology(deviceContext, D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+	stateCache.IASetInputLayout(deviceContext, pImpl->m_pVertexPosColorLayout.Get());
+	stateCache.VSSetShader(deviceContext, pImpl->m_pTriangleVS.Get());
+	stateCache.PSSetShader(deviceContext, pImpl->m_pTrianglePS.Get());
+	stateCache.GSSetShader(deviceContext, pImpl->m_pTriangleGS.Get());
+	stateCache.RSSetState(deviceContext, nullptr);
 }
 
 void BasicEffect::SetRenderCylinderNoCap(ID3D11DeviceContext* deviceContext) {
-	deviceContext->IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_LINESTRIP);
-	deviceContext->IASetInputLayout(pImpl->m_pVertexPosNormalColorLayout.Get());
-	deviceContext->VSSetShader(pImpl->m_pCylinderVS.Get(), nullptr, 0);
-	deviceContext->GSSetShader(pImpl->m_pCylinderGS.Get(), nullptr, 0);
-	deviceContext->PSSetShader(pImpl->m_pCylinderPS.Get(), nullptr, 0);
-	deviceContext->RSSetState(RenderStates::RSNoCull.Get());
+	auto& stateCache = pImpl->m_StateCache;
+	stateCache.IASetPrimitiveTopology(deviceContext, D3D11_PRIMITIVE_TOPOLOGY_LINESTRIP);
+	stateCache.IASetInputLayout(deviceContext, pImpl->m_pVertexPosNormalColorLayout.Get());
+	stateCache.VSSetShader(deviceContext, pImpl->m_pCylinderVS.Get());
+	stateCache.GSSetShader(deviceContext, pImpl->m_pCylinderGS.Get());
+	stateCache.PSSetShader(deviceContext, pImpl->m_pCylinderPS.Get());
+	stateCache.RSSetState(deviceContext, RenderStates::RSNoCull.Get());
 }
 
 void BasicEffect::SetRenderNormal(ID3D11DeviceContext* deviceContext) {
-	deviceContext->IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_POINTLIST);
-	deviceContext->IASetInputLayout(pImpl->m_pVertexPosNormalColorLayout.Get());
-	deviceContext->VSSetShader(pImpl->m_pNormalVS.Get(), nullptr, 0);
-	deviceContext->GSSetShader(pImpl->m_pNormalGS.Get(), nullptr, 0);
-	deviceContext->PSSetShader(pImpl->m_pNormalPS.Get(), nullptr, 0);
-	deviceContext->RSSetState(nullptr);
+	auto& stateCache = pImpl->m_StateCache;
+	stateCache.IASetPrimitiveTopology(deviceContext, D3D11_PRIMITIVE_TOPOLOGY_POINTLIST);
+	stateCache.IASetInputLayout(deviceContext, pImpl->m_pVertexPosNormalColorLayout.Get());
+	stateCache.VSSetShader(deviceContext, pImpl->m_pNormalVS.Get());
+	stateCache.GSSetShader(deviceContext, pImpl->m_pNormalGS.Get());
+	stateCache.PSSetShader(deviceContext, pImpl->m_pNormalPS.Get());
+	stateCache.RSSetState(deviceContext, nullptr);
+}
+
+void BasicEffect::SetRenderInstanced(ID3D11DeviceContext* deviceContext) {
+	auto& stateCache = pImpl->m_StateCache;
+	stateCache.IASetPrimitiveTopology(deviceContext, D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+	stateCache.IASetInputLayout(deviceContext, pImpl->m_pInstancePosNormalColorLayout.Get());
+	stateCache.VSSetShader(deviceContext, pImpl->m_pInstanceVS.Get());
+	stateCache.GSSetShader(deviceContext, nullptr);
+	stateCache.PSSetShader(deviceContext, pImpl->m_pCylinderPS.Get());
+	stateCache.RSSetState(deviceContext, nullptr);
 }
 
 void XM_CALLCONV BasicEffect::SetWorldMatrix(DirectX::FXMMATRIX W)
 {
-	auto& cBuffer = pImpl->m_CBFrame;
-	cBuffer.data.world = XMMatrixTranspose(W);
-	cBuffer.data.worldInvTranspose = XMMatrixTranspose(InverseTranspose(W));
-	pImpl->m_IsDirty = cBuffer.isDirty = true;
+	auto& cBuffer = pImpl->m_CBDrawing;
+	cBuffer.Write(cBuffer.data.world, XMMatrixTranspose(W));
+	cBuffer.Write(cBuffer.data.worldInvTranspose, XMMatrixTranspose(InverseTranspose(W)));
+	pImpl->m_IsDirty |= cBuffer.isDirty;
+}
+
+ConstantBufferRing::Allocation XM_CALLCONV BasicEffect::WriteObjectConstants(ConstantBufferRing& ring, FXMMATRIX W, const Material& material)
+{
+	Impl::CBChangesEveryDrawing data;
+	data.world = XMMatrixTranspose(W);
+	data.worldInvTranspose = XMMatrixTranspose(InverseTranspose(W));
+	data.material = material;
+	return ring.Allocate(data);
+}
+
+void BasicEffect::SetObjectConstants(ConstantBufferRing* ring, const ConstantBufferRing::Allocation& allocation)
+{
+	pImpl->m_pObjectRing = ring;
+	pImpl->m_ObjectAllocation = allocation;
 }
 
 void XM_CALLCONV BasicEffect::SetViewMatrix(FXMMATRIX V)
 {
-	auto& cBuffer = pImpl->m_CBRarely;
-	cBuffer.data.view = XMMatrixTranspose(V);
-	pImpl->m_IsDirty = cBuffer.isDirty = true;
+	auto& cBuffer = pImpl->m_CBFrame;
+	cBuffer.Write(cBuffer.data.view, XMMatrixTranspose(V));
+	pImpl->m_IsDirty |= cBuffer.isDirty;
 }
 
 void XM_CALLCONV BasicEffect::SetProjMatrix(FXMMATRIX P)
 {
-	auto& cBuffer = pImpl->m_CBOnResize;
-	cBuffer.data.proj = XMMatrixTranspose(P);
-	pImpl->m_IsDirty = cBuffer.isDirty = true;
+	auto& cBuffer = pImpl->m_CBFrame;
+	cBuffer.Write(cBuffer.data.proj, XMMatrixTranspose(P));
+	pImpl->m_IsDirty |= cBuffer.isDirty;
 }
 
 void BasicEffect::SetDirLight(size_t pos, const DirectionalLight& dirLight)
 {
 	auto& cBuffer = pImpl->m_CBRarely;
-	cBuffer.data.dirLight[pos] = dirLight;
-	pImpl->m_IsDirty = cBuffer.isDirty = true;
+	cBuffer.Write(cBuffer.data.dirLight[pos], dirLight);
+	pImpl->m_IsDirty |= cBuffer.isDirty;
 }
 
 void BasicEffect::SetPointLight(size_t pos, const PointLight& pointLight)
 {
 	auto& cBuffer = pImpl->m_CBRarely;
-	cBuffer.data.pointLight[pos] = pointLight;
-	pImpl->m_IsDirty = cBuffer.isDirty = true;
+	cBuffer.Write(cBuffer.data.pointLight[pos], pointLight);
+	pImpl->m_IsDirty |= cBuffer.isDirty;
 }
 
 void BasicEffect::SetSpotLight(size_t pos, const SpotLight& spotLight)
 {
 	auto& cBuffer = pImpl->m_CBRarely;
-	cBuffer.data.spotLight[pos] = spotLight;
-	pImpl->m_IsDirty = cBuffer.isDirty = true;
+	cBuffer.Write(cBuffer.data.spotLight[pos], spotLight);
+	pImpl->m_IsDirty |= cBuffer.isDirty;
 }
 
 void BasicEffect::SetMaterial(const Material& material)
 {
-	auto& cBuffer = pImpl->m_CBRarely;
-	cBuffer.data.material = material;
-	pImpl->m_IsDirty = cBuffer.isDirty = true;
+	auto& cBuffer = pImpl->m_CBDrawing;
+	cBuffer.Write(cBuffer.data.material, material);
+	pImpl->m_IsDirty |= cBuffer.isDirty;
 }
 
 void BasicEffect::SetTexture(ID3D11ShaderResourceView* texture)
@@ -243,34 +310,56 @@ void BasicEffect::SetTexture(ID3D11ShaderResourceView* texture)
 
 void BasicEffect::SetEyePos(const DirectX::XMFLOAT3& eyePos)
 {
-	auto& cBuffer = pImpl->m_CBRarely;
-	cBuffer.data.eyePos = eyePos;
-	pImpl->m_IsDirty = cBuffer.isDirty = true;
+	auto& cBuffer = pImpl->m_CBFrame;
+	cBuffer.Write(cBuffer.data.eyePos, eyePos);
+	pImpl->m_IsDirty |= cBuffer.isDirty;
+}
+
+void BasicEffect::SetCameraRelative(const Camera& camera)
+{
+	SetViewMatrix(camera.GetViewRelativeXM());
+	SetEyePos(XMFLOAT3(0.0f, 0.0f, 0.0f));
 }
 
 void BasicEffect::SetCylinderHeight(float height) {
-	auto& cBuffer = pImpl->m_CBRarely;
-	cBuffer.data.cylinderHeight = height;
-	pImpl->m_IsDirty = cBuffer.isDirty = true;
+	auto& cBuffer = pImpl->m_CBFrame;
+	cBuffer.Write(cBuffer.data.cylinderHeight, height);
+	pImpl->m_IsDirty |= cBuffer.isDirty;
+}
+
+DeviceContextStateCache& BasicEffect::GetStateCache()
+{
+	return pImpl->m_StateCache;
 }
 
 void BasicEffect::Apply(ID3D11DeviceContext* deviceContext)
 {
 	auto& pCBuffers = pImpl->m_pCBuffers;
-	// 将缓冲区绑定到渲染管线上
-	pCBuffers[0]->BindVS(deviceContext);
-	pCBuffers[1]->BindVS(deviceContext);
-	pCBuffers[2]->BindVS(deviceContext);
-
-	pCBuffers[0]->BindGS(deviceContext);
-	pCBuffers[1]->BindGS(deviceContext);
-	pCBuffers[2]->BindGS(deviceContext);
+	auto& stateCache = pImpl->m_StateCache;
+	// 将缓冲区绑定到渲染管线上，与当前绑定相同的调用由stateCache丢弃
+	if (pImpl->m_pObjectRing) {
+		pImpl->m_pObjectRing->BindVS(stateCache, deviceContext, CB_OBJECT_SLOT, pImpl->m_ObjectAllocation);
+		pImpl->m_pObjectRing->BindGS(stateCache, deviceContext, CB_OBJECT_SLOT, pImpl->m_ObjectAllocation);
+		pImpl->m_pObjectRing->BindPS(stateCache, deviceContext, CB_OBJECT_SLOT, pImpl->m_ObjectAllocation);
+	}
+	else {
+		stateCache.VSSetConstantBuffer(deviceContext, CB_OBJECT_SLOT, pCBuffers[0]->cBuffer.Get());
+		stateCache.GSSetConstantBuffer(deviceContext, CB_OBJECT_SLOT, pCBuffers[0]->cBuffer.Get());
+		stateCache.PSSetConstantBuffer(deviceContext, CB_OBJECT_SLOT, pCBuffers[0]->cBuffer.Get());
+	}
+	stateCache.VSSetConstantBuffer(deviceContext, CB_FRAME_SLOT, pCBuffers[1]->cBuffer.Get());
+	stateCache.VSSetConstantBuffer(deviceContext, CB_LIGHTING_SLOT, pCBuffers[2]->cBuffer.Get());
+
+	stateCache.GSSetConstantBuffer(deviceContext, CB_FRAME_SLOT, pCBuffers[1]->cBuffer.Get());
+	stateCache.GSSetConstantBuffer(deviceContext, CB_LIGHTING_SLOT, pCBuffers[2]->cBuffer.Get());
 	
-	pCBuffers[2]->BindPS(deviceContext);
+	// 像素着色器需要材质、观察点与光源
+	stateCache.PSSetConstantBuffer(deviceContext, CB_FRAME_SLOT, pCBuffers[1]->cBuffer.Get());
+	stateCache.PSSetConstantBuffer(deviceContext, CB_LIGHTING_SLOT, pCBuffers[2]->cBuffer.Get());
 
 
 	// 设置纹理
-	deviceContext->PSSetShaderResources(0, 1, pImpl->m_pTexture.GetAddressOf());
+	stateCache.PSSetShaderResource(deviceContext, 0, pImpl->m_pTexture.Get());
 
 	if (pImpl->m_IsDirty)
 	{
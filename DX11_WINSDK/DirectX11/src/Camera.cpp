@@ -1,4 +1,6 @@
 #include "Camera.h"
+#include "MathHelper.h"
+#include <cmath>
 using namespace DirectX;
 
 Camera::~Camera() {
@@ -13,6 +15,10 @@ XMFLOAT3 Camera::GetPosition() const {
 	return m_Transform.GetPosition();
 }
 
+Double3 Camera::GetPositionDouble() const {
+	return m_Transform.GetPositionDouble();
+}
+
 float Camera::GetRotationX() const {
 	return m_Transform.GetRotation().x;
 }
@@ -45,16 +51,102 @@ XMFLOAT3 Camera::GetLookAxis() const {
 	return m_Transform.GetForwardAxis();
 }
 
+float Camera::GetPitchFromForwardAxis(const XMFLOAT3& forward) {
+	// 无翻滚时前向量为(sin(y)cos(x), -sin(x), cos(y)cos(x))
+	float sinPitch = -forward.y;
+	if (sinPitch > 1.0f)
+		sinPitch = 1.0f;
+	else if (sinPitch < -1.0f)
+		sinPitch = -1.0f;
+	return asinf(sinPitch);
+}
+
+void Camera::UpdateMatrices() const {
+	bool isViewDirty = m_CachedTransformVersion != m_Transform.GetVersion();
+	if (!isViewDirty && !m_IsProjDirty)
+		return;
+
+	if (isViewDirty) {
+		// 观察矩阵的逆即相机的世界矩阵
+		XMStoreFloat4x4(&m_View, m_Transform.GetWorldToLocalMatrixXM());
+		XMStoreFloat4x4(&m_InvView, m_Transform.GetLocalToWorldMatrixXM());
+		m_CachedTransformVersion = m_Transform.GetVersion();
+	}
+	if (m_IsProjDirty) {
+		XMMATRIX Proj = PerspectiveFovLH(m_FovY, m_Aspect, m_NearZ, m_FarZ, m_ReverseZ, m_InfiniteFarPlane);
+		XMStoreFloat4x4(&m_Proj, Proj);
+		XMStoreFloat4x4(&m_InvProj, XMMatrixInverse(nullptr, Proj));
+		XMStoreFloat4x4(&m_CullProj, XMMatrixPerspectiveFovLH(m_FovY, m_Aspect, m_NearZ, m_FarZ));
+		m_IsProjDirty = false;
+	}
+
+	XMMATRIX View = XMLoadFloat4x4(&m_View);
+	XMMATRIX ViewProj = View * XMLoadFloat4x4(&m_Proj);
+	XMStoreFloat4x4(&m_ViewProj, ViewProj);
+	XMStoreFloat4x4(&m_InvViewProj, XMLoadFloat4x4(&m_InvProj) * XMLoadFloat4x4(&m_InvView));
+	// 反向Z只交换近远平面的提取方式；无限远平面时仍按farZ剔除，改用标准投影提取
+	XMMATRIX CullProj = XMLoadFloat4x4(&m_CullProj);
+	m_FrustumPlanes = m_InfiniteFarPlane ? Culling::ExtractFrustumPlanes(View * CullProj) :
+		Culling::ExtractFrustumPlanes(ViewProj, m_ReverseZ);
+	BoundingFrustum::CreateFromMatrix(m_BoundingFrustum, CullProj);
+	m_BoundingFrustum.Transform(m_BoundingFrustum, XMLoadFloat4x4(&m_InvView));
+	++m_Version;
+}
+
 XMMATRIX Camera::GetViewXM() const {
-	return m_Transform.GetWorldToLocalMatrixXM();
+	UpdateMatrices();
+	return XMLoadFloat4x4(&m_View);
 }
 
 XMMATRIX Camera::GetProjXM() const {
-	return XMMatrixPerspectiveFovLH(m_FovY, m_Aspect, m_NearZ, m_FarZ);
+	UpdateMatrices();
+	return XMLoadFloat4x4(&m_Proj);
 }
 
 XMMATRIX Camera::GetViewProjXM() const{
-	return GetViewXM() * GetProjXM();
+	UpdateMatrices();
+	return XMLoadFloat4x4(&m_ViewProj);
+}
+
+XMMATRIX Camera::GetInvViewXM() const {
+	UpdateMatrices();
+	return XMLoadFloat4x4(&m_InvView);
+}
+
+XMMATRIX Camera::GetInvProjXM() const {
+	UpdateMatrices();
+	return XMLoadFloat4x4(&m_InvProj);
+}
+
+XMMATRIX Camera::GetInvViewProjXM() const {
+	UpdateMatrices();
+	return XMLoadFloat4x4(&m_InvViewProj);
+}
+
+uint32_t Camera::GetVersion() const {
+	UpdateMatrices();
+	return m_Version;
+}
+
+BoundingFrustum Camera::GetBoundingFrustum() const {
+	UpdateMatrices();
+	return m_BoundingFrustum;
+}
+
+const Culling::FrustumPlanes& Camera::GetFrustumPlanes() const {
+	UpdateMatrices();
+	return m_FrustumPlanes;
+}
+
+XMMATRIX Camera::GetViewRelativeXM() const {
+	// 以相机自身为原点时观察矩阵的平移为0
+	XMMATRIX View = GetViewXM();
+	View.r[3] = g_XMIdentityR3;
+	return View;
+}
+
+XMMATRIX Camera::GetViewProjRelativeXM() const {
+	return GetViewRelativeXM() * GetProjXM();
 }
 
 D3D11_VIEWPORT Camera::GetViewPort() const {
@@ -66,6 +158,41 @@ void Camera::SetFrustum(float fovY, float aspect, float nearZ, float farZ) {
 	m_Aspect = aspect;
 	m_NearZ = nearZ;
 	m_FarZ = farZ;
+	m_IsProjDirty = true;
+}
+
+float Camera::GetFovY() const {
+	return m_FovY;
+}
+
+float Camera::GetAspectRatio() const {
+	return m_Aspect;
+}
+
+float Camera::GetNearZ() const {
+	return m_NearZ;
+}
+
+float Camera::GetFarZ() const {
+	return m_FarZ;
+}
+
+void Camera::SetReverseZ(bool enable) {
+	m_ReverseZ = enable;
+	m_IsProjDirty = true;
+}
+
+bool Camera::IsReverseZ() const {
+	return m_ReverseZ;
+}
+
+void Camera::SetInfiniteFarPlane(bool enable) {
+	m_InfiniteFarPlane = enable;
+	m_IsProjDirty = true;
+}
+
+bool Camera::IsInfiniteFarPlane() const {
+	return m_InfiniteFarPlane;
 }
 
 void Camera::SetViewPort(const D3D11_VIEWPORT& viewPort) {
@@ -94,16 +221,30 @@ void FirstPersonCamera::SetPosition(const XMFLOAT3& pos) {
 	m_Transform.SetPosition(pos);
 }
 
+void FirstPersonCamera::SetPosition(const Double3& pos) {
+	m_Transform.SetPosition(pos);
+}
+
 void FirstPersonCamera::LookAt(const XMFLOAT3& pos, const XMFLOAT3& target, const XMFLOAT3& up) {
 	m_Transform.SetPosition(pos);
 	m_Transform.LookAt(target, up);
 }
 
+void FirstPersonCamera::LookAt(const Double3& pos, const Double3& target, const XMFLOAT3& up) {
+	m_Transform.SetPosition(pos);
+	m_Transform.LookTo(target.RelativeTo(pos), up);
+}
+
 void FirstPersonCamera::LookTo(const XMFLOAT3& pos, const XMFLOAT3& to, const XMFLOAT3& up) {
 	m_Transform.SetPosition(pos);
 	m_Transform.LookTo(to, up);
 }
 
+void FirstPersonCamera::LookTo(const Double3& pos, const XMFLOAT3& to, const XMFLOAT3& up) {
+	m_Transform.SetPosition(pos);
+	m_Transform.LookTo(to, up);
+}
+
 void FirstPersonCamera::Strafe(float d) {
 	m_Transform.Translate(m_Transform.GetRightAxis(), d);
 }
@@ -121,21 +262,19 @@ void FirstPersonCamera::MoveForward(float d) {
 }
 
 void FirstPersonCamera::Pitch(float rad) {
-	XMFLOAT3 rotation = m_Transform.GetRotation();
-
-	rotation.x += rad;
-	if (rotation.x > XM_PI * 7 / 18)
-		rotation.x = XM_PI * 7 / 18;
-	else if (rotation.x < -XM_PI * 7 / 18)
-		rotation.x = -XM_PI * 7 / 18;
+	// 相机没有翻滚，俯仰角可由前向量的y分量直接得到
+	float pitch = GetPitchFromForwardAxis(m_Transform.GetForwardAxis());
+	float newPitch = pitch + rad;
+	if (newPitch > XM_PI * 7 / 18)
+		newPitch = XM_PI * 7 / 18;
+	else if (newPitch < -XM_PI * 7 / 18)
+		newPitch = -XM_PI * 7 / 18;
 
-	m_Transform.SetRotation(rotation);
+	m_Transform.RotateAxis(m_Transform.GetRightAxis(), newPitch - pitch);
 }
 
 void FirstPersonCamera::RotateY(float rad) {
-	XMFLOAT3 rotation = m_Transform.GetRotation();
-	rotation.y = XMScalarModAngle(rotation.y + rad);
-	m_Transform.SetRotation(rotation);
+	m_Transform.RotateAxis(XMFLOAT3(0.0f, 1.0f, 0.0f), rad);
 }
 
 ThirdPersonCamera::~ThirdPersonCamera() {
@@ -143,6 +282,10 @@ ThirdPersonCamera::~ThirdPersonCamera() {
 }
 
 XMFLOAT3 ThirdPersonCamera::GetTargetPosition() const {
+	return m_Target.ToFloat3();
+}
+
+Double3 ThirdPersonCamera::GetTargetPositionDouble() const {
 	return m_Target;
 }
 
@@ -151,24 +294,20 @@ float ThirdPersonCamera::GetDistance() const {
 }
 
 void ThirdPersonCamera::RotateX(float rad) {
-	XMFLOAT3 rotation = m_Transform.GetRotation();
-
-	rotation.x += rad;
-	if (rotation.x < 0.0f)
-		rotation.x = 0.0f;
-	else if (rotation.x > XM_PI / 3)
-		rotation.x = XM_PI / 3;
-
-	m_Transform.SetRotation(rotation);
+	float pitch = GetPitchFromForwardAxis(m_Transform.GetForwardAxis());
+	float newPitch = pitch + rad;
+	if (newPitch < 0.0f)
+		newPitch = 0.0f;
+	else if (newPitch > XM_PI / 3)
+		newPitch = XM_PI / 3;
+
+	m_Transform.RotateAxis(m_Transform.GetRightAxis(), newPitch - pitch);
 	m_Transform.SetPosition(m_Target);
 	m_Transform.Translate(m_Transform.GetForwardAxis(), -m_Distance);
 }
 
 void ThirdPersonCamera::RotateY(float rad) {
-	XMFLOAT3 rotation = m_Transform.GetRotation();
-	rotation.y = XMScalarModAngle(rotation.y + rad);
-
-	m_Transform.SetRotation(rotation);
+	m_Transform.RotateAxis(XMFLOAT3(0.0f, 1.0f, 0.0f), rad);
 	m_Transform.SetPosition(m_Target);
 	m_Transform.Translate(m_Transform.GetForwardAxis(), -m_Distance);
 }
@@ -208,6 +347,10 @@ void ThirdPersonCamera::SetRotationY(float rad)
 }
 
 void ThirdPersonCamera::SetTarget(const XMFLOAT3& target) {
+	m_Target = Double3(target);
+}
+
+void ThirdPersonCamera::SetTarget(const Double3& target) {
 	m_Target = target;
 }
 
@@ -0,0 +1,151 @@
+#include "CascadedShadow.h"
+#include "Camera.h"
+#include "JobSystem.h"
+#include "LightHelper.h"
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+
+using namespace DirectX;
+
+void CascadedShadow::SetCascadeCount(uint32_t count)
+{
+	m_CascadeCount = std::min(std::max(count, 1u), MaxCascades);
+}
+
+void CascadedShadow::SetSplitLambda(float lambda)
+{
+	m_SplitLambda = std::min(std::max(lambda, 0.0f), 1.0f);
+}
+
+void CascadedShadow::SetShadowMapSize(uint32_t size)
+{
+	m_ShadowMapSize = std::max(size, 1u);
+}
+
+void CascadedShadow::SetShadowDistance(float distance)
+{
+	m_ShadowDistance = distance;
+}
+
+void CascadedShadow::SetCasterExtrusion(float distance)
+{
+	m_CasterExtrusion = std::max(distance, 0.0f);
+}
+
+uint32_t CascadedShadow::GetCascadeCount() const
+{
+	return m_CascadeCount;
+}
+
+float CascadedShadow::GetSplitLambda() const
+{
+	return m_SplitLambda;
+}
+
+uint32_t CascadedShadow::GetShadowMapSize() const
+{
+	return m_ShadowMapSize;
+}
+
+void CascadedShadow::Update(const Camera& camera, const DirectionalLight& light)
+{
+	Update(camera, XMLoadFloat3(&light.direction));
+}
+
+void XM_CALLCONV CascadedShadow::Update(const Camera& camera, FXMVECTOR lightDirection)
+{
+	float nearZ = camera.GetNearZ();
+	float farZ = m_ShadowDistance > 0.0f ? std::min(m_ShadowDistance, camera.GetFarZ()) : camera.GetFarZ();
+	assert(nearZ > 0.0f && farZ > nearZ);
+
+	// 深度z处切面的半对角线长度为z * k
+	float tanHalfFovY = tanf(0.5f * camera.GetFovY());
+	float aspect = camera.GetAspectRatio();
+	float kSq = tanHalfFovY * tanHalfFovY * (1.0f + aspect * aspect);
+	XMMATRIX InvView = camera.GetInvViewXM();
+
+	// 光源空间的朝向只与光照方向有关
+	XMVECTOR dir = XMVector3Normalize(lightDirection);
+	XMVECTOR up = fabsf(XMVectorGetY(dir)) > 0.99f ? g_XMIdentityR2 : g_XMIdentityR1;
+	XMMATRIX LightRotation = XMMatrixLookToLH(g_XMZero, dir, up);
+	XMMATRIX InvLightRotation = XMMatrixTranspose(LightRotation);
+
+	// 纹理空间：x、y从[-1, 1]映射到[0, 1]，y轴翻转
+	XMMATRIX ToTexture = XMMatrixSet(
+		0.5f, 0.0f, 0.0f, 0.0f,
+		0.0f, -0.5f, 0.0f, 0.0f,
+		0.0f, 0.0f, 1.0f, 0.0f,
+		0.5f, 0.5f, 0.0f, 1.0f);
+
+	float splitNear = nearZ;
+	for (uint32_t i = 0; i < m_CascadeCount; ++i) {
+		Cascade& cascade = m_Cascades[i];
+		float t = static_cast<float>(i + 1) / m_CascadeCount;
+		float logSplit = nearZ * powf(farZ / nearZ, t);
+		float uniformSplit = nearZ + (farZ - nearZ) * t;
+		float splitFar = i + 1 == m_CascadeCount ? farZ : m_SplitLambda * logSplit + (1.0f - m_SplitLambda) * uniformSplit;
+
+		// 球心在视线上且到近、远切面角点距离相等；切面很宽时球心落在远切面上
+		float centerZ = std::min(0.5f * (splitNear + splitFar) * (1.0f + kSq), splitFar);
+		float dz = splitFar - centerZ;
+		float radius = sqrtf(dz * dz + splitFar * splitFar * kSq);
+		// 半径向上取整到1/16，避免浮点误差使投影范围逐帧微小变化
+		radius = ceilf(radius * 16.0f) / 16.0f;
+
+		// 球心在光源空间的x、y按纹素大小对齐
+		float texelSize = 2.0f * radius / m_ShadowMapSize;
+		XMVECTOR center = XMVector3Transform(XMVectorSet(0.0f, 0.0f, centerZ, 1.0f), InvView);
+		XMFLOAT3 centerLS;
+		XMStoreFloat3(&centerLS, XMVector3TransformNormal(center, LightRotation));
+		centerLS.x = floorf(centerLS.x / texelSize) * texelSize;
+		centerLS.y = floorf(centerLS.y / texelSize) * texelSize;
+		XMStoreFloat3(&cascade.center, XMVector3TransformNormal(XMLoadFloat3(&centerLS), InvLightRotation));
+
+		// 光源观察空间中球占据z∈[extrusion, extrusion + 2r]，其前方留出extrusion给投射者
+		float depthRange = 2.0f * radius + m_CasterExtrusion;
+		XMMATRIX LightView = LightRotation * XMMatrixTranslation(-centerLS.x, -centerLS.y,
+			-centerLS.z + radius + m_CasterExtrusion);
+		XMMATRIX LightProj = XMMatrixOrthographicOffCenterLH(-radius, radius, -radius, radius, 0.0f, depthRange);
+		XMMATRIX LightViewProj = LightView * LightProj;
+
+		cascade.nearZ = splitNear;
+		cascade.farZ = splitFar;
+		cascade.radius = radius;
+		XMStoreFloat4x4(&cascade.lightView, LightView);
+		XMStoreFloat4x4(&cascade.lightProj, LightProj);
+		XMStoreFloat4x4(&cascade.lightViewProj, LightViewProj);
+		XMStoreFloat4x4(&cascade.shadowTransform, LightViewProj * ToTexture);
+		cascade.planes = Culling::ExtractFrustumPlanes(LightViewProj);
+		splitNear = splitFar;
+	}
+}
+
+const CascadedShadow::Cascade& CascadedShadow::GetCascade(uint32_t index) const
+{
+	assert(index < m_CascadeCount);
+	return m_Cascades[index];
+}
+
+XMFLOAT4 CascadedShadow::GetCascadeSplits() const
+{
+	float splits[MaxCascades];
+	for (uint32_t i = 0; i < MaxCascades; ++i)
+		splits[i] = m_Cascades[std::min(i, m_CascadeCount - 1)].farZ;
+	return XMFLOAT4(splits[0], splits[1], splits[2], splits[3]);
+}
+
+size_t CascadedShadow::CullCasters(uint32_t cascade, const Culling::BoundingBoxSoA& boxes, uint32_t* casterIndices) const
+{
+	return Culling::CullBoxes(GetCascade(cascade).planes, boxes, casterIndices);
+}
+
+void CascadedShadow::CullCasters(JobSystem& jobSystem, const Culling::BoundingBoxSoA& boxes, std::vector<uint32_t>* casterLists) const
+{
+	// 级联数很少，依次对每个级联做多线程剔除负载更均匀
+	for (uint32_t i = 0; i < m_CascadeCount; ++i) {
+		std::vector<uint32_t>& list = casterLists[i];
+		list.resize(boxes.Size());
+		list.resize(Culling::CullBoxes(jobSystem, m_Cascades[i].planes, boxes, list.data()));
+	}
+}
@@ -0,0 +1,228 @@
+#include "ConstantBufferRing.h"
+#include "d3dUtil.h"
+#include "DXTrace.h"
+#include <cstring>
+
+bool ConstantBufferRing::InitResource(ID3D11Device* device, ID3D11DeviceContext1* deviceContext1, UINT byteWidth)
+{
+	if (!device)
+		return false;
+
+	m_pDevice = device;
+	m_pDeviceContext1 = deviceContext1;
+	m_Offsetting = m_NoOverwrite = false;
+	if (deviceContext1) {
+		D3D11_FEATURE_DATA_D3D11_OPTIONS options;
+		ZeroMemory(&options, sizeof(options));
+		if (SUCCEEDED(device->CheckFeatureSupport(D3D11_FEATURE_D3D11_OPTIONS, &options, sizeof(options)))) {
+			m_Offsetting = options.ConstantBufferOffsetting != FALSE;
+			m_NoOverwrite = options.MapNoOverwriteOnDynamicConstantBuffer != FALSE;
+		}
+	}
+
+	for (auto& buffers : m_FallbackBuffers)
+		buffers.clear();
+	m_pBuffer.Reset();
+	m_ByteWidth = 0;
+	m_pOverflowBuffer.Reset();
+	m_OverflowByteWidth = 0;
+	m_LastFrameBytes = 0;
+	if (m_Offsetting)
+		HR(CreateRingBuffer((byteWidth + AlignmentBytes - 1) / AlignmentBytes * AlignmentBytes));
+	return true;
+}
+
+bool ConstantBufferRing::IsOffsettingSupported() const
+{
+	return m_Offsetting;
+}
+
+void ConstantBufferRing::Begin(ID3D11DeviceContext* deviceContext)
+{
+	++m_FrameIndex;
+	m_FrameBytes = 0;
+	m_MapCount = 0;
+	m_Spilled = false;
+	m_SpillStart = 0;
+	m_Spill.clear();
+	if (!m_Offsetting)
+		return;
+
+	// 上一帧溢出时先把环扩大到能容纳整帧，至少两倍
+	if (m_LastFrameBytes > m_ByteWidth) {
+		UINT byteWidth = m_ByteWidth * 2;
+		while (byteWidth < m_LastFrameBytes)
+			byteWidth *= 2;
+		HR(CreateRingBuffer(byteWidth));
+	}
+
+	// 以上一帧的用量估计本帧，剩余空间不够时回到起点，让驱动换一块新的内存
+	D3D11_MAP mapType = D3D11_MAP_WRITE_NO_OVERWRITE;
+	if (!m_NoOverwrite || m_RingHead + m_LastFrameBytes > m_ByteWidth) {
+		mapType = D3D11_MAP_WRITE_DISCARD;
+		m_RingHead = 0;
+	}
+	m_FrameStart = m_RingHead;
+
+	D3D11_MAPPED_SUBRESOURCE mappedData;
+	HR(deviceContext->Map(m_pBuffer.Get(), 0, mapType, 0, &mappedData));
+	m_pMapped = static_cast<uint8_t*>(mappedData.pData);
+	++m_MapCount;
+}
+
+ConstantBufferRing::Allocation ConstantBufferRing::Allocate(const void* data, UINT byteSize)
+{
+	Allocation allocation = { m_FrameBytes, (byteSize + AlignmentBytes - 1) / AlignmentBytes * AlignmentBytes };
+	if (m_Offsetting && !m_Spilled && m_FrameStart + m_FrameBytes + allocation.byteSize > m_ByteWidth) {
+		// 映射内存是写合并的，不能读回；已写入的部分留在环中，之后的分配改写到内存里
+		m_SpillStart = m_FrameBytes;
+		m_Spilled = true;
+	}
+
+	if (m_Offsetting && !m_Spilled) {
+		memcpy(m_pMapped + m_FrameStart + m_FrameBytes, data, byteSize);
+	}
+	else {
+		m_Spill.resize(m_FrameBytes - m_SpillStart + allocation.byteSize);
+		memcpy(&m_Spill[m_FrameBytes - m_SpillStart], data, byteSize);
+	}
+	m_FrameBytes += allocation.byteSize;
+	return allocation;
+}
+
+void ConstantBufferRing::End(ID3D11DeviceContext* deviceContext)
+{
+	if (!m_Offsetting)
+		return;
+
+	deviceContext->Unmap(m_pBuffer.Get(), 0);
+	m_pMapped = nullptr;
+
+	if (m_Spilled) {
+		// 溢出的部分整体上传到溢出缓冲区，绑定时按偏移区分两个缓冲区
+		UINT spillBytes = m_FrameBytes - m_SpillStart;
+		if (m_OverflowByteWidth < spillBytes) {
+			m_pOverflowBuffer.Reset();
+			HR(CreateDynamicBuffer(spillBytes, m_pOverflowBuffer.GetAddressOf()));
+			m_OverflowByteWidth = spillBytes;
+			D3D11SetDebugObjectName(m_pOverflowBuffer.Get(), "ConstantBufferRing.Overflow");
+		}
+		D3D11_MAPPED_SUBRESOURCE mappedData;
+		HR(deviceContext->Map(m_pOverflowBuffer.Get(), 0, D3D11_MAP_WRITE_DISCARD, 0, &mappedData));
+		memcpy(mappedData.pData, m_Spill.data(), spillBytes);
+		deviceContext->Unmap(m_pOverflowBuffer.Get(), 0);
+		++m_MapCount;
+	}
+
+	m_RingHead = m_FrameStart + (m_Spilled ? m_SpillStart : m_FrameBytes);
+	m_LastFrameBytes = m_FrameBytes;
+}
+
+void ConstantBufferRing::BindVS(DeviceContextStateCache& stateCache, ID3D11DeviceContext* deviceContext, UINT slot, const Allocation& allocation)
+{
+	if (m_Offsetting) {
+		UINT firstConstant = 0;
+		ID3D11Buffer* buffer = GetOffsetBinding(allocation, firstConstant);
+		stateCache.VSSetConstantBuffer1(m_pDeviceContext1.Get(), slot, buffer, firstConstant, allocation.byteSize / 16);
+	}
+	else {
+		ID3D11Buffer* buffer = UploadFallback(deviceContext, StageVS, slot, allocation);
+		stateCache.VSSetConstantBuffer(deviceContext, slot, buffer);
+	}
+}
+
+void ConstantBufferRing::BindGS(DeviceContextStateCache& stateCache, ID3D11DeviceContext* deviceContext, UINT slot, const Allocation& allocation)
+{
+	if (m_Offsetting) {
+		UINT firstConstant = 0;
+		ID3D11Buffer* buffer = GetOffsetBinding(allocation, firstConstant);
+		stateCache.GSSetConstantBuffer1(m_pDeviceContext1.Get(), slot, buffer, firstConstant, allocation.byteSize / 16);
+	}
+	else {
+		ID3D11Buffer* buffer = UploadFallback(deviceContext, StageGS, slot, allocation);
+		stateCache.GSSetConstantBuffer(deviceContext, slot, buffer);
+	}
+}
+
+void ConstantBufferRing::BindPS(DeviceContextStateCache& stateCache, ID3D11DeviceContext* deviceContext, UINT slot, const Allocation& allocation)
+{
+	if (m_Offsetting) {
+		UINT firstConstant = 0;
+		ID3D11Buffer* buffer = GetOffsetBinding(allocation, firstConstant);
+		stateCache.PSSetConstantBuffer1(m_pDeviceContext1.Get(), slot, buffer, firstConstant, allocation.byteSize / 16);
+	}
+	else {
+		ID3D11Buffer* buffer = UploadFallback(deviceContext, StagePS, slot, allocation);
+		stateCache.PSSetConstantBuffer(deviceContext, slot, buffer);
+	}
+}
+
+UINT ConstantBufferRing::GetMapCount() const
+{
+	return m_MapCount;
+}
+
+UINT ConstantBufferRing::GetFrameBytes() const
+{
+	return m_FrameBytes;
+}
+
+HRESULT ConstantBufferRing::CreateDynamicBuffer(UINT byteWidth, ID3D11Buffer** ppBuffer)
+{
+	D3D11_BUFFER_DESC cbd;
+	ZeroMemory(&cbd, sizeof(cbd));
+	cbd.Usage = D3D11_USAGE_DYNAMIC;
+	cbd.BindFlags = D3D11_BIND_CONSTANT_BUFFER;
+	cbd.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE;
+	cbd.ByteWidth = byteWidth;
+	return m_pDevice->CreateBuffer(&cbd, nullptr, ppBuffer);
+}
+
+HRESULT ConstantBufferRing::CreateRingBuffer(UINT byteWidth)
+{
+	m_pBuffer.Reset();
+	HRESULT hr = CreateDynamicBuffer(byteWidth, m_pBuffer.GetAddressOf());
+	if (FAILED(hr))
+		return hr;
+
+	m_ByteWidth = byteWidth;
+	// 新缓冲区第一次须以WRITE_DISCARD映射
+	m_RingHead = byteWidth;
+	D3D11SetDebugObjectName(m_pBuffer.Get(), "ConstantBufferRing");
+	return S_OK;
+}
+
+ID3D11Buffer* ConstantBufferRing::GetOffsetBinding(const Allocation& allocation, UINT& firstConstant) const
+{
+	if (m_Spilled && allocation.offset >= m_SpillStart) {
+		firstConstant = (allocation.offset - m_SpillStart) / 16;
+		return m_pOverflowBuffer.Get();
+	}
+	firstConstant = (m_FrameStart + allocation.offset) / 16;
+	return m_pBuffer.Get();
+}
+
+ID3D11Buffer* ConstantBufferRing::UploadFallback(ID3D11DeviceContext* deviceContext, Stage stage, UINT slot, const Allocation& allocation)
+{
+	std::vector<FallbackBuffer>& buffers = m_FallbackBuffers[stage];
+	if (buffers.size() <= slot)
+		buffers.resize(slot + 1);
+	FallbackBuffer& fallback = buffers[slot];
+	if (fallback.frame == m_FrameIndex && fallback.offset == allocation.offset)
+		return fallback.buffer.Get();
+
+	if (fallback.byteWidth < allocation.byteSize) {
+		fallback.buffer.Reset();
+		HR(CreateDynamicBuffer(allocation.byteSize, fallback.buffer.GetAddressOf()));
+		fallback.byteWidth = allocation.byteSize;
+	}
+
+	D3D11_MAPPED_SUBRESOURCE mappedData;
+	HR(deviceContext->Map(fallback.buffer.Get(), 0, D3D11_MAP_WRITE_DISCARD, 0, &mappedData));
+	memcpy(mappedData.pData, &m_Spill[allocation.offset], allocation.byteSize);
+	deviceContext->Unmap(fallback.buffer.Get(), 0);
+	++m_MapCount;
+	fallback.frame = m_FrameIndex;
+	fallback.offset = allocation.offset;
+	return fallback.buffer.Get();
+}
@@ -0,0 +1,275 @@
+#include "Culling.h"
+#include "JobSystem.h"
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+
+using namespace DirectX;
+
+namespace {
+	// 6个平面的各分量分别广播到4个通道
+	struct SplatPlanes {
+		XMVECTOR x[6], y[6], z[6], w[6];
+		XMVECTOR absX[6], absY[6], absZ[6];
+
+		explicit SplatPlanes(const Culling::FrustumPlanes& frustum) {
+			for (int p = 0; p < 6; ++p) {
+				XMVECTOR plane = XMLoadFloat4(&frustum.planes[p]);
+				x[p] = XMVectorSplatX(plane);
+				y[p] = XMVectorSplatY(plane);
+				z[p] = XMVectorSplatZ(plane);
+				w[p] = XMVectorSplatW(plane);
+				absX[p] = XMVectorAbs(x[p]);
+				absY[p] = XMVectorAbs(y[p]);
+				absZ[p] = XMVectorAbs(z[p]);
+			}
+		}
+	};
+
+	inline XMVECTOR LoadSoA4(const float* p) {
+		return XMLoadFloat4(reinterpret_cast<const XMFLOAT4*>(p));
+	}
+
+	// 按掩码写出4个下标，不可见的下标会被后续写入覆盖
+	inline size_t WriteVisible(XMVECTOR outsideMask, uint32_t base, uint32_t* out) {
+		uint32_t outside[4];
+		XMStoreInt4(outside, outsideMask);
+		size_t count = 0;
+		for (uint32_t k = 0; k < 4; ++k) {
+			out[count] = base + k;
+			count += outside[k] == 0;
+		}
+		return count;
+	}
+
+	// 中心到平面的有向距离小于-radius时完全在平面外侧
+	size_t CullSpheresRange(const SplatPlanes& planes, const Culling::BoundingSphereSoA& spheres,
+		uint32_t begin, uint32_t end, uint32_t* out) {
+		size_t count = 0;
+		uint32_t i = begin;
+		for (; i + 4 <= end; i += 4) {
+			XMVECTOR cx = LoadSoA4(&spheres.centerX[i]);
+			XMVECTOR cy = LoadSoA4(&spheres.centerY[i]);
+			XMVECTOR cz = LoadSoA4(&spheres.centerZ[i]);
+			XMVECTOR negR = XMVectorNegate(LoadSoA4(&spheres.radius[i]));
+			XMVECTOR outside = XMVectorFalseInt();
+			for (int p = 0; p < 6; ++p) {
+				XMVECTOR dist = XMVectorMultiplyAdd(cx, planes.x[p], planes.w[p]);
+				dist = XMVectorMultiplyAdd(cy, planes.y[p], dist);
+				dist = XMVectorMultiplyAdd(cz, planes.z[p], dist);
+				outside = XMVectorOrInt(outside, XMVectorLess(dist, negR));
+			}
+			count += WriteVisible(outside, i, out + count);
+		}
+		for (; i < end; ++i) {
+			bool visible = true;
+			for (int p = 0; p < 6 && visible; ++p) {
+				float dist = XMVectorGetX(planes.x[p]) * spheres.centerX[i] + XMVectorGetX(planes.y[p]) * spheres.centerY[i] +
+					XMVectorGetX(planes.z[p]) * spheres.centerZ[i] + XMVectorGetX(planes.w[p]);
+				visible = dist >= -spheres.radius[i];
+			}
+			if (visible)
+				out[count++] = i;
+		}
+		return count;
+	}
+
+	// AABB在平面法向量上的投影半径为|n|·extents
+	size_t CullBoxesRange(const SplatPlanes& planes, const Culling::BoundingBoxSoA& boxes,
+		uint32_t begin, uint32_t end, uint32_t* out) {
+		size_t count = 0;
+		uint32_t i = begin;
+		for (; i + 4 <= end; i += 4) {
+			XMVECTOR cx = LoadSoA4(&boxes.centerX[i]);
+			XMVECTOR cy = LoadSoA4(&boxes.centerY[i]);
+			XMVECTOR cz = LoadSoA4(&boxes.centerZ[i]);
+			XMVECTOR ex = LoadSoA4(&boxes.extentsX[i]);
+			XMVECTOR ey = LoadSoA4(&boxes.extentsY[i]);
+			XMVECTOR ez = LoadSoA4(&boxes.extentsZ[i]);
+			XMVECTOR outside = XMVectorFalseInt();
+			for (int p = 0; p < 6; ++p) {
+				XMVECTOR dist = XMVectorMultiplyAdd(cx, planes.x[p], planes.w[p]);
+				dist = XMVectorMultiplyAdd(cy, planes.y[p], dist);
+				dist = XMVectorMultiplyAdd(cz, planes.z[p], dist);
+				XMVECTOR r = XMVectorMultiply(ex, planes.absX[p]);
+				r = XMVectorMultiplyAdd(ey, planes.absY[p], r);
+				r = XMVectorMultiplyAdd(ez, planes.absZ[p], r);
+				outside = XMVectorOrInt(outside, XMVectorLess(XMVectorAdd(dist, r), g_XMZero));
+			}
+			count += WriteVisible(outside, i, out + count);
+		}
+		for (; i < end; ++i) {
+			bool visible = true;
+			for (int p = 0; p < 6 && visible; ++p) {
+				float dist = XMVectorGetX(planes.x[p]) * boxes.centerX[i] + XMVectorGetX(planes.y[p]) * boxes.centerY[i] +
+					XMVectorGetX(planes.z[p]) * boxes.centerZ[i] + XMVectorGetX(planes.w[p]);
+				float r = XMVectorGetX(planes.absX[p]) * boxes.extentsX[i] + XMVectorGetX(planes.absY[p]) * boxes.extentsY[i] +
+					XMVectorGetX(planes.absZ[p]) * boxes.extentsZ[i];
+				visible = dist + r >= 0.0f;
+			}
+			if (visible)
+				out[count++] = i;
+		}
+		return count;
+	}
+
+	// 每批结果先写到该批起始下标处，全部完成后再按顺序紧凑到一起
+	template<class Kernel>
+	size_t ParallelCull(JobSystem& jobSystem, uint32_t count, uint32_t grainSize, uint32_t* visibleIndices, Kernel&& kernel) {
+		grainSize = std::max(grainSize, 4u);
+		uint32_t batchCount = (count + grainSize - 1) / grainSize;
+		std::vector<uint32_t> batchVisible(batchCount);
+		jobSystem.ParallelFor(count, grainSize, [&](uint32_t begin, uint32_t end) {
+			for (uint32_t b = begin; b < end; b += grainSize) {
+				uint32_t e = std::min(b + grainSize, end);
+				batchVisible[b / grainSize] = (uint32_t)kernel(b, e, visibleIndices + b);
+			}
+		});
+
+		size_t visibleCount = batchVisible.empty() ? 0 : batchVisible[0];
+		for (uint32_t b = 1; b < batchCount; ++b) {
+			memmove(visibleIndices + visibleCount, visibleIndices + (size_t)b * grainSize, batchVisible[b] * sizeof(uint32_t));
+			visibleCount += batchVisible[b];
+		}
+		return visibleCount;
+	}
+}
+
+Culling::FrustumPlanes XM_CALLCONV Culling::ExtractFrustumPlanes(FXMMATRIX viewProj, bool reverseZ)
+{
+	// clip = v * M，第j列为M各行的第j个分量
+	XMMATRIX T = XMMatrixTranspose(viewProj);
+	XMVECTOR zGreaterZero = T.r[2];
+	XMVECTOR zLessW = XMVectorSubtract(T.r[3], T.r[2]);
+	XMVECTOR planes[6] = {
+		XMVectorAdd(T.r[3], T.r[0]),		// 左：x >= -w
+		XMVectorSubtract(T.r[3], T.r[0]),	// 右：x <= w
+		XMVectorAdd(T.r[3], T.r[1]),		// 下：y >= -w
+		XMVectorSubtract(T.r[3], T.r[1]),	// 上：y <= w
+		reverseZ ? zLessW : zGreaterZero,	// 近
+		reverseZ ? zGreaterZero : zLessW	// 远
+	};
+
+	FrustumPlanes frustum;
+	for (int p = 0; p < 6; ++p) {
+		if (XMVector3LessOrEqual(XMVector3LengthSq(planes[p]), XMVectorReplicate(1e-12f)))
+			frustum.planes[p] = XMFLOAT4(0.0f, 0.0f, 0.0f, 1.0f);
+		else
+			XMStoreFloat4(&frustum.planes[p], XMPlaneNormalize(planes[p]));
+	}
+	return frustum;
+}
+
+void Culling::BoundingSphereSoA::Reserve(size_t count)
+{
+	centerX.reserve(count);
+	centerY.reserve(count);
+	centerZ.reserve(count);
+	radius.reserve(count);
+}
+
+void Culling::BoundingSphereSoA::Resize(size_t count)
+{
+	centerX.resize(count);
+	centerY.resize(count);
+	centerZ.resize(count);
+	radius.resize(count);
+}
+
+size_t Culling::BoundingSphereSoA::Size() const
+{
+	return radius.size();
+}
+
+void Culling::BoundingSphereSoA::Set(size_t index, const XMFLOAT3& center, float r)
+{
+	centerX[index] = center.x;
+	centerY[index] = center.y;
+	centerZ[index] = center.z;
+	radius[index] = r;
+}
+
+void Culling::BoundingSphereSoA::Add(const XMFLOAT3& center, float r)
+{
+	centerX.push_back(center.x);
+	centerY.push_back(center.y);
+	centerZ.push_back(center.z);
+	radius.push_back(r);
+}
+
+void Culling::BoundingBoxSoA::Reserve(size_t count)
+{
+	centerX.reserve(count);
+	centerY.reserve(count);
+	centerZ.reserve(count);
+	extentsX.reserve(count);
+	extentsY.reserve(count);
+	extentsZ.reserve(count);
+}
+
+void Culling::BoundingBoxSoA::Resize(size_t count)
+{
+	centerX.resize(count);
+	centerY.resize(count);
+	centerZ.resize(count);
+	extentsX.resize(count);
+	extentsY.resize(count);
+	extentsZ.resize(count);
+}
+
+size_t Culling::BoundingBoxSoA::Size() const
+{
+	return centerX.size();
+}
+
+void Culling::BoundingBoxSoA::Set(size_t index, const XMFLOAT3& center, const XMFLOAT3& extents)
+{
+	centerX[index] = center.x;
+	centerY[index] = center.y;
+	centerZ[index] = center.z;
+	extentsX[index] = extents.x;
+	extentsY[index] = extents.y;
+	extentsZ[index] = extents.z;
+}
+
+void Culling::BoundingBoxSoA::Add(const XMFLOAT3& center, const XMFLOAT3& extents)
+{
+	centerX.push_back(center.x);
+	centerY.push_back(center.y);
+	centerZ.push_back(center.z);
+	extentsX.push_back(extents.x);
+	extentsY.push_back(extents.y);
+	extentsZ.push_back(extents.z);
+}
+
+size_t Culling::CullSpheres(const FrustumPlanes& frustum, const BoundingSphereSoA& spheres, uint32_t* visibleIndices)
+{
+	assert(spheres.Size() <= UINT32_MAX);
+	SplatPlanes planes(frustum);
+	return CullSpheresRange(planes, spheres, 0, (uint32_t)spheres.Size(), visibleIndices);
+}
+
+size_t Culling::CullBoxes(const FrustumPlanes& frustum, const BoundingBoxSoA& boxes, uint32_t* visibleIndices)
+{
+	assert(boxes.Size() <= UINT32_MAX);
+	SplatPlanes planes(frustum);
+	return CullBoxesRange(planes, boxes, 0, (uint32_t)boxes.Size(), visibleIndices);
+}
+
+size_t Culling::CullSpheres(JobSystem& jobSystem, const FrustumPlanes& frustum, const BoundingSphereSoA& spheres,
+	uint32_t* visibleIndices, uint32_t grainSize)
+{
+	assert(spheres.Size() <= UINT32_MAX);
+	SplatPlanes planes(frustum);
+	return ParallelCull(jobSystem, (uint32_t)spheres.Size(), grainSize, visibleIndices,
+		[&](uint32_t begin, uint32_t end, uint32_t* out) { return CullSpheresRange(planes, spheres, begin, end, out); });
+}
+
+size_t Culling::CullBoxes(JobSystem& jobSystem, const FrustumPlanes& frustum, const BoundingBoxSoA& boxes,
+	uint32_t* visibleIndices, uint32_t grainSize)
+{
+	assert(boxes.Size() <= UINT32_MAX);
+	SplatPlanes planes(frustum);
+	return ParallelCull(jobSystem, (uint32_t)boxes.Size(), grainSize, visibleIndices,
+		[&](uint32_t begin, uint32_t end, uint32_t* out) { return CullBoxesRange(planes, boxes, begin, end, out); });
+}
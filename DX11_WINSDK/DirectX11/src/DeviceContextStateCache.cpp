@@ -0,0 +1,126 @@
+#include "DeviceContextStateCache.h"
+
+DeviceContextStateCache::DeviceContextStateCache() : m_pDeviceContext(), m_State(), m_Stats()
+{
+}
+
+void DeviceContextStateCache::Invalidate()
+{
+	m_State = State();
+}
+
+void DeviceContextStateCache::IASetPrimitiveTopology(ID3D11DeviceContext* deviceContext, D3D11_PRIMITIVE_TOPOLOGY topology)
+{
+	if (!Filter(deviceContext, m_State.topology, topology))
+		deviceContext->IASetPrimitiveTopology(topology);
+}
+
+void DeviceContextStateCache::IASetInputLayout(ID3D11DeviceContext* deviceContext, ID3D11InputLayout* inputLayout)
+{
+	if (!Filter(deviceContext, m_State.inputLayout, inputLayout))
+		deviceContext->IASetInputLayout(inputLayout);
+}
+
+void DeviceContextStateCache::VSSetShader(ID3D11DeviceContext* deviceContext, ID3D11VertexShader* shader)
+{
+	if (!Filter(deviceContext, m_State.vertexShader, shader))
+		deviceContext->VSSetShader(shader, nullptr, 0);
+}
+
+void DeviceContextStateCache::GSSetShader(ID3D11DeviceContext* deviceContext, ID3D11GeometryShader* shader)
+{
+	if (!Filter(deviceContext, m_State.geometryShader, shader))
+		deviceContext->GSSetShader(shader, nullptr, 0);
+}
+
+void DeviceContextStateCache::PSSetShader(ID3D11DeviceContext* deviceContext, ID3D11PixelShader* shader)
+{
+	if (!Filter(deviceContext, m_State.pixelShader, shader))
+		deviceContext->PSSetShader(shader, nullptr, 0);
+}
+
+void DeviceContextStateCache::RSSetState(ID3D11DeviceContext* deviceContext, ID3D11RasterizerState* rasterizerState)
+{
+	if (!Filter(deviceContext, m_State.rasterizerState, rasterizerState))
+		deviceContext->RSSetState(rasterizerState);
+}
+
+void DeviceContextStateCache::VSSetConstantBuffer(ID3D11DeviceContext* deviceContext, UINT slot, ID3D11Buffer* buffer)
+{
+	if (!FilterConstantBuffer(deviceContext, StageVS, slot, { buffer, 0, 0 }))
+		deviceContext->VSSetConstantBuffers(slot, 1, &buffer);
+}
+
+void DeviceContextStateCache::GSSetConstantBuffer(ID3D11DeviceContext* deviceContext, UINT slot, ID3D11Buffer* buffer)
+{
+	if (!FilterConstantBuffer(deviceContext, StageGS, slot, { buffer, 0, 0 }))
+		deviceContext->GSSetConstantBuffers(slot, 1, &buffer);
+}
+
+void DeviceContextStateCache::PSSetConstantBuffer(ID3D11DeviceContext* deviceContext, UINT slot, ID3D11Buffer* buffer)
+{
+	if (!FilterConstantBuffer(deviceContext, StagePS, slot, { buffer, 0, 0 }))
+		deviceContext->PSSetConstantBuffers(slot, 1, &buffer);
+}
+
+void DeviceContextStateCache::VSSetConstantBuffer1(ID3D11DeviceContext1* deviceContext1, UINT slot, ID3D11Buffer* buffer, UINT firstConstant, UINT numConstants)
+{
+	if (!FilterConstantBuffer(deviceContext1, StageVS, slot, { buffer, firstConstant, numConstants }))
+		deviceContext1->VSSetConstantBuffers1(slot, 1, &buffer, &firstConstant, &numConstants);
+}
+
+void DeviceContextStateCache::GSSetConstantBuffer1(ID3D11DeviceContext1* deviceContext1, UINT slot, ID3D11Buffer* buffer, UINT firstConstant, UINT numConstants)
+{
+	if (!FilterConstantBuffer(deviceContext1, StageGS, slot, { buffer, firstConstant, numConstants }))
+		deviceContext1->GSSetConstantBuffers1(slot, 1, &buffer, &firstConstant, &numConstants);
+}
+
+void DeviceContextStateCache::PSSetConstantBuffer1(ID3D11DeviceContext1* deviceContext1, UINT slot, ID3D11Buffer* buffer, UINT firstConstant, UINT numConstants)
+{
+	if (!FilterConstantBuffer(deviceContext1, StagePS, slot, { buffer, firstConstant, numConstants }))
+		deviceContext1->PSSetConstantBuffers1(slot, 1, &buffer, &firstConstant, &numConstants);
+}
+
+void DeviceContextStateCache::PSSetShaderResource(ID3D11DeviceContext* deviceContext, UINT slot, ID3D11ShaderResourceView* shaderResource)
+{
+	if (slot >= ShaderResourceSlotCount) {
+		++m_Stats.issuedCalls;
+		deviceContext->PSSetShaderResources(slot, 1, &shaderResource);
+	}
+	else if (!Filter(deviceContext, m_State.psShaderResources[slot], shaderResource)) {
+		deviceContext->PSSetShaderResources(slot, 1, &shaderResource);
+	}
+}
+
+const DeviceContextStateCache::Stats& DeviceContextStateCache::GetStats() const
+{
+	return m_Stats;
+}
+
+void DeviceContextStateCache::ResetStats()
+{
+	m_Stats = Stats();
+}
+
+template<class T>
+bool DeviceContextStateCache::Filter(ID3D11DeviceContext* deviceContext, CachedValue<T>& cached, const T& value)
+{
+	// 绑定的对象由上下文持有引用，记录的指针在解绑之前不会被别的对象重用
+	if (deviceContext != m_pDeviceContext) {
+		m_State = State();
+		m_pDeviceContext = deviceContext;
+	}
+	if (cached.valid && cached.value == value) {
+		++m_Stats.filteredCalls;
+		return true;
+	}
+	cached.value = value;
+	cached.valid = true;
+	++m_Stats.issuedCalls;
+	return false;
+}
+
+bool DeviceContextStateCache::FilterConstantBuffer(ID3D11DeviceContext* deviceContext, Stage stage, UINT slot, const ConstantBufferBinding& binding)
+{
+	return Filter(deviceContext, m_State.constantBuffers[stage][slot], binding);
+}
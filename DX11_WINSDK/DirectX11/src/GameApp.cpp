@@ -1,13 +1,16 @@
 #include "GameApp.h"
 #include "d3dUtil.h"
+#include "EffectHelper.h"
 #include "DXTrace.h"
+#include "MathHelper.h"
 
 using namespace DirectX;
 
 
 
 
-GameApp::GameApp(HINSTANCE hInstance) : D3DApp(hInstance), m_ShowMode(Mode::SplitedTriangle), m_VertexCount() {
+GameApp::GameApp(HINSTANCE hInstance) : D3DApp(hInstance), m_ShowMode(Mode::SplitedTriangle), m_VertexCount(),
+	m_Phi(), m_Theta(), m_PrevPhi(), m_PrevTheta(), m_ReverseZ(true) {
 
 }
 
@@ -44,6 +47,8 @@ void GameApp::OnResize() {
 	m_pd2dRenderTarget.Reset();
 
 	D3DApp::OnResize();
+	// D3DApp::OnResize直接修改上下文，不再假定之前记录的绑定有效
+	m_BasicEffect.GetStateCache().Invalidate();
 
 	ComPtr<IDXGISurface> surface;
 	HR(m_pSwapChain->GetBuffer(0, __uuidof(IDXGISurface), reinterpret_cast<void**>(surface.GetAddressOf())));
@@ -72,10 +77,10 @@ void GameApp::OnResize() {
 		assert(m_pd2dRenderTarget);
 	}
 
-	m_BasicEffect.SetProjMatrix(XMMatrixPerspectiveFovLH(XM_PI / 3, AspectRatio(), 1.0f, 1000.0f));
+	m_BasicEffect.SetProjMatrix(PerspectiveFovLH(XM_PI / 3, AspectRatio(), 1.0f, 1000.0f, m_ReverseZ, true));
 }
 
-void GameApp::UpdateScene(float dt) {
+void GameApp::ProcessInput(float dt) {
 	Mouse::State mouseState = m_pMouse->GetState();
 	Mouse::State lastMouseState = m_MouseTracker.GetLastState();
 	m_MouseTracker.Update(mouseState);
@@ -83,16 +88,6 @@ void GameApp::UpdateScene(float dt) {
 	Keyboard::State keyState = m_pKeyboard->GetState();
 	m_KeyboardTracker.Update(keyState);
 
-
-	if (m_ShowMode == Mode::SplitedTriangle) {
-		m_BasicEffect.SetWorldMatrix(XMMatrixIdentity());
-	}
-	else {
-		static float phi = 0.0f, theta = 0.0f;
-		phi += 0.2f * dt, theta += 0.3f * dt;
-		m_BasicEffect.SetWorldMatrix(XMMatrixRotationX(phi) * XMMatrixRotationY(theta));
-	}
-
 	if (m_KeyboardTracker.IsKeyPressed(Keyboard::D1)) {
 		m_ShowMode = Mode::SplitedTriangle;
 		ResetTriangle();
@@ -120,12 +115,36 @@ void GameApp::UpdateScene(float dt) {
 	}
 }
 
+void GameApp::SaveSceneState() {
+	m_PrevPhi = m_Phi, m_PrevTheta = m_Theta;
+}
+
+void GameApp::UpdateScene(float dt) {
+	if (m_ShowMode != Mode::SplitedTriangle) {
+		m_Phi += 0.2f * dt, m_Theta += 0.3f * dt;
+	}
+}
+
 void GameApp::DrawScene() {
 	assert(m_pd3dImmediateContext);
 	assert(m_pSwapChain);
 
+	CBufferBase::ResetUploadStats();
+	DeviceContextStateCache& stateCache = m_BasicEffect.GetStateCache();
+	stateCache.ResetStats();
 	m_pd3dImmediateContext->ClearRenderTargetView(m_pRenderTargetView.Get(), reinterpret_cast<const float*>(&Colors::Black));
-	m_pd3dImmediateContext->ClearDepthStencilView(m_pDepthStencilView.Get(), D3D11_CLEAR_DEPTH | D3D11_CLEAR_STENCIL, 1.0f, 0);
+	m_pd3dImmediateContext->ClearDepthStencilView(m_pDepthStencilView.Get(), D3D11_CLEAR_DEPTH | D3D11_CLEAR_STENCIL,
+		RenderStates::GetDepthClearValue(m_ReverseZ), 0);
+
+	if (m_ShowMode == Mode::SplitedTriangle) {
+		m_BasicEffect.SetWorldMatrix(XMMatrixIdentity());
+	}
+	else {
+		float alpha = InterpolationAlpha();
+		float phi = m_PrevPhi + (m_Phi - m_PrevPhi) * alpha;
+		float theta = m_PrevTheta + (m_Theta - m_PrevTheta) * alpha;
+		m_BasicEffect.SetWorldMatrix(XMMatrixRotationX(phi) * XMMatrixRotationY(theta));
+	}
 
 	m_BasicEffect.Apply(m_pd3dImmediateContext.Get());
 	m_pd3dImmediateContext->Draw(m_VertexCount, 0);
@@ -148,6 +167,12 @@ void GameApp::DrawScene() {
 			text += L"圆线构造柱面(Q-显示圆线的法向量)";
 		else
 			text += L"圆线构造柱面(Q-隐藏圆线的法向量)";
+		const CBufferBase::UploadStats& uploadStats = CBufferBase::GetUploadStats();
+		text += L"\n常量缓冲区上传: " + std::to_wstring(uploadStats.uploadCount) + L"次 " +
+			std::to_wstring(uploadStats.uploadBytes) + L"字节 跳过" + std::to_wstring(uploadStats.skipCount) + L"次";
+		const DeviceContextStateCache::Stats& stateStats = stateCache.GetStats();
+		text += L"\n状态设置: 发出" + std::to_wstring(stateStats.issuedCalls) + L"次 过滤" +
+			std::to_wstring(stateStats.filteredCalls) + L"次";
 		m_pd2dRenderTarget->DrawTextW(text.c_str(), (UINT32)text.length(), m_pTextFormat.Get(),
 			D2D1_RECT_F{ 0.0f, 0.0f, 600.0f, 200.0f }, m_pColorBrush.Get());
 		HR(m_pd2dRenderTarget->EndDraw());
@@ -181,7 +206,7 @@ bool GameApp::InitResource() {
 		XMVectorSet(0.0f, 0.0f, -5.0f, 1.0f),
 		XMVectorZero(),
 		XMVectorSet(0.0f, 1.0f, 0.0f, 0.0f)));
-	m_BasicEffect.SetProjMatrix(XMMatrixPerspectiveFovLH(XM_PI / 3, AspectRatio(), 1.0f, 1000.0f));
+	m_BasicEffect.SetProjMatrix(PerspectiveFovLH(XM_PI / 3, AspectRatio(), 1.0f, 1000.0f, m_ReverseZ, true));
 	// 圆柱高度
 	m_BasicEffect.SetCylinderHeight(2.0f);
 
@@ -190,6 +215,7 @@ bool GameApp::InitResource() {
 	UINT offset = 0;							// 起始偏移量
 	m_pd3dImmediateContext->IASetVertexBuffers(0, 1, m_pVertexBuffer.GetAddressOf(), &stride, &offset);
 	// 设置默认渲染状态
+	m_pd3dImmediateContext->OMSetDepthStencilState(RenderStates::GetDepthStencilState(m_ReverseZ), 0);
 	m_BasicEffect.SetRenderSplitedTriangle(m_pd3dImmediateContext.Get());
 
 	return true;
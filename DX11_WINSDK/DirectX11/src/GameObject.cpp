@@ -1,8 +1,11 @@
 #include "GameObject.h"
 #include "d3dUtil.h"
+#include "LooseOctree.h"
+#include <cassert>
 using namespace DirectX;
 
-GameObject::GameObject() : m_IndexCount(), m_Material(), m_VertexStride() {
+GameObject::GameObject() : m_Material(), m_ConstantAllocation(),
+	m_SpatialHandle(LooseOctree::InvalidHandle), m_SpatialVersion(), m_SpatialDirty() {
 
 }
 
@@ -14,33 +17,139 @@ const Transform& GameObject::GetTransform() const {
 	return m_Transfrom;
 }
 
+void GameObject::SavePreviousTransform() {
+	m_PrevTransform = m_Transfrom;
+}
+
+const Transform& GameObject::GetPreviousTransform() const {
+	return m_PrevTransform;
+}
+
+Transform GameObject::GetInterpolatedTransform(float alpha) const {
+	return Transform::Interpolate(m_PrevTransform, m_Transfrom, alpha);
+}
+
+void GameObject::SetMesh(const MeshHandle& mesh) {
+	m_Mesh = mesh;
+	if (m_Mesh)
+		SetLocalBoundingBox(m_Mesh->localBounds);
+}
+
+const MeshHandle& GameObject::GetMesh() const {
+	return m_Mesh;
+}
+
 void GameObject::SetTexture(ID3D11ShaderResourceView* texture) {
 	m_pTexture = texture;
 }
 
+ID3D11ShaderResourceView* GameObject::GetTexture() const {
+	return m_pTexture.Get();
+}
+
 void GameObject::SetMaterial(const Material& material) {
 	m_Material = material;
 }
 
-void GameObject::Draw(ID3D11DeviceContext* deviceContext, BasicEffect& effect) {
-	UINT strides = m_VertexStride;
+const Material& GameObject::GetMaterial() const {
+	return m_Material;
+}
+
+void GameObject::SetLocalBoundingBox(const BoundingBox& box) {
+	m_LocalBoundingBox = box;
+	m_SpatialDirty = true;
+}
+
+const BoundingBox& GameObject::GetLocalBoundingBox() const {
+	return m_LocalBoundingBox;
+}
+
+BoundingBox GameObject::GetBoundingBox() const {
+	BoundingBox box;
+	m_LocalBoundingBox.Transform(box, m_Transfrom.GetLocalToWorldMatrixXM());
+	return box;
+}
+
+BoundingOrientedBox GameObject::GetOrientedBoundingBox() const {
+	BoundingOrientedBox box;
+	BoundingOrientedBox::CreateFromBoundingBox(box, m_LocalBoundingBox);
+	box.Transform(box, m_Transfrom.GetLocalToWorldMatrixXM());
+	return box;
+}
+
+void GameObject::AddToSpatialIndex(LooseOctree& octree, uint32_t userData) {
+	assert(m_SpatialHandle == LooseOctree::InvalidHandle);
+	BoundingBox box = GetBoundingBox();
+	m_SpatialHandle = octree.Insert(box.Center, box.Extents, userData);
+	m_SpatialVersion = m_Transfrom.GetVersion();
+	m_SpatialDirty = false;
+}
+
+void GameObject::RemoveFromSpatialIndex(LooseOctree& octree) {
+	if (m_SpatialHandle == LooseOctree::InvalidHandle)
+		return;
+	octree.Remove(m_SpatialHandle);
+	m_SpatialHandle = LooseOctree::InvalidHandle;
+}
+
+void GameObject::UpdateSpatialIndex(LooseOctree& octree) {
+	if (m_SpatialHandle == LooseOctree::InvalidHandle)
+		return;
+	uint32_t version = m_Transfrom.GetVersion();
+	if (version == m_SpatialVersion && !m_SpatialDirty)
+		return;
+	BoundingBox box = GetBoundingBox();
+	octree.Update(m_SpatialHandle, box.Center, box.Extents);
+	m_SpatialVersion = version;
+	m_SpatialDirty = false;
+}
+
+void GameObject::Draw(ID3D11DeviceContext* deviceContext, BasicEffect& effect, const Double3& origin) {
+	DrawWithWorld(deviceContext, effect, m_Transfrom.GetLocalToWorldMatrixXM(origin));
+}
+
+void GameObject::Draw(ID3D11DeviceContext* deviceContext, BasicEffect& effect, const Double3& origin, float alpha) {
+	DrawWithWorld(deviceContext, effect, GetInterpolatedTransform(alpha).GetLocalToWorldMatrixXM(origin));
+}
+
+void GameObject::WriteConstants(BasicEffect& effect, ConstantBufferRing& ring, const Double3& origin) {
+	m_ConstantAllocation = effect.WriteObjectConstants(ring, m_Transfrom.GetLocalToWorldMatrixXM(origin), m_Material);
+}
+
+void GameObject::Draw(ID3D11DeviceContext* deviceContext, BasicEffect& effect, ConstantBufferRing& ring) {
+	const MeshResource* mesh = BindMesh(deviceContext);
+	if (mesh == nullptr)
+		return;
+
+	effect.SetObjectConstants(&ring, m_ConstantAllocation);
+	effect.SetTexture(m_pTexture.Get());
+	effect.Apply(deviceContext);
+	effect.SetObjectConstants(nullptr, ConstantBufferRing::Allocation());
+
+	deviceContext->DrawIndexed(mesh->indexCount, 0, 0);
+}
+
+const MeshResource* GameObject::BindMesh(ID3D11DeviceContext* deviceContext) const {
+	const MeshResource* mesh = m_Mesh.Get();
+	if (mesh == nullptr)
+		return nullptr;
+
+	UINT strides = mesh->vertexStride;
 	UINT offset = 0;
-	deviceContext->IASetVertexBuffers(0, 1, m_pVertexBuffer.GetAddressOf(), &strides, &offset);
-	deviceContext->IASetIndexBuffer(m_pIndexBuffer.Get(), DXGI_FORMAT_R32_UINT, 0);
+	deviceContext->IASetVertexBuffers(0, 1, mesh->vertexBuffer.GetAddressOf(), &strides, &offset);
+	deviceContext->IASetIndexBuffer(mesh->indexBuffer.Get(), mesh->indexFormat, 0);
+	return mesh;
+}
 
-	effect.SetWorldMatrix(m_Transfrom.GetLocalToWorldMatrixXM());
+void XM_CALLCONV GameObject::DrawWithWorld(ID3D11DeviceContext* deviceContext, BasicEffect& effect, FXMMATRIX world) {
+	const MeshResource* mesh = BindMesh(deviceContext);
+	if (mesh == nullptr)
+		return;
+
+	effect.SetWorldMatrix(world);
 	effect.SetTexture(m_pTexture.Get());
 	effect.SetMaterial(m_Material);
 	effect.Apply(deviceContext);
 
-	deviceContext->DrawIndexed(m_IndexCount, 0, 0);
+	deviceContext->DrawIndexed(mesh->indexCount, 0, 0);
 }
-
-void GameObject::SetDebugObjectName(const std::string& name) {
-#if (defined(DEBUG) || defined(_DEBUG) && (GRAPHICS_DEBUGGER_OBJECT_NAME))
-	D3D11SetDebugObjectName(m_pVertexBuffer.Get(), name + ".VertexBuffer");
-	D3D11SetDebugObjectName(m_pIndexBuffer.Get(), name + ".IndexBuffer");
-#else
-	UNREFERENCED_PARAMETER(name);
-#endif
-}
\ No newline at end of file
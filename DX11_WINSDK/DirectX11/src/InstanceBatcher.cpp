@@ -0,0 +1,94 @@
+#include "InstanceBatcher.h"
+#include "MathHelper.h"
+#include <cstring>
+#include <functional>
+using namespace DirectX;
+
+void InstanceBatcher::Clear() {
+	m_Items.clear();
+	m_Materials.clear();
+	m_Groups.clear();
+	m_GroupMap.clear();
+	m_LastMaterial = 0;
+	m_LastGroup = 0;
+	m_Batches.clear();
+	m_InstanceData.clear();
+}
+
+void InstanceBatcher::Reserve(size_t count) {
+	m_Items.reserve(count);
+	m_InstanceData.reserve(count);
+}
+
+void XM_CALLCONV InstanceBatcher::Add(const MeshResource* mesh, ID3D11ShaderResourceView* texture, const Material& material,
+	FXMMATRIX world) {
+	Item item;
+	XMStoreFloat4x4(&item.world, world);
+	item.group = FindGroup({ mesh, texture, FindMaterial(material) });
+	m_Items.push_back(item);
+}
+
+void InstanceBatcher::Build() {
+	// 计数排序：组数远小于物体数，线性时间完成分组
+	uint32_t groupCount = static_cast<uint32_t>(m_Groups.size());
+	m_GroupOffsets.assign(groupCount, 0);
+	for (const Item& item : m_Items)
+		++m_GroupOffsets[item.group];
+
+	m_Batches.resize(groupCount);
+	uint32_t start = 0;
+	for (uint32_t i = 0; i < groupCount; ++i) {
+		const GroupKey& key = m_Groups[i];
+		m_Batches[i] = { key.mesh, key.texture, m_Materials[key.materialIndex], start, m_GroupOffsets[i] };
+		m_GroupOffsets[i] = start;
+		start += m_Batches[i].instanceCount;
+	}
+
+	m_InstanceData.resize(m_Items.size());
+	for (const Item& item : m_Items) {
+		InstancedData& data = m_InstanceData[m_GroupOffsets[item.group]++];
+		XMMATRIX W = XMLoadFloat4x4(&item.world);
+		XMStoreFloat4x4(&data.world, XMMatrixTranspose(W));
+		XMStoreFloat4x4(&data.worldInvTranspose, XMMatrixTranspose(InverseTranspose(W)));
+	}
+}
+
+size_t InstanceBatcher::GetItemCount() const {
+	return m_Items.size();
+}
+
+const std::vector<InstanceBatcher::Batch>& InstanceBatcher::GetBatches() const {
+	return m_Batches;
+}
+
+const std::vector<InstancedData>& InstanceBatcher::GetInstanceData() const {
+	return m_InstanceData;
+}
+
+size_t InstanceBatcher::GroupKeyHash::operator()(const GroupKey& key) const {
+	size_t h = std::hash<const void*>()(key.mesh);
+	h ^= std::hash<const void*>()(key.texture) + 0x9e3779b9 + (h << 6) + (h >> 2);
+	h ^= std::hash<uint32_t>()(key.materialIndex) + 0x9e3779b9 + (h << 6) + (h >> 2);
+	return h;
+}
+
+uint32_t InstanceBatcher::FindMaterial(const Material& material) {
+	// 材质按字节比较，一帧内不同的材质通常只有几种
+	if (!m_Materials.empty() && memcmp(&m_Materials[m_LastMaterial], &material, sizeof(Material)) == 0)
+		return m_LastMaterial;
+	for (uint32_t i = 0; i < m_Materials.size(); ++i) {
+		if (memcmp(&m_Materials[i], &material, sizeof(Material)) == 0)
+			return m_LastMaterial = i;
+	}
+	m_Materials.push_back(material);
+	return m_LastMaterial = static_cast<uint32_t>(m_Materials.size() - 1);
+}
+
+uint32_t InstanceBatcher::FindGroup(const GroupKey& key) {
+	if (!m_Groups.empty() && m_Groups[m_LastGroup] == key)
+		return m_LastGroup;
+	auto it = m_GroupMap.emplace(key, static_cast<uint32_t>(m_Groups.size()));
+	if (it.second)
+		m_Groups.push_back(key);
+	return m_LastGroup = it.first->second;
+}
@@ -0,0 +1,95 @@
+#include "InstancedRenderer.h"
+#include "GameObject.h"
+#include "d3dUtil.h"
+#include "DXTrace.h"
+using namespace DirectX;
+
+bool InstancedRenderer::InitResource(ID3D11Device* device, UINT initialCapacity) {
+	if (!device)
+		return false;
+	m_pDevice = device;
+	m_pInstanceBuffer.Reset();
+	m_Capacity = 0;
+	ReserveInstanceBuffer(initialCapacity > 0 ? initialCapacity : 1);
+	return true;
+}
+
+void InstancedRenderer::Begin() {
+	m_Batcher.Clear();
+}
+
+void InstancedRenderer::Submit(const GameObject& object, const Double3& origin) {
+	Submit(object.GetMesh(), object.GetTexture(), object.GetMaterial(), object.GetTransform().GetLocalToWorldMatrixXM(origin));
+}
+
+void XM_CALLCONV InstancedRenderer::Submit(const MeshHandle& mesh, ID3D11ShaderResourceView* texture, const Material& material,
+	FXMMATRIX world) {
+	if (mesh)
+		m_Batcher.Add(mesh.Get(), texture, material, world);
+}
+
+void InstancedRenderer::End(ID3D11DeviceContext* deviceContext, BasicEffect& effect) {
+	m_DrawCallCount = 0;
+	m_InstanceCount = 0;
+	if (m_Batcher.GetItemCount() == 0)
+		return;
+
+	m_Batcher.Build();
+	const std::vector<InstancedData>& instanceData = m_Batcher.GetInstanceData();
+	UINT instanceCount = static_cast<UINT>(instanceData.size());
+	ReserveInstanceBuffer(instanceCount);
+
+	// 所有实例一次写入
+	D3D11_MAPPED_SUBRESOURCE mappedData;
+	HR(deviceContext->Map(m_pInstanceBuffer.Get(), 0, D3D11_MAP_WRITE_DISCARD, 0, &mappedData));
+	memcpy_s(mappedData.pData, sizeof(InstancedData) * m_Capacity, instanceData.data(), sizeof(InstancedData) * instanceCount);
+	deviceContext->Unmap(m_pInstanceBuffer.Get(), 0);
+
+	effect.SetRenderInstanced(deviceContext);
+	for (const InstanceBatcher::Batch& batch : m_Batcher.GetBatches()) {
+		const MeshResource* mesh = batch.mesh;
+		ID3D11Buffer* buffers[2] = { mesh->vertexBuffer.Get(), m_pInstanceBuffer.Get() };
+		UINT strides[2] = { mesh->vertexStride, sizeof(InstancedData) };
+		UINT offsets[2] = { 0, 0 };
+		deviceContext->IASetVertexBuffers(0, 2, buffers, strides, offsets);
+		deviceContext->IASetIndexBuffer(mesh->indexBuffer.Get(), mesh->indexFormat, 0);
+
+		effect.SetTexture(batch.texture);
+		effect.SetMaterial(batch.material);
+		effect.Apply(deviceContext);
+
+		deviceContext->DrawIndexedInstanced(mesh->indexCount, batch.instanceCount, 0, 0, batch.startInstance);
+		++m_DrawCallCount;
+	}
+	m_InstanceCount = instanceCount;
+}
+
+UINT InstancedRenderer::GetDrawCallCount() const {
+	return m_DrawCallCount;
+}
+
+UINT InstancedRenderer::GetInstanceCount() const {
+	return m_InstanceCount;
+}
+
+void InstancedRenderer::ReserveInstanceBuffer(UINT count) {
+	if (count <= m_Capacity)
+		return;
+	UINT capacity = m_Capacity > 0 ? m_Capacity : 1;
+	while (capacity < count)
+		capacity *= 2;
+
+	D3D11_BUFFER_DESC vbd;
+	ZeroMemory(&vbd, sizeof(vbd));
+	vbd.Usage = D3D11_USAGE_DYNAMIC;
+	vbd.ByteWidth = sizeof(InstancedData) * capacity;
+	vbd.BindFlags = D3D11_BIND_VERTEX_BUFFER;
+	vbd.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE;
+	m_pInstanceBuffer.Reset();
+	HR(m_pDevice->CreateBuffer(&vbd, nullptr, m_pInstanceBuffer.GetAddressOf()));
+	m_Capacity = capacity;
+
+#if (defined(DEBUG) || defined(_DEBUG) && (GRAPHICS_DEBUGGER_OBJECT_NAME))
+	D3D11SetDebugObjectName(m_pInstanceBuffer.Get(), "InstanceBuffer");
+#endif
+}
@@ -0,0 +1,139 @@
+#include "JobSystem.h"
+#include <algorithm>
+
+namespace {
+	// 当前线程所属的线程池及其队列下标，外部线程为0
+	thread_local const JobSystem* t_pOwner = nullptr;
+	thread_local uint32_t t_WorkerIndex = 0;
+}
+
+JobSystem::JobSystem(uint32_t threadCount)
+{
+	if (threadCount == 0)
+		threadCount = std::max(1u, std::thread::hardware_concurrency());
+
+	for (uint32_t i = 0; i < threadCount; ++i)
+		m_Queues.push_back(std::make_unique<WorkQueue>());
+	for (uint32_t i = 1; i < threadCount; ++i)
+		m_Threads.emplace_back(&JobSystem::WorkerLoop, this, i);
+}
+
+JobSystem::~JobSystem()
+{
+	{
+		std::lock_guard<std::mutex> lock(m_WakeMutex);
+		m_Quit = true;
+	}
+	m_WakeCondition.notify_all();
+	for (auto& thread : m_Threads)
+		thread.join();
+}
+
+uint32_t JobSystem::GetThreadCount() const
+{
+	return static_cast<uint32_t>(m_Queues.size());
+}
+
+void JobSystem::ParallelFor(uint32_t count, uint32_t grainSize, const RangeFunc& func)
+{
+	if (count == 0)
+		return;
+	grainSize = std::max(grainSize, 1u);
+	uint32_t batchCount = (count + grainSize - 1) / grainSize;
+	if (m_Threads.empty() || batchCount == 1)
+	{
+		func(0, count);
+		return;
+	}
+
+	// 任务轮流分发到各个队列，从当前线程的队列开始
+	std::atomic<uint32_t> pending{ batchCount };
+	uint32_t queueCount = static_cast<uint32_t>(m_Queues.size());
+	uint32_t selfIndex = GetCurrentWorkerIndex();
+	for (uint32_t q = 0; q < queueCount && q < batchCount; ++q)
+	{
+		WorkQueue& queue = *m_Queues[(selfIndex + q) % queueCount];
+		std::lock_guard<std::mutex> lock(queue.mutex);
+		for (uint32_t b = q; b < batchCount; b += queueCount)
+		{
+			uint32_t begin = b * grainSize;
+			queue.jobs.push_back({ &func, begin, std::min(begin + grainSize, count), &pending });
+		}
+	}
+	m_QueuedJobs.fetch_add(batchCount, std::memory_order_release);
+	{
+		std::lock_guard<std::mutex> lock(m_WakeMutex);
+	}
+	m_WakeCondition.notify_all();
+
+	// 调用线程参与执行，直到本次的任务全部完成
+	Job job;
+	while (pending.load(std::memory_order_acquire) > 0)
+	{
+		if (TryGetJob(selfIndex, job))
+			Execute(job);
+		else
+			std::this_thread::yield();
+	}
+}
+
+void JobSystem::WorkerLoop(uint32_t workerIndex)
+{
+	t_pOwner = this;
+	t_WorkerIndex = workerIndex;
+
+	Job job;
+	for (;;)
+	{
+		if (TryGetJob(workerIndex, job))
+		{
+			Execute(job);
+			continue;
+		}
+
+		std::unique_lock<std::mutex> lock(m_WakeMutex);
+		m_WakeCondition.wait(lock, [this]() { return m_Quit || m_QueuedJobs.load(std::memory_order_acquire) > 0; });
+		if (m_Quit)
+			return;
+	}
+}
+
+bool JobSystem::TryGetJob(uint32_t workerIndex, Job& job)
+{
+	if (m_QueuedJobs.load(std::memory_order_acquire) == 0)
+		return false;
+
+	// 先从自己队列的队尾取，再依次从其它队列的队首窃取
+	uint32_t queueCount = static_cast<uint32_t>(m_Queues.size());
+	for (uint32_t i = 0; i < queueCount; ++i)
+	{
+		WorkQueue& queue = *m_Queues[(workerIndex + i) % queueCount];
+		std::lock_guard<std::mutex> lock(queue.mutex);
+		if (queue.jobs.empty())
+			continue;
+		if (i == 0)
+		{
+			job = queue.jobs.back();
+			queue.jobs.pop_back();
+		}
+		else
+		{
+			job = queue.jobs.front();
+			queue.jobs.pop_front();
+		}
+		m_QueuedJobs.fetch_sub(1, std::memory_order_relaxed);
+		return true;
+	}
+	return false;
+}
+
+void JobSystem::Execute(const Job& job)
+{
+	(*job.func)(job.begin, job.end);
+	job.pending->fetch_sub(1, std::memory_order_release);
+}
+
+uint32_t JobSystem::GetCurrentWorkerIndex() const
+{
+	return t_pOwner == this ? t_WorkerIndex : 0;
+}
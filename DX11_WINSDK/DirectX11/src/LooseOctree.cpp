@@ -0,0 +1,497 @@
+#include "LooseOctree.h"
+#include <algorithm>
+#include <cassert>
+#include <cfloat>
+#include <cmath>
+#include <functional>
+#include <queue>
+
+using namespace DirectX;
+
+namespace {
+	enum class Overlap { Outside, Intersect, Inside };
+
+	// 深度优先遍历时栈中最多同时有每层的7个兄弟节点加上最后一层的8个子节点
+	const uint32_t s_StackSize = 8 * LooseOctree::MaxDepthLimit + 8;
+
+	inline float MaxComponent(const XMFLOAT3& v) {
+		return std::max(v.x, std::max(v.y, v.z));
+	}
+
+	// 与Culling::CullBoxes的SIMD内核使用相同的运算顺序，结果逐个一致
+	inline Overlap TestBoxPlanes(const Culling::FrustumPlanes& frustum, const XMFLOAT3& center, const XMFLOAT3& extents) {
+		Overlap result = Overlap::Inside;
+		for (int p = 0; p < 6; ++p) {
+			const XMFLOAT4& plane = frustum.planes[p];
+			float dist = center.x * plane.x + plane.w;
+			dist = center.y * plane.y + dist;
+			dist = center.z * plane.z + dist;
+			float r = extents.x * fabsf(plane.x);
+			r = extents.y * fabsf(plane.y) + r;
+			r = extents.z * fabsf(plane.z) + r;
+			if (dist + r < 0.0f)
+				return Overlap::Outside;
+			if (dist - r < 0.0f)
+				result = Overlap::Intersect;
+		}
+		return result;
+	}
+
+	// 点到包围盒的距离平方，点在盒内时为0
+	inline float DistanceSqToBox(const XMFLOAT3& point, const XMFLOAT3& center, const XMFLOAT3& extents) {
+		float dx = std::max(fabsf(point.x - center.x) - extents.x, 0.0f);
+		float dy = std::max(fabsf(point.y - center.y) - extents.y, 0.0f);
+		float dz = std::max(fabsf(point.z - center.z) - extents.z, 0.0f);
+		return dx * dx + dy * dy + dz * dz;
+	}
+
+	inline float FarthestDistanceSqToBox(const XMFLOAT3& point, const XMFLOAT3& center, const XMFLOAT3& extents) {
+		float dx = fabsf(point.x - center.x) + extents.x;
+		float dy = fabsf(point.y - center.y) + extents.y;
+		float dz = fabsf(point.z - center.z) + extents.z;
+		return dx * dx + dy * dy + dz * dz;
+	}
+
+	struct Ray {
+		XMFLOAT3 origin;
+		XMFLOAT3 invDirection;		// 方向分量为0时为无穷大
+		float maxDistance;
+
+		// 方向为零向量时返回false
+		bool Init(const XMFLOAT3& o, const XMFLOAT3& direction, float maxDist) {
+			float length = sqrtf(direction.x * direction.x + direction.y * direction.y + direction.z * direction.z);
+			if (length <= 0.0f)
+				return false;
+			origin = o;
+			invDirection = XMFLOAT3(length / direction.x, length / direction.y, length / direction.z);
+			maxDistance = maxDist;
+			return true;
+		}
+
+		// 板块法求射线进入包围盒的距离，射线与板块边界重合产生的NaN被std::max/std::min忽略
+		bool Intersect(const XMFLOAT3& center, const XMFLOAT3& extents, float& tEnter) const {
+			float tMin = 0.0f, tMax = maxDistance;
+			const float* c = &center.x;
+			const float* e = &extents.x;
+			const float* o = &origin.x;
+			const float* inv = &invDirection.x;
+			for (int i = 0; i < 3; ++i) {
+				float t0 = (c[i] - e[i] - o[i]) * inv[i];
+				float t1 = (c[i] + e[i] - o[i]) * inv[i];
+				if (t0 > t1)
+					std::swap(t0, t1);
+				tMin = std::max(tMin, t0);
+				tMax = std::min(tMax, t1);
+			}
+			tEnter = tMin;
+			return tMin <= tMax;
+		}
+	};
+
+	inline XMFLOAT3 LooseExtents(float halfSize) {
+		return XMFLOAT3(2.0f * halfSize, 2.0f * halfSize, 2.0f * halfSize);
+	}
+}
+
+LooseOctree::LooseOctree(const XMFLOAT3& center, float halfSize, uint32_t maxDepth)
+{
+	Reset(center, halfSize, maxDepth);
+}
+
+void LooseOctree::Reset(const XMFLOAT3& center, float halfSize, uint32_t maxDepth)
+{
+	assert(halfSize > 0.0f);
+	m_MaxDepth = std::min(maxDepth, MaxDepthLimit);
+	m_Nodes.clear();
+	m_Objects.clear();
+	m_FreeHandles.clear();
+	m_ReinsertCount = 0;
+	m_Size = 0;
+
+	m_Nodes.emplace_back();
+	Node& root = m_Nodes[0];
+	root.center = center;
+	root.halfSize = halfSize;
+	root.parent = InvalidHandle;
+	root.depth = 0;
+	root.subtreeCount = 0;
+	root.split = false;
+	std::fill(std::begin(root.children), std::end(root.children), InvalidHandle);
+}
+
+void LooseOctree::Clear()
+{
+	Reset(m_Nodes[0].center, m_Nodes[0].halfSize, m_MaxDepth);
+}
+
+uint32_t LooseOctree::Insert(const XMFLOAT3& center, const XMFLOAT3& extents, uint32_t userData)
+{
+	uint32_t handle;
+	if (!m_FreeHandles.empty()) {
+		handle = m_FreeHandles.back();
+		m_FreeHandles.pop_back();
+	}
+	else {
+		handle = static_cast<uint32_t>(m_Objects.size());
+		m_Objects.emplace_back();
+	}
+
+	Object& object = m_Objects[handle];
+	object.center = center;
+	object.extents = extents;
+	object.userData = userData;
+	Link(handle, FindNode(center, extents));
+	++m_Size;
+	return handle;
+}
+
+void LooseOctree::Update(uint32_t handle, const XMFLOAT3& center, const XMFLOAT3& extents)
+{
+	assert(handle < m_Objects.size() && m_Objects[handle].node != InvalidHandle);
+	Object& object = m_Objects[handle];
+	object.center = center;
+	object.extents = extents;
+	if (FitsNode(m_Nodes[object.node], center, extents))
+		return;
+
+	Unlink(handle);
+	Link(handle, FindNode(center, extents));
+	++m_ReinsertCount;
+}
+
+void LooseOctree::Remove(uint32_t handle)
+{
+	assert(handle < m_Objects.size() && m_Objects[handle].node != InvalidHandle);
+	Unlink(handle);
+	m_Objects[handle].node = InvalidHandle;
+	m_FreeHandles.push_back(handle);
+	--m_Size;
+}
+
+void LooseOctree::Rebuild()
+{
+	XMFLOAT3 minCenter(FLT_MAX, FLT_MAX, FLT_MAX), maxCenter(-FLT_MAX, -FLT_MAX, -FLT_MAX);
+	for (const Object& object : m_Objects) {
+		if (object.node == InvalidHandle)
+			continue;
+		minCenter.x = std::min(minCenter.x, object.center.x);
+		minCenter.y = std::min(minCenter.y, object.center.y);
+		minCenter.z = std::min(minCenter.z, object.center.z);
+		maxCenter.x = std::max(maxCenter.x, object.center.x);
+		maxCenter.y = std::max(maxCenter.y, object.center.y);
+		maxCenter.z = std::max(maxCenter.z, object.center.z);
+	}
+
+	// 根节点只需包含所有物体的中心，稍微放大以免边界上的物体因舍入落到范围外
+	Node& root = m_Nodes[0];
+	if (m_Size > 0) {
+		root.center = XMFLOAT3(0.5f * (minCenter.x + maxCenter.x), 0.5f * (minCenter.y + maxCenter.y),
+			0.5f * (minCenter.z + maxCenter.z));
+		float halfSize = 0.5f * std::max(maxCenter.x - minCenter.x, std::max(maxCenter.y - minCenter.y, maxCenter.z - minCenter.z));
+		root.halfSize = std::max(halfSize * 1.001f, 1e-3f);
+	}
+	root.subtreeCount = 0;
+	root.split = false;
+	root.objects.clear();
+	std::fill(std::begin(root.children), std::end(root.children), InvalidHandle);
+	m_Nodes.resize(1);
+	m_ReinsertCount = 0;
+
+	for (uint32_t handle = 0; handle < m_Objects.size(); ++handle) {
+		Object& object = m_Objects[handle];
+		if (object.node != InvalidHandle)
+			Link(handle, FindNode(object.center, object.extents));
+	}
+}
+
+size_t LooseOctree::Size() const
+{
+	return m_Size;
+}
+
+uint32_t LooseOctree::GetNodeCount() const
+{
+	return static_cast<uint32_t>(m_Nodes.size());
+}
+
+uint32_t LooseOctree::GetMaxDepth() const
+{
+	return m_MaxDepth;
+}
+
+uint32_t LooseOctree::GetUserData(uint32_t handle) const
+{
+	assert(handle < m_Objects.size() && m_Objects[handle].node != InvalidHandle);
+	return m_Objects[handle].userData;
+}
+
+void LooseOctree::GetBounds(uint32_t handle, XMFLOAT3& center, XMFLOAT3& extents) const
+{
+	assert(handle < m_Objects.size() && m_Objects[handle].node != InvalidHandle);
+	center = m_Objects[handle].center;
+	extents = m_Objects[handle].extents;
+}
+
+uint32_t LooseOctree::GetReinsertCount() const
+{
+	return m_ReinsertCount;
+}
+
+void LooseOctree::QueryFrustum(const Culling::FrustumPlanes& frustum, std::vector<uint32_t>& results) const
+{
+	Query([&](const XMFLOAT3& center, const XMFLOAT3& extents) {
+		return TestBoxPlanes(frustum, center, extents);
+	}, [&](const Object& object) {
+		return TestBoxPlanes(frustum, object.center, object.extents) != Overlap::Outside;
+	}, results);
+}
+
+void LooseOctree::QuerySphere(const XMFLOAT3& center, float radius, std::vector<uint32_t>& results) const
+{
+	float radiusSq = radius * radius;
+	Query([&](const XMFLOAT3& nodeCenter, const XMFLOAT3& extents) {
+		if (DistanceSqToBox(center, nodeCenter, extents) > radiusSq)
+			return Overlap::Outside;
+		return FarthestDistanceSqToBox(center, nodeCenter, extents) <= radiusSq ? Overlap::Inside : Overlap::Intersect;
+	}, [&](const Object& object) {
+		return DistanceSqToBox(center, object.center, object.extents) <= radiusSq;
+	}, results);
+}
+
+void LooseOctree::QueryRay(const XMFLOAT3& origin, const XMFLOAT3& direction, float maxDistance,
+	std::vector<uint32_t>& results) const
+{
+	Ray ray;
+	if (!ray.Init(origin, direction, maxDistance)) {
+		results.clear();
+		return;
+	}
+	float t;
+	Query([&](const XMFLOAT3& center, const XMFLOAT3& extents) {
+		return ray.Intersect(center, extents, t) ? Overlap::Intersect : Overlap::Outside;
+	}, [&](const Object& object) {
+		return ray.Intersect(object.center, object.extents, t);
+	}, results);
+}
+
+bool LooseOctree::Raycast(const XMFLOAT3& origin, const XMFLOAT3& direction, float maxDistance,
+	uint32_t& userData, float& distance) const
+{
+	Ray ray;
+	if (m_Size == 0 || !ray.Init(origin, direction, maxDistance))
+		return false;
+
+	// 按进入距离由近到远访问节点，进入距离超过当前最近命中时结束
+	using Entry = std::pair<float, uint32_t>;
+	std::priority_queue<Entry, std::vector<Entry>, std::greater<Entry>> nodes;
+	nodes.emplace(0.0f, 0);
+	bool hit = false;
+	while (!nodes.empty() && nodes.top().first <= ray.maxDistance) {
+		const Node& node = m_Nodes[nodes.top().second];
+		nodes.pop();
+		float t;
+		for (uint32_t handle : node.objects) {
+			const Object& object = m_Objects[handle];
+			if (ray.Intersect(object.center, object.extents, t) && (!hit || t < ray.maxDistance)) {
+				hit = true;
+				userData = object.userData;
+				ray.maxDistance = t;
+			}
+		}
+		for (uint32_t child : node.children) {
+			if (child == InvalidHandle || m_Nodes[child].subtreeCount == 0)
+				continue;
+			if (ray.Intersect(m_Nodes[child].center, LooseExtents(m_Nodes[child].halfSize), t))
+				nodes.emplace(t, child);
+		}
+	}
+	if (hit)
+		distance = ray.maxDistance;
+	return hit;
+}
+
+void LooseOctree::QueryNearest(const XMFLOAT3& point, uint32_t k, std::vector<uint32_t>& results) const
+{
+	results.clear();
+	if (k == 0 || m_Size == 0)
+		return;
+
+	// 节点按到点的距离由近到远访问，best为当前最近的k个(堆顶最远)
+	using Entry = std::pair<float, uint32_t>;
+	std::priority_queue<Entry, std::vector<Entry>, std::greater<Entry>> nodes;
+	std::priority_queue<Entry> best;
+	nodes.emplace(0.0f, 0);
+	while (!nodes.empty()) {
+		if (best.size() == k && nodes.top().first > best.top().first)
+			break;
+		const Node& node = m_Nodes[nodes.top().second];
+		nodes.pop();
+		for (uint32_t handle : node.objects) {
+			const Object& object = m_Objects[handle];
+			float distSq = DistanceSqToBox(point, object.center, object.extents);
+			if (best.size() < k)
+				best.emplace(distSq, object.userData);
+			else if (distSq < best.top().first) {
+				best.pop();
+				best.emplace(distSq, object.userData);
+			}
+		}
+		for (uint32_t child : node.children) {
+			if (child == InvalidHandle || m_Nodes[child].subtreeCount == 0)
+				continue;
+			float distSq = DistanceSqToBox(point, m_Nodes[child].center, LooseExtents(m_Nodes[child].halfSize));
+			if (best.size() < k || distSq <= best.top().first)
+				nodes.emplace(distSq, child);
+		}
+	}
+
+	results.resize(best.size());
+	for (size_t i = results.size(); i > 0; --i) {
+		results[i - 1] = best.top().second;
+		best.pop();
+	}
+}
+
+uint32_t LooseOctree::CreateNode(uint32_t parent, uint32_t octant)
+{
+	uint32_t index = static_cast<uint32_t>(m_Nodes.size());
+	m_Nodes.emplace_back();
+	Node& node = m_Nodes[index];
+	const Node& parentNode = m_Nodes[parent];
+	float offset = 0.5f * parentNode.halfSize;
+	node.center = XMFLOAT3(parentNode.center.x + (octant & 1 ? offset : -offset),
+		parentNode.center.y + (octant & 2 ? offset : -offset),
+		parentNode.center.z + (octant & 4 ? offset : -offset));
+	node.halfSize = offset;
+	node.parent = parent;
+	node.depth = parentNode.depth + 1;
+	node.subtreeCount = 0;
+	node.split = false;
+	std::fill(std::begin(node.children), std::end(node.children), InvalidHandle);
+	m_Nodes[parent].children[octant] = index;
+	return index;
+}
+
+uint32_t LooseOctree::FindNode(const XMFLOAT3& center, const XMFLOAT3& extents)
+{
+	float maxExtent = MaxComponent(extents);
+	const Node& root = m_Nodes[0];
+	if (fabsf(center.x - root.center.x) > root.halfSize || fabsf(center.y - root.center.y) > root.halfSize ||
+		fabsf(center.z - root.center.z) > root.halfSize)
+		return 0;
+
+	// 子节点的松散范围是其半边长的2倍，中心在子节点内时只要最大半长不超过子节点半边长就能容纳
+	uint32_t index = 0;
+	while (m_Nodes[index].split && m_Nodes[index].depth < m_MaxDepth && maxExtent <= 0.5f * m_Nodes[index].halfSize) {
+		const Node& node = m_Nodes[index];
+		uint32_t octant = (center.x >= node.center.x ? 1 : 0) | (center.y >= node.center.y ? 2 : 0) |
+			(center.z >= node.center.z ? 4 : 0);
+		uint32_t child = node.children[octant];
+		index = child != InvalidHandle ? child : CreateNode(index, octant);
+	}
+	return index;
+}
+
+bool LooseOctree::FitsNode(const Node& node, const XMFLOAT3& center, const XMFLOAT3& extents) const
+{
+	float maxExtent = MaxComponent(extents);
+	bool inside = fabsf(center.x - node.center.x) <= node.halfSize && fabsf(center.y - node.center.y) <= node.halfSize &&
+		fabsf(center.z - node.center.z) <= node.halfSize;
+	// 根节点容纳范围外的物体
+	if (node.parent != InvalidHandle && (!inside || maxExtent > node.halfSize))
+		return false;
+	// 节点已分裂且物体小到可以放入子节点
+	return !(inside && node.split && node.depth < m_MaxDepth && maxExtent <= 0.5f * node.halfSize);
+}
+
+void LooseOctree::Link(uint32_t handle, uint32_t node)
+{
+	Object& object = m_Objects[handle];
+	object.node = node;
+	object.slot = static_cast<uint32_t>(m_Nodes[node].objects.size());
+	m_Nodes[node].objects.push_back(handle);
+	for (uint32_t n = node; n != InvalidHandle; n = m_Nodes[n].parent)
+		++m_Nodes[n].subtreeCount;
+
+	const Node& current = m_Nodes[node];
+	if (!current.split && current.depth < m_MaxDepth && current.objects.size() > NodeCapacity)
+		Split(node);
+}
+
+void LooseOctree::Split(uint32_t node)
+{
+	m_Nodes[node].split = true;
+	// Unlink会改变节点的物体列表，先复制一份
+	std::vector<uint32_t> objects = m_Nodes[node].objects;
+	for (uint32_t handle : objects) {
+		Object& object = m_Objects[handle];
+		uint32_t target = FindNode(object.center, object.extents);
+		if (target != node) {
+			Unlink(handle);
+			Link(handle, target);
+		}
+	}
+}
+
+void LooseOctree::Unlink(uint32_t handle)
+{
+	Object& object = m_Objects[handle];
+	std::vector<uint32_t>& objects = m_Nodes[object.node].objects;
+	uint32_t last = objects.back();
+	objects[object.slot] = last;
+	m_Objects[last].slot = object.slot;
+	objects.pop_back();
+	for (uint32_t n = object.node; n != InvalidHandle; n = m_Nodes[n].parent)
+		--m_Nodes[n].subtreeCount;
+}
+
+void LooseOctree::CollectSubtree(uint32_t node, std::vector<uint32_t>& results) const
+{
+	uint32_t stack[s_StackSize];
+	uint32_t top = 0;
+	stack[top++] = node;
+	while (top > 0) {
+		const Node& current = m_Nodes[stack[--top]];
+		for (uint32_t handle : current.objects)
+			results.push_back(m_Objects[handle].userData);
+		for (uint32_t child : current.children) {
+			if (child != InvalidHandle && m_Nodes[child].subtreeCount > 0)
+				stack[top++] = child;
+		}
+	}
+}
+
+template<class NodeTest, class ObjectTest>
+void LooseOctree::Query(NodeTest&& nodeTest, ObjectTest&& objectTest, std::vector<uint32_t>& results) const
+{
+	results.clear();
+	if (m_Size == 0)
+		return;
+
+	uint32_t stack[s_StackSize];
+	uint32_t top = 0;
+	stack[top++] = 0;
+	while (top > 0) {
+		uint32_t index = stack[--top];
+		const Node& node = m_Nodes[index];
+		// 根节点中可能有范围外的物体，不做节点测试
+		if (index != 0) {
+			Overlap overlap = nodeTest(node.center, LooseExtents(node.halfSize));
+			if (overlap == Overlap::Outside)
+				continue;
+			if (overlap == Overlap::Inside) {
+				CollectSubtree(index, results);
+				continue;
+			}
+		}
+		for (uint32_t handle : node.objects) {
+			const Object& object = m_Objects[handle];
+			if (objectTest(object))
+				results.push_back(object.userData);
+		}
+		for (uint32_t child : node.children) {
+			if (child != InvalidHandle && m_Nodes[child].subtreeCount > 0)
+				stack[top++] = child;
+		}
+	}
+}
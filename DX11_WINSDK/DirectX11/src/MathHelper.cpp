@@ -0,0 +1,60 @@
+#include "MathHelper.h"
+
+using namespace DirectX;
+
+void AffineInverseBatch(const XMFLOAT4X4* matrices, XMFLOAT4X4* inverses, size_t count)
+{
+	size_t i = 0;
+	for (; i + 4 <= count; i += 4)
+	{
+		XMMATRIX M0 = XMLoadFloat4x4(&matrices[i]);
+		XMMATRIX M1 = XMLoadFloat4x4(&matrices[i + 1]);
+		XMMATRIX M2 = XMLoadFloat4x4(&matrices[i + 2]);
+		XMMATRIX M3 = XMLoadFloat4x4(&matrices[i + 3]);
+
+		// 转置后aRC的第k个分量为第k个矩阵的(R, C)元素
+		XMMATRIX row0 = XMMatrixTranspose(XMMATRIX(M0.r[0], M1.r[0], M2.r[0], M3.r[0]));
+		XMMATRIX row1 = XMMatrixTranspose(XMMATRIX(M0.r[1], M1.r[1], M2.r[1], M3.r[1]));
+		XMMATRIX row2 = XMMatrixTranspose(XMMATRIX(M0.r[2], M1.r[2], M2.r[2], M3.r[2]));
+		XMMATRIX row3 = XMMatrixTranspose(XMMATRIX(M0.r[3], M1.r[3], M2.r[3], M3.r[3]));
+		XMVECTOR a00 = row0.r[0], a01 = row0.r[1], a02 = row0.r[2];
+		XMVECTOR a10 = row1.r[0], a11 = row1.r[1], a12 = row1.r[2];
+		XMVECTOR a20 = row2.r[0], a21 = row2.r[1], a22 = row2.r[2];
+		XMVECTOR t0 = row3.r[0], t1 = row3.r[1], t2 = row3.r[2];
+
+		// 余子式
+		XMVECTOR c00 = XMVectorNegativeMultiplySubtract(a12, a21, XMVectorMultiply(a11, a22));
+		XMVECTOR c01 = XMVectorNegativeMultiplySubtract(a10, a22, XMVectorMultiply(a12, a20));
+		XMVECTOR c02 = XMVectorNegativeMultiplySubtract(a11, a20, XMVectorMultiply(a10, a21));
+		XMVECTOR c10 = XMVectorNegativeMultiplySubtract(a01, a22, XMVectorMultiply(a02, a21));
+		XMVECTOR c11 = XMVectorNegativeMultiplySubtract(a02, a20, XMVectorMultiply(a00, a22));
+		XMVECTOR c12 = XMVectorNegativeMultiplySubtract(a00, a21, XMVectorMultiply(a01, a20));
+		XMVECTOR c20 = XMVectorNegativeMultiplySubtract(a02, a11, XMVectorMultiply(a01, a12));
+		XMVECTOR c21 = XMVectorNegativeMultiplySubtract(a00, a12, XMVectorMultiply(a02, a10));
+		XMVECTOR c22 = XMVectorNegativeMultiplySubtract(a01, a10, XMVectorMultiply(a00, a11));
+
+		XMVECTOR det = XMVectorMultiplyAdd(a00, c00, XMVectorMultiplyAdd(a01, c01, XMVectorMultiply(a02, c02)));
+		XMVECTOR invDet = XMVectorReciprocal(det);
+
+		// 逆矩阵的(i, j)元素为cji / det
+		XMVECTOR b00 = XMVectorMultiply(c00, invDet), b01 = XMVectorMultiply(c10, invDet), b02 = XMVectorMultiply(c20, invDet);
+		XMVECTOR b10 = XMVectorMultiply(c01, invDet), b11 = XMVectorMultiply(c11, invDet), b12 = XMVectorMultiply(c21, invDet);
+		XMVECTOR b20 = XMVectorMultiply(c02, invDet), b21 = XMVectorMultiply(c12, invDet), b22 = XMVectorMultiply(c22, invDet);
+
+		// 平移：-t * inv
+		XMVECTOR s0 = XMVectorNegate(XMVectorMultiplyAdd(t0, b00, XMVectorMultiplyAdd(t1, b10, XMVectorMultiply(t2, b20))));
+		XMVECTOR s1 = XMVectorNegate(XMVectorMultiplyAdd(t0, b01, XMVectorMultiplyAdd(t1, b11, XMVectorMultiply(t2, b21))));
+		XMVECTOR s2 = XMVectorNegate(XMVectorMultiplyAdd(t0, b02, XMVectorMultiplyAdd(t1, b12, XMVectorMultiply(t2, b22))));
+
+		// 转置回每个矩阵各自的行
+		XMMATRIX out0 = XMMatrixTranspose(XMMATRIX(b00, b01, b02, XMVectorZero()));
+		XMMATRIX out1 = XMMatrixTranspose(XMMATRIX(b10, b11, b12, XMVectorZero()));
+		XMMATRIX out2 = XMMatrixTranspose(XMMATRIX(b20, b21, b22, XMVectorZero()));
+		XMMATRIX out3 = XMMatrixTranspose(XMMATRIX(s0, s1, s2, XMVectorSplatOne()));
+		for (size_t k = 0; k < 4; ++k)
+			XMStoreFloat4x4(&inverses[i + k], XMMATRIX(out0.r[k], out1.r[k], out2.r[k], out3.r[k]));
+	}
+
+	for (; i < count; ++i)
+		XMStoreFloat4x4(&inverses[i], AffineInverse(XMLoadFloat4x4(&matrices[i])));
+}
@@ -0,0 +1,160 @@
+#include "MeshRegistry.h"
+#include "d3dUtil.h"
+#include "DXTrace.h"
+#include <cassert>
+using namespace DirectX;
+
+MeshHandle::~MeshHandle() {
+	Reset();
+}
+
+MeshHandle::MeshHandle(const MeshHandle& other) : m_pRegistry(other.m_pRegistry), m_Id(other.m_Id) {
+	if (m_pRegistry)
+		m_pRegistry->AddRef(m_Id);
+}
+
+MeshHandle& MeshHandle::operator=(const MeshHandle& other) {
+	// 先增加再减少，自赋值时不会提前释放
+	MeshRegistry* registry = other.m_pRegistry;
+	uint32_t id = other.m_Id;
+	if (registry)
+		registry->AddRef(id);
+	Reset();
+	m_pRegistry = registry;
+	m_Id = id;
+	return *this;
+}
+
+MeshHandle::MeshHandle(MeshHandle&& other) noexcept : m_pRegistry(other.m_pRegistry), m_Id(other.m_Id) {
+	other.m_pRegistry = nullptr;
+	other.m_Id = InvalidId;
+}
+
+MeshHandle& MeshHandle::operator=(MeshHandle&& other) noexcept {
+	if (this != &other) {
+		Reset();
+		m_pRegistry = other.m_pRegistry;
+		m_Id = other.m_Id;
+		other.m_pRegistry = nullptr;
+		other.m_Id = InvalidId;
+	}
+	return *this;
+}
+
+void MeshHandle::Reset() {
+	if (m_pRegistry)
+		m_pRegistry->Release(m_Id);
+	m_pRegistry = nullptr;
+	m_Id = InvalidId;
+}
+
+const MeshResource* MeshHandle::Get() const {
+	return m_pRegistry ? &m_pRegistry->m_Entries[m_Id].mesh : nullptr;
+}
+
+MeshRegistry::~MeshRegistry() {
+	assert(m_MeshCount == 0 && "all MeshHandles must be released before the registry");
+}
+
+MeshHandle MeshRegistry::Find(const std::string& name) {
+	auto it = m_NameToId.find(name);
+	if (it == m_NameToId.end())
+		return MeshHandle();
+	AddRef(it->second);
+	return MeshHandle(this, it->second);
+}
+
+uint32_t MeshRegistry::GetRefCount(const MeshHandle& handle) const {
+	if (handle.m_pRegistry != this)
+		return 0;
+	return m_Entries[handle.m_Id].refCount;
+}
+
+size_t MeshRegistry::GetMeshCount() const {
+	return m_MeshCount;
+}
+
+size_t MeshRegistry::GetBufferBytes() const {
+	return m_BufferBytes;
+}
+
+MeshHandle MeshRegistry::CreateMesh(ID3D11Device* device, const std::string& name,
+	const void* vertexData, UINT vertexStride, UINT vertexCount,
+	const void* indexData, DXGI_FORMAT indexFormat, UINT indexCount,
+	const BoundingBox& localBounds) {
+	UINT indexStride = indexFormat == DXGI_FORMAT_R16_UINT ? 2 : 4;
+	MeshResource mesh;
+	mesh.vertexStride = vertexStride;
+	mesh.vertexCount = vertexCount;
+	mesh.indexCount = indexCount;
+	mesh.indexFormat = indexFormat;
+	mesh.localBounds = localBounds;
+	mesh.name = name;
+
+	D3D11_BUFFER_DESC vbd;
+	ZeroMemory(&vbd, sizeof(vbd));
+	vbd.Usage = D3D11_USAGE_IMMUTABLE;
+	vbd.ByteWidth = vertexStride * vertexCount;
+	vbd.BindFlags = D3D11_BIND_VERTEX_BUFFER;
+	vbd.CPUAccessFlags = 0;
+
+	D3D11_SUBRESOURCE_DATA InitData;
+	ZeroMemory(&InitData, sizeof(InitData));
+	InitData.pSysMem = vertexData;
+	HR(device->CreateBuffer(&vbd, &InitData, mesh.vertexBuffer.GetAddressOf()));
+
+	D3D11_BUFFER_DESC ibd;
+	ZeroMemory(&ibd, sizeof(ibd));
+	ibd.Usage = D3D11_USAGE_IMMUTABLE;
+	ibd.ByteWidth = indexStride * indexCount;
+	ibd.BindFlags = D3D11_BIND_INDEX_BUFFER;
+	ibd.CPUAccessFlags = 0;
+
+	InitData.pSysMem = indexData;
+	HR(device->CreateBuffer(&ibd, &InitData, mesh.indexBuffer.GetAddressOf()));
+
+#if (defined(DEBUG) || defined(_DEBUG) && (GRAPHICS_DEBUGGER_OBJECT_NAME))
+	if (!name.empty()) {
+		D3D11SetDebugObjectName(mesh.vertexBuffer.Get(), name + ".VertexBuffer");
+		D3D11SetDebugObjectName(mesh.indexBuffer.Get(), name + ".IndexBuffer");
+	}
+#endif
+
+	uint32_t id;
+	if (!m_FreeIds.empty()) {
+		id = m_FreeIds.back();
+		m_FreeIds.pop_back();
+	}
+	else {
+		id = (uint32_t)m_Entries.size();
+		m_Entries.emplace_back();
+	}
+	m_Entries[id].mesh = std::move(mesh);
+	m_Entries[id].refCount = 1;
+	if (!name.empty())
+		m_NameToId[name] = id;
+	++m_MeshCount;
+	m_BufferBytes += vbd.ByteWidth + ibd.ByteWidth;
+	return MeshHandle(this, id);
+}
+
+void MeshRegistry::AddRef(uint32_t id) {
+	assert(id < m_Entries.size() && m_Entries[id].refCount > 0);
+	++m_Entries[id].refCount;
+}
+
+void MeshRegistry::Release(uint32_t id) {
+	assert(id < m_Entries.size() && m_Entries[id].refCount > 0);
+	Entry& entry = m_Entries[id];
+	if (--entry.refCount > 0)
+		return;
+
+	// 最后一个引用释放，缓冲区随之释放，编号留给之后的网格
+	const MeshResource& mesh = entry.mesh;
+	m_BufferBytes -= mesh.vertexStride * mesh.vertexCount + (mesh.indexFormat == DXGI_FORMAT_R16_UINT ? 2 : 4) * mesh.indexCount;
+	if (!mesh.name.empty())
+		m_NameToId.erase(mesh.name);
+	entry.mesh = MeshResource();
+	m_FreeIds.push_back(id);
+	--m_MeshCount;
+}
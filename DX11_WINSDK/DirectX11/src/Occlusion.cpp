@@ -0,0 +1,437 @@
+#include "Occlusion.h"
+#include "JobSystem.h"
+#include <algorithm>
+#include <cassert>
+#include <cfloat>
+#include <cmath>
+#include <cstring>
+#include <unordered_map>
+
+using namespace DirectX;
+
+namespace {
+	struct CellKey {
+		int64_t x, y, z;
+		bool operator==(const CellKey& other) const { return x == other.x && y == other.y && z == other.z; }
+	};
+
+	struct CellKeyHash {
+		size_t operator()(const CellKey& key) const {
+			uint64_t h = (uint64_t)key.x * 0x9E3779B97F4A7C15ull;
+			h ^= (uint64_t)key.y * 0xC2B2AE3D27D4EB4Full + (h << 6) + (h >> 2);
+			h ^= (uint64_t)key.z * 0x165667B19E3779F9ull + (h << 6) + (h >> 2);
+			return (size_t)h;
+		}
+	};
+
+	const uint32_t s_TileLevels = 5;	// log2(TileSize)，块内可独立生成的HiZ层级数
+}
+
+OccluderMesh OccluderMesh::Simplify(const std::vector<XMFLOAT3>& positions, const std::vector<uint32_t>& indices, float cellSize)
+{
+	assert(cellSize > 0.0f);
+	OccluderMesh mesh;
+	// 同一网格单元内的顶点合并为其中第一个顶点，使合并后的顶点仍在原表面上
+	std::unordered_map<CellKey, uint32_t, CellKeyHash> cellToVertex;
+	std::vector<uint32_t> remap(positions.size());
+	float invCellSize = 1.0f / cellSize;
+	for (size_t i = 0; i < positions.size(); ++i) {
+		const XMFLOAT3& p = positions[i];
+		CellKey key = { (int64_t)std::floor(p.x * invCellSize), (int64_t)std::floor(p.y * invCellSize),
+			(int64_t)std::floor(p.z * invCellSize) };
+		auto it = cellToVertex.find(key);
+		if (it == cellToVertex.end()) {
+			it = cellToVertex.emplace(key, (uint32_t)mesh.positions.size()).first;
+			mesh.positions.push_back(p);
+		}
+		remap[i] = it->second;
+	}
+
+	mesh.indices.reserve(indices.size());
+	for (size_t i = 0; i + 2 < indices.size(); i += 3) {
+		uint32_t i0 = remap[indices[i]], i1 = remap[indices[i + 1]], i2 = remap[indices[i + 2]];
+		if (i0 == i1 || i1 == i2 || i2 == i0)
+			continue;
+		mesh.indices.push_back(i0);
+		mesh.indices.push_back(i1);
+		mesh.indices.push_back(i2);
+	}
+	return mesh;
+}
+
+OcclusionCuller::OcclusionCuller(uint32_t width, uint32_t height)
+{
+	Resize(width, height);
+}
+
+void OcclusionCuller::Resize(uint32_t width, uint32_t height)
+{
+	m_TilesX = std::max(1u, (width + TileSize - 1) / TileSize);
+	m_TilesY = std::max(1u, (height + TileSize - 1) / TileSize);
+	m_Width = m_TilesX * TileSize;
+	m_Height = m_TilesY * TileSize;
+	m_TileBins.assign((size_t)m_TilesX * m_TilesY, std::vector<uint32_t>());
+
+	// 块内的层级尺寸恰好减半，其余层级向上取整直到1x1
+	m_HiZSizes.clear();
+	uint32_t w = m_Width, h = m_Height;
+	m_HiZSizes.push_back(XMUINT2(w, h));
+	while (w > 1 || h > 1) {
+		w = (w + 1) / 2;
+		h = (h + 1) / 2;
+		m_HiZSizes.push_back(XMUINT2(w, h));
+	}
+	m_HiZ.resize(m_HiZSizes.size());
+	for (size_t i = 0; i < m_HiZ.size(); ++i)
+		m_HiZ[i].assign((size_t)m_HiZSizes[i].x * m_HiZSizes[i].y, 1.0f);
+}
+
+uint32_t OcclusionCuller::GetWidth() const
+{
+	return m_Width;
+}
+
+uint32_t OcclusionCuller::GetHeight() const
+{
+	return m_Height;
+}
+
+void XM_CALLCONV OcclusionCuller::BeginFrame(FXMMATRIX viewProj, bool reverseZ)
+{
+	XMMATRIX ViewProj = viewProj;
+	if (reverseZ) {
+		// z' = w - z
+		ViewProj = XMMatrixMultiply(ViewProj, XMMatrixSet(
+			1.0f, 0.0f, 0.0f, 0.0f,
+			0.0f, 1.0f, 0.0f, 0.0f,
+			0.0f, 0.0f, -1.0f, 0.0f,
+			0.0f, 0.0f, 1.0f, 1.0f));
+	}
+	XMStoreFloat4x4(&m_ViewProj, ViewProj);
+	m_Triangles.clear();
+}
+
+void XM_CALLCONV OcclusionCuller::AddOccluder(const OccluderMesh& mesh, FXMMATRIX world)
+{
+	XMMATRIX WorldViewProj = XMMatrixMultiply(world, XMLoadFloat4x4(&m_ViewProj));
+	m_ClipVertices.resize(mesh.positions.size());
+	XMVector3TransformStream(m_ClipVertices.data(), sizeof(XMFLOAT4), mesh.positions.data(), sizeof(XMFLOAT3),
+		mesh.positions.size(), WorldViewProj);
+
+	for (size_t i = 0; i + 2 < mesh.indices.size(); i += 3) {
+		const XMFLOAT4* v[3] = { &m_ClipVertices[mesh.indices[i]], &m_ClipVertices[mesh.indices[i + 1]],
+			&m_ClipVertices[mesh.indices[i + 2]] };
+		// 三个顶点都在同一裁剪平面外侧时整个三角形不可见
+		bool outside = true;
+		for (int k = 0; k < 3 && outside; ++k) outside = v[k]->x > v[k]->w;
+		if (outside) continue;
+		outside = true;
+		for (int k = 0; k < 3 && outside; ++k) outside = v[k]->x < -v[k]->w;
+		if (outside) continue;
+		outside = true;
+		for (int k = 0; k < 3 && outside; ++k) outside = v[k]->y > v[k]->w;
+		if (outside) continue;
+		outside = true;
+		for (int k = 0; k < 3 && outside; ++k) outside = v[k]->y < -v[k]->w;
+		if (outside) continue;
+		outside = true;
+		for (int k = 0; k < 3 && outside; ++k) outside = v[k]->z > v[k]->w;
+		if (outside) continue;
+
+		int behind = (v[0]->z < 0.0f) + (v[1]->z < 0.0f) + (v[2]->z < 0.0f);
+		if (behind == 3)
+			continue;
+		if (behind == 0) {
+			SetupTriangle(XMLoadFloat4(v[0]), XMLoadFloat4(v[1]), XMLoadFloat4(v[2]));
+			continue;
+		}
+
+		// 按近平面z = 0裁剪，得到3或4个顶点的凸多边形后按扇形拆分
+		XMVECTOR poly[4];
+		int polyCount = 0;
+		for (int k = 0; k < 3; ++k) {
+			const XMFLOAT4* a = v[k];
+			const XMFLOAT4* b = v[(k + 1) % 3];
+			if (a->z >= 0.0f)
+				poly[polyCount++] = XMLoadFloat4(a);
+			if ((a->z >= 0.0f) != (b->z >= 0.0f)) {
+				float t = a->z / (a->z - b->z);
+				poly[polyCount++] = XMVectorLerp(XMLoadFloat4(a), XMLoadFloat4(b), t);
+			}
+		}
+		for (int k = 1; k + 1 < polyCount; ++k)
+			SetupTriangle(poly[0], poly[k], poly[k + 1]);
+	}
+}
+
+void XM_CALLCONV OcclusionCuller::SetupTriangle(FXMVECTOR v0, FXMVECTOR v1, FXMVECTOR v2)
+{
+	// 裁剪空间 -> 屏幕空间，y轴向下
+	float x[3], y[3], z[3];
+	XMVECTOR v[3] = { v0, v1, v2 };
+	for (int k = 0; k < 3; ++k) {
+		XMFLOAT4 p;
+		XMStoreFloat4(&p, v[k]);
+		float invW = 1.0f / p.w;
+		x[k] = (p.x * invW * 0.5f + 0.5f) * m_Width;
+		y[k] = (0.5f - p.y * invW * 0.5f) * m_Height;
+		z[k] = p.z * invW;
+	}
+
+	// 屏幕上顺时针为正面(与默认光栅化状态一致)，此时有向面积为正
+	float area = (x[1] - x[0]) * (y[2] - y[0]) - (x[2] - x[0]) * (y[1] - y[0]);
+	if (!(area > 0.0f))
+		return;
+
+	ScreenTriangle tri;
+	float minX = std::min({ x[0], x[1], x[2] }), maxX = std::max({ x[0], x[1], x[2] });
+	float minY = std::min({ y[0], y[1], y[2] }), maxY = std::max({ y[0], y[1], y[2] });
+	// 只有像素中心被覆盖时才写入
+	tri.minX = std::max(0, (int32_t)std::ceil(std::max(minX - 0.5f, -1.0f)));
+	tri.maxX = std::min((int32_t)m_Width - 1, (int32_t)std::floor(std::min(maxX - 0.5f, (float)m_Width)));
+	tri.minY = std::max(0, (int32_t)std::ceil(std::max(minY - 0.5f, -1.0f)));
+	tri.maxY = std::min((int32_t)m_Height - 1, (int32_t)std::floor(std::min(maxY - 0.5f, (float)m_Height)));
+	if (tri.minX > tri.maxX || tri.minY > tri.maxY)
+		return;
+
+	// 边a->b的边函数在第三个顶点处等于面积，因此内部为非负
+	for (int k = 0; k < 3; ++k) {
+		int a = k, b = (k + 1) % 3;
+		tri.edgeA[k] = y[a] - y[b];
+		tri.edgeB[k] = x[b] - x[a];
+		tri.edgeC[k] = -(tri.edgeA[k] * x[a] + tri.edgeB[k] * y[a]);
+	}
+
+	float invArea = 1.0f / area;
+	tri.depthA = ((z[1] - z[0]) * (y[2] - y[0]) - (z[2] - z[0]) * (y[1] - y[0])) * invArea;
+	tri.depthB = ((x[1] - x[0]) * (z[2] - z[0]) - (x[2] - x[0]) * (z[1] - z[0])) * invArea;
+	tri.depthC = z[0] - tri.depthA * x[0] - tri.depthB * y[0];
+	m_Triangles.push_back(tri);
+}
+
+void OcclusionCuller::BinTriangles()
+{
+	for (auto& bin : m_TileBins)
+		bin.clear();
+	for (uint32_t i = 0; i < (uint32_t)m_Triangles.size(); ++i) {
+		const ScreenTriangle& tri = m_Triangles[i];
+		uint32_t tx0 = tri.minX / TileSize, tx1 = tri.maxX / TileSize;
+		uint32_t ty0 = tri.minY / TileSize, ty1 = tri.maxY / TileSize;
+		for (uint32_t ty = ty0; ty <= ty1; ++ty)
+			for (uint32_t tx = tx0; tx <= tx1; ++tx)
+				m_TileBins[(size_t)ty * m_TilesX + tx].push_back(i);
+	}
+}
+
+void OcclusionCuller::RasterizeTile(uint32_t tileIndex)
+{
+	int32_t tileX = (int32_t)(tileIndex % m_TilesX) * TileSize;
+	int32_t tileY = (int32_t)(tileIndex / m_TilesX) * TileSize;
+	float* depth = m_HiZ[0].data();
+
+	for (int32_t y = tileY; y < tileY + (int32_t)TileSize; ++y)
+		std::fill_n(depth + (size_t)y * m_Width + tileX, TileSize, 1.0f);
+
+	// 每次处理一行中相邻的4个像素
+	const XMVECTOR pixelOffsets = XMVectorSet(0.5f, 1.5f, 2.5f, 3.5f);
+	for (uint32_t triIndex : m_TileBins[tileIndex]) {
+		const ScreenTriangle& tri = m_Triangles[triIndex];
+		int32_t x0 = std::max(tri.minX, tileX) & ~3;
+		int32_t x1 = std::min(tri.maxX, tileX + (int32_t)TileSize - 1);
+		int32_t y0 = std::max(tri.minY, tileY);
+		int32_t y1 = std::min(tri.maxY, tileY + (int32_t)TileSize - 1);
+
+		XMVECTOR edgeA[3], edgeStep[3];
+		for (int k = 0; k < 3; ++k) {
+			edgeA[k] = XMVectorReplicate(tri.edgeA[k]);
+			edgeStep[k] = XMVectorReplicate(4.0f * tri.edgeA[k]);
+		}
+		XMVECTOR depthA = XMVectorReplicate(tri.depthA);
+		XMVECTOR depthStep = XMVectorReplicate(4.0f * tri.depthA);
+		XMVECTOR px0 = XMVectorAdd(XMVectorReplicate((float)x0), pixelOffsets);
+
+		for (int32_t y = y0; y <= y1; ++y) {
+			float py = y + 0.5f;
+			XMVECTOR e[3];
+			for (int k = 0; k < 3; ++k)
+				e[k] = XMVectorMultiplyAdd(px0, edgeA[k], XMVectorReplicate(tri.edgeB[k] * py + tri.edgeC[k]));
+			XMVECTOR z = XMVectorMultiplyAdd(px0, depthA, XMVectorReplicate(tri.depthB * py + tri.depthC));
+
+			float* row = depth + (size_t)y * m_Width;
+			for (int32_t x = x0; x <= x1; x += 4) {
+				XMVECTOR inside = XMVectorAndInt(XMVectorGreaterOrEqual(e[0], g_XMZero),
+					XMVectorAndInt(XMVectorGreaterOrEqual(e[1], g_XMZero), XMVectorGreaterOrEqual(e[2], g_XMZero)));
+				XMVECTOR current = XMLoadFloat4(reinterpret_cast<const XMFLOAT4*>(row + x));
+				XMVECTOR result = XMVectorSelect(current, XMVectorMin(current, z), inside);
+				XMStoreFloat4(reinterpret_cast<XMFLOAT4*>(row + x), result);
+				for (int k = 0; k < 3; ++k)
+					e[k] = XMVectorAdd(e[k], edgeStep[k]);
+				z = XMVectorAdd(z, depthStep);
+			}
+		}
+	}
+
+	// 块内的HiZ层级只依赖本块的像素
+	for (uint32_t level = 1; level <= s_TileLevels; ++level) {
+		const float* src = m_HiZ[level - 1].data();
+		float* dst = m_HiZ[level].data();
+		uint32_t srcWidth = m_HiZSizes[level - 1].x, dstWidth = m_HiZSizes[level].x;
+		uint32_t size = TileSize >> level;
+		uint32_t dx0 = (uint32_t)tileX >> level, dy0 = (uint32_t)tileY >> level;
+		for (uint32_t dy = dy0; dy < dy0 + size; ++dy) {
+			const float* r0 = src + (size_t)(2 * dy) * srcWidth;
+			const float* r1 = r0 + srcWidth;
+			for (uint32_t dx = dx0; dx < dx0 + size; ++dx)
+				dst[(size_t)dy * dstWidth + dx] = std::max(std::max(r0[2 * dx], r0[2 * dx + 1]), std::max(r1[2 * dx], r1[2 * dx + 1]));
+		}
+	}
+}
+
+void OcclusionCuller::BuildUpperHiZ()
+{
+	for (uint32_t level = s_TileLevels + 1; level < (uint32_t)m_HiZ.size(); ++level) {
+		const float* src = m_HiZ[level - 1].data();
+		float* dst = m_HiZ[level].data();
+		XMUINT2 srcSize = m_HiZSizes[level - 1], dstSize = m_HiZSizes[level];
+		for (uint32_t dy = 0; dy < dstSize.y; ++dy) {
+			uint32_t sy0 = 2 * dy, sy1 = std::min(2 * dy + 1, srcSize.y - 1);
+			for (uint32_t dx = 0; dx < dstSize.x; ++dx) {
+				uint32_t sx0 = 2 * dx, sx1 = std::min(2 * dx + 1, srcSize.x - 1);
+				dst[(size_t)dy * dstSize.x + dx] = std::max(
+					std::max(src[(size_t)sy0 * srcSize.x + sx0], src[(size_t)sy0 * srcSize.x + sx1]),
+					std::max(src[(size_t)sy1 * srcSize.x + sx0], src[(size_t)sy1 * srcSize.x + sx1]));
+			}
+		}
+	}
+}
+
+void OcclusionCuller::Rasterize()
+{
+	BinTriangles();
+	for (uint32_t i = 0; i < (uint32_t)m_TileBins.size(); ++i)
+		RasterizeTile(i);
+	BuildUpperHiZ();
+}
+
+void OcclusionCuller::Rasterize(JobSystem& jobSystem)
+{
+	BinTriangles();
+	jobSystem.ParallelFor((uint32_t)m_TileBins.size(), 1, [this](uint32_t begin, uint32_t end) {
+		for (uint32_t i = begin; i < end; ++i)
+			RasterizeTile(i);
+	});
+	BuildUpperHiZ();
+}
+
+bool OcclusionCuller::IsVisible(const XMFLOAT3& center, const XMFLOAT3& extents) const
+{
+	// 角点 = 中心 ± 各轴半长，先分别变换再组合
+	XMMATRIX ViewProj = XMLoadFloat4x4(&m_ViewProj);
+	XMVECTOR c = XMVector3Transform(XMLoadFloat3(&center), ViewProj);
+	XMVECTOR ex = XMVectorScale(ViewProj.r[0], extents.x);
+	XMVECTOR ey = XMVectorScale(ViewProj.r[1], extents.y);
+	XMVECTOR ez = XMVectorScale(ViewProj.r[2], extents.z);
+
+	float minX = FLT_MAX, minY = FLT_MAX, maxX = -FLT_MAX, maxY = -FLT_MAX, minZ = FLT_MAX;
+	for (int k = 0; k < 8; ++k) {
+		XMVECTOR corner = XMVectorAdd(c, (k & 1) ? ex : XMVectorNegate(ex));
+		corner = XMVectorAdd(corner, (k & 2) ? ey : XMVectorNegate(ey));
+		corner = XMVectorAdd(corner, (k & 4) ? ez : XMVectorNegate(ez));
+		XMFLOAT4 p;
+		XMStoreFloat4(&p, corner);
+		if (p.z < 0.0f || p.w <= 0.0f)
+			return true;
+		float invW = 1.0f / p.w;
+		float sx = (p.x * invW * 0.5f + 0.5f) * m_Width;
+		float sy = (0.5f - p.y * invW * 0.5f) * m_Height;
+		minX = std::min(minX, sx); maxX = std::max(maxX, sx);
+		minY = std::min(minY, sy); maxY = std::max(maxY, sy);
+		minZ = std::min(minZ, p.z * invW);
+	}
+	if (maxX < 0.0f || maxY < 0.0f || minX >= (float)m_Width || minY >= (float)m_Height)
+		return false;
+
+	uint32_t x0 = (uint32_t)std::max(minX, 0.0f), x1 = (uint32_t)std::min(maxX, (float)m_Width - 1.0f);
+	uint32_t y0 = (uint32_t)std::max(minY, 0.0f), y1 = (uint32_t)std::min(maxY, (float)m_Height - 1.0f);
+
+	// 选择使矩形最多覆盖2x2纹素的层级
+	uint32_t level = 0;
+	while (level + 1 < (uint32_t)m_HiZ.size() && ((x1 >> level) - (x0 >> level) > 1 || (y1 >> level) - (y0 >> level) > 1))
+		++level;
+
+	const float* hiz = m_HiZ[level].data();
+	uint32_t width = m_HiZSizes[level].x;
+	for (uint32_t y = y0 >> level; y <= y1 >> level; ++y)
+		for (uint32_t x = x0 >> level; x <= x1 >> level; ++x)
+			if (minZ <= hiz[(size_t)y * width + x])
+				return true;
+	return false;
+}
+
+size_t OcclusionCuller::CullRange(const Culling::BoundingBoxSoA& boxes, const uint32_t* candidates, size_t begin, size_t end,
+	uint32_t* out) const
+{
+	size_t count = 0;
+	for (size_t i = begin; i < end; ++i) {
+		uint32_t index = candidates[i];
+		XMFLOAT3 center(boxes.centerX[index], boxes.centerY[index], boxes.centerZ[index]);
+		XMFLOAT3 extents(boxes.extentsX[index], boxes.extentsY[index], boxes.extentsZ[index]);
+		if (IsVisible(center, extents))
+			out[count++] = index;
+	}
+	return count;
+}
+
+size_t OcclusionCuller::CullBoxes(const Culling::BoundingBoxSoA& boxes, const uint32_t* candidates, size_t count,
+	uint32_t* visibleIndices) const
+{
+	return CullRange(boxes, candidates, 0, count, visibleIndices);
+}
+
+size_t OcclusionCuller::CullBoxes(JobSystem& jobSystem, const Culling::BoundingBoxSoA& boxes, const uint32_t* candidates,
+	size_t count, uint32_t* visibleIndices, uint32_t grainSize) const
+{
+	// 每批结果先写到该批起始位置，全部完成后再按顺序紧凑到一起；visibleIndices可以与candidates相同
+	assert(count <= UINT32_MAX);
+	grainSize = std::max(grainSize, 1u);
+	uint32_t batchCount = (uint32_t)((count + grainSize - 1) / grainSize);
+	std::vector<uint32_t> batchVisible(batchCount);
+	jobSystem.ParallelFor((uint32_t)count, grainSize, [&](uint32_t begin, uint32_t end) {
+		for (uint32_t b = begin; b < end; b += grainSize) {
+			uint32_t e = std::min(b + grainSize, end);
+			batchVisible[b / grainSize] = (uint32_t)CullRange(boxes, candidates, b, e, visibleIndices + b);
+		}
+	});
+
+	size_t visibleCount = batchVisible.empty() ? 0 : batchVisible[0];
+	for (uint32_t b = 1; b < batchCount; ++b) {
+		memmove(visibleIndices + visibleCount, visibleIndices + (size_t)b * grainSize, batchVisible[b] * sizeof(uint32_t));
+		visibleCount += batchVisible[b];
+	}
+	return visibleCount;
+}
+
+uint32_t OcclusionCuller::GetTriangleCount() const
+{
+	return (uint32_t)m_Triangles.size();
+}
+
+uint32_t OcclusionCuller::GetHiZLevelCount() const
+{
+	return (uint32_t)m_HiZ.size();
+}
+
+uint32_t OcclusionCuller::GetHiZWidth(uint32_t level) const
+{
+	return m_HiZSizes[level].x;
+}
+
+uint32_t OcclusionCuller::GetHiZHeight(uint32_t level) const
+{
+	return m_HiZSizes[level].y;
+}
+
+const float* OcclusionCuller::GetHiZ(uint32_t level) const
+{
+	return m_HiZ[level].data();
+}
@@ -0,0 +1,151 @@
+#include "RenderQueue.h"
+#include <cstring>
+
+namespace {
+	const uint32_t s_TextureShift = 0;
+	const uint32_t s_MaterialShift = s_TextureShift + RenderQueue::TextureBits;
+	const uint32_t s_ShaderShift = s_MaterialShift + RenderQueue::MaterialBits;
+	const uint32_t s_StateBits = RenderQueue::TextureBits + RenderQueue::MaterialBits + RenderQueue::ShaderBits;
+	const uint32_t s_TransparentShift = s_StateBits + RenderQueue::DepthBits;
+	const uint32_t s_PassShift = s_TransparentShift + 1;
+	static_assert(s_PassShift + RenderQueue::PassBits == 64, "RenderQueue key must use exactly 64 bits");
+
+	// 每趟处理11位，6趟覆盖64位，比8位一趟少两次遍历，直方图仍能放进缓存
+	const uint32_t s_RadixBits = 11;
+	const uint32_t s_RadixSize = 1u << s_RadixBits;
+	const uint32_t s_RadixPasses = (64 + s_RadixBits - 1) / s_RadixBits;
+
+	inline uint64_t Field(uint32_t value, uint32_t bits) {
+		return value & ((1u << bits) - 1);
+	}
+}
+
+uint64_t RenderQueue::MakeKey(uint32_t pass, bool transparent, uint32_t shader, uint32_t material, uint32_t texture, float depth)
+{
+	uint64_t state = Field(shader, ShaderBits) << s_ShaderShift |
+		Field(material, MaterialBits) << s_MaterialShift |
+		Field(texture, TextureBits) << s_TextureShift;
+	uint64_t depthBits = QuantizeDepth(depth);
+	uint64_t key = Field(pass, PassBits) << s_PassShift;
+	if (transparent) {
+		// 取反后深度大的排在前面
+		key |= 1ull << s_TransparentShift;
+		key |= ((1ull << DepthBits) - 1 - depthBits) << s_StateBits;
+		key |= state;
+	}
+	else {
+		key |= state << DepthBits;
+		key |= depthBits;
+	}
+	return key;
+}
+
+uint32_t RenderQueue::GetPass(uint64_t key)
+{
+	return static_cast<uint32_t>(key >> s_PassShift);
+}
+
+bool RenderQueue::IsTransparent(uint64_t key)
+{
+	return (key >> s_TransparentShift & 1) != 0;
+}
+
+uint32_t RenderQueue::GetShader(uint64_t key)
+{
+	uint64_t state = IsTransparent(key) ? key : key >> DepthBits;
+	return static_cast<uint32_t>(Field(static_cast<uint32_t>(state >> s_ShaderShift), ShaderBits));
+}
+
+uint32_t RenderQueue::GetMaterial(uint64_t key)
+{
+	uint64_t state = IsTransparent(key) ? key : key >> DepthBits;
+	return static_cast<uint32_t>(Field(static_cast<uint32_t>(state >> s_MaterialShift), MaterialBits));
+}
+
+uint32_t RenderQueue::GetTexture(uint64_t key)
+{
+	uint64_t state = IsTransparent(key) ? key : key >> DepthBits;
+	return static_cast<uint32_t>(Field(static_cast<uint32_t>(state >> s_TextureShift), TextureBits));
+}
+
+uint32_t RenderQueue::QuantizeDepth(float depth)
+{
+	// 非负浮点数的位模式与数值同序，取高24位(指数与高位尾数)，无需预先知道深度范围
+	if (!(depth > 0.0f))
+		return 0;
+	uint32_t bits;
+	memcpy(&bits, &depth, sizeof(bits));
+	return bits >> (31 - DepthBits);
+}
+
+void RenderQueue::Clear()
+{
+	m_Packets.clear();
+}
+
+void RenderQueue::Reserve(size_t count)
+{
+	m_Packets.reserve(count);
+	m_Scratch.reserve(count);
+}
+
+void RenderQueue::Submit(uint64_t key, uint32_t payload)
+{
+	m_Packets.push_back({ key, payload });
+}
+
+void RenderQueue::Submit(uint32_t pass, bool transparent, uint32_t shader, uint32_t material, uint32_t texture, float depth, uint32_t payload)
+{
+	m_Packets.push_back({ MakeKey(pass, transparent, shader, material, texture, depth), payload });
+}
+
+void RenderQueue::Sort()
+{
+	size_t count = m_Packets.size();
+	if (count < 2)
+		return;
+
+	// 一次遍历统计所有趟的直方图
+	m_Histograms.assign(s_RadixPasses * s_RadixSize, 0);
+	for (const Packet& packet : m_Packets) {
+		uint64_t key = packet.key;
+		for (uint32_t p = 0; p < s_RadixPasses; ++p)
+			++m_Histograms[p * s_RadixSize + (key >> (p * s_RadixBits) & (s_RadixSize - 1))];
+	}
+
+	m_Scratch.resize(count);
+	Packet* src = m_Packets.data();
+	Packet* dst = m_Scratch.data();
+	for (uint32_t p = 0; p < s_RadixPasses; ++p) {
+		uint32_t* histogram = &m_Histograms[p * s_RadixSize];
+		uint32_t shift = p * s_RadixBits;
+		// 所有包在这几位上相同，这一趟不改变顺序
+		if (histogram[src[0].key >> shift & (s_RadixSize - 1)] == count)
+			continue;
+
+		uint32_t offset = 0;
+		for (uint32_t i = 0; i < s_RadixSize; ++i) {
+			uint32_t c = histogram[i];
+			histogram[i] = offset;
+			offset += c;
+		}
+		for (size_t i = 0; i < count; ++i)
+			dst[histogram[src[i].key >> shift & (s_RadixSize - 1)]++] = src[i];
+		Packet* temp = src;
+		src = dst;
+		dst = temp;
+	}
+
+	if (src != m_Packets.data())
+		m_Packets.swap(m_Scratch);
+}
+
+size_t RenderQueue::Size() const
+{
+	return m_Packets.size();
+}
+
+const std::vector<RenderQueue::Packet>& RenderQueue::GetPackets() const
+{
+	return m_Packets;
+}
@@ -23,10 +23,40 @@ ComPtr<ID3D11DepthStencilState> RenderStates::DSSNoDepthTest = nullptr;
 ComPtr<ID3D11DepthStencilState> RenderStates::DSSNoDepthWrite = nullptr;
 ComPtr<ID3D11DepthStencilState> RenderStates::DSSNoDepthTestWithStencil = nullptr;
 ComPtr<ID3D11DepthStencilState> RenderStates::DSSNoDepthWriteWithStencil = nullptr;
+ComPtr<ID3D11DepthStencilState> RenderStates::DSSReverseZ = nullptr;
+ComPtr<ID3D11DepthStencilState> RenderStates::DSSReverseZNoDepthWrite = nullptr;
+ComPtr<ID3D11DepthStencilState> RenderStates::DSSReverseZWriteStencil = nullptr;
+ComPtr<ID3D11DepthStencilState> RenderStates::DSSReverseZDrawWithStencil = nullptr;
+ComPtr<ID3D11DepthStencilState> RenderStates::DSSReverseZNoDoubleBlend = nullptr;
+ComPtr<ID3D11DepthStencilState> RenderStates::DSSReverseZNoDepthWriteWithStencil = nullptr;
 bool RenderStates::IsInit() {
 	return RSWireframe != nullptr;
 }
 
+float RenderStates::GetDepthClearValue(bool reverseZ) {
+	return reverseZ ? 0.0f : 1.0f;
+}
+
+ID3D11DepthStencilState* RenderStates::GetDepthStencilState(bool reverseZ, bool depthWrite) {
+	if (reverseZ)
+		return depthWrite ? DSSReverseZ.Get() : DSSReverseZNoDepthWrite.Get();
+	return depthWrite ? nullptr : DSSNoDepthWrite.Get();
+}
+
+ID3D11DepthStencilState* RenderStates::GetDepthStencilState(bool reverseZ, DepthStencilMode mode) {
+	switch (mode) {
+	case DepthStencilMode::WriteStencil:
+		return reverseZ ? DSSReverseZWriteStencil.Get() : DSSWriteStencil.Get();
+	case DepthStencilMode::DrawWithStencil:
+		return reverseZ ? DSSReverseZDrawWithStencil.Get() : DSSDrawWithStencil.Get();
+	case DepthStencilMode::NoDoubleBlend:
+		return reverseZ ? DSSReverseZNoDoubleBlend.Get() : DSSNoDoubleBlend.Get();
+	case DepthStencilMode::NoDepthWriteWithStencil:
+		return reverseZ ? DSSReverseZNoDepthWriteWithStencil.Get() : DSSNoDepthWriteWithStencil.Get();
+	}
+	return nullptr;
+}
+
 void RenderStates::InitAll(ID3D11Device* device) {
 	if (IsInit()) {
 		return;
@@ -216,6 +246,28 @@ void RenderStates::InitAll(ID3D11Device* device) {
 	dsDesc.BackFace.StencilFunc = D3D11_COMPARISON_EQUAL;
 	HR(device->CreateDepthStencilState(&dsDesc, DSSNoDepthWriteWithStencil.GetAddressOf()));
 
+	// 反向Z：近处深度更大
+	dsDesc.DepthEnable = true;
+	dsDesc.DepthWriteMask = D3D11_DEPTH_WRITE_MASK_ALL;
+	dsDesc.DepthFunc = D3D11_COMPARISON_GREATER_EQUAL;
+	dsDesc.StencilEnable = false;
+	HR(device->CreateDepthStencilState(&dsDesc, DSSReverseZ.GetAddressOf()));
+
+	dsDesc.DepthWriteMask = D3D11_DEPTH_WRITE_MASK_ZERO;
+	HR(device->CreateDepthStencilState(&dsDesc, DSSReverseZNoDepthWrite.GetAddressOf()));
+
+	// 带模板的状态：除深度比较外与标准深度版本完全相同
+	auto createReverseZ = [device](ID3D11DepthStencilState* standard, ID3D11DepthStencilState** reverseZ) {
+		D3D11_DEPTH_STENCIL_DESC desc;
+		standard->GetDesc(&desc);
+		desc.DepthFunc = D3D11_COMPARISON_GREATER_EQUAL;
+		HR(device->CreateDepthStencilState(&desc, reverseZ));
+	};
+	createReverseZ(DSSWriteStencil.Get(), DSSReverseZWriteStencil.GetAddressOf());
+	createReverseZ(DSSDrawWithStencil.Get(), DSSReverseZDrawWithStencil.GetAddressOf());
+	createReverseZ(DSSNoDoubleBlend.Get(), DSSReverseZNoDoubleBlend.GetAddressOf());
+	createReverseZ(DSSNoDepthWriteWithStencil.Get(), DSSReverseZNoDepthWriteWithStencil.GetAddressOf());
+
 	D3D11SetDebugObjectName(RSCullClockWise.Get(), "RSCullClockWise");
 	D3D11SetDebugObjectName(RSNoCull.Get(), "RSNoCull");
 	D3D11SetDebugObjectName(RSWireframe.Get(), "RSWireframe");
@@ -235,4 +287,10 @@ void RenderStates::InitAll(ID3D11Device* device) {
 	D3D11SetDebugObjectName(DSSNoDepthWrite.Get(), "DSSNoDepthWrite");
 	D3D11SetDebugObjectName(DSSNoDepthTestWithStencil.Get(), "DSSNoDepthTestWithStencil");
 	D3D11SetDebugObjectName(DSSNoDepthWriteWithStencil.Get(), "DSSNoDepthWriteWithStencil");
+	D3D11SetDebugObjectName(DSSReverseZ.Get(), "DSSReverseZ");
+	D3D11SetDebugObjectName(DSSReverseZNoDepthWrite.Get(), "DSSReverseZNoDepthWrite");
+	D3D11SetDebugObjectName(DSSReverseZWriteStencil.Get(), "DSSReverseZWriteStencil");
+	D3D11SetDebugObjectName(DSSReverseZDrawWithStencil.Get(), "DSSReverseZDrawWithStencil");
+	D3D11SetDebugObjectName(DSSReverseZNoDoubleBlend.Get(), "DSSReverseZNoDoubleBlend");
+	D3D11SetDebugObjectName(DSSReverseZNoDepthWriteWithStencil.Get(), "DSSReverseZNoDepthWriteWithStencil");
 }
\ No newline at end of file
@@ -0,0 +1,67 @@
+#include "SkinnedMesh.h"
+#include "d3dUtil.h"
+#include "DXTrace.h"
+using namespace DirectX;
+
+SkinnedMesh::SkinnedMesh() : m_IndexFormat(DXGI_FORMAT_R32_UINT), m_IndexCount() {
+
+}
+
+void SkinnedMesh::CreateBuffers(ID3D11Device* device, const void* indexData, UINT indexByteWidth) {
+	// 顶点缓冲区每帧整体重写
+	D3D11_BUFFER_DESC vbd;
+	ZeroMemory(&vbd, sizeof(vbd));
+	vbd.Usage = D3D11_USAGE_DYNAMIC;
+	vbd.ByteWidth = sizeof(VertexPosNormalTangentTex) * (UINT)m_BindPoseVertices.size();
+	vbd.BindFlags = D3D11_BIND_VERTEX_BUFFER;
+	vbd.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE;
+	HR(device->CreateBuffer(&vbd, nullptr, m_pVertexBuffer.GetAddressOf()));
+
+	D3D11_BUFFER_DESC ibd;
+	ZeroMemory(&ibd, sizeof(ibd));
+	ibd.Usage = D3D11_USAGE_IMMUTABLE;
+	ibd.ByteWidth = indexByteWidth;
+	ibd.BindFlags = D3D11_BIND_INDEX_BUFFER;
+	ibd.CPUAccessFlags = 0;
+
+	D3D11_SUBRESOURCE_DATA InitData;
+	ZeroMemory(&InitData, sizeof(InitData));
+	InitData.pSysMem = indexData;
+	HR(device->CreateBuffer(&ibd, &InitData, m_pIndexBuffer.GetAddressOf()));
+}
+
+void SkinnedMesh::Update(ID3D11DeviceContext* deviceContext, const XMFLOAT4X4A* skinningMatrices, JobSystem* jobSystem) {
+	if (m_pVertexBuffer == nullptr)
+		return;
+
+	D3D11_MAPPED_SUBRESOURCE mappedData;
+	HR(deviceContext->Map(m_pVertexBuffer.Get(), 0, D3D11_MAP_WRITE_DISCARD, 0, &mappedData));
+	// 映射的内存通常为写合并内存，蒙皮内核只顺序写入不回读
+	auto pDest = reinterpret_cast<VertexPosNormalTangentTex*>(mappedData.pData);
+	if (jobSystem)
+		Skinning::SkinVertices(*jobSystem, m_BindPoseVertices.data(), pDest, m_BindPoseVertices.size(), skinningMatrices);
+	else
+		Skinning::SkinVertices(m_BindPoseVertices.data(), pDest, m_BindPoseVertices.size(), skinningMatrices);
+	deviceContext->Unmap(m_pVertexBuffer.Get(), 0);
+}
+
+void SkinnedMesh::Draw(ID3D11DeviceContext* deviceContext) {
+	UINT strides = sizeof(VertexPosNormalTangentTex);
+	UINT offset = 0;
+	deviceContext->IASetVertexBuffers(0, 1, m_pVertexBuffer.GetAddressOf(), &strides, &offset);
+	deviceContext->IASetIndexBuffer(m_pIndexBuffer.Get(), m_IndexFormat, 0);
+	deviceContext->DrawIndexed(m_IndexCount, 0, 0);
+}
+
+UINT SkinnedMesh::GetVertexCount() const {
+	return (UINT)m_BindPoseVertices.size();
+}
+
+void SkinnedMesh::SetDebugObjectName(const std::string& name) {
+#if (defined(DEBUG) || defined(_DEBUG) && (GRAPHICS_DEBUGGER_OBJECT_NAME))
+	D3D11SetDebugObjectName(m_pVertexBuffer.Get(), name + ".VertexBuffer");
+	D3D11SetDebugObjectName(m_pIndexBuffer.Get(), name + ".IndexBuffer");
+#else
+	UNREFERENCED_PARAMETER(name);
+#endif
+}
@@ -0,0 +1,112 @@
+#include "Skinning.h"
+#include "Animation.h"
+#include "JobSystem.h"
+#include <cassert>
+
+using namespace DirectX;
+
+uint32_t Skeleton::AddBone(int32_t parent, const XMFLOAT4X4& inverseBindPose)
+{
+	assert(parent == NoParent || (parent >= 0 && (uint32_t)parent < m_ParentIndices.size()));
+	assert(m_ParentIndices.size() < MaxBones);
+	m_ParentIndices.push_back(parent);
+	m_InverseBindPoses.push_back(inverseBindPose);
+	return (uint32_t)m_ParentIndices.size() - 1;
+}
+
+uint32_t Skeleton::GetBoneCount() const
+{
+	return (uint32_t)m_ParentIndices.size();
+}
+
+int32_t Skeleton::GetParent(uint32_t bone) const
+{
+	return m_ParentIndices[bone];
+}
+
+const XMFLOAT4X4& Skeleton::GetInverseBindPose(uint32_t bone) const
+{
+	return m_InverseBindPoses[bone];
+}
+
+void Skeleton::ComputeSkinningMatrices(const XMFLOAT4X4* localMatrices, XMFLOAT4X4A* skinningMatrices) const
+{
+	// 父骨骼总在子骨骼之前，一次遍历即可得到模型空间矩阵，先暂存在输出数组中
+	for (size_t i = 0; i < m_ParentIndices.size(); ++i) {
+		XMMATRIX Model = XMLoadFloat4x4(&localMatrices[i]);
+		int32_t parent = m_ParentIndices[i];
+		if (parent != NoParent)
+			Model = XMMatrixMultiply(Model, XMLoadFloat4x4A(&skinningMatrices[parent]));
+		XMStoreFloat4x4A(&skinningMatrices[i], Model);
+	}
+	ApplyInverseBindPoses(skinningMatrices);
+}
+
+void Skeleton::ComputeSkinningMatrices(const AnimationPose& localPose, XMFLOAT4X4A* skinningMatrices) const
+{
+	assert(localPose.rotations.size() >= m_ParentIndices.size());
+	for (size_t i = 0; i < m_ParentIndices.size(); ++i) {
+		XMMATRIX Model = XMMatrixAffineTransformation(XMLoadFloat3(&localPose.scales[i]), g_XMZero,
+			XMLoadFloat4(&localPose.rotations[i]), XMLoadFloat3(&localPose.positions[i]));
+		int32_t parent = m_ParentIndices[i];
+		if (parent != NoParent)
+			Model = XMMatrixMultiply(Model, XMLoadFloat4x4A(&skinningMatrices[parent]));
+		XMStoreFloat4x4A(&skinningMatrices[i], Model);
+	}
+	ApplyInverseBindPoses(skinningMatrices);
+}
+
+void Skeleton::ApplyInverseBindPoses(XMFLOAT4X4A* matrices) const
+{
+	for (size_t i = 0; i < m_ParentIndices.size(); ++i) {
+		XMMATRIX Model = XMLoadFloat4x4A(&matrices[i]);
+		XMStoreFloat4x4A(&matrices[i], XMMatrixMultiply(XMLoadFloat4x4(&m_InverseBindPoses[i]), Model));
+	}
+}
+
+void Skinning::SkinVertices(const VertexPosNormalTangentTexSkin* src, VertexPosNormalTangentTex* dst, size_t count,
+	const XMFLOAT4X4A* skinningMatrices)
+{
+	for (size_t i = 0; i < count; ++i) {
+		const VertexPosNormalTangentTexSkin& v = src[i];
+		XMVECTOR weights = XMLoadFloat4(&v.weights);
+		XMVECTOR w0 = XMVectorSplatX(weights);
+		XMVECTOR w1 = XMVectorSplatY(weights);
+		XMVECTOR w2 = XMVectorSplatZ(weights);
+		XMVECTOR w3 = XMVectorSplatW(weights);
+
+		// 混合矩阵 = sum(w[k] * M[bone[k]])，权重为0的骨骼同样参与计算以避免分支
+		XMMATRIX M0 = XMLoadFloat4x4A(&skinningMatrices[v.boneIndices[0]]);
+		XMMATRIX M1 = XMLoadFloat4x4A(&skinningMatrices[v.boneIndices[1]]);
+		XMMATRIX M2 = XMLoadFloat4x4A(&skinningMatrices[v.boneIndices[2]]);
+		XMMATRIX M3 = XMLoadFloat4x4A(&skinningMatrices[v.boneIndices[3]]);
+		XMMATRIX Blend;
+		for (int r = 0; r < 4; ++r) {
+			XMVECTOR row = XMVectorMultiply(M0.r[r], w0);
+			row = XMVectorMultiplyAdd(M1.r[r], w1, row);
+			row = XMVectorMultiplyAdd(M2.r[r], w2, row);
+			Blend.r[r] = XMVectorMultiplyAdd(M3.r[r], w3, row);
+		}
+
+		XMVECTOR pos = XMVector3Transform(XMLoadFloat3(&v.pos), Blend);
+		XMVECTOR normal = XMVector3Normalize(XMVector3TransformNormal(XMLoadFloat3(&v.normal), Blend));
+		XMVECTOR tangent = XMLoadFloat4(&v.tangent);
+		// 切线的w分量为副切线的手性，保持不变
+		tangent = XMVectorSelect(tangent, XMVector3Normalize(XMVector3TransformNormal(tangent, Blend)), g_XMSelect1110);
+
+		VertexPosNormalTangentTex& out = dst[i];
+		XMStoreFloat3(&out.pos, pos);
+		XMStoreFloat3(&out.normal, normal);
+		XMStoreFloat4(&out.tangent, tangent);
+		out.tex = v.tex;
+	}
+}
+
+void Skinning::SkinVertices(JobSystem& jobSystem, const VertexPosNormalTangentTexSkin* src, VertexPosNormalTangentTex* dst,
+	size_t count, const XMFLOAT4X4A* skinningMatrices, uint32_t grainSize)
+{
+	assert(count <= UINT32_MAX);
+	jobSystem.ParallelFor((uint32_t)count, grainSize, [=](uint32_t begin, uint32_t end) {
+		SkinVertices(src + begin, dst + begin, end - begin, skinningMatrices);
+	});
+}
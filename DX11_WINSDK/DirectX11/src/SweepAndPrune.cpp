@@ -0,0 +1,273 @@
+#include "SweepAndPrune.h"
+#include <algorithm>
+#include <cassert>
+
+using namespace DirectX;
+
+uint32_t SweepAndPrune::Add(const BoundingBox& box, uint32_t userData)
+{
+	uint32_t handle;
+	if (!m_FreeHandles.empty()) {
+		handle = m_FreeHandles.back();
+		m_FreeHandles.pop_back();
+	}
+	else {
+		handle = static_cast<uint32_t>(m_Objects.size());
+		m_Objects.emplace_back();
+	}
+
+	Object& object = m_Objects[handle];
+	object.userData = userData;
+	object.alive = true;
+	SetBounds(handle, box);
+	m_AddedHandles.push_back(handle);
+	++m_Size;
+	return handle;
+}
+
+void SweepAndPrune::SetBounds(uint32_t handle, const BoundingBox& box)
+{
+	assert(handle < m_Objects.size() && m_Objects[handle].alive);
+	Object& object = m_Objects[handle];
+	object.minPoint = XMFLOAT3(box.Center.x - box.Extents.x, box.Center.y - box.Extents.y, box.Center.z - box.Extents.z);
+	object.maxPoint = XMFLOAT3(box.Center.x + box.Extents.x, box.Center.y + box.Extents.y, box.Center.z + box.Extents.z);
+}
+
+void SweepAndPrune::Remove(uint32_t handle)
+{
+	assert(handle < m_Objects.size() && m_Objects[handle].alive);
+	m_Objects[handle].alive = false;
+	m_RemovedHandles.push_back(handle);
+	--m_Size;
+}
+
+void SweepAndPrune::Clear()
+{
+	m_Objects.clear();
+	for (std::vector<Endpoint>& endpoints : m_Endpoints)
+		endpoints.clear();
+	m_AddedHandles.clear();
+	m_RemovedHandles.clear();
+	m_FreeHandles.clear();
+	m_Pairs.clear();
+	m_ChangedPairs.clear();
+	m_BeginOverlaps.clear();
+	m_EndOverlaps.clear();
+	m_SwapCount = 0;
+	m_Size = 0;
+}
+
+void SweepAndPrune::Update()
+{
+	m_SwapCount = 0;
+
+	// 移除的物体：删掉端点，与其相关的重叠对作为结束事件
+	if (!m_RemovedHandles.empty()) {
+		for (std::vector<Endpoint>& endpoints : m_Endpoints) {
+			endpoints.erase(std::remove_if(endpoints.begin(), endpoints.end(), [this](const Endpoint& endpoint) {
+				return !m_Objects[endpoint.Handle()].alive;
+			}), endpoints.end());
+		}
+		for (auto it = m_Pairs.begin(); it != m_Pairs.end();) {
+			uint32_t a = static_cast<uint32_t>(*it >> 32), b = static_cast<uint32_t>(*it);
+			if (!m_Objects[a].alive || !m_Objects[b].alive) {
+				m_ChangedPairs.emplace(*it, true);
+				it = m_Pairs.erase(it);
+			}
+			else {
+				++it;
+			}
+		}
+	}
+
+	// 新物体的端点接在末尾，相当于位于所有物体的右侧且不与任何物体重叠，排序时向左移动找到重叠对
+	size_t addedCount = 0;
+	for (uint32_t handle : m_AddedHandles) {
+		if (!m_Objects[handle].alive)
+			continue;
+		for (std::vector<Endpoint>& endpoints : m_Endpoints) {
+			endpoints.push_back({ 0.0f, handle << 1 });
+			endpoints.push_back({ 0.0f, handle << 1 | 1 });
+		}
+		++addedCount;
+	}
+	m_AddedHandles.clear();
+
+	// 一次加入很多物体时插入排序退化为平方复杂度，改为整体排序后重新扫描
+	if (addedCount > BatchRebuildThreshold) {
+		RebuildPairs();
+	}
+	else {
+		for (uint32_t axis = 0; axis < 3; ++axis)
+			SortAxis(axis);
+	}
+
+	EmitEvents();
+	m_FreeHandles.insert(m_FreeHandles.end(), m_RemovedHandles.begin(), m_RemovedHandles.end());
+	m_RemovedHandles.clear();
+}
+
+size_t SweepAndPrune::Size() const
+{
+	return m_Size;
+}
+
+size_t SweepAndPrune::GetOverlapCount() const
+{
+	return m_Pairs.size();
+}
+
+void SweepAndPrune::GetOverlaps(std::vector<Pair>& pairs) const
+{
+	pairs.clear();
+	pairs.reserve(m_Pairs.size());
+	for (uint64_t key : m_Pairs) {
+		uint32_t a = m_Objects[key >> 32].userData, b = m_Objects[static_cast<uint32_t>(key)].userData;
+		pairs.push_back({ std::min(a, b), std::max(a, b) });
+	}
+	std::sort(pairs.begin(), pairs.end());
+}
+
+const std::vector<SweepAndPrune::Pair>& SweepAndPrune::GetBeginOverlaps() const
+{
+	return m_BeginOverlaps;
+}
+
+const std::vector<SweepAndPrune::Pair>& SweepAndPrune::GetEndOverlaps() const
+{
+	return m_EndOverlaps;
+}
+
+uint64_t SweepAndPrune::GetSwapCount() const
+{
+	return m_SwapCount;
+}
+
+void SweepAndPrune::FilterOverlaps(const std::vector<Pair>& pairs, const BoundingOrientedBox* orientedBoxes,
+	std::vector<Pair>& results)
+{
+	assert(&pairs != &results);
+	results.clear();
+	for (const Pair& pair : pairs) {
+		const BoundingOrientedBox& a = orientedBoxes[pair.first];
+		const BoundingOrientedBox& b = orientedBoxes[pair.second];
+		// 先用外接球排除，再做分离轴测试
+		XMVECTOR distSq = XMVector3LengthSq(XMVectorSubtract(XMLoadFloat3(&a.Center), XMLoadFloat3(&b.Center)));
+		XMVECTOR radius = XMVectorAdd(XMVector3Length(XMLoadFloat3(&a.Extents)), XMVector3Length(XMLoadFloat3(&b.Extents)));
+		if (XMVector3Greater(distSq, XMVectorMultiply(radius, radius)))
+			continue;
+		if (a.Intersects(b))
+			results.push_back(pair);
+	}
+}
+
+uint64_t SweepAndPrune::PairKey(uint32_t a, uint32_t b)
+{
+	return a < b ? (static_cast<uint64_t>(a) << 32 | b) : (static_cast<uint64_t>(b) << 32 | a);
+}
+
+bool SweepAndPrune::Overlaps(uint32_t a, uint32_t b) const
+{
+	const Object& objA = m_Objects[a];
+	const Object& objB = m_Objects[b];
+	return objA.minPoint.x <= objB.maxPoint.x && objB.minPoint.x <= objA.maxPoint.x &&
+		objA.minPoint.y <= objB.maxPoint.y && objB.minPoint.y <= objA.maxPoint.y &&
+		objA.minPoint.z <= objB.maxPoint.z && objB.minPoint.z <= objA.maxPoint.z;
+}
+
+void SweepAndPrune::AddPair(uint32_t a, uint32_t b)
+{
+	uint64_t key = PairKey(a, b);
+	if (m_Pairs.insert(key).second)
+		m_ChangedPairs.emplace(key, false);
+}
+
+void SweepAndPrune::RemovePair(uint32_t a, uint32_t b)
+{
+	uint64_t key = PairKey(a, b);
+	if (m_Pairs.erase(key))
+		m_ChangedPairs.emplace(key, true);
+}
+
+void SweepAndPrune::SortAxis(uint32_t axis)
+{
+	std::vector<Endpoint>& endpoints = m_Endpoints[axis];
+	for (Endpoint& endpoint : endpoints) {
+		const Object& object = m_Objects[endpoint.Handle()];
+		endpoint.value = endpoint.IsMax() ? (&object.maxPoint.x)[axis] : (&object.minPoint.x)[axis];
+	}
+
+	// 插入排序，每次交换对应两个区间端点相对位置的变化
+	for (size_t i = 1; i < endpoints.size(); ++i) {
+		Endpoint endpoint = endpoints[i];
+		size_t j = i;
+		while (j > 0 && endpoint < endpoints[j - 1]) {
+			const Endpoint& prev = endpoints[j - 1];
+			if (!endpoint.IsMax() && prev.IsMax()) {
+				if (Overlaps(endpoint.Handle(), prev.Handle()))
+					AddPair(endpoint.Handle(), prev.Handle());
+			}
+			else if (endpoint.IsMax() && !prev.IsMax()) {
+				RemovePair(endpoint.Handle(), prev.Handle());
+			}
+			endpoints[j] = prev;
+			--j;
+		}
+		m_SwapCount += i - j;
+		endpoints[j] = endpoint;
+	}
+}
+
+void SweepAndPrune::RebuildPairs()
+{
+	for (uint32_t axis = 0; axis < 3; ++axis) {
+		std::vector<Endpoint>& endpoints = m_Endpoints[axis];
+		for (Endpoint& endpoint : endpoints) {
+			const Object& object = m_Objects[endpoint.Handle()];
+			endpoint.value = endpoint.IsMax() ? (&object.maxPoint.x)[axis] : (&object.minPoint.x)[axis];
+		}
+		std::sort(endpoints.begin(), endpoints.end());
+	}
+
+	// 旧的对都记为帧开始时重叠，沿x轴扫描得到新的对
+	for (uint64_t key : m_Pairs)
+		m_ChangedPairs.emplace(key, true);
+	m_Pairs.clear();
+
+	std::vector<uint32_t> active;
+	std::vector<uint32_t> activeSlots(m_Objects.size());
+	for (const Endpoint& endpoint : m_Endpoints[0]) {
+		uint32_t handle = endpoint.Handle();
+		if (endpoint.IsMax()) {
+			uint32_t slot = activeSlots[handle];
+			active[slot] = active.back();
+			activeSlots[active[slot]] = slot;
+			active.pop_back();
+			continue;
+		}
+		for (uint32_t other : active) {
+			if (Overlaps(handle, other))
+				AddPair(handle, other);
+		}
+		activeSlots[handle] = static_cast<uint32_t>(active.size());
+		active.push_back(handle);
+	}
+}
+
+void SweepAndPrune::EmitEvents()
+{
+	m_BeginOverlaps.clear();
+	m_EndOverlaps.clear();
+	// 同一帧内先开始后结束(或相反)的对不产生事件
+	for (const auto& changed : m_ChangedPairs) {
+		bool overlapping = m_Pairs.count(changed.first) != 0;
+		if (overlapping == changed.second)
+			continue;
+		uint32_t a = m_Objects[changed.first >> 32].userData, b = m_Objects[static_cast<uint32_t>(changed.first)].userData;
+		Pair pair = { std::min(a, b), std::max(a, b) };
+		(overlapping ? m_BeginOverlaps : m_EndOverlaps).push_back(pair);
+	}
+	m_ChangedPairs.clear();
+	std::sort(m_BeginOverlaps.begin(), m_BeginOverlaps.end());
+	std::sort(m_EndOverlaps.begin(), m_EndOverlaps.end());
+}
@@ -0,0 +1,517 @@
+#include "TerrainField.h"
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+
+using namespace DirectX;
+
+namespace {
+	// 线段p0 + t * dir(t∈[0, tMax])与轴对齐包围盒的slab测试
+	bool SegmentBoxTest(const XMFLOAT3& p0, const XMFLOAT3& dir, const XMFLOAT3& boxMin, const XMFLOAT3& boxMax,
+		float tMax, float& tEnter)
+	{
+		const float* p = &p0.x;
+		const float* d = &dir.x;
+		const float* bmin = &boxMin.x;
+		const float* bmax = &boxMax.x;
+		float t0 = 0.0f, t1 = tMax;
+		for (int axis = 0; axis < 3; ++axis)
+		{
+			if (fabsf(d[axis]) < 1e-12f)
+			{
+				if (p[axis] < bmin[axis] || p[axis] > bmax[axis])
+					return false;
+				continue;
+			}
+			float invD = 1.0f / d[axis];
+			float tNear = (bmin[axis] - p[axis]) * invD;
+			float tFar = (bmax[axis] - p[axis]) * invD;
+			if (tNear > tFar)
+				std::swap(tNear, tFar);
+			t0 = std::max(t0, tNear);
+			t1 = std::min(t1, tFar);
+			if (t0 > t1)
+				return false;
+		}
+		tEnter = t0;
+		return true;
+	}
+}
+
+TerrainField::TerrainField(float width, float depth, uint32_t slicesX, uint32_t slicesZ,
+	const std::function<float(float, float)>& heightFunc)
+{
+	Init(width, depth, slicesX, slicesZ, heightFunc);
+}
+
+void TerrainField::Init(float width, float depth, uint32_t slicesX, uint32_t slicesZ,
+	const std::function<float(float, float)>& heightFunc)
+{
+	m_Width = width;
+	m_Depth = depth;
+	m_SlicesX = std::max(slicesX, 1u);
+	m_SlicesZ = std::max(slicesZ, 1u);
+	m_CellWidth = width / m_SlicesX;
+	m_CellDepth = depth / m_SlicesZ;
+	// 宽度或深度为0时地形退化为一条线，所有查询落在第0列(行)而不是得到inf
+	m_InvCellWidth = m_CellWidth > 0.0f ? 1.0f / m_CellWidth : 0.0f;
+	m_InvCellDepth = m_CellDepth > 0.0f ? 1.0f / m_CellDepth : 0.0f;
+	m_OriginX = -width / 2;
+	m_OriginZ = -depth / 2;
+
+	// 采样位置与CreateTerrain的顶点位置保持一致
+	m_Heights.resize((size_t)(m_SlicesX + 1) * (m_SlicesZ + 1));
+	size_t index = 0;
+	for (uint32_t z = 0; z <= m_SlicesZ; ++z)
+	{
+		float posZ = m_OriginZ + z * m_CellDepth;
+		for (uint32_t x = 0; x <= m_SlicesX; ++x)
+		{
+			float posX = m_OriginX + x * m_CellWidth;
+			m_Heights[index++] = heightFunc(posX, posZ);
+		}
+	}
+
+	BuildMinMaxLevels();
+}
+
+float TerrainField::GetWidth() const
+{
+	return m_Width;
+}
+
+float TerrainField::GetDepth() const
+{
+	return m_Depth;
+}
+
+uint32_t TerrainField::GetSlicesX() const
+{
+	return m_SlicesX;
+}
+
+uint32_t TerrainField::GetSlicesZ() const
+{
+	return m_SlicesZ;
+}
+
+bool TerrainField::Contains(float x, float z) const
+{
+	return x >= m_OriginX && x <= m_OriginX + m_Width && z >= m_OriginZ && z <= m_OriginZ + m_Depth;
+}
+
+float TerrainField::GetVertexHeight(uint32_t ix, uint32_t iz) const
+{
+	if (m_Heights.empty())
+		return 0.0f;
+	ix = std::min(ix, m_SlicesX);
+	iz = std::min(iz, m_SlicesZ);
+	return m_Heights[(size_t)iz * (m_SlicesX + 1) + ix];
+}
+
+XMFLOAT3 TerrainField::GetVertexNormal(uint32_t ix, uint32_t iz) const
+{
+	uint32_t x0 = ix > 0 ? ix - 1 : 0, x1 = std::min(ix + 1, m_SlicesX);
+	uint32_t z0 = iz > 0 ? iz - 1 : 0, z1 = std::min(iz + 1, m_SlicesZ);
+	// 与Init中的倒数相同，单元格尺寸为0的方向视为没有坡度
+	float dhdx = (GetVertexHeight(x1, iz) - GetVertexHeight(x0, iz)) * m_InvCellWidth / (x1 - x0);
+	float dhdz = (GetVertexHeight(ix, z1) - GetVertexHeight(ix, z0)) * m_InvCellDepth / (z1 - z0);
+
+	XMFLOAT3 normal;
+	XMStoreFloat3(&normal, XMVector3Normalize(XMVectorSet(-dhdx, 1.0f, -dhdz, 0.0f)));
+	return normal;
+}
+
+float TerrainField::GetHeight(float x, float z) const
+{
+	if (m_Heights.empty())
+		return 0.0f;
+
+	uint32_t cellX, cellZ;
+	float u, v;
+	GetCellCoord(x, z, cellX, cellZ, u, v);
+	const float* row0 = &m_Heights[(size_t)cellZ * (m_SlicesX + 1) + cellX];
+	const float* row1 = row0 + (m_SlicesX + 1);
+
+	float h0 = row0[0] + (row0[1] - row0[0]) * u;
+	float h1 = row1[0] + (row1[1] - row1[0]) * u;
+	return h0 + (h1 - h0) * v;
+}
+
+XMFLOAT3 TerrainField::GetNormal(float x, float z) const
+{
+	XMFLOAT3 normal;
+	XMStoreFloat3(&normal, GetNormalXM(x, z));
+	return normal;
+}
+
+XMVECTOR XM_CALLCONV TerrainField::GetNormalXM(float x, float z) const
+{
+	if (m_Heights.empty())
+		return g_XMIdentityR1;
+
+	uint32_t cellX, cellZ;
+	float u, v;
+	GetCellCoord(x, z, cellX, cellZ, u, v);
+	const float* row0 = &m_Heights[(size_t)cellZ * (m_SlicesX + 1) + cellX];
+	const float* row1 = row0 + (m_SlicesX + 1);
+
+	// 双线性曲面的偏导数
+	float dhdx = ((row0[1] - row0[0]) * (1.0f - v) + (row1[1] - row1[0]) * v) * m_InvCellWidth;
+	float dhdz = ((row1[0] - row0[0]) * (1.0f - u) + (row1[1] - row0[1]) * u) * m_InvCellDepth;
+	return XMVector3Normalize(XMVectorSet(-dhdx, 1.0f, -dhdz, 0.0f));
+}
+
+void TerrainField::GetHeights(const XMFLOAT2* positions, float* heights, size_t count) const
+{
+	GetHeightsAndNormals(positions, heights, nullptr, count);
+}
+
+void TerrainField::GetHeightsAndNormals(const XMFLOAT2* positions, float* heights, XMFLOAT3* normals, size_t count) const
+{
+	if (m_Heights.empty())
+	{
+		for (size_t i = 0; i < count; ++i)
+		{
+			heights[i] = 0.0f;
+			if (normals)
+				normals[i] = XMFLOAT3(0.0f, 1.0f, 0.0f);
+		}
+		return;
+	}
+
+	const XMVECTOR originX = XMVectorReplicate(m_OriginX);
+	const XMVECTOR originZ = XMVectorReplicate(m_OriginZ);
+	const XMVECTOR invCellWidth = XMVectorReplicate(m_InvCellWidth);
+	const XMVECTOR invCellDepth = XMVectorReplicate(m_InvCellDepth);
+	const XMVECTOR maxGridX = XMVectorReplicate((float)m_SlicesX);
+	const XMVECTOR maxGridZ = XMVectorReplicate((float)m_SlicesZ);
+	const XMVECTOR maxCellX = XMVectorReplicate((float)(m_SlicesX - 1));
+	const XMVECTOR maxCellZ = XMVectorReplicate((float)(m_SlicesZ - 1));
+	const size_t rowPitch = m_SlicesX + 1;
+
+	size_t i = 0;
+	for (; i + 4 <= count; i += 4)
+	{
+		// (x0, z0, x1, z1), (x2, z2, x3, z3) -> (x0, x1, x2, x3), (z0, z1, z2, z3)
+		XMVECTOR p01 = XMLoadFloat4(reinterpret_cast<const XMFLOAT4*>(positions + i));
+		XMVECTOR p23 = XMLoadFloat4(reinterpret_cast<const XMFLOAT4*>(positions + i + 2));
+		XMVECTOR gx = XMVectorMultiply(XMVectorSubtract(XMVectorPermute<0, 2, 4, 6>(p01, p23), originX), invCellWidth);
+		XMVECTOR gz = XMVectorMultiply(XMVectorSubtract(XMVectorPermute<1, 3, 5, 7>(p01, p23), originZ), invCellDepth);
+		gx = XMVectorClamp(gx, g_XMZero, maxGridX);
+		gz = XMVectorClamp(gz, g_XMZero, maxGridZ);
+		XMVECTOR cellX = XMVectorMin(XMVectorFloor(gx), maxCellX);
+		XMVECTOR cellZ = XMVectorMin(XMVectorFloor(gz), maxCellZ);
+		XMVECTOR u = XMVectorSubtract(gx, cellX);
+		XMVECTOR v = XMVectorSubtract(gz, cellZ);
+
+		// 取出4个单元格的角点高度
+		alignas(16) float cx[4], cz[4], h00[4], h10[4], h01[4], h11[4];
+		XMStoreFloat4A(reinterpret_cast<XMFLOAT4A*>(cx), cellX);
+		XMStoreFloat4A(reinterpret_cast<XMFLOAT4A*>(cz), cellZ);
+		for (int k = 0; k < 4; ++k)
+		{
+			const float* row0 = &m_Heights[(size_t)cz[k] * rowPitch + (size_t)cx[k]];
+			const float* row1 = row0 + rowPitch;
+			h00[k] = row0[0];
+			h10[k] = row0[1];
+			h01[k] = row1[0];
+			h11[k] = row1[1];
+		}
+		XMVECTOR H00 = XMLoadFloat4A(reinterpret_cast<const XMFLOAT4A*>(h00));
+		XMVECTOR H10 = XMLoadFloat4A(reinterpret_cast<const XMFLOAT4A*>(h10));
+		XMVECTOR H01 = XMLoadFloat4A(reinterpret_cast<const XMFLOAT4A*>(h01));
+		XMVECTOR H11 = XMLoadFloat4A(reinterpret_cast<const XMFLOAT4A*>(h11));
+
+		XMVECTOR h = XMVectorLerpV(XMVectorLerpV(H00, H10, u), XMVectorLerpV(H01, H11, u), v);
+		XMStoreFloat4(reinterpret_cast<XMFLOAT4*>(heights + i), h);
+
+		if (normals)
+		{
+			XMVECTOR dhdx = XMVectorMultiply(XMVectorLerpV(XMVectorSubtract(H10, H00), XMVectorSubtract(H11, H01), v), invCellWidth);
+			XMVECTOR dhdz = XMVectorMultiply(XMVectorLerpV(XMVectorSubtract(H01, H00), XMVectorSubtract(H11, H10), u), invCellDepth);
+			// 同时归一化4个法向量(-dhdx, 1, -dhdz)
+			XMVECTOR invLength = XMVectorReciprocalSqrt(
+				XMVectorMultiplyAdd(dhdx, dhdx, XMVectorMultiplyAdd(dhdz, dhdz, g_XMOne)));
+			alignas(16) float nx[4], ny[4], nz[4];
+			XMStoreFloat4A(reinterpret_cast<XMFLOAT4A*>(nx), XMVectorNegate(XMVectorMultiply(dhdx, invLength)));
+			XMStoreFloat4A(reinterpret_cast<XMFLOAT4A*>(ny), invLength);
+			XMStoreFloat4A(reinterpret_cast<XMFLOAT4A*>(nz), XMVectorNegate(XMVectorMultiply(dhdz, invLength)));
+			for (int k = 0; k < 4; ++k)
+				normals[i + k] = XMFLOAT3(nx[k], ny[k], nz[k]);
+		}
+	}
+
+	for (; i < count; ++i)
+	{
+		heights[i] = GetHeight(positions[i].x, positions[i].y);
+		if (normals)
+			normals[i] = GetNormal(positions[i].x, positions[i].y);
+	}
+}
+
+bool TerrainField::IntersectSegment(const XMFLOAT3& p0, const XMFLOAT3& p1, float& t) const
+{
+	t = FLT_MAX;
+	if (m_MinMaxLevels.empty())
+		return false;
+
+	XMFLOAT3 dir(p1.x - p0.x, p1.y - p0.y, p1.z - p0.z);
+
+	// 地形视为实心，节点包围盒向下延伸到无穷远，否则位于地形下方的线段会被错误剔除
+	auto nodeBox = [this](uint32_t level, uint32_t x, uint32_t z, XMFLOAT3& boxMin, XMFLOAT3& boxMax, float& minHeight) {
+		const MinMaxLevel& minMaxLevel = m_MinMaxLevels[level];
+		const XMFLOAT2& minMax = minMaxLevel.minMax[(size_t)z * minMaxLevel.width + x];
+		uint32_t cellX0 = x << level, cellZ0 = z << level;
+		uint32_t cellX1 = std::min((x + 1) << level, m_SlicesX);
+		uint32_t cellZ1 = std::min((z + 1) << level, m_SlicesZ);
+		boxMin = XMFLOAT3(GetGridLineX(cellX0), -FLT_MAX, GetGridLineZ(cellZ0));
+		boxMax = XMFLOAT3(GetGridLineX(cellX1), minMax.y, GetGridLineZ(cellZ1));
+		minHeight = minMax.x;
+	};
+
+	struct NodeEntry {
+		uint32_t level, x, z;
+		float tEnter;
+	};
+	// 每弹出一个节点最多压入4个子节点，栈深不超过3 * 层数 + 1
+	NodeEntry stack[4 * 33];
+	uint32_t top = 0;
+
+	XMFLOAT3 boxMin, boxMax;
+	float tEnter, minHeight;
+	const uint32_t topLevel = (uint32_t)m_MinMaxLevels.size() - 1;
+	nodeBox(topLevel, 0, 0, boxMin, boxMax, minHeight);
+	if (!SegmentBoxTest(p0, dir, boxMin, boxMax, 1.0f, tEnter))
+		return false;
+
+	float bestT = FLT_MAX;
+	// 进入节点时已不高于节点最低点，进入处即为该节点内的首个交点
+	if (p0.y + dir.y * tEnter <= minHeight)
+		bestT = tEnter;
+	else
+		stack[top++] = { topLevel, 0, 0, tEnter };
+
+	while (top > 0)
+	{
+		NodeEntry node = stack[--top];
+		if (node.tEnter > bestT)
+			continue;
+
+		float tMax = std::min(bestT, 1.0f);
+		if (node.level == 0)
+		{
+			float cellT;
+			if (IntersectCell(node.x, node.z, p0, dir, 0.0f, tMax, cellT) && cellT < bestT)
+				bestT = cellT;
+			continue;
+		}
+
+		const MinMaxLevel& childLevel = m_MinMaxLevels[node.level - 1];
+		NodeEntry children[4];
+		uint32_t childCount = 0;
+		for (uint32_t dz = 0; dz < 2; ++dz)
+		{
+			for (uint32_t dx = 0; dx < 2; ++dx)
+			{
+				uint32_t childX = node.x * 2 + dx, childZ = node.z * 2 + dz;
+				if (childX >= childLevel.width || childZ >= childLevel.depth)
+					continue;
+				nodeBox(node.level - 1, childX, childZ, boxMin, boxMax, minHeight);
+				if (!SegmentBoxTest(p0, dir, boxMin, boxMax, tMax, tEnter))
+					continue;
+				if (p0.y + dir.y * tEnter <= minHeight)
+				{
+					if (tEnter < bestT)
+						bestT = tEnter;
+					continue;
+				}
+				children[childCount++] = { node.level - 1, childX, childZ, tEnter };
+			}
+		}
+		// 远的先入栈，近的子节点先被访问；最多4个，插入排序即可
+		for (uint32_t i = 1; i < childCount; ++i)
+		{
+			NodeEntry child = children[i];
+			uint32_t j = i;
+			for (; j > 0 && children[j - 1].tEnter < child.tEnter; --j)
+				children[j] = children[j - 1];
+			children[j] = child;
+		}
+		for (uint32_t i = 0; i < childCount; ++i)
+			stack[top++] = children[i];
+	}
+
+	if (bestT > 1.0f)
+		return false;
+	t = bestT;
+	return true;
+}
+
+size_t TerrainField::IntersectSegments(const XMFLOAT3* p0, const XMFLOAT3* p1, float* t, size_t count) const
+{
+	size_t hitCount = 0;
+	for (size_t i = 0; i < count; ++i)
+	{
+		if (IntersectSegment(p0[i], p1[i], t[i]))
+			++hitCount;
+	}
+	return hitCount;
+}
+
+void TerrainField::BuildMinMaxLevels()
+{
+	m_MinMaxLevels.clear();
+
+	// 单元格级别：4个角点高度的最小/最大值
+	MinMaxLevel cellLevel;
+	cellLevel.width = m_SlicesX;
+	cellLevel.depth = m_SlicesZ;
+	cellLevel.minMax.resize((size_t)m_SlicesX * m_SlicesZ);
+	const size_t rowPitch = m_SlicesX + 1;
+	for (uint32_t z = 0; z < m_SlicesZ; ++z)
+	{
+		for (uint32_t x = 0; x < m_SlicesX; ++x)
+		{
+			const float* row0 = &m_Heights[(size_t)z * rowPitch + x];
+			const float* row1 = row0 + rowPitch;
+			float minH = std::min(std::min(row0[0], row0[1]), std::min(row1[0], row1[1]));
+			float maxH = std::max(std::max(row0[0], row0[1]), std::max(row1[0], row1[1]));
+			cellLevel.minMax[(size_t)z * m_SlicesX + x] = XMFLOAT2(minH, maxH);
+		}
+	}
+	m_MinMaxLevels.push_back(std::move(cellLevel));
+
+	// 逐级合并2x2节点直到只剩1个
+	while (m_MinMaxLevels.back().width > 1 || m_MinMaxLevels.back().depth > 1)
+	{
+		const MinMaxLevel& prevLevel = m_MinMaxLevels.back();
+		MinMaxLevel nextLevel;
+		nextLevel.width = (prevLevel.width + 1) / 2;
+		nextLevel.depth = (prevLevel.depth + 1) / 2;
+		nextLevel.minMax.resize((size_t)nextLevel.width * nextLevel.depth);
+		for (uint32_t z = 0; z < nextLevel.depth; ++z)
+		{
+			for (uint32_t x = 0; x < nextLevel.width; ++x)
+			{
+				XMFLOAT2 minMax(FLT_MAX, -FLT_MAX);
+				for (uint32_t dz = 0; dz < 2; ++dz)
+				{
+					for (uint32_t dx = 0; dx < 2; ++dx)
+					{
+						uint32_t prevX = x * 2 + dx, prevZ = z * 2 + dz;
+						if (prevX >= prevLevel.width || prevZ >= prevLevel.depth)
+							continue;
+						const XMFLOAT2& child = prevLevel.minMax[(size_t)prevZ * prevLevel.width + prevX];
+						minMax.x = std::min(minMax.x, child.x);
+						minMax.y = std::max(minMax.y, child.y);
+					}
+				}
+				nextLevel.minMax[(size_t)z * nextLevel.width + x] = minMax;
+			}
+		}
+		m_MinMaxLevels.push_back(std::move(nextLevel));
+	}
+}
+
+float TerrainField::GetGridLineX(uint32_t i) const
+{
+	return i >= m_SlicesX ? m_OriginX + m_Width : m_OriginX + i * m_CellWidth;
+}
+
+float TerrainField::GetGridLineZ(uint32_t i) const
+{
+	return i >= m_SlicesZ ? m_OriginZ + m_Depth : m_OriginZ + i * m_CellDepth;
+}
+
+void TerrainField::GetCellCoord(float x, float z, uint32_t& cellX, uint32_t& cellZ, float& u, float& v) const
+{
+	float gx = std::min(std::max((x - m_OriginX) * m_InvCellWidth, 0.0f), (float)m_SlicesX);
+	float gz = std::min(std::max((z - m_OriginZ) * m_InvCellDepth, 0.0f), (float)m_SlicesZ);
+	float fx = std::min(floorf(gx), (float)(m_SlicesX - 1));
+	float fz = std::min(floorf(gz), (float)(m_SlicesZ - 1));
+	cellX = (uint32_t)fx;
+	cellZ = (uint32_t)fz;
+	u = gx - fx;
+	v = gz - fz;
+}
+
+bool TerrainField::IntersectCell(uint32_t cellX, uint32_t cellZ, const XMFLOAT3& p0, const XMFLOAT3& dir,
+	float tMin, float tMax, float& t) const
+{
+	float x0 = GetGridLineX(cellX);
+	float z0 = GetGridLineZ(cellZ);
+
+	// 线段位于该单元格xz范围内的参数区间[ta, tb]
+	float ta = tMin, tb = tMax;
+	const float p[2] = { p0.x, p0.z };
+	const float d[2] = { dir.x, dir.z };
+	const float lo[2] = { x0, z0 };
+	const float hi[2] = { GetGridLineX(cellX + 1), GetGridLineZ(cellZ + 1) };
+	for (int axis = 0; axis < 2; ++axis)
+	{
+		if (fabsf(d[axis]) < 1e-12f)
+		{
+			if (p[axis] < lo[axis] || p[axis] > hi[axis])
+				return false;
+			continue;
+		}
+		float tNear = (lo[axis] - p[axis]) / d[axis];
+		float tFar = (hi[axis] - p[axis]) / d[axis];
+		if (tNear > tFar)
+			std::swap(tNear, tFar);
+		ta = std::max(ta, tNear);
+		tb = std::min(tb, tFar);
+	}
+	if (ta > tb)
+		return false;
+
+	// h(u, v) = a + b * u + c * v + e * u * v
+	const float* row0 = &m_Heights[(size_t)cellZ * (m_SlicesX + 1) + cellX];
+	const float* row1 = row0 + (m_SlicesX + 1);
+	float a = row0[0];
+	float b = row0[1] - row0[0];
+	float c = row1[0] - row0[0];
+	float e = row0[0] - row0[1] - row1[0] + row1[1];
+
+	// u(t) = u0 + du * t, v(t) = v0 + dv * t
+	float u0 = (p0.x - x0) * m_InvCellWidth, du = dir.x * m_InvCellWidth;
+	float v0 = (p0.z - z0) * m_InvCellDepth, dv = dir.z * m_InvCellDepth;
+
+	// f(t) = h(u(t), v(t)) - y(t) = A * t^2 + B * t + C，f由负变为非负处即为穿入地形的位置
+	float A = e * du * dv;
+	float B = b * du + c * dv + e * (u0 * dv + v0 * du) - dir.y;
+	float C = a + b * u0 + c * v0 + e * u0 * v0 - p0.y;
+
+	if ((A * ta + B) * ta + C >= 0.0f)
+	{
+		t = ta;
+		return true;
+	}
+
+	float root = FLT_MAX;
+	if (fabsf(A) < 1e-12f)
+	{
+		if (B > 0.0f)
+			root = -C / B;
+	}
+	else
+	{
+		float disc = B * B - 4.0f * A * C;
+		if (disc >= 0.0f)
+		{
+			// 数值稳定的求根公式
+			float q = -0.5f * (B + (B >= 0.0f ? sqrtf(disc) : -sqrtf(disc)));
+			float r0 = q / A;
+			float r1 = q != 0.0f ? C / q : r0;
+			if (r0 > r1)
+				std::swap(r0, r1);
+			root = r0 >= ta ? r0 : r1;
+		}
+	}
+
+	if (root < ta || root > tb)
+		return false;
+	t = root;
+	return true;
+}
@@ -1,10 +1,13 @@
 #include "Transform.h"
+#include "MathHelper.h"
+#include <cmath>
 
 using namespace DirectX;
 
 Transform::Transform(const DirectX::XMFLOAT3& scale, const DirectX::XMFLOAT3& rotation, const DirectX::XMFLOAT3& position)
-	: m_Scale(scale), m_Rotation(rotation), m_Position(position)
+	: m_Scale(scale), m_Position(position)
 {
+	SetRotation(rotation);
 }
 
 XMFLOAT3 Transform::GetScale() const
@@ -19,80 +22,95 @@ DirectX::XMVECTOR Transform::GetScaleXM() const
 
 XMFLOAT3 Transform::GetRotation() const
 {
-	return m_Rotation;
+	return GetEulerAnglesFromQuaternion(m_Rotation);
 }
 
 DirectX::XMVECTOR Transform::GetRotationXM() const
 {
-	return XMLoadFloat3(&m_Rotation);
+	XMFLOAT3 rotation = GetRotation();
+	return XMLoadFloat3(&rotation);
+}
+
+XMFLOAT4 Transform::GetRotationQuat() const
+{
+	return m_Rotation;
+}
+
+DirectX::XMVECTOR Transform::GetRotationQuatXM() const
+{
+	return XMLoadFloat4(&m_Rotation);
 }
 
 XMFLOAT3 Transform::GetPosition() const
 {
-	return m_Position;
+	return m_Position.ToFloat3();
 }
 
 DirectX::XMVECTOR Transform::GetPositionXM() const
 {
-	return XMLoadFloat3(&m_Position);
+	XMFLOAT3 position = m_Position.ToFloat3();
+	return XMLoadFloat3(&position);
+}
+
+Double3 Transform::GetPositionDouble() const
+{
+	return m_Position;
 }
 
 XMFLOAT3 Transform::GetRightAxis() const
 {
-	XMMATRIX R = XMMatrixRotationRollPitchYawFromVector(XMLoadFloat3(&m_Rotation));
-	XMFLOAT3 right;
-	XMStoreFloat3(&right, R.r[0]);
-	return right;
+	if (m_IsWorldDirty)
+		UpdateWorldMatrix();
+	return m_RightAxis;
 }
 
 DirectX::XMVECTOR Transform::GetRightAxisXM() const
 {
-	XMFLOAT3 right = GetRightAxis();
-	return XMLoadFloat3(&right);
+	if (m_IsWorldDirty)
+		UpdateWorldMatrix();
+	return XMLoadFloat3(&m_RightAxis);
 }
 
 XMFLOAT3 Transform::GetUpAxis() const
 {
-	XMMATRIX R = XMMatrixRotationRollPitchYawFromVector(XMLoadFloat3(&m_Rotation));
-	XMFLOAT3 up;
-	XMStoreFloat3(&up, R.r[1]);
-	return up;
+	if (m_IsWorldDirty)
+		UpdateWorldMatrix();
+	return m_UpAxis;
 }
 
 DirectX::XMVECTOR Transform::GetUpAxisXM() const
 {
-	XMFLOAT3 up = GetUpAxis();
-	return XMLoadFloat3(&up);
+	if (m_IsWorldDirty)
+		UpdateWorldMatrix();
+	return XMLoadFloat3(&m_UpAxis);
 }
 
 XMFLOAT3 Transform::GetForwardAxis() const
 {
-	XMMATRIX R = XMMatrixRotationRollPitchYawFromVector(XMLoadFloat3(&m_Rotation));
-	XMFLOAT3 forward;
-	XMStoreFloat3(&forward, R.r[2]);
-	return forward;
+	if (m_IsWorldDirty)
+		UpdateWorldMatrix();
+	return m_ForwardAxis;
 }
 
 DirectX::XMVECTOR Transform::GetForwardAxisXM() const
 {
-	XMFLOAT3 forward = GetForwardAxis();
-	return XMLoadFloat3(&forward);
+	if (m_IsWorldDirty)
+		UpdateWorldMatrix();
+	return XMLoadFloat3(&m_ForwardAxis);
 }
 
 XMFLOAT4X4 Transform::GetLocalToWorldMatrix() const
 {
-	XMFLOAT4X4 res;
-	XMStoreFloat4x4(&res, GetLocalToWorldMatrixXM());
-	return res;
+	if (m_IsWorldDirty)
+		UpdateWorldMatrix();
+	return m_LocalToWorld;
 }
 
 XMMATRIX Transform::GetLocalToWorldMatrixXM() const
 {
-	XMVECTOR scaleVec = XMLoadFloat3(&m_Scale);
-	XMVECTOR rotationVec = XMLoadFloat3(&m_Rotation);
-	XMVECTOR positionVec = XMLoadFloat3(&m_Position);
-	XMMATRIX World = XMMatrixScalingFromVector(scaleVec) * XMMatrixRotationRollPitchYawFromVector(rotationVec) * XMMatrixTranslationFromVector(positionVec);
-	return World;
+	if (m_IsWorldDirty)
+		UpdateWorldMatrix();
+	return XMLoadFloat4x4(&m_LocalToWorld);
 }
 
 XMFLOAT4X4 Transform::GetWorldToLocalMatrix() const
@@ -104,107 +122,215 @@ XMFLOAT4X4 Transform::GetWorldToLocalMatrix() const
 
 XMMATRIX Transform::GetWorldToLocalMatrixXM() const
 {
-	XMMATRIX InvWorld = XMMatrixInverse(nullptr, GetLocalToWorldMatrixXM());
+	if (m_IsInverseDirty)
+	{
+		// 缩放分量已知，无需通用求逆
+		MatrixKind kind = MatrixKind::Affine;
+		if (m_Scale.x == m_Scale.y && m_Scale.y == m_Scale.z)
+			kind = m_Scale.x == 1.0f ? MatrixKind::Rigid : MatrixKind::UniformScale;
+		XMMATRIX InvWorld = FastInverse(GetLocalToWorldMatrixXM(), kind);
+		XMStoreFloat4x4(&m_WorldToLocal, InvWorld);
+		m_IsInverseDirty = false;
+		return InvWorld;
+	}
+	return XMLoadFloat4x4(&m_WorldToLocal);
+}
+
+XMMATRIX Transform::GetLocalToWorldMatrixXM(const Double3& origin) const
+{
+	// 旋转缩放部分与绝对世界矩阵相同，只替换平移
+	XMMATRIX World = GetLocalToWorldMatrixXM();
+	XMFLOAT3 offset = m_Position.RelativeTo(origin);
+	World.r[3] = XMVectorSetW(XMLoadFloat3(&offset), 1.0f);
+	return World;
+}
+
+XMMATRIX Transform::GetWorldToLocalMatrixXM(const Double3& origin) const
+{
+	// 逆矩阵的上3x3部分不变，平移为-offset * inv3x3
+	XMMATRIX InvWorld = GetWorldToLocalMatrixXM();
+	XMFLOAT3 offset = m_Position.RelativeTo(origin);
+	XMVECTOR t = XMVector3TransformNormal(XMLoadFloat3(&offset), InvWorld);
+	InvWorld.r[3] = XMVectorSetW(XMVectorNegate(t), 1.0f);
 	return InvWorld;
 }
 
 void Transform::SetScale(const XMFLOAT3& scale)
 {
 	m_Scale = scale;
+	MarkDirty();
 }
 
 void Transform::SetScale(float x, float y, float z)
 {
 	m_Scale = XMFLOAT3(x, y, z);
+	MarkDirty();
 }
 
 void Transform::SetRotation(const XMFLOAT3& eulerAnglesInRadian)
 {
-	m_Rotation = eulerAnglesInRadian;
+	XMStoreFloat4(&m_Rotation, XMQuaternionRotationRollPitchYawFromVector(XMLoadFloat3(&eulerAnglesInRadian)));
+	MarkDirty();
 }
 
 void Transform::SetRotation(float x, float y, float z)
 {
-	m_Rotation = XMFLOAT3(x, y, z);
+	XMStoreFloat4(&m_Rotation, XMQuaternionRotationRollPitchYaw(x, y, z));
+	MarkDirty();
+}
+
+void Transform::SetRotationQuat(const XMFLOAT4& quaternion)
+{
+	XMStoreFloat4(&m_Rotation, XMQuaternionNormalize(XMLoadFloat4(&quaternion)));
+	MarkDirty();
 }
 
 void Transform::SetPosition(const XMFLOAT3& position)
 {
-	m_Position = position;
+	m_Position = Double3(position);
+	MarkDirty();
 }
 
 void Transform::SetPosition(float x, float y, float z)
 {
-	m_Position = XMFLOAT3(x, y, z);
+	m_Position = Double3(x, y, z);
+	MarkDirty();
+}
+
+void Transform::SetPosition(const Double3& position)
+{
+	m_Position = position;
+	MarkDirty();
 }
 
 void Transform::Rotate(const XMFLOAT3& eulerAnglesInRadian)
 {
-	XMVECTOR newRotationVec = XMVectorAdd(XMLoadFloat3(&m_Rotation), XMLoadFloat3(&eulerAnglesInRadian));
-	XMStoreFloat3(&m_Rotation, newRotationVec);
+	// 先进行原有旋转，再进行欧拉角表示的增量旋转；直接组合四元数，不经过欧拉角分解
+	XMVECTOR rotationQuat = XMQuaternionMultiply(XMLoadFloat4(&m_Rotation),
+		XMQuaternionRotationRollPitchYawFromVector(XMLoadFloat3(&eulerAnglesInRadian)));
+	XMStoreFloat4(&m_Rotation, XMQuaternionNormalize(rotationQuat));
+	MarkDirty();
 }
 
 void Transform::RotateAxis(const XMFLOAT3& axis, float radian)
 {
-	XMVECTOR rotationVec = XMLoadFloat3(&m_Rotation);
-	XMMATRIX R = XMMatrixRotationRollPitchYawFromVector(rotationVec) *
-		XMMatrixRotationAxis(XMLoadFloat3(&axis), radian);
-	XMFLOAT4X4 rotMatrix;
-	XMStoreFloat4x4(&rotMatrix, R);
-	m_Rotation = GetEulerAnglesFromRotationMatrix(rotMatrix);
+	// 先进行原有旋转，再绕世界空间的axis旋转
+	XMVECTOR rotationQuat = XMQuaternionMultiply(XMLoadFloat4(&m_Rotation),
+		XMQuaternionRotationAxis(XMLoadFloat3(&axis), radian));
+	XMStoreFloat4(&m_Rotation, XMQuaternionNormalize(rotationQuat));
+	MarkDirty();
 }
 
 void Transform::RotateAround(const XMFLOAT3& point, const XMFLOAT3& axis, float radian)
 {
-	XMVECTOR rotationVec = XMLoadFloat3(&m_Rotation);
-	XMVECTOR positionVec = XMLoadFloat3(&m_Position);
-	XMVECTOR centerVec = XMLoadFloat3(&point);
-
-	// 以point作为原点进行旋转
-	XMMATRIX RT = XMMatrixRotationRollPitchYawFromVector(rotationVec) * XMMatrixTranslationFromVector(positionVec - centerVec);
-	RT *= XMMatrixRotationAxis(XMLoadFloat3(&axis), radian);
-	RT *= XMMatrixTranslationFromVector(centerVec);
-	XMFLOAT4X4 rotMatrix;
-	XMStoreFloat4x4(&rotMatrix, RT);
-	m_Rotation = GetEulerAnglesFromRotationMatrix(rotMatrix);
-	XMStoreFloat3(&m_Position, RT.r[3]);
+	XMVECTOR axisQuat = XMQuaternionRotationAxis(XMLoadFloat3(&axis), radian);
+
+	// 以point作为原点进行旋转，相对偏移以单精度旋转后再加回双精度位置
+	XMVECTOR rotationQuat = XMQuaternionMultiply(XMLoadFloat4(&m_Rotation), axisQuat);
+	XMStoreFloat4(&m_Rotation, XMQuaternionNormalize(rotationQuat));
+	Double3 center(point);
+	XMFLOAT3 offset = m_Position.RelativeTo(center);
+	XMStoreFloat3(&offset, XMVector3Rotate(XMLoadFloat3(&offset), axisQuat));
+	m_Position = Double3(center.x + offset.x, center.y + offset.y, center.z + offset.z);
+	MarkDirty();
 }
 
 void Transform::Translate(const XMFLOAT3& direction, float magnitude)
 {
 	XMVECTOR directionVec = XMVector3Normalize(XMLoadFloat3(&direction));
-	XMVECTOR newPosition = XMVectorMultiplyAdd(XMVectorReplicate(magnitude), directionVec, XMLoadFloat3(&m_Position));
-	XMStoreFloat3(&m_Position, newPosition);
+	XMFLOAT3 offset;
+	XMStoreFloat3(&offset, XMVectorScale(directionVec, magnitude));
+	m_Position.x += offset.x;
+	m_Position.y += offset.y;
+	m_Position.z += offset.z;
+	MarkDirty();
 }
 
 void Transform::LookAt(const XMFLOAT3& target, const XMFLOAT3& up)
 {
-	XMMATRIX View = XMMatrixLookAtLH(XMLoadFloat3(&m_Position), XMLoadFloat3(&target), XMLoadFloat3(&up));
-	XMMATRIX InvView = XMMatrixInverse(nullptr, View);
-	XMFLOAT4X4 rotMatrix;
-	XMStoreFloat4x4(&rotMatrix, InvView);
-	m_Rotation = GetEulerAnglesFromRotationMatrix(rotMatrix);
+	XMFLOAT3 direction;
+	direction = Double3(target).RelativeTo(m_Position);
+	LookTo(direction, up);
 }
 
 void Transform::LookTo(const XMFLOAT3& direction, const XMFLOAT3& up)
 {
-	XMMATRIX View = XMMatrixLookToLH(XMLoadFloat3(&m_Position), XMLoadFloat3(&direction), XMLoadFloat3(&up));
-	XMMATRIX InvView = XMMatrixInverse(nullptr, View);
-	XMFLOAT4X4 rotMatrix;
-	XMStoreFloat4x4(&rotMatrix, InvView);
-	m_Rotation = GetEulerAnglesFromRotationMatrix(rotMatrix);
+	// 直接构造旋转矩阵的三个基向量，观察矩阵的逆的旋转部分即为此矩阵
+	XMVECTOR forwardVec = XMVector3Normalize(XMLoadFloat3(&direction));
+	XMVECTOR rightVec = XMVector3Normalize(XMVector3Cross(XMLoadFloat3(&up), forwardVec));
+	XMVECTOR upVec = XMVector3Cross(forwardVec, rightVec);
+	XMMATRIX R(rightVec, upVec, forwardVec, g_XMIdentityR3);
+	XMStoreFloat4(&m_Rotation, XMQuaternionNormalize(XMQuaternionRotationMatrix(R)));
+	MarkDirty();
+}
+
+Transform Transform::Interpolate(const Transform& from, const Transform& to, float t)
+{
+	Transform res;
+	XMStoreFloat3(&res.m_Scale, XMVectorLerp(XMLoadFloat3(&from.m_Scale), XMLoadFloat3(&to.m_Scale), t));
+	XMStoreFloat4(&res.m_Rotation, XMQuaternionSlerp(XMLoadFloat4(&from.m_Rotation), XMLoadFloat4(&to.m_Rotation), t));
+	// 位置以双精度插值，避免远离原点时出现抖动
+	res.m_Position.x = from.m_Position.x + (to.m_Position.x - from.m_Position.x) * t;
+	res.m_Position.y = from.m_Position.y + (to.m_Position.y - from.m_Position.y) * t;
+	res.m_Position.z = from.m_Position.z + (to.m_Position.z - from.m_Position.z) * t;
+	return res;
 }
 
-XMFLOAT3 Transform::GetEulerAnglesFromRotationMatrix(const XMFLOAT4X4& rotationMatrix)
+XMFLOAT3 Transform::GetEulerAnglesFromQuaternion(const XMFLOAT4& q) const
 {
+	// 只需要旋转矩阵中的5个元素，由四元数直接算出
+	float m01 = 2.0f * (q.x * q.y + q.z * q.w);
+	float m11 = 1.0f - 2.0f * (q.x * q.x + q.z * q.z);
+	float m20 = 2.0f * (q.x * q.z + q.y * q.w);
+	float m21 = 2.0f * (q.y * q.z - q.x * q.w);
+	float m22 = 1.0f - 2.0f * (q.x * q.x + q.y * q.y);
+
 	// 通过旋转矩阵反求欧拉角
-	float c = sqrtf(1.0f - rotationMatrix(2, 1) * rotationMatrix(2, 1));
+	float c = sqrtf(1.0f - m21 * m21);
 	// 防止r[2][1]出现大于1的情况
-	if (isnan(c))
+	if (std::isnan(c))
 		c = 0.0f;
 	XMFLOAT3 rotation;
-	rotation.z = atan2f(rotationMatrix(0, 1), rotationMatrix(1, 1));
-	rotation.x = atan2f(-rotationMatrix(2, 1), c);
-	rotation.y = atan2f(rotationMatrix(2, 0), rotationMatrix(2, 2));
+	rotation.z = atan2f(m01, m11);
+	rotation.x = atan2f(-m21, c);
+	rotation.y = atan2f(m20, m22);
 	return rotation;
 }
+
+uint32_t Transform::GetVersion() const
+{
+	return m_Version;
+}
+
+void Transform::UpdateCache() const
+{
+	if (m_IsWorldDirty)
+		UpdateWorldMatrix();
+	if (m_IsInverseDirty)
+		GetWorldToLocalMatrixXM();
+}
+
+void Transform::MarkDirty()
+{
+	m_IsWorldDirty = true;
+	m_IsInverseDirty = true;
+	++m_Version;
+}
+
+void Transform::UpdateWorldMatrix() const
+{
+	XMMATRIX R = XMMatrixRotationQuaternion(XMLoadFloat4(&m_Rotation));
+	XMStoreFloat3(&m_RightAxis, R.r[0]);
+	XMStoreFloat3(&m_UpAxis, R.r[1]);
+	XMStoreFloat3(&m_ForwardAxis, R.r[2]);
+
+	// S * R * T等价于将R的各行按缩放分量缩放，再把平移放入第4行
+	XMMATRIX World;
+	World.r[0] = XMVectorScale(R.r[0], m_Scale.x);
+	World.r[1] = XMVectorScale(R.r[1], m_Scale.y);
+	World.r[2] = XMVectorScale(R.r[2], m_Scale.z);
+	XMFLOAT3 position = m_Position.ToFloat3();
+	World.r[3] = XMVectorSetW(XMLoadFloat3(&position), 1.0f);
+	XMStoreFloat4x4(&m_LocalToWorld, World);
+	m_IsWorldDirty = false;
+}
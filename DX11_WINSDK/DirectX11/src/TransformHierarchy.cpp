@@ -0,0 +1,350 @@
+#include "TransformHierarchy.h"
+#include "JobSystem.h"
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+
+using namespace DirectX;
+
+namespace {
+	template<class T>
+	void InsertAt(std::vector<T>& vec, uint32_t index, const T& value) {
+		vec.insert(vec.begin() + index, value);
+	}
+
+	template<class T>
+	void EraseRange(std::vector<T>& vec, uint32_t begin, uint32_t end) {
+		vec.erase(vec.begin() + begin, vec.begin() + end);
+	}
+}
+
+void TransformHierarchy::Reserve(size_t nodeCount)
+{
+	m_LocalScales.reserve(nodeCount);
+	m_LocalRotations.reserve(nodeCount);
+	m_LocalPositions.reserve(nodeCount);
+	m_WorldMatrices.reserve(nodeCount);
+	m_ParentIndices.reserve(nodeCount);
+	m_SubtreeEnds.reserve(nodeCount);
+	m_DirtyFlags.reserve(nodeCount);
+	m_IndexToHandle.reserve(nodeCount);
+	m_HandleToIndex.reserve(nodeCount);
+}
+
+void TransformHierarchy::Clear()
+{
+	m_LocalScales.clear();
+	m_LocalRotations.clear();
+	m_LocalPositions.clear();
+	m_WorldMatrices.clear();
+	m_ParentIndices.clear();
+	m_SubtreeEnds.clear();
+	m_DirtyFlags.clear();
+	m_IndexToHandle.clear();
+	m_HandleToIndex.clear();
+	m_FreeHandles.clear();
+}
+
+TransformHierarchy::NodeHandle TransformHierarchy::AddNode(NodeHandle parent, const Transform& localTransform)
+{
+	return AddNode(parent, localTransform.GetScale(), localTransform.GetRotationQuat(), localTransform.GetPosition());
+}
+
+TransformHierarchy::NodeHandle TransformHierarchy::AddNode(NodeHandle parent, const XMFLOAT3& scale,
+	const XMFLOAT4& rotationQuat, const XMFLOAT3& position)
+{
+	uint32_t parentIndex = UINT32_MAX;
+	uint32_t index = static_cast<uint32_t>(m_ParentIndices.size());
+	if (parent != InvalidHandle)
+	{
+		assert(IsValid(parent));
+		parentIndex = m_HandleToIndex[parent];
+		index = m_SubtreeEnds[parentIndex];
+	}
+
+	// 插入位置之后的节点整体后移一位
+	bool append = index == m_ParentIndices.size();
+	if (!append)
+	{
+		for (uint32_t& p : m_ParentIndices)
+			if (p != UINT32_MAX && p >= index)
+				++p;
+		for (uint32_t& e : m_SubtreeEnds)
+			if (e > index)
+				++e;
+		for (uint32_t i = index; i < m_IndexToHandle.size(); ++i)
+			++m_HandleToIndex[m_IndexToHandle[i]];
+	}
+	// 祖先节点的子树都包含了新节点
+	for (uint32_t p = parentIndex; p != UINT32_MAX; p = m_ParentIndices[p])
+		if (m_SubtreeEnds[p] == index)
+			++m_SubtreeEnds[p];
+
+	NodeHandle handle;
+	if (!m_FreeHandles.empty())
+	{
+		handle = m_FreeHandles.back();
+		m_FreeHandles.pop_back();
+		m_HandleToIndex[handle] = index;
+	}
+	else
+	{
+		handle = static_cast<NodeHandle>(m_HandleToIndex.size());
+		m_HandleToIndex.push_back(index);
+	}
+
+	XMFLOAT4A rotation;
+	XMStoreFloat4A(&rotation, XMQuaternionNormalize(XMLoadFloat4(&rotationQuat)));
+	InsertAt(m_LocalScales, index, scale);
+	InsertAt(m_LocalRotations, index, rotation);
+	InsertAt(m_LocalPositions, index, position);
+	InsertAt(m_WorldMatrices, index, XMFLOAT4X4A());
+	InsertAt(m_ParentIndices, index, parentIndex);
+	InsertAt(m_SubtreeEnds, index, index + 1);
+	InsertAt(m_DirtyFlags, index, uint8_t(0));
+	InsertAt(m_IndexToHandle, index, handle);
+	MarkDirty(index);
+
+	return handle;
+}
+
+void TransformHierarchy::RemoveNode(NodeHandle node)
+{
+	assert(IsValid(node));
+	uint32_t begin = m_HandleToIndex[node];
+	uint32_t end = m_SubtreeEnds[begin];
+	uint32_t count = end - begin;
+
+	for (uint32_t i = begin; i < end; ++i)
+	{
+		m_HandleToIndex[m_IndexToHandle[i]] = UINT32_MAX;
+		m_FreeHandles.push_back(m_IndexToHandle[i]);
+	}
+	for (uint32_t p = m_ParentIndices[begin]; p != UINT32_MAX; p = m_ParentIndices[p])
+		m_SubtreeEnds[p] -= count;
+
+	EraseRange(m_LocalScales, begin, end);
+	EraseRange(m_LocalRotations, begin, end);
+	EraseRange(m_LocalPositions, begin, end);
+	EraseRange(m_WorldMatrices, begin, end);
+	EraseRange(m_ParentIndices, begin, end);
+	EraseRange(m_SubtreeEnds, begin, end);
+	EraseRange(m_DirtyFlags, begin, end);
+	EraseRange(m_IndexToHandle, begin, end);
+
+	for (uint32_t i = begin; i < m_IndexToHandle.size(); ++i)
+	{
+		m_HandleToIndex[m_IndexToHandle[i]] -= count;
+		if (m_ParentIndices[i] != UINT32_MAX && m_ParentIndices[i] >= end)
+			m_ParentIndices[i] -= count;
+		m_SubtreeEnds[i] -= count;
+	}
+}
+
+bool TransformHierarchy::IsValid(NodeHandle node) const
+{
+	return node < m_HandleToIndex.size() && m_HandleToIndex[node] != UINT32_MAX;
+}
+
+size_t TransformHierarchy::GetNodeCount() const
+{
+	return m_ParentIndices.size();
+}
+
+TransformHierarchy::NodeHandle TransformHierarchy::GetParent(NodeHandle node) const
+{
+	uint32_t parentIndex = m_ParentIndices[m_HandleToIndex[node]];
+	return parentIndex == UINT32_MAX ? InvalidHandle : m_IndexToHandle[parentIndex];
+}
+
+XMFLOAT3 TransformHierarchy::GetLocalScale(NodeHandle node) const
+{
+	return m_LocalScales[m_HandleToIndex[node]];
+}
+
+XMFLOAT4 TransformHierarchy::GetLocalRotationQuat(NodeHandle node) const
+{
+	return m_LocalRotations[m_HandleToIndex[node]];
+}
+
+XMFLOAT3 TransformHierarchy::GetLocalPosition(NodeHandle node) const
+{
+	return m_LocalPositions[m_HandleToIndex[node]];
+}
+
+void TransformHierarchy::SetLocalScale(NodeHandle node, const XMFLOAT3& scale)
+{
+	uint32_t index = m_HandleToIndex[node];
+	m_LocalScales[index] = scale;
+	MarkDirty(index);
+}
+
+void TransformHierarchy::SetLocalRotationQuat(NodeHandle node, const XMFLOAT4& rotationQuat)
+{
+	uint32_t index = m_HandleToIndex[node];
+	XMStoreFloat4A(&m_LocalRotations[index], XMQuaternionNormalize(XMLoadFloat4(&rotationQuat)));
+	MarkDirty(index);
+}
+
+void TransformHierarchy::SetLocalPosition(NodeHandle node, const XMFLOAT3& position)
+{
+	uint32_t index = m_HandleToIndex[node];
+	m_LocalPositions[index] = position;
+	MarkDirty(index);
+}
+
+void TransformHierarchy::SetLocalTransform(NodeHandle node, const Transform& localTransform)
+{
+	uint32_t index = m_HandleToIndex[node];
+	m_LocalScales[index] = localTransform.GetScale();
+	XMStoreFloat4A(&m_LocalRotations[index], localTransform.GetRotationQuatXM());
+	m_LocalPositions[index] = localTransform.GetPosition();
+	MarkDirty(index);
+}
+
+XMFLOAT4X4 TransformHierarchy::GetWorldMatrix(NodeHandle node) const
+{
+	return m_WorldMatrices[m_HandleToIndex[node]];
+}
+
+XMMATRIX XM_CALLCONV TransformHierarchy::GetWorldMatrixXM(NodeHandle node) const
+{
+	return XMLoadFloat4x4A(&m_WorldMatrices[m_HandleToIndex[node]]);
+}
+
+const XMFLOAT4X4A* TransformHierarchy::GetWorldMatrices() const
+{
+	return m_WorldMatrices.data();
+}
+
+uint32_t TransformHierarchy::GetNodeIndex(NodeHandle node) const
+{
+	return m_HandleToIndex[node];
+}
+
+void TransformHierarchy::UpdateWorldMatrices()
+{
+	UpdateRange(0, static_cast<uint32_t>(m_ParentIndices.size()), false);
+}
+
+void TransformHierarchy::UpdateWorldMatrices(JobSystem& jobSystem, uint32_t grainSize)
+{
+	CollectUpdateTasks(grainSize);
+	if (m_UpdateTasks.empty())
+		return;
+
+	// 各任务的区间互不相交，其父节点在串行阶段或同一区间内已经算好
+	jobSystem.ParallelFor(static_cast<uint32_t>(m_UpdateTasks.size()), 1, [this](uint32_t begin, uint32_t end) {
+		for (uint32_t i = begin; i < end; ++i)
+			UpdateRange(m_UpdateTasks[i].begin, m_UpdateTasks[i].end, m_UpdateTasks[i].forceUpdate);
+	});
+}
+
+void TransformHierarchy::CollectUpdateTasks(uint32_t grainSize)
+{
+	m_UpdateTasks.clear();
+	m_TaskStack.clear();
+
+	uint32_t nodeCount = static_cast<uint32_t>(m_ParentIndices.size());
+	for (uint32_t root = 0; root < nodeCount; root = m_SubtreeEnds[root])
+	{
+		m_TaskStack.emplace_back(root, false);
+		while (!m_TaskStack.empty())
+		{
+			uint32_t index = m_TaskStack.back().first;
+			bool forceUpdate = m_TaskStack.back().second;
+			m_TaskStack.pop_back();
+
+			uint8_t flags = m_DirtyFlags[index];
+			if (!forceUpdate && !flags)
+				continue;
+
+			uint32_t subtreeEnd = m_SubtreeEnds[index];
+			if (subtreeEnd - index <= grainSize)
+			{
+				// 与前一个相邻且类型相同的小任务合并
+				if (!m_UpdateTasks.empty() && m_UpdateTasks.back().end == index &&
+					m_UpdateTasks.back().forceUpdate == forceUpdate &&
+					subtreeEnd - m_UpdateTasks.back().begin <= grainSize)
+					m_UpdateTasks.back().end = subtreeEnd;
+				else
+					m_UpdateTasks.push_back({ index, subtreeEnd, forceUpdate });
+				continue;
+			}
+
+			// 子树过大，串行计算该节点后继续划分其子节点
+			bool childForceUpdate = forceUpdate || (flags & DirtySelf);
+			if (childForceUpdate)
+				ComputeWorldMatrix(index);
+			m_DirtyFlags[index] = 0;
+
+			// 逆序压栈，使任务保持深度优先顺序以便合并
+			size_t stackBase = m_TaskStack.size();
+			for (uint32_t child = index + 1; child < subtreeEnd; child = m_SubtreeEnds[child])
+				m_TaskStack.emplace_back(child, childForceUpdate);
+			std::reverse(m_TaskStack.begin() + stackBase, m_TaskStack.end());
+		}
+	}
+}
+
+void TransformHierarchy::MarkDirty(uint32_t index)
+{
+	m_DirtyFlags[index] |= DirtySelf;
+	// 向上标记，遇到已标记的祖先即可停止
+	for (uint32_t p = m_ParentIndices[index]; p != UINT32_MAX && !m_DirtyFlags[p]; p = m_ParentIndices[p])
+		m_DirtyFlags[p] = DirtyDescendant;
+}
+
+void TransformHierarchy::ComputeWorldMatrix(uint32_t index)
+{
+	// 局部矩阵S * R * T：R的各行按缩放分量缩放，第4行为平移
+	XMMATRIX R = XMMatrixRotationQuaternion(XMLoadFloat4A(&m_LocalRotations[index]));
+	const XMFLOAT3& scale = m_LocalScales[index];
+	XMMATRIX Local;
+	Local.r[0] = XMVectorScale(R.r[0], scale.x);
+	Local.r[1] = XMVectorScale(R.r[1], scale.y);
+	Local.r[2] = XMVectorScale(R.r[2], scale.z);
+	Local.r[3] = XMVectorSetW(XMLoadFloat3(&m_LocalPositions[index]), 1.0f);
+
+	uint32_t parentIndex = m_ParentIndices[index];
+	if (parentIndex != UINT32_MAX)
+		Local = XMMatrixMultiply(Local, XMLoadFloat4x4A(&m_WorldMatrices[parentIndex]));
+	XMStoreFloat4x4A(&m_WorldMatrices[index], Local);
+}
+
+void TransformHierarchy::UpdateRange(uint32_t begin, uint32_t end, bool forceUpdate)
+{
+	if (forceUpdate)
+	{
+		for (uint32_t i = begin; i < end; ++i)
+			ComputeWorldMatrix(i);
+		memset(m_DirtyFlags.data() + begin, 0, end - begin);
+		return;
+	}
+
+	uint32_t i = begin;
+	while (i < end)
+	{
+		uint8_t flags = m_DirtyFlags[i];
+		if (flags & DirtySelf)
+		{
+			// 该节点改变后整棵子树都需要重新计算
+			uint32_t subtreeEnd = m_SubtreeEnds[i];
+			for (uint32_t j = i; j < subtreeEnd; ++j)
+				ComputeWorldMatrix(j);
+			memset(m_DirtyFlags.data() + i, 0, subtreeEnd - i);
+			i = subtreeEnd;
+		}
+		else if (flags & DirtyDescendant)
+		{
+			// 进入子树继续查找
+			m_DirtyFlags[i] = 0;
+			++i;
+		}
+		else
+		{
+			// 跳过未改变的子树
+			i = m_SubtreeEnds[i];
+		}
+	}
+}
@@ -2,6 +2,7 @@
 #include "d3dUtil.h"
 #include "DXTrace.h"
 #include <sstream>
+#include <cmath>
 
 namespace {
 	D3DApp* g_pd3dApp = nullptr;
@@ -24,6 +25,10 @@ D3DApp::D3DApp(HINSTANCE hInstance)
 	m_Resizing(false),
 	m_Enable4xMsaa(true),
 	m_4xMsaaQuality(0),
+	m_FixedTimeStep(1.0f / 60.0f),
+	m_MaxStepsPerFrame(5),
+	m_Accumulator(0.0),
+	m_InterpolationAlpha(1.0f),
 	m_pd3dDevice(nullptr),
 	m_pd3dImmediateContext(nullptr),
 	m_pSwapChain(nullptr),
@@ -56,6 +61,51 @@ float D3DApp::AspectRatio() const {
 	return static_cast<float>(m_ClientWidth) / m_ClientHeight;
 }
 
+void D3DApp::SetFixedTimeStep(float hz, int maxStepsPerFrame) {
+	m_FixedTimeStep = hz > 0.0f ? 1.0f / hz : 0.0f;
+	m_MaxStepsPerFrame = maxStepsPerFrame > 0 ? maxStepsPerFrame : 1;
+	m_Accumulator = 0.0;
+	m_InterpolationAlpha = 1.0f;
+}
+
+float D3DApp::FixedTimeStep() const {
+	return m_FixedTimeStep;
+}
+
+float D3DApp::InterpolationAlpha() const {
+	return m_InterpolationAlpha;
+}
+
+void D3DApp::ProcessInput(float dt) {
+}
+
+void D3DApp::SaveSceneState() {
+}
+
+void D3DApp::StepScene(float dt) {
+	ProcessInput(dt);
+	if (m_FixedTimeStep <= 0.0f) {
+		SaveSceneState();
+		UpdateScene(dt);
+		m_InterpolationAlpha = 1.0f;
+		return;
+	}
+
+	// 超出追赶上限的时间直接丢弃，避免卡顿后陷入越追越慢的循环
+	m_Accumulator += dt;
+	int steps = 0;
+	while (m_Accumulator >= m_FixedTimeStep && steps < m_MaxStepsPerFrame) {
+		SaveSceneState();
+		UpdateScene(m_FixedTimeStep);
+		m_Accumulator -= m_FixedTimeStep;
+		++steps;
+	}
+	if (m_Accumulator >= m_FixedTimeStep)
+		m_Accumulator = fmod(m_Accumulator, (double)m_FixedTimeStep);
+
+	m_InterpolationAlpha = (float)(m_Accumulator / m_FixedTimeStep);
+}
+
 int D3DApp::Run() {
 	MSG msg = { 0 };
 
@@ -72,7 +122,7 @@ int D3DApp::Run() {
 
 			if (!m_AppPaused) {
 				CalculateFrameStats();
-				UpdateScene(m_Timer.DeltaTime());
+				StepScene(m_Timer.DeltaTime());
 				DrawScene();
 			}
 			else {
@@ -129,7 +179,8 @@ void D3DApp::OnResize() {
 	depthStencilDesc.Height = m_ClientHeight;
 	depthStencilDesc.MipLevels = 1;
 	depthStencilDesc.ArraySize = 1;
-	depthStencilDesc.Format = DXGI_FORMAT_D24_UNORM_S8_UINT;
+	// 浮点深度配合反向Z才能在远处保持精度，24位定点深度下反向Z几乎没有收益
+	depthStencilDesc.Format = DXGI_FORMAT_D32_FLOAT_S8X24_UINT;
 
 	if (m_Enable4xMsaa) {
 		depthStencilDesc.SampleDesc.Count = 4;